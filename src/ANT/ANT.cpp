@@ -43,6 +43,10 @@
 #define ANT_RUNNING  0x01
 #define ANT_PAUSED   0x02
 
+// how long the thread blocks waiting for the stick before
+// checking for commands from the controller (ms)
+#define ANT_READ_TIMEOUT 50
+
 // network key
 const unsigned char ANT::key[8] = { 0xB9, 0xA5, 0x21, 0xFB, 0xBD, 0x72, 0xC3, 0x45 };
 
@@ -130,6 +134,8 @@ ANT::ANT(QObject *parent, DeviceConfiguration *devConf, QString athlete) : QThre
     state = ST_WAIT_FOR_SYNC;
     length = bytes = 0;
     checksum = ANT_SYNC_BYTE;
+    decoded = dropped = 0;
+    second.invalidate();
 
     // ant ids - may not be configured of course
     if (devConf && devConf->deviceProfile.length())
@@ -249,6 +255,12 @@ void ANT::run()
     state = ST_WAIT_FOR_SYNC;
     length = bytes = 0;
     checksum = ANT_SYNC_BYTE;
+    decoded = dropped = 0;
+    second.invalidate();
+
+    pvars.lock();
+    stats = ANTReceiveStats();
+    pvars.unlock();
 
     if (openPort() == 0) {
 
@@ -261,16 +273,25 @@ void ANT::run()
         return;
     }
 
+    QElapsedTimer latency;
+
     while(1)
     {
-        // read more bytes from the device
-        uint8_t byte;
+        // wait for whatever the device has for us, rather than
+        // polling for single bytes and sleeping in between
+        uint8_t buffer[64];
 
-        int rc = rawRead(&byte, 1);
+        int rc = waitRead(buffer, sizeof(buffer), ANT_READ_TIMEOUT);
 
-        if (rc > 0)
-            receiveByte((unsigned char)byte);
-        else {
+        quint64 was = decoded;
+        if (rc > 0) {
+            latency.start();
+
+            for (int i=0; i<rc; i++) receiveByte((unsigned char)buffer[i]);
+
+            if (decoded != was) ring.write(telemetry);
+
+        } else if (rc < 0) {
 
             // Recognise USB device removal. Linux transitions through -5 (I/O error)
             // to -6 (No such device or address). Windows seems to stick on -5
@@ -284,6 +305,8 @@ void ANT::run()
             msleep(5);
         }
 
+        updateStats(was, decoded != was ? latency.nsecsElapsed() / 1000.0 : 0);
+
         //----------------------------------------------------------------------
         // LISTEN TO CONTROLLER FOR COMMANDS
         //----------------------------------------------------------------------
@@ -637,6 +660,48 @@ ANT::getRealtimeData(RealtimeData &rtData)
     rtData.setSlope(gradient);
 }
 
+ANTReceiveStats
+ANT::receiveStats()
+{
+    QMutexLocker locker(&pvars);
+    return stats;
+}
+
+// called by whichever thread is decoding after each read, or each message
+// when replaying, with how long handling the messages decoded since 'was'
+// took. The totals are published every time, the rates once a second
+void
+ANT::updateStats(quint64 was, double usecs)
+{
+    if (!second.isValid()) {
+        second.start();
+        lastDecoded = was;
+        latencyTotal = latencyMax = 0;
+        latencyCount = 0;
+    }
+
+    if (decoded != was) {
+        latencyTotal += usecs;
+        latencyCount++;
+        if (usecs > latencyMax) latencyMax = usecs;
+    }
+
+    QMutexLocker locker(&pvars);
+    stats.messages = decoded;
+    stats.dropped = dropped;
+
+    if (second.elapsed() >= 1000) {
+        stats.rate = (decoded - lastDecoded) * 1000.0 / second.elapsed();
+        stats.latency = latencyCount ? latencyTotal / latencyCount : 0;
+        stats.maxLatency = latencyMax;
+
+        lastDecoded = decoded;
+        latencyTotal = latencyMax = 0;
+        latencyCount = 0;
+        second.restart();
+    }
+}
+
 /*======================================================================
  * Channel management
  *====================================================================*/
@@ -951,6 +1016,7 @@ ANT::receiveByte(unsigned char byte) {
         case ST_GET_LENGTH:
             if ((byte == 0) || (byte > ANT_MAX_LENGTH)) {
                 state = ST_WAIT_FOR_SYNC;
+                dropped++;
             }
             else {
               rxMessage[ANT_OFFSET_LENGTH] = byte;
@@ -977,7 +1043,10 @@ ANT::receiveByte(unsigned char byte) {
 
         case ST_VALIDATE_PACKET:
             if (checksum == byte){
+                decoded++;
                 processMessage();
+            } else {
+                dropped++;
             }
             state = ST_WAIT_FOR_SYNC;
             break;
@@ -1283,6 +1352,111 @@ int ANT::rawRead(uint8_t bytes[], int size)
     return -1; // keep compiler happy.
 }
 
+// block until the device has data or the timeout expires, returning what
+// is available (up to size bytes), 0 on timeout or -ve on error
+int ANT::waitRead(uint8_t bytes[], int size, int timeout)
+{
+#ifdef WIN32
+#ifdef GC_HAVE_LIBUSB
+    if (usbMode == USB2) {
+        int rc = usb2->read((char *)bytes, size, timeout);
+        if (rc < 0 && rc != -ENXIO && rc != -EIO) return 0; // timed out
+        return rc;
+    }
+#endif
+    // USBXpress has no timeout, so we still poll it, nothing read is
+    // a timeout but errors are passed on like everywhere else
+    int rc = rawRead(bytes, 1);
+    if (rc == 0) msleep(5);
+    return rc;
+#else
+
+#ifdef GC_HAVE_LIBUSB
+    if (usbMode == USB2) {
+        int rc = usb2->read((char *)bytes, size, timeout);
+        if (rc < 0 && rc != -ENXIO && rc != -EIO) return 0; // timed out
+        return rc;
+    }
+#endif
+
+    // wait for the port to become readable
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    FD_SET(devicePort, &readfds);
+
+    struct timeval tv;
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+
+    int rc = select(devicePort+1, &readfds, NULL, NULL, &tv);
+    if (rc == 0) return 0;
+    if (rc < 0) return (errno == EINTR) ? 0 : -1;
+
+    // then take everything that's there, the port is non-blocking
+    rc = read(devicePort, bytes, size);
+    if (rc < 0) return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+    if (rc == 0) return -1; // readable but nothing there, device has gone
+    return rc;
+#endif
+}
+
+//
+// Replay a captured message, nothing is sent to the device so we
+// take the channel types from the channel ids we sent at the time and
+// only pass on telemetry, the channel events would drive each
+// channel's state machine and there is nobody to answer it
+//
+void
+ANT::replay(unsigned char RS, const unsigned char *message)
+{
+    int length = message[ANT_OFFSET_LENGTH];
+    if (message[ANT_OFFSET_SYNC] != ANT_SYNC_BYTE || length == 0 || length+3 > ANT_MAX_MESSAGE_SIZE) return;
+
+    int channel = message[ANT_OFFSET_CHANNEL_NUMBER] & 0x7;
+    channels = ANT_MAX_CHANNELS;
+
+    if (RS == 'S') {
+        if (message[ANT_OFFSET_ID] != ANT_CHANNEL_ID) return;
+
+        const ant_sensor_type_t *st=ant_sensor_types;
+        do {
+            if (st->device_id == message[6]) {
+                antChannel[channel]->channel_type = st->type;
+                antChannel[channel]->device_number = message[4] + (message[5]<<8);
+                antChannel[channel]->status = ANTChannel::Open;
+                antChannel[channel]->setId();
+                break;
+            }
+        } while (++st, st->type != ANTChannel::CHANNEL_TYPE_GUARD);
+        return;
+    }
+
+    switch (message[ANT_OFFSET_ID]) {
+        case ANT_BROADCAST_DATA:
+        case ANT_ACK_DATA:
+        case ANT_BURST_DATA:
+        case ANT_CHANNEL_ID:
+            break;
+        default:
+            return;
+    }
+
+    // the logger doesn't keep the checksum
+    QElapsedTimer latency;
+    latency.start();
+
+    unsigned char sum = 0;
+    quint64 was = decoded;
+    for (int i=0; i<length+3; i++) {
+        receiveByte(message[i]);
+        sum ^= message[i];
+    }
+    receiveByte(sum);
+
+    if (decoded != was) ring.write(telemetry);
+    updateStats(was, latency.nsecsElapsed() / 1000.0);
+}
+
 // convert 'p' 'c' etc into ANT values for device type
 int ANT::interpretSuffix(char c)
 {
@@ -25,6 +25,7 @@
 //
 #include "GoldenCheetah.h"
 #include "RealtimeData.h"
+#include "RealtimeRing.h"
 #include "CalibrationData.h"
 #include "DeviceConfiguration.h"
 
@@ -70,6 +71,7 @@
 #include <termios.h> // unix!!
 #include <unistd.h> // unix!!
 #include <sys/ioctl.h>
+#include <sys/select.h>
 #ifndef N_TTY // for OpenBSD
 #define N_TTY 0
 #endif
@@ -139,6 +141,18 @@ struct setChannelAtom {
     int channel_type;
 };
 
+// receive statistics, the totals are kept up to date and the rates are
+// updated once a second, by the ANT thread or a Replay
+struct ANTReceiveStats {
+    ANTReceiveStats() : messages(0), dropped(0), rate(0), latency(0), maxLatency(0) {}
+
+    quint64 messages;   // messages decoded since started
+    quint64 dropped;    // frames discarded for a bad length or checksum
+    double rate;        // messages per second over the last second
+    double latency;     // mean and worst microseconds from a read returning to
+    double maxLatency;  // its messages being handled, over the last second
+};
+
 //======================================================================
 // ANT Constants
 //======================================================================
@@ -462,6 +476,8 @@ public slots:
 
     // get telemetry
     void getRealtimeData(RealtimeData &);             // return current realtime data
+    ANTReceiveStats receiveStats();                   // how well are we keeping up?
+    RealtimeRing *telemetryRing() { return &ring; }   // every update as it is decoded
 
     // kickr command loading - only ANT device we know about to do this so not generic
     void setLoad(double);
@@ -500,6 +516,10 @@ public:
     void handleChannelEvent(void);
     void processMessage(void);
 
+    // feed a message captured by ANTLogger back through the decoder as
+    // if it had just been read from the stick (see Replay)
+    void replay(unsigned char RS, const unsigned char *message);
+
     // calibration
     uint8_t getCalibrationType()
     {
@@ -588,6 +608,7 @@ public:
     int closePort();
     int rawRead(uint8_t bytes[], int size);
     int rawWrite(uint8_t *bytes, int size);
+    int waitRead(uint8_t bytes[], int size, int timeout); // whatever arrives within timeout ms, 0 if nothing
 
     bool modeERGO(void) const;
     bool modeSLOPE(void) const;
@@ -676,6 +697,7 @@ private:
     void run();
 
     RealtimeData telemetry;
+    RealtimeRing ring;
     CalibrationData calibration;
 
     QMutex pvars;  // lock/unlock access to telemetry data between thread and controller
@@ -715,6 +737,15 @@ private:
     int length;
     int bytes;
     int checksum;
+    quint64 decoded, dropped; // frames, only touched by the ANT thread
+    ANTReceiveStats stats;    // published copy, guarded by pvars
+
+    // statistics for the current second, see updateStats()
+    QElapsedTimer second;
+    quint64 lastDecoded;
+    double latencyTotal, latencyMax;
+    int latencyCount;
+    void updateStats(quint64 was, double usecs);
     int powerchannels; // how many power channels do we have?
     QDateTime lastCadenceMessage;
 
@@ -88,6 +88,12 @@ ANTlocalController::pause()
 int
 ANTlocalController::stop()
 {
+    // how well we kept up with the stick, for the log
+    ANTReceiveStats stats = myANTlocal->receiveStats();
+    qDebug() << "ANT: decoded" << stats.messages << "messages, dropped" << stats.dropped
+             << "frames, last second" << stats.rate << "messages/s handled in mean"
+             << stats.latency << "us max" << stats.maxLatency << "us";
+
     int rc =  myANTlocal->stop();
     logger->close();
     return rc;
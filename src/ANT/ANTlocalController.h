@@ -60,6 +60,7 @@ public:
     bool doesPush(), doesPull(), doesLoad();
     void getRealtimeData(RealtimeData &rtData);
     void pushRealtimeData(RealtimeData &rtData);
+    RealtimeRing *telemetryRing() { return myANTlocal->telemetryRing(); }
 
     // now with the kickr we can control trainers
     void setLoad(double);
@@ -22,6 +22,7 @@
 #include "Athlete.h"
 #include "AllPlotWindow.h"
 #include "AllPlotSlopeCurve.h"
+#include "AllPlotSeriesData.h"
 #include "ReferenceLineDialog.h"
 #include "ExhaustionDialog.h"
 #include "RideFile.h"
@@ -950,6 +951,10 @@ AllPlot::AllPlot(QWidget *parent, AllPlotWindow *window, Context *context, RideF
 
     setXTitle();
 
+    // smoothing for recalc() in the background
+    smoothJobs = new ChartDataQueue(this);
+    connect(smoothJobs, SIGNAL(ready(ChartDataJob*)), this, SLOT(smoothingReady(ChartDataJob*)));
+
     standard = new AllPlotObject(this, window ? window->userDataSeries : QList<UserData*>());
 
     standard->intervalHighlighterCurve->setSamples(new IntervalPlotData(this, context, window));
@@ -1727,18 +1732,485 @@ AllPlot::setMatchLabels(AllPlotObject *objects)
     }
 }
 
+// empty the smoothed arrays, for raw data or while smoothing in the background
+static void
+clearSmoothed(AllPlotArrays *objects)
+{
+    for (int k=0; k<objects->U.count(); k++) objects->U[k].smooth.resize(0);
+    objects->smoothWatts.resize(0);
+    objects->smoothNP.resize(0);
+    objects->smoothGear.resize(0);
+    objects->smoothRV.resize(0);
+    objects->smoothRCad.resize(0);
+    objects->smoothRGCT.resize(0);
+    objects->smoothSmO2.resize(0);
+    objects->smoothtHb.resize(0);
+    objects->smoothO2Hb.resize(0);
+    objects->smoothHHb.resize(0);
+    objects->smoothAT.resize(0);
+    objects->smoothANT.resize(0);
+    objects->smoothXP.resize(0);
+    objects->smoothAP.resize(0);
+    objects->smoothHr.resize(0);
+    objects->smoothTcore.resize(0);
+    objects->smoothSpeed.resize(0);
+    objects->smoothAccel.resize(0);
+    objects->smoothWattsD.resize(0);
+    objects->smoothCadD.resize(0);
+    objects->smoothNmD.resize(0);
+    objects->smoothHrD.resize(0);
+    objects->smoothCad.resize(0);
+    objects->smoothTime.resize(0);
+    objects->smoothDistance.resize(0);
+    objects->smoothAltitude.resize(0);
+    objects->smoothSlope.resize(0);
+    objects->smoothTemp.resize(0);
+    objects->smoothWind.resize(0);
+    objects->smoothRelSpeed.resize(0);
+    objects->smoothTorque.resize(0);
+    objects->smoothLTE.resize(0);
+    objects->smoothRTE.resize(0);
+    objects->smoothLPS.resize(0);
+    objects->smoothRPS.resize(0);
+    objects->smoothLPCO.resize(0);
+    objects->smoothRPCO.resize(0);
+    objects->smoothLPP.resize(0);
+    objects->smoothRPP.resize(0);
+    objects->smoothLPPP.resize(0);
+    objects->smoothRPPP.resize(0);
+    objects->smoothBalanceL.resize(0);
+    objects->smoothBalanceR.resize(0);
+}
+
+// do the smoothing by calculating the average of the "applysmooth" values
+// left of each second, for recalc(). only touches the arrays so it can be
+// done off the GUI thread
+static void
+smoothSeries(AllPlotArrays *objects, int rideTimeSecs, int applysmooth, bool bydist)
+{
+    // user data totals
+    QVector<double> utotals;
+    utotals.resize(objects->U.count());
+    utotals.fill(0);
+
+    double totalWatts = 0.0;
+    double totalNP = 0.0;
+    double totalRCad = 0.0;
+    double totalRV = 0.0;
+    double totalRGCT = 0.0;
+    double totalSmO2 = 0.0;
+    double totaltHb = 0.0;
+    double totalO2Hb = 0.0;
+    double totalHHb = 0.0;
+    double totalATISS = 0.0;
+    double totalANTISS = 0.0;
+    double totalXP = 0.0;
+    double totalAP = 0.0;
+    double totalHr = 0.0;
+    double totalTcore = 0.0;
+    double totalSpeed = 0.0;
+    double totalAccel = 0.0;
+    double totalWattsD = 0.0;
+    double totalCadD = 0.0;
+    double totalNmD = 0.0;
+    double totalHrD = 0.0;
+    double totalCad = 0.0;
+    double totalDist = 0.0;
+    double totalAlt = 0.0;
+    double totalSlope = 0.0;
+    double totalTemp = 0.0;
+    double totalWind = 0.0;
+    double totalTorque = 0.0;
+    double totalBalance = 0.0;
+    double totalLTE = 0.0;
+    double totalRTE = 0.0;
+    double totalLPS = 0.0;
+    double totalRPS = 0.0;
+    double totalLPCO = 0.0;
+    double totalRPCO = 0.0;
+    double totalLPPB = 0.0;
+    double totalRPPB = 0.0;
+    double totalLPPE = 0.0;
+    double totalRPPE = 0.0;
+    double totalLPPPB = 0.0;
+    double totalRPPPB = 0.0;
+    double totalLPPPE = 0.0;
+    double totalRPPPE = 0.0;
+    double currentGearRatio = 0.0;
+
+
+    QList<DataPoint> list;
+
+    objects->smoothWatts.resize(rideTimeSecs + 1);
+    objects->smoothNP.resize(rideTimeSecs + 1);
+    objects->smoothGear.resize(rideTimeSecs + 1);
+    objects->smoothRV.resize(rideTimeSecs + 1);
+    objects->smoothRCad.resize(rideTimeSecs + 1);
+    objects->smoothRGCT.resize(rideTimeSecs + 1);
+    objects->smoothSmO2.resize(rideTimeSecs + 1);
+    objects->smoothtHb.resize(rideTimeSecs + 1);
+    objects->smoothO2Hb.resize(rideTimeSecs + 1);
+    objects->smoothHHb.resize(rideTimeSecs + 1);
+    objects->smoothAT.resize(rideTimeSecs + 1);
+    objects->smoothANT.resize(rideTimeSecs + 1);
+    objects->smoothXP.resize(rideTimeSecs + 1);
+    objects->smoothAP.resize(rideTimeSecs + 1);
+    objects->smoothHr.resize(rideTimeSecs + 1);
+    objects->smoothTcore.resize(rideTimeSecs + 1);
+    objects->smoothSpeed.resize(rideTimeSecs + 1);
+    objects->smoothAccel.resize(rideTimeSecs + 1);
+    objects->smoothWattsD.resize(rideTimeSecs + 1);
+    objects->smoothCadD.resize(rideTimeSecs + 1);
+    objects->smoothNmD.resize(rideTimeSecs + 1);
+    objects->smoothHrD.resize(rideTimeSecs + 1);
+    objects->smoothCad.resize(rideTimeSecs + 1);
+    objects->smoothTime.resize(rideTimeSecs + 1);
+    objects->smoothDistance.resize(rideTimeSecs + 1);
+    objects->smoothAltitude.resize(rideTimeSecs + 1);
+    objects->smoothSlope.resize(rideTimeSecs + 1);
+    objects->smoothTemp.resize(rideTimeSecs + 1);
+    objects->smoothWind.resize(rideTimeSecs + 1);
+    objects->smoothRelSpeed.resize(rideTimeSecs + 1);
+    objects->smoothTorque.resize(rideTimeSecs + 1);
+    objects->smoothBalanceL.resize(rideTimeSecs + 1);
+    objects->smoothBalanceR.resize(rideTimeSecs + 1);
+    objects->smoothLTE.resize(rideTimeSecs + 1);
+    objects->smoothRTE.resize(rideTimeSecs + 1);
+    objects->smoothLPS.resize(rideTimeSecs + 1);
+    objects->smoothRPS.resize(rideTimeSecs + 1);
+    objects->smoothLPCO.resize(rideTimeSecs + 1);
+    objects->smoothRPCO.resize(rideTimeSecs + 1);
+    objects->smoothLPP.resize(rideTimeSecs + 1);
+    objects->smoothRPP.resize(rideTimeSecs + 1);
+    objects->smoothLPPP.resize(rideTimeSecs + 1);
+    objects->smoothRPPP.resize(rideTimeSecs + 1);
+    for(int k=0; k<objects->U.count(); k++) {
+        objects->U[k].smooth.resize(rideTimeSecs + 1);
+    }
+
+    // do the smoothing by calculating the average of the "applysmooth" values left
+    // of the current data point - for points in time smaller than "applysmooth"
+    // only the available datapoints left are used to build the average
+    int i = 0;
+    for (int secs = 0; secs <= rideTimeSecs; ++secs) {
+        while ((i < objects->timeArray.count()) && (objects->timeArray[i] <= secs)) {
+
+            // collect user data if its there
+            QList<double> udata;
+            for (int k=0; k<objects->U.count(); k++) udata << (objects->U[k].array.size() > i ? objects->U[k].array[i] : 0);
+
+            // add to list
+            DataPoint dp(objects->timeArray[i],
+                         (!objects->hrArray.empty() ? objects->hrArray[i] : 0),
+                         (!objects->wattsArray.empty() ? objects->wattsArray[i] : 0),
+                         (!objects->atissArray.empty() ? objects->atissArray[i] : 0),
+                         (!objects->antissArray.empty() ? objects->antissArray[i] : 0),
+                         (!objects->npArray.empty() ? objects->npArray[i] : 0),
+                         (!objects->rvArray.empty() ? objects->rvArray[i] : 0),
+                         (!objects->rcadArray.empty() ? objects->rcadArray[i] : 0),
+                         (!objects->rgctArray.empty() ? objects->rgctArray[i] : 0),
+                         (!objects->smo2Array.empty() ? objects->smo2Array[i] : 0),
+                         (!objects->thbArray.empty() ? objects->thbArray[i] : 0),
+                         (!objects->o2hbArray.empty() ? objects->o2hbArray[i] : 0),
+                         (!objects->hhbArray.empty() ? objects->hhbArray[i] : 0),
+                         (!objects->apArray.empty() ? objects->apArray[i] : 0),
+                         (!objects->xpArray.empty() ? objects->xpArray[i] : 0),
+                         (!objects->speedArray.empty() ? objects->speedArray[i] : 0),
+                         (!objects->cadArray.empty() ? objects->cadArray[i] : 0),
+                         (!objects->altArray.empty() ? objects->altArray[i] : 0),
+                         (!objects->tempArray.empty() ? objects->tempArray[i] : 0),
+                         (!objects->windArray.empty() ? objects->windArray[i] : 0),
+                         (!objects->torqueArray.empty() ? objects->torqueArray[i] : 0),
+                         (!objects->balanceArray.empty() ? objects->balanceArray[i] : 0),
+                         (!objects->lteArray.empty() ? objects->lteArray[i] : 0),
+                         (!objects->rteArray.empty() ? objects->rteArray[i] : 0),
+                         (!objects->lpsArray.empty() ? objects->lpsArray[i] : 0),
+                         (!objects->rpsArray.empty() ? objects->rpsArray[i] : 0),
+                         (!objects->lpcoArray.empty() ? objects->lpcoArray[i] : 0),
+                         (!objects->rpcoArray.empty() ? objects->rpcoArray[i] : 0),
+                         (!objects->lppbArray.empty() ? objects->lppbArray[i] : 0),
+                         (!objects->rppbArray.empty() ? objects->rppbArray[i] : 0),
+                         (!objects->lppeArray.empty() ? objects->lppeArray[i] : 0),
+                         (!objects->rppeArray.empty() ? objects->rppeArray[i] : 0),
+                         (!objects->lpppbArray.empty() ? objects->lpppbArray[i] : 0),
+                         (!objects->rpppbArray.empty() ? objects->rpppbArray[i] : 0),
+                         (!objects->lpppeArray.empty() ? objects->lpppeArray[i] : 0),
+                         (!objects->rpppeArray.empty() ? objects->rpppeArray[i] : 0),
+                         (!objects->accelArray.empty() ? objects->accelArray[i] : 0),
+                         (!objects->wattsDArray.empty() ? objects->wattsDArray[i] : 0),
+                         (!objects->cadDArray.empty() ? objects->cadDArray[i] : 0),
+                         (!objects->nmDArray.empty() ? objects->nmDArray[i] : 0),
+                         (!objects->hrDArray.empty() ? objects->hrDArray[i] : 0),
+                         (!objects->slopeArray.empty() ? objects->slopeArray[i] : 0),
+                         (!objects->tcoreArray.empty() ? objects->tcoreArray[i] : 0),
+                        udata);
+
+            // apend to list
+            list.append(dp);
+
+            // maintain totals
+            if (!objects->wattsArray.empty()) totalWatts += objects->wattsArray[i];
+            if (!objects->npArray.empty()) totalNP += objects->npArray[i];
+            if (!objects->rvArray.empty()) totalRV += objects->rvArray[i];
+            if (!objects->rcadArray.empty()) totalRCad += objects->rcadArray[i];
+            if (!objects->rgctArray.empty()) totalRGCT += objects->rgctArray[i];
+            if (!objects->smo2Array.empty()) totalSmO2 += objects->smo2Array[i];
+            if (!objects->thbArray.empty()) totaltHb += objects->thbArray[i];
+            if (!objects->o2hbArray.empty()) totalO2Hb += objects->o2hbArray[i];
+            if (!objects->hhbArray.empty()) totalHHb += objects->hhbArray[i];
+            if (!objects->atissArray.empty()) totalATISS += objects->atissArray[i];
+            if (!objects->antissArray.empty()) totalANTISS += objects->antissArray[i];
+            if (!objects->xpArray.empty()) totalXP += objects->xpArray[i];
+            if (!objects->apArray.empty()) totalAP += objects->apArray[i];
+            if (!objects->tcoreArray.empty()) totalTcore    += objects->tcoreArray[i];
+            if (!objects->hrArray.empty()) totalHr    += objects->hrArray[i];
+            if (!objects->accelArray.empty()) totalAccel += objects->accelArray[i];
+            if (!objects->wattsDArray.empty()) totalWattsD += objects->wattsDArray[i];
+            if (!objects->cadDArray.empty()) totalCadD += objects->cadDArray[i];
+            if (!objects->nmDArray.empty()) totalNmD += objects->nmDArray[i];
+            if (!objects->hrDArray.empty()) totalHrD += objects->hrDArray[i];
+            if (!objects->speedArray.empty()) totalSpeed += objects->speedArray[i];
+            if (!objects->cadArray.empty()) totalCad   += objects->cadArray[i];
+            if (!objects->altArray.empty()) totalAlt   += objects->altArray[i];
+            if (!objects->slopeArray.empty()) totalSlope   += objects->slopeArray[i];
+            if (!objects->windArray.empty()) totalWind   += objects->windArray[i];
+            if (!objects->torqueArray.empty()) totalTorque   += objects->torqueArray[i];
+            if (!objects->tempArray.empty() ) {
+                if (objects->tempArray[i] == RideFile::NA) {
+                    dp.temp = (i>0 && !list.empty()?list.back().temp:0.0);
+                    totalTemp   += dp.temp;
+                }
+                else {
+                    totalTemp   += objects->tempArray[i];
+                }
+            }
+            if (!objects->balanceArray.empty()) totalBalance   += (objects->balanceArray[i]>0?objects->balanceArray[i]:50);
+            if (!objects->lteArray.empty()) totalLTE   += (objects->lteArray[i]>0?objects->lteArray[i]:0);
+            if (!objects->rteArray.empty()) totalRTE   += (objects->rteArray[i]>0?objects->rteArray[i]:0);
+            if (!objects->lpsArray.empty()) totalLPS   += (objects->lpsArray[i]>0?objects->lpsArray[i]:0);
+            if (!objects->rpsArray.empty()) totalRPS   += (objects->rpsArray[i]>0?objects->rpsArray[i]:0);
+            if (!objects->lpcoArray.empty()) totalLPCO   += objects->lpcoArray[i];
+            if (!objects->rpcoArray.empty()) totalRPCO   += objects->rpcoArray[i];
+            if (!objects->lppbArray.empty()) totalLPPB   += (objects->lppbArray[i]>0?objects->lppbArray[i]:0);
+            if (!objects->rppbArray.empty()) totalRPPB   += (objects->rppbArray[i]>0?objects->rppbArray[i]:0);
+            if (!objects->lppeArray.empty()) totalLPPE   += (objects->lppeArray[i]>0?objects->lppeArray[i]:0);
+            if (!objects->rppeArray.empty()) totalRPPE   += (objects->rppeArray[i]>0?objects->rppeArray[i]:0);
+            if (!objects->lpppbArray.empty()) totalLPPPB   += (objects->lpppbArray[i]>0?objects->lpppbArray[i]:0);
+            if (!objects->rpppbArray.empty()) totalRPPPB   += (objects->rpppbArray[i]>0?objects->rpppbArray[i]:0);
+            if (!objects->lpppeArray.empty()) totalLPPPE   += (objects->lpppeArray[i]>0?objects->lpppeArray[i]:0);
+            if (!objects->rpppeArray.empty()) totalRPPPE   += (objects->rpppeArray[i]>0?objects->rpppeArray[i]:0);
+
+            // set values which must not be smoothed
+            if (!objects->gearArray.empty()) currentGearRatio = (objects->gearArray[i]>0?objects->gearArray[i]:0);
+            totalDist   = objects->distanceArray[i];
+
+            // totalise user data
+            for(int k=0; k<utotals.count(); k++) utotals[k] += udata[k];
+
+            ++i;
+        }
+
+        // remove data from before smoothing duration (er, really?)
+        while (!list.empty() && (list.front().time < secs - applysmooth)) {
+            DataPoint &dp = list.front();
+            totalWatts -= dp.watts;
+            totalNP -= dp.np;
+            totalRV -= dp.rv;
+            totalRCad -= dp.rcad;
+            totalRGCT -= dp.rgct;
+            totalSmO2 -= dp.smo2;
+            totaltHb -= dp.thb;
+            totalO2Hb -= dp.o2hb;
+            totalHHb -= dp.hhb;
+            totalATISS -= dp.atiss;
+            totalANTISS -= dp.antiss;
+            totalAP -= dp.ap;
+            totalXP -= dp.xp;
+            totalHr    -= dp.hr;
+            totalTcore    -= dp.tcore;
+            totalSpeed -= dp.speed;
+            totalAccel -= dp.kphd;
+            totalWattsD -= dp.wattsd;
+            totalCadD -= dp.cadd;
+            totalNmD -= dp.nmd;
+            totalHrD -= dp.hrd;
+            totalCad   -= dp.cad;
+            totalAlt   -= dp.alt;
+            totalSlope -= dp.slope;
+            totalTemp   -= dp.temp;
+            totalWind   -= dp.wind;
+            totalTorque   -= dp.torque;
+            totalLTE   -= dp.lte;
+            totalRTE   -= dp.rte;
+            totalLPS   -= dp.lps;
+            totalRPS   -= dp.rps;
+            totalLPCO  -= dp.lpco;
+            totalRPCO  -= dp.rpco;
+            totalLPPB   -= dp.lppb;
+            totalRPPB   -= dp.rppb;
+            totalLPPE   -= dp.lppe;
+            totalRPPE   -= dp.rppe;
+            totalLPPPB  -= dp.lpppb;
+            totalRPPPB  -= dp.rpppb;
+            totalLPPPE  -= dp.lpppe;
+            totalRPPPE  -= dp.rpppe;
+            totalBalance   -= (dp.lrbalance>0?dp.lrbalance:50);
+            for(int k=0; k<utotals.count(); k++) utotals[k] -= dp.user[k];
+
+            list.removeFirst();
+        }
+
+        // TODO: this is wrong.  We should do a weighted average over the
+        // seconds represented by each point...
+        if (list.empty()) {
+
+            for (int k=0; k<objects->U.count(); k++) objects->U[k].smooth[secs] = 0.0;
+            objects->smoothWatts[secs] = 0.0;
+            objects->smoothNP[secs] = 0.0;
+            objects->smoothRV[secs] = 0.0;
+            objects->smoothRCad[secs] = 0.0;
+            objects->smoothRGCT[secs] = 0.0;
+            objects->smoothSmO2[secs] = 0.0;
+            objects->smoothtHb[secs] = 0.0;
+            objects->smoothO2Hb[secs] = 0.0;
+            objects->smoothHHb[secs] = 0.0;
+            objects->smoothAT[secs] = 0.0;
+            objects->smoothANT[secs] = 0.0;
+            objects->smoothXP[secs] = 0.0;
+            objects->smoothAP[secs] = 0.0;
+            objects->smoothHr[secs]    = 0.0;
+            objects->smoothTcore[secs]    = 0.0;
+            objects->smoothSpeed[secs] = 0.0;
+            objects->smoothAccel[secs] = 0.0;
+            objects->smoothWattsD[secs] = 0.0;
+            objects->smoothCadD[secs] = 0.0;
+            objects->smoothNmD[secs] = 0.0;
+            objects->smoothHrD[secs] = 0.0;
+            objects->smoothCad[secs]   = 0.0;
+            objects->smoothAltitude[secs]   = ((secs > 0) ? objects->smoothAltitude[secs - 1] : objects->altArray[secs] ) ;
+            objects->smoothSlope[secs]   =  0.0;
+            objects->smoothTemp[secs]   = 0.0;
+            objects->smoothWind[secs] = 0.0;
+            objects->smoothRelSpeed[secs] =  QwtIntervalSample();
+            objects->smoothTorque[secs] = 0.0;
+            objects->smoothLTE[secs] = 0.0;
+            objects->smoothRTE[secs] = 0.0;
+            objects->smoothLPS[secs] = 0.0;
+            objects->smoothRPS[secs] = 0.0;
+            objects->smoothLPCO[secs] = 0.0;
+            objects->smoothRPCO[secs] = 0.0;
+            objects->smoothLPP[secs] = QwtIntervalSample();
+            objects->smoothRPP[secs] = QwtIntervalSample();
+            objects->smoothLPPP[secs] = QwtIntervalSample();
+            objects->smoothRPPP[secs] = QwtIntervalSample();
+            objects->smoothBalanceL[secs] = 50;
+            objects->smoothBalanceR[secs] = 50;
+
+        } else {
+
+            for(int k=0; k<utotals.count(); k++) objects->U[k].smooth[secs] = utotals[k] / list.size();
+            objects->smoothWatts[secs]    = totalWatts / list.size();
+            objects->smoothNP[secs]    = totalNP / list.size();
+            objects->smoothRV[secs]    = totalRV / list.size();
+            objects->smoothRCad[secs]    = totalRCad / list.size();
+            objects->smoothRGCT[secs]    = totalRGCT / list.size();
+            objects->smoothSmO2[secs]    = totalSmO2 / list.size();
+            objects->smoothtHb[secs]    = totaltHb / list.size();
+            objects->smoothO2Hb[secs]    = totalO2Hb / list.size();
+            objects->smoothHHb[secs]    = totalHHb / list.size();
+            objects->smoothAT[secs]    = totalATISS / list.size();
+            objects->smoothANT[secs]    = totalANTISS / list.size();
+            objects->smoothXP[secs]    = totalXP / list.size();
+            objects->smoothAP[secs]    = totalAP / list.size();
+            objects->smoothHr[secs]       = totalHr / list.size();
+            objects->smoothTcore[secs]       = totalTcore / list.size();
+            objects->smoothSpeed[secs]    = totalSpeed / list.size();
+            objects->smoothAccel[secs]    = totalAccel / double(list.size());
+            objects->smoothWattsD[secs]    = totalWattsD / double(list.size());
+            objects->smoothCadD[secs]    = totalCadD / double(list.size());
+            objects->smoothNmD[secs]    = totalNmD / double(list.size());
+            objects->smoothHrD[secs]    = totalHrD / double(list.size());
+            objects->smoothCad[secs]      = totalCad / list.size();
+            objects->smoothAltitude[secs]      = totalAlt / list.size();
+            objects->smoothSlope[secs]      = totalSlope / double(list.size());
+            objects->smoothTemp[secs]      = totalTemp / list.size();
+            objects->smoothWind[secs]    = totalWind / list.size();
+            objects->smoothTorque[secs]    = totalTorque / list.size();
+            objects->smoothRelSpeed[secs] =  QwtIntervalSample(bydist ? totalDist : secs / 60.0, 
+                                                               QwtInterval(qMin(totalWind / list.size(),
+                                                               totalSpeed / list.size()), 
+                                                               qMax(totalWind / list.size(), 
+                                                               totalSpeed / list.size())));
+
+            // left /right pedal data
+            double balance = totalBalance / list.size();
+            if (balance == 0) {
+                objects->smoothBalanceL[secs]    = 50;
+                objects->smoothBalanceR[secs]    = 50;
+            } else if (balance >= 50) {
+                objects->smoothBalanceL[secs]    = balance;
+                objects->smoothBalanceR[secs]    = 50;
+            }
+            else {
+                objects->smoothBalanceL[secs]    = 50;
+                objects->smoothBalanceR[secs]    = balance;
+            }
+            objects->smoothLTE[secs]    = totalLTE / list.size();
+            objects->smoothRTE[secs]    = totalRTE / list.size();
+            objects->smoothLPS[secs]    = totalLPS / list.size();
+            objects->smoothRPS[secs]    = totalRPS / list.size();
+            objects->smoothLPCO[secs]   = totalLPCO / list.size();
+            objects->smoothRPCO[secs]   = totalRPCO / list.size();
+            objects->smoothLPP[secs]    = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalLPPB / list.size(), totalLPPE / list.size() ) );
+            objects->smoothRPP[secs]    = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalRPPB / list.size(), totalRPPE / list.size() ) );
+            objects->smoothLPPP[secs]   = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalLPPPB / list.size(), totalLPPPE / list.size() ) );
+            objects->smoothRPPP[secs]   = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalRPPPB / list.size(), totalRPPPE / list.size() ) );
+        }
+        objects->smoothGear[secs] = currentGearRatio;
+        objects->smoothDistance[secs] = totalDist;
+        objects->smoothTime[secs]  =  secs / 60.0;
+    }
+}
+
+// smooths the arrays for recalc() of the standard curves off the GUI thread,
+// they are copied in and copied back when ready, see smoothingReady()
+class AllPlotSmoothJob : public ChartDataJob
+{
+    public:
+        AllPlotSmoothJob(const AllPlotArrays &arrays, int rideTimeSecs, int applysmooth, bool bydist)
+            : arrays(arrays), rideTimeSecs(rideTimeSecs), applysmooth(applysmooth), bydist(bydist) {}
+
+        void prepare() { smoothSeries(&arrays, rideTimeSecs, applysmooth, bydist); }
+
+        AllPlotArrays arrays;
+        int rideTimeSecs, applysmooth;
+        bool bydist;
+};
+
 void
-AllPlot::recalc(AllPlotObject *objects)
+AllPlot::recalc(AllPlotObject *objects, bool background)
+{
+    // anything still being smoothed for the standard curves is superseded
+    if (objects == standard) smoothJobs->cancel();
+
+    // when there's no need to wait, say so now
+    if (!smoothArrays(objects, background && objects == standard) && background) emit recalculated();
+}
+
+// the first half of recalc(), returns true if the smoothing is being done in
+// the background in which case the curves are set when it's ready
+bool
+AllPlot::smoothArrays(AllPlotObject *objects, bool background)
 {
     if (referencePlot !=NULL){
-        return;
+        return false;
     }
 
     if (objects->timeArray.empty())
-        return;
+        return false;
 
     // skip null rides
-    if (!rideItem || !rideItem->ride()) return;
+    if (!rideItem || !rideItem->ride()) return false;
 
 
     int rideTimeSecs = (int) ceil(objects->timeArray[objects->timeArray.count()-1]);
@@ -1808,7 +2280,7 @@ AllPlot::recalc(AllPlotObject *objects)
         if (!objects->lpppbArray.empty()) objects->lpppCurve->setSamples(new QwtIntervalSeriesData(intData));
         if (!objects->rpppbArray.empty()) objects->rpppCurve->setSamples(new QwtIntervalSeriesData(intData));
 
-        return;
+        return false;
     }
 
     // if recintsecs is longer than the smoothing, or equal to the smoothing there is no point in even trying
@@ -1819,11 +2291,6 @@ AllPlot::recalc(AllPlotObject *objects)
     
     // we should only smooth the curves if objects->smoothed rate is greater than sample rate
 
-    // user data totals
-    QVector<double> utotals;
-    utotals.resize(objects->U.count());
-    utotals.fill(0);
-
     // Offset for timeOfDay
     if (context->isCompareIntervals || !bytimeofday)
         timeoffset = 0;
@@ -1832,431 +2299,20 @@ AllPlot::recalc(AllPlotObject *objects)
 
     if (applysmooth > 0) {
 
-        double totalWatts = 0.0;
-        double totalNP = 0.0;
-        double totalRCad = 0.0;
-        double totalRV = 0.0;
-        double totalRGCT = 0.0;
-        double totalSmO2 = 0.0;
-        double totaltHb = 0.0;
-        double totalO2Hb = 0.0;
-        double totalHHb = 0.0;
-        double totalATISS = 0.0;
-        double totalANTISS = 0.0;
-        double totalXP = 0.0;
-        double totalAP = 0.0;
-        double totalHr = 0.0;
-        double totalTcore = 0.0;
-        double totalSpeed = 0.0;
-        double totalAccel = 0.0;
-        double totalWattsD = 0.0;
-        double totalCadD = 0.0;
-        double totalNmD = 0.0;
-        double totalHrD = 0.0;
-        double totalCad = 0.0;
-        double totalDist = 0.0;
-        double totalAlt = 0.0;
-        double totalSlope = 0.0;
-        double totalTemp = 0.0;
-        double totalWind = 0.0;
-        double totalTorque = 0.0;
-        double totalBalance = 0.0;
-        double totalLTE = 0.0;
-        double totalRTE = 0.0;
-        double totalLPS = 0.0;
-        double totalRPS = 0.0;
-        double totalLPCO = 0.0;
-        double totalRPCO = 0.0;
-        double totalLPPB = 0.0;
-        double totalRPPB = 0.0;
-        double totalLPPE = 0.0;
-        double totalRPPE = 0.0;
-        double totalLPPPB = 0.0;
-        double totalRPPPB = 0.0;
-        double totalLPPPE = 0.0;
-        double totalRPPPE = 0.0;
-        double currentGearRatio = 0.0;
-
-
-        QList<DataPoint> list;
-
-        objects->smoothWatts.resize(rideTimeSecs + 1);
-        objects->smoothNP.resize(rideTimeSecs + 1);
-        objects->smoothGear.resize(rideTimeSecs + 1);
-        objects->smoothRV.resize(rideTimeSecs + 1);
-        objects->smoothRCad.resize(rideTimeSecs + 1);
-        objects->smoothRGCT.resize(rideTimeSecs + 1);
-        objects->smoothSmO2.resize(rideTimeSecs + 1);
-        objects->smoothtHb.resize(rideTimeSecs + 1);
-        objects->smoothO2Hb.resize(rideTimeSecs + 1);
-        objects->smoothHHb.resize(rideTimeSecs + 1);
-        objects->smoothAT.resize(rideTimeSecs + 1);
-        objects->smoothANT.resize(rideTimeSecs + 1);
-        objects->smoothXP.resize(rideTimeSecs + 1);
-        objects->smoothAP.resize(rideTimeSecs + 1);
-        objects->smoothHr.resize(rideTimeSecs + 1);
-        objects->smoothTcore.resize(rideTimeSecs + 1);
-        objects->smoothSpeed.resize(rideTimeSecs + 1);
-        objects->smoothAccel.resize(rideTimeSecs + 1);
-        objects->smoothWattsD.resize(rideTimeSecs + 1);
-        objects->smoothCadD.resize(rideTimeSecs + 1);
-        objects->smoothNmD.resize(rideTimeSecs + 1);
-        objects->smoothHrD.resize(rideTimeSecs + 1);
-        objects->smoothCad.resize(rideTimeSecs + 1);
-        objects->smoothTime.resize(rideTimeSecs + 1);
-        objects->smoothDistance.resize(rideTimeSecs + 1);
-        objects->smoothAltitude.resize(rideTimeSecs + 1);
-        objects->smoothSlope.resize(rideTimeSecs + 1);
-        objects->smoothTemp.resize(rideTimeSecs + 1);
-        objects->smoothWind.resize(rideTimeSecs + 1);
-        objects->smoothRelSpeed.resize(rideTimeSecs + 1);
-        objects->smoothTorque.resize(rideTimeSecs + 1);
-        objects->smoothBalanceL.resize(rideTimeSecs + 1);
-        objects->smoothBalanceR.resize(rideTimeSecs + 1);
-        objects->smoothLTE.resize(rideTimeSecs + 1);
-        objects->smoothRTE.resize(rideTimeSecs + 1);
-        objects->smoothLPS.resize(rideTimeSecs + 1);
-        objects->smoothRPS.resize(rideTimeSecs + 1);
-        objects->smoothLPCO.resize(rideTimeSecs + 1);
-        objects->smoothRPCO.resize(rideTimeSecs + 1);
-        objects->smoothLPP.resize(rideTimeSecs + 1);
-        objects->smoothRPP.resize(rideTimeSecs + 1);
-        objects->smoothLPPP.resize(rideTimeSecs + 1);
-        objects->smoothRPPP.resize(rideTimeSecs + 1);
-        for(int k=0; k<objects->U.count(); k++) {
-            objects->U[k].smooth.resize(rideTimeSecs + 1);
-        }
-
-        // do the smoothing by calculating the average of the "applysmooth" values left
-        // of the current data point - for points in time smaller than "applysmooth"
-        // only the available datapoints left are used to build the average
-        int i = 0;
-        for (int secs = 0; secs <= rideTimeSecs; ++secs) {
-            while ((i < objects->timeArray.count()) && (objects->timeArray[i] <= secs)) {
-
-                // collect user data if its there
-                QList<double> udata;
-                for (int k=0; k<objects->U.count(); k++) udata << (objects->U[k].array.size() > i ? objects->U[k].array[i] : 0);
-
-                // add to list
-                DataPoint dp(objects->timeArray[i],
-                             (!objects->hrArray.empty() ? objects->hrArray[i] : 0),
-                             (!objects->wattsArray.empty() ? objects->wattsArray[i] : 0),
-                             (!objects->atissArray.empty() ? objects->atissArray[i] : 0),
-                             (!objects->antissArray.empty() ? objects->antissArray[i] : 0),
-                             (!objects->npArray.empty() ? objects->npArray[i] : 0),
-                             (!objects->rvArray.empty() ? objects->rvArray[i] : 0),
-                             (!objects->rcadArray.empty() ? objects->rcadArray[i] : 0),
-                             (!objects->rgctArray.empty() ? objects->rgctArray[i] : 0),
-                             (!objects->smo2Array.empty() ? objects->smo2Array[i] : 0),
-                             (!objects->thbArray.empty() ? objects->thbArray[i] : 0),
-                             (!objects->o2hbArray.empty() ? objects->o2hbArray[i] : 0),
-                             (!objects->hhbArray.empty() ? objects->hhbArray[i] : 0),
-                             (!objects->apArray.empty() ? objects->apArray[i] : 0),
-                             (!objects->xpArray.empty() ? objects->xpArray[i] : 0),
-                             (!objects->speedArray.empty() ? objects->speedArray[i] : 0),
-                             (!objects->cadArray.empty() ? objects->cadArray[i] : 0),
-                             (!objects->altArray.empty() ? objects->altArray[i] : 0),
-                             (!objects->tempArray.empty() ? objects->tempArray[i] : 0),
-                             (!objects->windArray.empty() ? objects->windArray[i] : 0),
-                             (!objects->torqueArray.empty() ? objects->torqueArray[i] : 0),
-                             (!objects->balanceArray.empty() ? objects->balanceArray[i] : 0),
-                             (!objects->lteArray.empty() ? objects->lteArray[i] : 0),
-                             (!objects->rteArray.empty() ? objects->rteArray[i] : 0),
-                             (!objects->lpsArray.empty() ? objects->lpsArray[i] : 0),
-                             (!objects->rpsArray.empty() ? objects->rpsArray[i] : 0),
-                             (!objects->lpcoArray.empty() ? objects->lpcoArray[i] : 0),
-                             (!objects->rpcoArray.empty() ? objects->rpcoArray[i] : 0),
-                             (!objects->lppbArray.empty() ? objects->lppbArray[i] : 0),
-                             (!objects->rppbArray.empty() ? objects->rppbArray[i] : 0),
-                             (!objects->lppeArray.empty() ? objects->lppeArray[i] : 0),
-                             (!objects->rppeArray.empty() ? objects->rppeArray[i] : 0),
-                             (!objects->lpppbArray.empty() ? objects->lpppbArray[i] : 0),
-                             (!objects->rpppbArray.empty() ? objects->rpppbArray[i] : 0),
-                             (!objects->lpppeArray.empty() ? objects->lpppeArray[i] : 0),
-                             (!objects->rpppeArray.empty() ? objects->rpppeArray[i] : 0),
-                             (!objects->accelArray.empty() ? objects->accelArray[i] : 0),
-                             (!objects->wattsDArray.empty() ? objects->wattsDArray[i] : 0),
-                             (!objects->cadDArray.empty() ? objects->cadDArray[i] : 0),
-                             (!objects->nmDArray.empty() ? objects->nmDArray[i] : 0),
-                             (!objects->hrDArray.empty() ? objects->hrDArray[i] : 0),
-                             (!objects->slopeArray.empty() ? objects->slopeArray[i] : 0),
-                             (!objects->tcoreArray.empty() ? objects->tcoreArray[i] : 0),
-                            udata);
-
-                // apend to list
-                list.append(dp);
-
-                // maintain totals
-                if (!objects->wattsArray.empty()) totalWatts += objects->wattsArray[i];
-                if (!objects->npArray.empty()) totalNP += objects->npArray[i];
-                if (!objects->rvArray.empty()) totalRV += objects->rvArray[i];
-                if (!objects->rcadArray.empty()) totalRCad += objects->rcadArray[i];
-                if (!objects->rgctArray.empty()) totalRGCT += objects->rgctArray[i];
-                if (!objects->smo2Array.empty()) totalSmO2 += objects->smo2Array[i];
-                if (!objects->thbArray.empty()) totaltHb += objects->thbArray[i];
-                if (!objects->o2hbArray.empty()) totalO2Hb += objects->o2hbArray[i];
-                if (!objects->hhbArray.empty()) totalHHb += objects->hhbArray[i];
-                if (!objects->atissArray.empty()) totalATISS += objects->atissArray[i];
-                if (!objects->antissArray.empty()) totalANTISS += objects->antissArray[i];
-                if (!objects->xpArray.empty()) totalXP += objects->xpArray[i];
-                if (!objects->apArray.empty()) totalAP += objects->apArray[i];
-                if (!objects->tcoreArray.empty()) totalTcore    += objects->tcoreArray[i];
-                if (!objects->hrArray.empty()) totalHr    += objects->hrArray[i];
-                if (!objects->accelArray.empty()) totalAccel += objects->accelArray[i];
-                if (!objects->wattsDArray.empty()) totalWattsD += objects->wattsDArray[i];
-                if (!objects->cadDArray.empty()) totalCadD += objects->cadDArray[i];
-                if (!objects->nmDArray.empty()) totalNmD += objects->nmDArray[i];
-                if (!objects->hrDArray.empty()) totalHrD += objects->hrDArray[i];
-                if (!objects->speedArray.empty()) totalSpeed += objects->speedArray[i];
-                if (!objects->cadArray.empty()) totalCad   += objects->cadArray[i];
-                if (!objects->altArray.empty()) totalAlt   += objects->altArray[i];
-                if (!objects->slopeArray.empty()) totalSlope   += objects->slopeArray[i];
-                if (!objects->windArray.empty()) totalWind   += objects->windArray[i];
-                if (!objects->torqueArray.empty()) totalTorque   += objects->torqueArray[i];
-                if (!objects->tempArray.empty() ) {
-                    if (objects->tempArray[i] == RideFile::NA) {
-                        dp.temp = (i>0 && !list.empty()?list.back().temp:0.0);
-                        totalTemp   += dp.temp;
-                    }
-                    else {
-                        totalTemp   += objects->tempArray[i];
-                    }
-                }
-                if (!objects->balanceArray.empty()) totalBalance   += (objects->balanceArray[i]>0?objects->balanceArray[i]:50);
-                if (!objects->lteArray.empty()) totalLTE   += (objects->lteArray[i]>0?objects->lteArray[i]:0);
-                if (!objects->rteArray.empty()) totalRTE   += (objects->rteArray[i]>0?objects->rteArray[i]:0);
-                if (!objects->lpsArray.empty()) totalLPS   += (objects->lpsArray[i]>0?objects->lpsArray[i]:0);
-                if (!objects->rpsArray.empty()) totalRPS   += (objects->rpsArray[i]>0?objects->rpsArray[i]:0);
-                if (!objects->lpcoArray.empty()) totalLPCO   += objects->lpcoArray[i];
-                if (!objects->rpcoArray.empty()) totalRPCO   += objects->rpcoArray[i];
-                if (!objects->lppbArray.empty()) totalLPPB   += (objects->lppbArray[i]>0?objects->lppbArray[i]:0);
-                if (!objects->rppbArray.empty()) totalRPPB   += (objects->rppbArray[i]>0?objects->rppbArray[i]:0);
-                if (!objects->lppeArray.empty()) totalLPPE   += (objects->lppeArray[i]>0?objects->lppeArray[i]:0);
-                if (!objects->rppeArray.empty()) totalRPPE   += (objects->rppeArray[i]>0?objects->rppeArray[i]:0);
-                if (!objects->lpppbArray.empty()) totalLPPPB   += (objects->lpppbArray[i]>0?objects->lpppbArray[i]:0);
-                if (!objects->rpppbArray.empty()) totalRPPPB   += (objects->rpppbArray[i]>0?objects->rpppbArray[i]:0);
-                if (!objects->lpppeArray.empty()) totalLPPPE   += (objects->lpppeArray[i]>0?objects->lpppeArray[i]:0);
-                if (!objects->rpppeArray.empty()) totalRPPPE   += (objects->rpppeArray[i]>0?objects->rpppeArray[i]:0);
-
-                // set values which must not be smoothed
-                if (!objects->gearArray.empty()) currentGearRatio = (objects->gearArray[i]>0?objects->gearArray[i]:0);
-                totalDist   = objects->distanceArray[i];
-
-                // totalise user data
-                for(int k=0; k<utotals.count(); k++) utotals[k] += udata[k];
-
-                ++i;
-            }
-
-            // remove data from before smoothing duration (er, really?)
-            while (!list.empty() && (list.front().time < secs - applysmooth)) {
-                DataPoint &dp = list.front();
-                totalWatts -= dp.watts;
-                totalNP -= dp.np;
-                totalRV -= dp.rv;
-                totalRCad -= dp.rcad;
-                totalRGCT -= dp.rgct;
-                totalSmO2 -= dp.smo2;
-                totaltHb -= dp.thb;
-                totalO2Hb -= dp.o2hb;
-                totalHHb -= dp.hhb;
-                totalATISS -= dp.atiss;
-                totalANTISS -= dp.antiss;
-                totalAP -= dp.ap;
-                totalXP -= dp.xp;
-                totalHr    -= dp.hr;
-                totalTcore    -= dp.tcore;
-                totalSpeed -= dp.speed;
-                totalAccel -= dp.kphd;
-                totalWattsD -= dp.wattsd;
-                totalCadD -= dp.cadd;
-                totalNmD -= dp.nmd;
-                totalHrD -= dp.hrd;
-                totalCad   -= dp.cad;
-                totalAlt   -= dp.alt;
-                totalSlope -= dp.slope;
-                totalTemp   -= dp.temp;
-                totalWind   -= dp.wind;
-                totalTorque   -= dp.torque;
-                totalLTE   -= dp.lte;
-                totalRTE   -= dp.rte;
-                totalLPS   -= dp.lps;
-                totalRPS   -= dp.rps;
-                totalLPCO  -= dp.lpco;
-                totalRPCO  -= dp.rpco;
-                totalLPPB   -= dp.lppb;
-                totalRPPB   -= dp.rppb;
-                totalLPPE   -= dp.lppe;
-                totalRPPE   -= dp.rppe;
-                totalLPPPB  -= dp.lpppb;
-                totalRPPPB  -= dp.rpppb;
-                totalLPPPE  -= dp.lpppe;
-                totalRPPPE  -= dp.rpppe;
-                totalBalance   -= (dp.lrbalance>0?dp.lrbalance:50);
-                for(int k=0; k<utotals.count(); k++) utotals[k] -= dp.user[k];
-
-                list.removeFirst();
-            }
+        // smoothing a long ride takes a while, the curves are set when ready
+        if (background) {
+            smoothJobs->submit(new AllPlotSmoothJob(*objects, rideTimeSecs, applysmooth, bydist));
 
-            // TODO: this is wrong.  We should do a weighted average over the
-            // seconds represented by each point...
-            if (list.empty()) {
-
-                for (int k=0; k<objects->U.count(); k++) objects->U[k].smooth[secs] = 0.0;
-                objects->smoothWatts[secs] = 0.0;
-                objects->smoothNP[secs] = 0.0;
-                objects->smoothRV[secs] = 0.0;
-                objects->smoothRCad[secs] = 0.0;
-                objects->smoothRGCT[secs] = 0.0;
-                objects->smoothSmO2[secs] = 0.0;
-                objects->smoothtHb[secs] = 0.0;
-                objects->smoothO2Hb[secs] = 0.0;
-                objects->smoothHHb[secs] = 0.0;
-                objects->smoothAT[secs] = 0.0;
-                objects->smoothANT[secs] = 0.0;
-                objects->smoothXP[secs] = 0.0;
-                objects->smoothAP[secs] = 0.0;
-                objects->smoothHr[secs]    = 0.0;
-                objects->smoothTcore[secs]    = 0.0;
-                objects->smoothSpeed[secs] = 0.0;
-                objects->smoothAccel[secs] = 0.0;
-                objects->smoothWattsD[secs] = 0.0;
-                objects->smoothCadD[secs] = 0.0;
-                objects->smoothNmD[secs] = 0.0;
-                objects->smoothHrD[secs] = 0.0;
-                objects->smoothCad[secs]   = 0.0;
-                objects->smoothAltitude[secs]   = ((secs > 0) ? objects->smoothAltitude[secs - 1] : objects->altArray[secs] ) ;
-                objects->smoothSlope[secs]   =  0.0;
-                objects->smoothTemp[secs]   = 0.0;
-                objects->smoothWind[secs] = 0.0;
-                objects->smoothRelSpeed[secs] =  QwtIntervalSample();
-                objects->smoothTorque[secs] = 0.0;
-                objects->smoothLTE[secs] = 0.0;
-                objects->smoothRTE[secs] = 0.0;
-                objects->smoothLPS[secs] = 0.0;
-                objects->smoothRPS[secs] = 0.0;
-                objects->smoothLPCO[secs] = 0.0;
-                objects->smoothRPCO[secs] = 0.0;
-                objects->smoothLPP[secs] = QwtIntervalSample();
-                objects->smoothRPP[secs] = QwtIntervalSample();
-                objects->smoothLPPP[secs] = QwtIntervalSample();
-                objects->smoothRPPP[secs] = QwtIntervalSample();
-                objects->smoothBalanceL[secs] = 50;
-                objects->smoothBalanceR[secs] = 50;
-
-            } else {
-
-                for(int k=0; k<utotals.count(); k++) objects->U[k].smooth[secs] = utotals[k] / list.size();
-                objects->smoothWatts[secs]    = totalWatts / list.size();
-                objects->smoothNP[secs]    = totalNP / list.size();
-                objects->smoothRV[secs]    = totalRV / list.size();
-                objects->smoothRCad[secs]    = totalRCad / list.size();
-                objects->smoothRGCT[secs]    = totalRGCT / list.size();
-                objects->smoothSmO2[secs]    = totalSmO2 / list.size();
-                objects->smoothtHb[secs]    = totaltHb / list.size();
-                objects->smoothO2Hb[secs]    = totalO2Hb / list.size();
-                objects->smoothHHb[secs]    = totalHHb / list.size();
-                objects->smoothAT[secs]    = totalATISS / list.size();
-                objects->smoothANT[secs]    = totalANTISS / list.size();
-                objects->smoothXP[secs]    = totalXP / list.size();
-                objects->smoothAP[secs]    = totalAP / list.size();
-                objects->smoothHr[secs]       = totalHr / list.size();
-                objects->smoothTcore[secs]       = totalTcore / list.size();
-                objects->smoothSpeed[secs]    = totalSpeed / list.size();
-                objects->smoothAccel[secs]    = totalAccel / double(list.size());
-                objects->smoothWattsD[secs]    = totalWattsD / double(list.size());
-                objects->smoothCadD[secs]    = totalCadD / double(list.size());
-                objects->smoothNmD[secs]    = totalNmD / double(list.size());
-                objects->smoothHrD[secs]    = totalHrD / double(list.size());
-                objects->smoothCad[secs]      = totalCad / list.size();
-                objects->smoothAltitude[secs]      = totalAlt / list.size();
-                objects->smoothSlope[secs]      = totalSlope / double(list.size());
-                objects->smoothTemp[secs]      = totalTemp / list.size();
-                objects->smoothWind[secs]    = totalWind / list.size();
-                objects->smoothTorque[secs]    = totalTorque / list.size();
-                objects->smoothRelSpeed[secs] =  QwtIntervalSample(bydist ? totalDist : secs / 60.0, 
-                                                                   QwtInterval(qMin(totalWind / list.size(),
-                                                                   totalSpeed / list.size()), 
-                                                                   qMax(totalWind / list.size(), 
-                                                                   totalSpeed / list.size())));
-
-                // left /right pedal data
-                double balance = totalBalance / list.size();
-                if (balance == 0) {
-                    objects->smoothBalanceL[secs]    = 50;
-                    objects->smoothBalanceR[secs]    = 50;
-                } else if (balance >= 50) {
-                    objects->smoothBalanceL[secs]    = balance;
-                    objects->smoothBalanceR[secs]    = 50;
-                }
-                else {
-                    objects->smoothBalanceL[secs]    = 50;
-                    objects->smoothBalanceR[secs]    = balance;
-                }
-                objects->smoothLTE[secs]    = totalLTE / list.size();
-                objects->smoothRTE[secs]    = totalRTE / list.size();
-                objects->smoothLPS[secs]    = totalLPS / list.size();
-                objects->smoothRPS[secs]    = totalRPS / list.size();
-                objects->smoothLPCO[secs]   = totalLPCO / list.size();
-                objects->smoothRPCO[secs]   = totalRPCO / list.size();
-                objects->smoothLPP[secs]    = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalLPPB / list.size(), totalLPPE / list.size() ) );
-                objects->smoothRPP[secs]    = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalRPPB / list.size(), totalRPPE / list.size() ) );
-                objects->smoothLPPP[secs]   = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalLPPPB / list.size(), totalLPPPE / list.size() ) );
-                objects->smoothRPPP[secs]   = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalRPPPB / list.size(), totalRPPPE / list.size() ) );
-            }
-            objects->smoothGear[secs] = currentGearRatio;
-            objects->smoothDistance[secs] = totalDist;
-            objects->smoothTime[secs]  =  secs / 60.0;
+            // the old ride's values mustn't be read against the new ride
+            clearSmoothed(objects);
+            return true;
         }
+        smoothSeries(objects, rideTimeSecs, applysmooth, bydist);
 
     } else {
 
         // no standard->smoothing .. just raw data
-        for (int k=0; k<objects->U.count(); k++) objects->U[k].smooth.resize(0);
-        objects->smoothWatts.resize(0);
-        objects->smoothNP.resize(0);
-        objects->smoothGear.resize(0);
-        objects->smoothRV.resize(0);
-        objects->smoothRCad.resize(0);
-        objects->smoothRGCT.resize(0);
-        objects->smoothSmO2.resize(0);
-        objects->smoothtHb.resize(0);
-        objects->smoothO2Hb.resize(0);
-        objects->smoothHHb.resize(0);
-        objects->smoothAT.resize(0);
-        objects->smoothANT.resize(0);
-        objects->smoothXP.resize(0);
-        objects->smoothAP.resize(0);
-        objects->smoothHr.resize(0);
-        objects->smoothTcore.resize(0);
-        objects->smoothSpeed.resize(0);
-        objects->smoothAccel.resize(0);
-        objects->smoothWattsD.resize(0);
-        objects->smoothCadD.resize(0);
-        objects->smoothNmD.resize(0);
-        objects->smoothHrD.resize(0);
-        objects->smoothCad.resize(0);
-        objects->smoothTime.resize(0);
-        objects->smoothDistance.resize(0);
-        objects->smoothAltitude.resize(0);
-        objects->smoothSlope.resize(0);
-        objects->smoothTemp.resize(0);
-        objects->smoothWind.resize(0);
-        objects->smoothRelSpeed.resize(0);
-        objects->smoothTorque.resize(0);
-        objects->smoothLTE.resize(0);
-        objects->smoothRTE.resize(0);
-        objects->smoothLPS.resize(0);
-        objects->smoothRPS.resize(0);
-        objects->smoothLPCO.resize(0);
-        objects->smoothRPCO.resize(0);
-        objects->smoothLPP.resize(0);
-        objects->smoothRPP.resize(0);
-        objects->smoothLPPP.resize(0);
-        objects->smoothRPPP.resize(0);
-        objects->smoothBalanceL.resize(0);
-        objects->smoothBalanceR.resize(0);
+        clearSmoothed(objects);
 
         // fill with raw data
         for (int k=0; k<objects->U.count(); k++) objects->U[k].smooth = objects->U[k].array;
@@ -2325,6 +2381,14 @@ AllPlot::recalc(AllPlotObject *objects)
         }
     }
 
+    plotSmoothed(objects, applysmooth);
+    return false;
+}
+
+// the second half of recalc(), set the curves from the smoothed arrays
+void
+AllPlot::plotSmoothed(AllPlotObject *objects, int applysmooth)
+{
     QVector<double> &xaxis = bydist ? objects->smoothDistance : objects->smoothTime;
     int startingIndex = qMin(smooth, xaxis.count());
     int totalPoints = xaxis.count() - startingIndex;
@@ -2366,112 +2430,112 @@ AllPlot::recalc(AllPlotObject *objects)
     // set curve.
     for(int k=0; k<objects->U.count(); k++) {
         if (!objects->U[k].array.empty()) {
-            objects->U[k].curve->setSamples(xaxis.data() + startingIndex, objects->U[k].smooth.data() + startingIndex, totalPoints);
+            objects->U[k].curve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->U[k].smooth.data() + startingIndex, totalPoints));
         }
     }
 
     if (!objects->wattsArray.empty()) {
-        objects->wattsCurve->setSamples(xaxis.data() + startingIndex, objects->smoothWatts.data() + startingIndex, totalPoints);
+        objects->wattsCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothWatts.data() + startingIndex, totalPoints));
     }
 
     if (!objects->antissArray.empty()) {
-        objects->antissCurve->setSamples(xaxis.data() + startingIndex, objects->smoothANT.data() + startingIndex, totalPoints);
+        objects->antissCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothANT.data() + startingIndex, totalPoints));
     }
 
     if (!objects->atissArray.empty()) {
-        objects->atissCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAT.data() + startingIndex, totalPoints);
+        objects->atissCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothAT.data() + startingIndex, totalPoints));
     }
 
     if (!objects->rvArray.empty()) {
-        objects->rvCurve->setSamples(xaxis.data() + startingIndex, objects->smoothRV.data() + startingIndex, totalPoints);
+        objects->rvCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothRV.data() + startingIndex, totalPoints));
     }
 
     if (!objects->rcadArray.empty()) {
-        objects->rcadCurve->setSamples(xaxis.data() + startingIndex, objects->smoothRCad.data() + startingIndex, totalPoints);
+        objects->rcadCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothRCad.data() + startingIndex, totalPoints));
     }
 
     if (!objects->rgctArray.empty()) {
-        objects->rgctCurve->setSamples(xaxis.data() + startingIndex, objects->smoothRGCT.data() + startingIndex, totalPoints);
+        objects->rgctCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothRGCT.data() + startingIndex, totalPoints));
     }
 
     if (!objects->gearArray.empty()) {
-        objects->gearCurve->setSamples(xaxis.data() + startingIndex, objects->smoothGear.data() + startingIndex, totalPoints);
+        objects->gearCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothGear.data() + startingIndex, totalPoints));
     }
 
     if (!objects->smo2Array.empty()) {
-        objects->smo2Curve->setSamples(xaxis.data() + startingIndex, objects->smoothSmO2.data() + startingIndex, totalPoints);
+        objects->smo2Curve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothSmO2.data() + startingIndex, totalPoints));
     }
 
     if (!objects->thbArray.empty()) {
-        objects->thbCurve->setSamples(xaxis.data() + startingIndex, objects->smoothtHb.data() + startingIndex, totalPoints);
+        objects->thbCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothtHb.data() + startingIndex, totalPoints));
     }
 
     if (!objects->o2hbArray.empty()) {
-        objects->o2hbCurve->setSamples(xaxis.data() + startingIndex, objects->smoothO2Hb.data() + startingIndex, totalPoints);
+        objects->o2hbCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothO2Hb.data() + startingIndex, totalPoints));
     }
 
     if (!objects->hhbArray.empty()) {
-        objects->hhbCurve->setSamples(xaxis.data() + startingIndex, objects->smoothHHb.data() + startingIndex, totalPoints);
+        objects->hhbCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothHHb.data() + startingIndex, totalPoints));
     }
 
     if (!objects->npArray.empty()) {
-        objects->npCurve->setSamples(xaxis.data() + startingIndex, objects->smoothNP.data() + startingIndex, totalPoints);
+        objects->npCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothNP.data() + startingIndex, totalPoints));
     }
 
     if (!objects->xpArray.empty()) {
-        objects->xpCurve->setSamples(xaxis.data() + startingIndex, objects->smoothXP.data() + startingIndex, totalPoints);
+        objects->xpCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothXP.data() + startingIndex, totalPoints));
     }
 
     if (!objects->apArray.empty()) {
-        objects->apCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAP.data() + startingIndex, totalPoints);
+        objects->apCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothAP.data() + startingIndex, totalPoints));
     }
 
     if (!objects->hrArray.empty()) {
-        objects->hrCurve->setSamples(xaxis.data() + startingIndex, objects->smoothHr.data() + startingIndex, totalPoints);
+        objects->hrCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothHr.data() + startingIndex, totalPoints));
     }
 
     if (!objects->tcoreArray.empty()) {
-        objects->tcoreCurve->setSamples(xaxis.data() + startingIndex, objects->smoothTcore.data() + startingIndex, totalPoints);
+        objects->tcoreCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothTcore.data() + startingIndex, totalPoints));
     }
 
     if (!objects->speedArray.empty()) {
-        objects->speedCurve->setSamples(xaxis.data() + startingIndex, objects->smoothSpeed.data() + startingIndex, totalPoints);
+        objects->speedCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothSpeed.data() + startingIndex, totalPoints));
     }
 
     if (!objects->accelArray.empty()) {
-        objects->accelCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAccel.data() + startingIndex, totalPoints);
+        objects->accelCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothAccel.data() + startingIndex, totalPoints));
     }
 
     if (!objects->wattsDArray.empty()) {
-        objects->wattsDCurve->setSamples(xaxis.data() + startingIndex, objects->smoothWattsD.data() + startingIndex, totalPoints);
+        objects->wattsDCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothWattsD.data() + startingIndex, totalPoints));
     }
 
     if (!objects->cadDArray.empty()) {
-        objects->cadDCurve->setSamples(xaxis.data() + startingIndex, objects->smoothCadD.data() + startingIndex, totalPoints);
+        objects->cadDCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothCadD.data() + startingIndex, totalPoints));
     }
 
     if (!objects->nmDArray.empty()) {
-        objects->nmDCurve->setSamples(xaxis.data() + startingIndex, objects->smoothNmD.data() + startingIndex, totalPoints);
+        objects->nmDCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothNmD.data() + startingIndex, totalPoints));
     }
 
     if (!objects->hrDArray.empty()) {
-        objects->hrDCurve->setSamples(xaxis.data() + startingIndex, objects->smoothHrD.data() + startingIndex, totalPoints);
+        objects->hrDCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothHrD.data() + startingIndex, totalPoints));
     }
 
     if (!objects->cadArray.empty()) {
-        objects->cadCurve->setSamples(xaxis.data() + startingIndex, objects->smoothCad.data() + startingIndex, totalPoints);
+        objects->cadCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothCad.data() + startingIndex, totalPoints));
     }
 
     if (!objects->altArray.empty()) {
-        objects->altCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAltitude.data() + startingIndex, totalPoints);
+        objects->altCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothAltitude.data() + startingIndex, totalPoints));
         objects->altSlopeCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAltitude.data() + startingIndex, totalPoints);
     }
     if (!objects->slopeArray.empty()) {
-        objects->slopeCurve->setSamples(xaxis.data() + startingIndex, objects->smoothSlope.data() + startingIndex, totalPoints);
+        objects->slopeCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothSlope.data() + startingIndex, totalPoints));
     }
 
     if (!objects->tempArray.empty()) {
-        objects->tempCurve->setSamples(xaxis.data() + startingIndex, objects->smoothTemp.data() + startingIndex, totalPoints);
+        objects->tempCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothTemp.data() + startingIndex, totalPoints));
     }
 
 
@@ -2480,29 +2544,29 @@ AllPlot::recalc(AllPlotObject *objects)
     }
 
     if (!objects->torqueArray.empty()) {
-        objects->torqueCurve->setSamples(xaxis.data() + startingIndex, objects->smoothTorque.data() + startingIndex, totalPoints);
+        objects->torqueCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, objects->smoothTorque.data() + startingIndex, totalPoints));
     }
 
     // left/right pedals
     if (!objects->balanceArray.empty()) {
-        objects->balanceLCurve->setSamples(xaxis.data() + startingIndex, 
-                                           objects->smoothBalanceL.data() + startingIndex, totalPoints);
-        objects->balanceRCurve->setSamples(xaxis.data() + startingIndex, 
-                                           objects->smoothBalanceR.data() + startingIndex, totalPoints);
-    }
-    if (!objects->lteArray.empty()) objects->lteCurve->setSamples(xaxis.data() + startingIndex, 
-                                             objects->smoothLTE.data() + startingIndex, totalPoints);
-    if (!objects->rteArray.empty()) objects->rteCurve->setSamples(xaxis.data() + startingIndex, 
-                                             objects->smoothRTE.data() + startingIndex, totalPoints);
-    if (!objects->lpsArray.empty()) objects->lpsCurve->setSamples(xaxis.data() + startingIndex, 
-                                             objects->smoothLPS.data() + startingIndex, totalPoints);
-    if (!objects->rpsArray.empty()) objects->rpsCurve->setSamples(xaxis.data() + startingIndex, 
-                                             objects->smoothRPS.data() + startingIndex, totalPoints);
-
-    if (!objects->lpcoArray.empty()) objects->lpcoCurve->setSamples(xaxis.data() + startingIndex,
-                                             objects->smoothLPCO.data() + startingIndex, totalPoints);
-    if (!objects->rpcoArray.empty()) objects->rpcoCurve->setSamples(xaxis.data() + startingIndex,
-                                             objects->smoothRPCO.data() + startingIndex, totalPoints);
+        objects->balanceLCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, 
+                                           objects->smoothBalanceL.data() + startingIndex, totalPoints));
+        objects->balanceRCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, 
+                                           objects->smoothBalanceR.data() + startingIndex, totalPoints));
+    }
+    if (!objects->lteArray.empty()) objects->lteCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, 
+                                             objects->smoothLTE.data() + startingIndex, totalPoints));
+    if (!objects->rteArray.empty()) objects->rteCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, 
+                                             objects->smoothRTE.data() + startingIndex, totalPoints));
+    if (!objects->lpsArray.empty()) objects->lpsCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, 
+                                             objects->smoothLPS.data() + startingIndex, totalPoints));
+    if (!objects->rpsArray.empty()) objects->rpsCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex, 
+                                             objects->smoothRPS.data() + startingIndex, totalPoints));
+
+    if (!objects->lpcoArray.empty()) objects->lpcoCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex,
+                                             objects->smoothLPCO.data() + startingIndex, totalPoints));
+    if (!objects->rpcoArray.empty()) objects->rpcoCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data() + startingIndex,
+                                             objects->smoothRPCO.data() + startingIndex, totalPoints));
     if (!objects->lppbArray.empty()) {
         objects->lppCurve->setSamples(new QwtIntervalSeriesData(objects->smoothLPP));
     }
@@ -2534,6 +2598,20 @@ AllPlot::recalc(AllPlotObject *objects)
     replot();
 }
 
+// the smoothing recalc() asked for in the background, set the curves
+void
+AllPlot::smoothingReady(ChartDataJob *job)
+{
+    // the ride went away whilst we were at it
+    if (!rideItem || !rideItem->ride()) return;
+
+    AllPlotSmoothJob *smoothed = static_cast<AllPlotSmoothJob*>(job);
+    static_cast<AllPlotArrays&>(*standard) = smoothed->arrays;
+    plotSmoothed(standard, smoothed->applysmooth);
+
+    emit recalculated();
+}
+
 void
 AllPlot::refreshIntervalMarkers()
 {
@@ -3357,50 +3435,50 @@ AllPlot::setDataFromPlot(AllPlot *plot, int startidx, int stopidx)
         setMatchLabels(standard);
     }
     int points = stopidx - startidx + 1; // e.g. 10 to 12 is 3 points 10,11,12, so not 12-10 !
-    for(int k=0; k<standard->U.count(); k++) standard->U[k].curve->setSamples(xaxis,smoothU[k], points);
+    for(int k=0; k<standard->U.count(); k++) standard->U[k].curve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothU[k], points));
     standard->hrvCurve->setSamples(plot->standard->smoothHrv_time.data(),
                    plot->standard->smoothHrv.data(),
                    plot->standard->smoothHrv.count());
-    standard->wattsCurve->setSamples(xaxis,smoothW,points);
-    standard->atissCurve->setSamples(xaxis,smoothAT,points);
-    standard->antissCurve->setSamples(xaxis,smoothANT,points);
-    standard->npCurve->setSamples(xaxis,smoothN,points);
-    standard->rvCurve->setSamples(xaxis,smoothRV,points);
-    standard->rcadCurve->setSamples(xaxis,smoothRCad,points);
-    standard->rgctCurve->setSamples(xaxis,smoothRGCT,points);
-    standard->gearCurve->setSamples(xaxis,smoothGear,points);
-    standard->smo2Curve->setSamples(xaxis,smoothSmO2,points);
-    standard->thbCurve->setSamples(xaxis,smoothtHb,points);
-    standard->o2hbCurve->setSamples(xaxis,smoothO2Hb,points);
-    standard->hhbCurve->setSamples(xaxis,smoothHHb,points);
-    standard->xpCurve->setSamples(xaxis,smoothX,points);
-    standard->apCurve->setSamples(xaxis,smoothL,points);
-    standard->hrCurve->setSamples(xaxis, smoothHR,points);
-    standard->tcoreCurve->setSamples(xaxis, smoothTCORE,points);
-    standard->speedCurve->setSamples(xaxis, smoothS, points);
-    standard->accelCurve->setSamples(xaxis, smoothAC, points);
-    standard->wattsDCurve->setSamples(xaxis, smoothWD, points);
-    standard->cadDCurve->setSamples(xaxis, smoothCD, points);
-    standard->nmDCurve->setSamples(xaxis, smoothND, points);
-    standard->hrDCurve->setSamples(xaxis, smoothHD, points);
-    standard->cadCurve->setSamples(xaxis, smoothC, points);
-    standard->altCurve->setSamples(xaxis, smoothA, points);
+    standard->wattsCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothW, points));
+    standard->atissCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothAT, points));
+    standard->antissCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothANT, points));
+    standard->npCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothN, points));
+    standard->rvCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothRV, points));
+    standard->rcadCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothRCad, points));
+    standard->rgctCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothRGCT, points));
+    standard->gearCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothGear, points));
+    standard->smo2Curve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothSmO2, points));
+    standard->thbCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothtHb, points));
+    standard->o2hbCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothO2Hb, points));
+    standard->hhbCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothHHb, points));
+    standard->xpCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothX, points));
+    standard->apCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothL, points));
+    standard->hrCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothHR, points));
+    standard->tcoreCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothTCORE, points));
+    standard->speedCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothS, points));
+    standard->accelCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothAC, points));
+    standard->wattsDCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothWD, points));
+    standard->cadDCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothCD, points));
+    standard->nmDCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothND, points));
+    standard->hrDCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothHD, points));
+    standard->cadCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothC, points));
+    standard->altCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothA, points));
     standard->altSlopeCurve->setSamples(xaxis, smoothA, points);
-    standard->slopeCurve->setSamples(xaxis, smoothSL, points);
-    standard->tempCurve->setSamples(xaxis, smoothTE, points);
+    standard->slopeCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothSL, points));
+    standard->tempCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothTE, points));
 
     QVector<QwtIntervalSample> tmpWND(points);
     memcpy(tmpWND.data(), smoothRS, (points) * sizeof(QwtIntervalSample));
     standard->windCurve->setSamples(new QwtIntervalSeriesData(tmpWND));
-    standard->torqueCurve->setSamples(xaxis, smoothNM, points);
-    standard->balanceLCurve->setSamples(xaxis, smoothBALL, points);
-    standard->balanceRCurve->setSamples(xaxis, smoothBALR, points);
-    standard->lteCurve->setSamples(xaxis, smoothLTE, points);
-    standard->rteCurve->setSamples(xaxis, smoothRTE, points);
-    standard->lpsCurve->setSamples(xaxis, smoothLPS, points);
-    standard->rpsCurve->setSamples(xaxis, smoothRPS, points);
-    standard->lpcoCurve->setSamples(xaxis, smoothLPCO, points);
-    standard->rpcoCurve->setSamples(xaxis, smoothRPCO, points);
+    standard->torqueCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothNM, points));
+    standard->balanceLCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothBALL, points));
+    standard->balanceRCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothBALR, points));
+    standard->lteCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothLTE, points));
+    standard->rteCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothRTE, points));
+    standard->lpsCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothLPS, points));
+    standard->rpsCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothRPS, points));
+    standard->lpcoCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothLPCO, points));
+    standard->rpcoCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis, smoothRPCO, points));
 
     QVector<QwtIntervalSample> tmpLDC(points);
     memcpy(tmpLDC.data(), smoothLPP, (points) * sizeof(QwtIntervalSample));
@@ -4093,8 +4171,7 @@ AllPlot::setDataFromPlot(AllPlot *plot)
             ourCurve->attach(this);
 
             // lets clone the data
-            QVector<QPointF> array;
-            for (size_t i=0; i<thereCurve->data()->size(); i++) array << thereCurve->data()->sample(i);
+            QVector<QPointF> array = AllPlotSeriesData::samples(thereCurve->data());
 
             ourCurve->setSamples(array);
             ourCurve->setYAxis(yLeft);
@@ -4122,8 +4199,7 @@ AllPlot::setDataFromPlot(AllPlot *plot)
             ourCurve2->attach(this);
 
             // lets clone the data
-            QVector<QPointF> array;
-            for (size_t i=0; i<thereCurve2->data()->size(); i++) array << thereCurve2->data()->sample(i);
+            QVector<QPointF> array = AllPlotSeriesData::samples(thereCurve2->data());
 
             ourCurve2->setSamples(array);
             ourCurve2->setYAxis(yLeft);
@@ -4163,8 +4239,7 @@ AllPlot::setDataFromPlot(AllPlot *plot)
             ourASCurve->attach(this);
 
             // lets clone the data
-            QVector<QPointF> array;
-            for (size_t i=0; i<thereASCurve->data()->size(); i++) array << thereASCurve->data()->sample(i);
+            QVector<QPointF> array = AllPlotSeriesData::samples(thereASCurve->data());
 
             ourASCurve->setSamples(array);
             ourASCurve->setYAxis(yLeft);
@@ -4194,9 +4269,9 @@ AllPlot::setDataFromPlot(AllPlot *plot)
 
             // minimum non-zero value... worst case its zero !
             double minNZ = 0.00f;
-            for (size_t i=0; i<thereCurve->data()->size(); i++) {
-                if (!minNZ) minNZ = thereCurve->data()->sample(i).y();
-                else if (thereCurve->data()->sample(i).y()<minNZ) minNZ = thereCurve->data()->sample(i).y();
+            foreach(QPointF point, AllPlotSeriesData::samples(thereCurve->data())) {
+                if (!minNZ) minNZ = point.y();
+                else if (point.y()<minNZ) minNZ = point.y();
             }
             setAxisScale(QwtPlot::yLeft, minNZ, thereCurve->maxYValue() + 0.10f);
 
@@ -4856,9 +4931,9 @@ AllPlot::setDataFromPlots(QList<AllPlot *> plots)
 
                     // lets clone the data
                     QVector<double> x,y;
-                    for (size_t i=0; i<thereCurve->data()->size(); i++) {
-                        x << thereCurve->data()->sample(i).x();
-                        y << thereCurve->data()->sample(i).y();
+                    foreach(QPointF point, AllPlotSeriesData::samples(thereCurve->data())) {
+                        x << point.x();
+                        y << point.y();
                     }
 
                     ourCurve->setSamples(x,y);
@@ -4896,8 +4971,7 @@ AllPlot::setDataFromPlots(QList<AllPlot *> plots)
                     ourCurve2->setPen(pen);
 
                     // lets clone the data
-                    QVector<QPointF> array;
-                    for (size_t i=0; i<thereCurve2->data()->size(); i++) array << thereCurve2->data()->sample(i);
+                    QVector<QPointF> array = AllPlotSeriesData::samples(thereCurve2->data());
 
                     ourCurve2->setSamples(array);
                     ourCurve2->setYAxis(yLeft);
@@ -4955,8 +5029,7 @@ AllPlot::setDataFromPlots(QList<AllPlot *> plots)
                     ourASCurve->attach(this);
 
                     // lets clone the data
-                    QVector<QPointF> array;
-                    for (size_t i=0; i<thereASCurve->data()->size(); i++) array << thereASCurve->data()->sample(i);
+                    QVector<QPointF> array = AllPlotSeriesData::samples(thereASCurve->data());
 
                     ourASCurve->setSamples(array);
                     ourASCurve->setYAxis(yLeft);
@@ -5149,152 +5222,152 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
 
         if (!object->U[k].smooth.empty()) {
 
-            standard->U[k].curve->setSamples(xaxis.data(), object->U[k].smooth.data(), totalPoints);
+            standard->U[k].curve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->U[k].smooth.data(), totalPoints));
             standard->U[k].curve->attach(this);
             standard->U[k].curve->setVisible(true);
         }
     }
 
     if (!object->wattsArray.empty()) {
-        standard->wattsCurve->setSamples(xaxis.data(), object->smoothWatts.data(), totalPoints);
+        standard->wattsCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothWatts.data(), totalPoints));
         standard->wattsCurve->attach(this);
         standard->wattsCurve->setVisible(true);
     }
 
     if (!object->antissArray.empty()) {
-        standard->antissCurve->setSamples(xaxis.data(), object->smoothANT.data(), totalPoints);
+        standard->antissCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothANT.data(), totalPoints));
         standard->antissCurve->attach(this);
         standard->antissCurve->setVisible(true);
     }
 
     if (!object->atissArray.empty()) {
-        standard->atissCurve->setSamples(xaxis.data(), object->smoothAT.data(), totalPoints);
+        standard->atissCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothAT.data(), totalPoints));
         standard->atissCurve->attach(this);
         standard->atissCurve->setVisible(true);
     }
 
     if (!object->npArray.empty()) {
-        standard->npCurve->setSamples(xaxis.data(), object->smoothNP.data(), totalPoints);
+        standard->npCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothNP.data(), totalPoints));
         standard->npCurve->attach(this);
         standard->npCurve->setVisible(true);
     }
 
     if (!object->rvArray.empty()) {
-        standard->rvCurve->setSamples(xaxis.data(), object->smoothRV.data(), totalPoints);
+        standard->rvCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothRV.data(), totalPoints));
         standard->rvCurve->attach(this);
         standard->rvCurve->setVisible(true);
     }
 
     if (!object->rcadArray.empty()) {
-        standard->rcadCurve->setSamples(xaxis.data(), object->smoothRCad.data(), totalPoints);
+        standard->rcadCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothRCad.data(), totalPoints));
         standard->rcadCurve->attach(this);
         standard->rcadCurve->setVisible(true);
     }
 
     if (!object->rgctArray.empty()) {
-        standard->rgctCurve->setSamples(xaxis.data(), object->smoothRGCT.data(), totalPoints);
+        standard->rgctCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothRGCT.data(), totalPoints));
         standard->rgctCurve->attach(this);
         standard->rgctCurve->setVisible(true);
     }
 
     if (!object->gearArray.empty()) {
-        standard->gearCurve->setSamples(xaxis.data(), object->smoothGear.data(), totalPoints);
+        standard->gearCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothGear.data(), totalPoints));
         standard->gearCurve->attach(this);
         standard->gearCurve->setVisible(true);
     }
 
     if (!object->smo2Array.empty()) {
-        standard->smo2Curve->setSamples(xaxis.data(), object->smoothSmO2.data(), totalPoints);
+        standard->smo2Curve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothSmO2.data(), totalPoints));
         standard->smo2Curve->attach(this);
         standard->smo2Curve->setVisible(true);
     }
 
     if (!object->thbArray.empty()) {
-        standard->thbCurve->setSamples(xaxis.data(), object->smoothtHb.data(), totalPoints);
+        standard->thbCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothtHb.data(), totalPoints));
         standard->thbCurve->attach(this);
         standard->thbCurve->setVisible(true);
     }
 
     if (!object->o2hbArray.empty()) {
-        standard->o2hbCurve->setSamples(xaxis.data(), object->smoothO2Hb.data(), totalPoints);
+        standard->o2hbCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothO2Hb.data(), totalPoints));
         standard->o2hbCurve->attach(this);
         standard->o2hbCurve->setVisible(true);
     }
 
     if (!object->hhbArray.empty()) {
-        standard->hhbCurve->setSamples(xaxis.data(), object->smoothHHb.data(), totalPoints);
+        standard->hhbCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothHHb.data(), totalPoints));
         standard->hhbCurve->attach(this);
         standard->hhbCurve->setVisible(true);
     }
 
     if (!object->xpArray.empty()) {
-        standard->xpCurve->setSamples(xaxis.data(), object->smoothXP.data(), totalPoints);
+        standard->xpCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothXP.data(), totalPoints));
         standard->xpCurve->attach(this);
         standard->xpCurve->setVisible(true);
     }
 
     if (!object->apArray.empty()) {
-        standard->apCurve->setSamples(xaxis.data(), object->smoothAP.data(), totalPoints);
+        standard->apCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothAP.data(), totalPoints));
         standard->apCurve->attach(this);
         standard->apCurve->setVisible(true);
     }
 
     if (!object->tcoreArray.empty()) {
-        standard->tcoreCurve->setSamples(xaxis.data(), object->smoothTcore.data(), totalPoints);
+        standard->tcoreCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothTcore.data(), totalPoints));
         standard->tcoreCurve->attach(this);
         standard->tcoreCurve->setVisible(true);
     }
 
     if (!object->hrArray.empty()) {
-        standard->hrCurve->setSamples(xaxis.data(), object->smoothHr.data(), totalPoints);
+        standard->hrCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothHr.data(), totalPoints));
         standard->hrCurve->attach(this);
         standard->hrCurve->setVisible(true);
     }
 
     if (!object->speedArray.empty()) {
-        standard->speedCurve->setSamples(xaxis.data(), object->smoothSpeed.data(), totalPoints);
+        standard->speedCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothSpeed.data(), totalPoints));
         standard->speedCurve->attach(this);
         standard->speedCurve->setVisible(true);
     }
 
     if (!object->accelArray.empty()) {
-        standard->accelCurve->setSamples(xaxis.data(), object->smoothAccel.data(), totalPoints);
+        standard->accelCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothAccel.data(), totalPoints));
         standard->accelCurve->attach(this);
         standard->accelCurve->setVisible(true);
     }
 
     if (!object->wattsDArray.empty()) {
-        standard->wattsDCurve->setSamples(xaxis.data(), object->smoothWattsD.data(), totalPoints);
+        standard->wattsDCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothWattsD.data(), totalPoints));
         standard->wattsDCurve->attach(this);
         standard->wattsDCurve->setVisible(true);
     }
 
     if (!object->cadDArray.empty()) {
-        standard->cadDCurve->setSamples(xaxis.data(), object->smoothCadD.data(), totalPoints);
+        standard->cadDCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothCadD.data(), totalPoints));
         standard->cadDCurve->attach(this);
         standard->cadDCurve->setVisible(true);
     }
 
     if (!object->nmDArray.empty()) {
-        standard->nmDCurve->setSamples(xaxis.data(), object->smoothNmD.data(), totalPoints);
+        standard->nmDCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothNmD.data(), totalPoints));
         standard->nmDCurve->attach(this);
         standard->nmDCurve->setVisible(true);
     }
 
     if (!object->hrDArray.empty()) {
-        standard->hrDCurve->setSamples(xaxis.data(), object->smoothHrD.data(), totalPoints);
+        standard->hrDCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothHrD.data(), totalPoints));
         standard->hrDCurve->attach(this);
         standard->hrDCurve->setVisible(true);
     }
 
     if (!object->cadArray.empty()) {
-        standard->cadCurve->setSamples(xaxis.data(), object->smoothCad.data(), totalPoints);
+        standard->cadCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothCad.data(), totalPoints));
         standard->cadCurve->attach(this);
         standard->cadCurve->setVisible(true);
     }
 
     if (!object->altArray.empty()) {
-        standard->altCurve->setSamples(xaxis.data(), object->smoothAltitude.data(), totalPoints);
+        standard->altCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothAltitude.data(), totalPoints));
         standard->altCurve->attach(this);
         standard->altCurve->setVisible(true);
         standard->altSlopeCurve->setSamples(xaxis.data(), object->smoothAltitude.data(), totalPoints);
@@ -5303,13 +5376,13 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->slopeArray.empty()) {
-        standard->slopeCurve->setSamples(xaxis.data(), object->smoothSlope.data(), totalPoints);
+        standard->slopeCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothSlope.data(), totalPoints));
         standard->slopeCurve->attach(this);
         standard->slopeCurve->setVisible(true);
     }
 
     if (!object->tempArray.empty()) {
-        standard->tempCurve->setSamples(xaxis.data(), object->smoothTemp.data(), totalPoints);
+        standard->tempCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothTemp.data(), totalPoints));
         standard->tempCurve->attach(this);
         standard->tempCurve->setVisible(true);
     }
@@ -5322,14 +5395,14 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->torqueArray.empty()) {
-        standard->torqueCurve->setSamples(xaxis.data(), object->smoothTorque.data(), totalPoints);
+        standard->torqueCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothTorque.data(), totalPoints));
         standard->torqueCurve->attach(this);
         standard->torqueCurve->setVisible(true);
     }
 
     if (!object->balanceArray.empty()) {
-        standard->balanceLCurve->setSamples(xaxis.data(), object->smoothBalanceL.data(), totalPoints);
-        standard->balanceRCurve->setSamples(xaxis.data(), object->smoothBalanceR.data(), totalPoints);
+        standard->balanceLCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothBalanceL.data(), totalPoints));
+        standard->balanceRCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothBalanceR.data(), totalPoints));
         standard->balanceLCurve->attach(this);
         standard->balanceLCurve->setVisible(true);
         standard->balanceRCurve->attach(this);
@@ -5337,8 +5410,8 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->lteArray.empty()) {
-        standard->lteCurve->setSamples(xaxis.data(), object->smoothLTE.data(), totalPoints);
-        standard->rteCurve->setSamples(xaxis.data(), object->smoothRTE.data(), totalPoints);
+        standard->lteCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothLTE.data(), totalPoints));
+        standard->rteCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothRTE.data(), totalPoints));
         standard->lteCurve->attach(this);
         standard->lteCurve->setVisible(true);
         standard->rteCurve->attach(this);
@@ -5346,8 +5419,8 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->lpsArray.empty()) {
-        standard->lpsCurve->setSamples(xaxis.data(), object->smoothLPS.data(), totalPoints);
-        standard->rpsCurve->setSamples(xaxis.data(), object->smoothRPS.data(), totalPoints);
+        standard->lpsCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothLPS.data(), totalPoints));
+        standard->rpsCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothRPS.data(), totalPoints));
         standard->lpsCurve->attach(this);
         standard->lpsCurve->setVisible(true);
         standard->rpsCurve->attach(this);
@@ -5355,8 +5428,8 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->lpcoArray.empty()) {
-        standard->lpcoCurve->setSamples(xaxis.data(), object->smoothLPCO.data(), totalPoints);
-        standard->rpcoCurve->setSamples(xaxis.data(), object->smoothRPCO.data(), totalPoints);
+        standard->lpcoCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothLPCO.data(), totalPoints));
+        standard->rpcoCurve->setSamples(new AllPlotSeriesData(canvas(), xaxis.data(), object->smoothRPCO.data(), totalPoints));
         standard->lpcoCurve->attach(this);
         standard->lpcoCurve->setVisible(true);
         standard->rpcoCurve->attach(this);
@@ -5462,8 +5535,11 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
 }
 
 void
-AllPlot::setDataFromRide(RideItem *_rideItem, QList<UserData*>user)
+AllPlot::setDataFromRide(RideItem *_rideItem, QList<UserData*>user, bool background)
 {
+    // whatever we were smoothing is no longer wanted
+    smoothJobs->cancel();
+
     rideItem = _rideItem;
     if (_rideItem == NULL) return;
 
@@ -5474,7 +5550,7 @@ AllPlot::setDataFromRide(RideItem *_rideItem, QList<UserData*>user)
     //standard->wattsArray.clear();
     //standard->curveTitle.setLabel(QwtText(QString(""), QwtText::PlainText)); // default to no title
 
-    setDataFromRideFile(rideItem->ride(), standard, user);
+    setDataFromRideFile(rideItem->ride(), standard, user, background);
 
     // remember the curves and colors
     isolation = false;
@@ -5482,7 +5558,7 @@ AllPlot::setDataFromRide(RideItem *_rideItem, QList<UserData*>user)
 }
 
 void
-AllPlot::setDataFromRideFile(RideFile *ride, AllPlotObject *here, QList<UserData*>user)
+AllPlot::setDataFromRideFile(RideFile *ride, AllPlotObject *here, QList<UserData*>user, bool background)
 {
     if (ride && ride->dataPoints().size()) {
         const RideFileDataPresent *dataPresent = ride->areDataPresent();
@@ -5798,7 +5874,7 @@ AllPlot::setDataFromRideFile(RideFile *ride, AllPlotObject *here, QList<UserData
                                                : point->nm * FEET_LB_PER_NM));
             ++arrayLength;
         }
-        recalc(here);
+        recalc(here, background);
 
     }
     else {
@@ -5863,6 +5939,9 @@ AllPlot::setDataFromRideFile(RideFile *ride, AllPlotObject *here, QList<UserData
             delete referenceLine;
         }
         here->referenceLines.clear();
+
+        // nothing to smooth, but the caller is still waiting
+        if (background) emit recalculated();
     }
 
     // record the max x value
@@ -47,6 +47,7 @@
 
 #include "UserData.h"
 #include "RideFile.h"
+#include "ChartDataJob.h"
 
 class QwtPlotCurve;
 class QwtPlotGappedCurve;
@@ -351,95 +352,12 @@ struct UserObject {
     QColor          color;
 };
 
-class AllPlot;
-class MergeAdjust;
-class AllPlotObject : public QObject
-{
-    Q_OBJECT;
-
-    // one set for every ride being plotted, which
-    // as standard is just one, its only when we start
-    // compare mode that we get more...
-
-    public:
-
-    AllPlotObject(AllPlot*, QList<UserData*>); // construct associate with a plot
-    ~AllPlotObject(); // delete and disassociate from a plot
-
-    void setVisible(bool); // show or hide objects
-    void setColor(QColor color); // set ALL curves the same color
-    void hideUnwanted(); // hide curves we are not interested in
-                         // using setVisible ...
-
-    QwtPlotGrid *grid;
-    QVector<QwtPlotMarker*> d_mrk;
-    QVector<QwtPlotMarker*> cal_mrk;
-    QwtPlotMarker curveTitle;
-    QwtPlotMarker *allMarker1;
-    QwtPlotMarker *allMarker2;
-
-    // reference lines
-    QVector<QwtPlotCurve*> referenceLines;
-    QVector<QwtPlotCurve*> tmpReferenceLines;
-
-    // points of exhaustion
-    QVector<QwtPlotMarker*> exhaustionLines;
-    QVector<QwtPlotMarker*> tmpExhaustionLines;
-
-    QwtPlotCurve *wattsCurve;
-    QwtPlotCurve *slopeCurve;
-    AllPlotSlopeCurve *altSlopeCurve;
-    QwtPlotCurve *atissCurve;
-    QwtPlotCurve *antissCurve;
-    QwtPlotCurve *rvCurve;
-    QwtPlotCurve *rcadCurve;
-    QwtPlotCurve *rgctCurve;
-    QwtPlotCurve *gearCurve;
-    QwtPlotCurve *smo2Curve;
-    QwtPlotCurve *thbCurve;
-    QwtPlotCurve *o2hbCurve;
-    QwtPlotCurve *hhbCurve;
-    QwtPlotCurve *npCurve;
-    QwtPlotCurve *xpCurve;
-    QwtPlotCurve *apCurve;
-    QwtPlotCurve *hrCurve;
-    QwtPlotCurve *hrvCurve;
-    QwtPlotCurve *tcoreCurve;
-    QwtPlotCurve *speedCurve;
-    QwtPlotCurve *accelCurve;
-    QwtPlotCurve *wattsDCurve;
-    QwtPlotCurve *cadDCurve;
-    QwtPlotCurve *nmDCurve;
-    QwtPlotCurve *hrDCurve;
-    QwtPlotCurve *cadCurve;
-    QwtPlotCurve *altCurve;
-    QwtPlotCurve *tempCurve;
-    QwtPlotIntervalCurve *windCurve;
-    QwtPlotCurve *torqueCurve;
-    QwtPlotCurve *balanceLCurve;
-    QwtPlotCurve *balanceRCurve;
-    QwtPlotCurve *wCurve;
-    QwtPlotCurve *mCurve;
-    QwtPlotCurve *lteCurve;
-    QwtPlotCurve *rteCurve;
-    QwtPlotCurve *lpsCurve;
-    QwtPlotCurve *rpsCurve;
-    QwtPlotCurve *lpcoCurve;
-    QwtPlotCurve *rpcoCurve;
-    QwtPlotIntervalCurve *lppCurve;
-    QwtPlotIntervalCurve *rppCurve;
-    QwtPlotIntervalCurve *lpppCurve;
-    QwtPlotIntervalCurve *rpppCurve;
+// The arrays for a ride, as read from it and as smoothed by recalc(). Apart
+// from the curves so they can be copied (cheaply, they are shared until
+// written) and smoothed off the GUI thread.
+struct AllPlotArrays {
 
     // source data
-    QVector<double> match;
-    QVector<double> matchTime;
-    QVector<double> matchDist;
-    QVector<QwtPlotMarker*> matchLabels;
-    QVector<double> wprime;
-    QVector<double> wprimeTime;
-    QVector<double> wprimeDist;
-
     QVector<double> hrArray;
   //    QVector<double> hrvArray;
     QVector<double> tcoreArray;
@@ -534,9 +452,101 @@ class AllPlotObject : public QObject
     QVector<QwtIntervalSample> smoothRPPP;
     QVector<QwtIntervalSample> smoothRelSpeed;
 
-    // setup as copy from user data
-    void setUserData(QList<UserData*>); // reset below to reflect current
+    // user data
     QList<UserObject> U;
+};
+
+class AllPlot;
+class MergeAdjust;
+class AllPlotObject : public QObject, public AllPlotArrays
+{
+    Q_OBJECT;
+
+    // one set for every ride being plotted, which
+    // as standard is just one, its only when we start
+    // compare mode that we get more...
+
+    public:
+
+    AllPlotObject(AllPlot*, QList<UserData*>); // construct associate with a plot
+    ~AllPlotObject(); // delete and disassociate from a plot
+
+    void setVisible(bool); // show or hide objects
+    void setColor(QColor color); // set ALL curves the same color
+    void hideUnwanted(); // hide curves we are not interested in
+                         // using setVisible ...
+
+    QwtPlotGrid *grid;
+    QVector<QwtPlotMarker*> d_mrk;
+    QVector<QwtPlotMarker*> cal_mrk;
+    QwtPlotMarker curveTitle;
+    QwtPlotMarker *allMarker1;
+    QwtPlotMarker *allMarker2;
+
+    // reference lines
+    QVector<QwtPlotCurve*> referenceLines;
+    QVector<QwtPlotCurve*> tmpReferenceLines;
+
+    // points of exhaustion
+    QVector<QwtPlotMarker*> exhaustionLines;
+    QVector<QwtPlotMarker*> tmpExhaustionLines;
+
+    QwtPlotCurve *wattsCurve;
+    QwtPlotCurve *slopeCurve;
+    AllPlotSlopeCurve *altSlopeCurve;
+    QwtPlotCurve *atissCurve;
+    QwtPlotCurve *antissCurve;
+    QwtPlotCurve *rvCurve;
+    QwtPlotCurve *rcadCurve;
+    QwtPlotCurve *rgctCurve;
+    QwtPlotCurve *gearCurve;
+    QwtPlotCurve *smo2Curve;
+    QwtPlotCurve *thbCurve;
+    QwtPlotCurve *o2hbCurve;
+    QwtPlotCurve *hhbCurve;
+    QwtPlotCurve *npCurve;
+    QwtPlotCurve *xpCurve;
+    QwtPlotCurve *apCurve;
+    QwtPlotCurve *hrCurve;
+    QwtPlotCurve *hrvCurve;
+    QwtPlotCurve *tcoreCurve;
+    QwtPlotCurve *speedCurve;
+    QwtPlotCurve *accelCurve;
+    QwtPlotCurve *wattsDCurve;
+    QwtPlotCurve *cadDCurve;
+    QwtPlotCurve *nmDCurve;
+    QwtPlotCurve *hrDCurve;
+    QwtPlotCurve *cadCurve;
+    QwtPlotCurve *altCurve;
+    QwtPlotCurve *tempCurve;
+    QwtPlotIntervalCurve *windCurve;
+    QwtPlotCurve *torqueCurve;
+    QwtPlotCurve *balanceLCurve;
+    QwtPlotCurve *balanceRCurve;
+    QwtPlotCurve *wCurve;
+    QwtPlotCurve *mCurve;
+    QwtPlotCurve *lteCurve;
+    QwtPlotCurve *rteCurve;
+    QwtPlotCurve *lpsCurve;
+    QwtPlotCurve *rpsCurve;
+    QwtPlotCurve *lpcoCurve;
+    QwtPlotCurve *rpcoCurve;
+    QwtPlotIntervalCurve *lppCurve;
+    QwtPlotIntervalCurve *rppCurve;
+    QwtPlotIntervalCurve *lpppCurve;
+    QwtPlotIntervalCurve *rpppCurve;
+
+    // source data, along with those in AllPlotArrays
+    QVector<double> match;
+    QVector<double> matchTime;
+    QVector<double> matchDist;
+    QVector<QwtPlotMarker*> matchLabels;
+    QVector<double> wprime;
+    QVector<double> wprimeTime;
+    QVector<double> wprimeDist;
+
+    // setup as copy from user data
+    void setUserData(QList<UserData*>); // reset U to reflect current
 
     // highlighting intervals
     QwtPlotCurve *intervalHighlighterCurve,  // highlight selected intervals on the Plot
@@ -565,9 +575,10 @@ class AllPlot : public QwtPlot
 
         bool eventFilter(QObject *object, QEvent *e);
 
-        // set the curve data e.g. when a ride is selected
-        void setDataFromRide(RideItem *_rideItem, QList<UserData*>);
-        void setDataFromRideFile(RideFile *ride, AllPlotObject *object, QList<UserData*>); // when plotting lots of rides on fullPlot
+        // set the curve data e.g. when a ride is selected, in the background
+        // any smoothing is done off the GUI thread, see recalc()
+        void setDataFromRide(RideItem *_rideItem, QList<UserData*>, bool background=false);
+        void setDataFromRideFile(RideFile *ride, AllPlotObject *object, QList<UserData*>, bool background=false); // when plotting lots of rides on fullPlot
         void setDataFromPlot(AllPlot *plot, int startidx, int stopidx);
         void setDataFromPlot(AllPlot *plot); // used for single series plotting
         void setDataFromPlots(QList<AllPlot*>); // user for single series comparing
@@ -590,8 +601,10 @@ class AllPlot : public QwtPlot
         void refreshExhaustionsForAllPlots();
         void setAxisTitle(QwtAxisId axis, QString label);
 
-        // refresh data / plot parameters
-        void recalc(AllPlotObject *objects);
+        // refresh data / plot parameters, in the background the standard
+        // curves are smoothed off the GUI thread and recalculated() is
+        // emitted once they are set (straight away if there's no need)
+        void recalc(AllPlotObject *objects, bool background=false);
         void setYMax();
         void setLeftOnePalette(); // color of yLeft,1 axis
         void setRightPalette(); // color of yRight,0 axis
@@ -667,6 +680,10 @@ class AllPlot : public QwtPlot
 
     signals:
         void resized();
+        void recalculated();
+
+    private slots:
+        void smoothingReady(ChartDataJob *);
 
     protected:
 
@@ -755,6 +772,12 @@ class AllPlot : public QwtPlot
         LTMCanvasPicker *_canvasPicker; // allow point selection/hover
         QFont labelFont;
 
+        // recalc() in two halves, the smoothing (which can be in the
+        // background) and then setting the curves from what it smoothed
+        ChartDataQueue *smoothJobs;
+        bool smoothArrays(AllPlotObject *objects, bool background);
+        void plotSmoothed(AllPlotObject *objects, int applysmooth);
+
         void setAltSlopePlotStyle (AllPlotSlopeCurve *curve);
         void setAxisScaleDiv(const QwtAxisId&, double, double, double);
         static inline void nextStep( int& step ) {
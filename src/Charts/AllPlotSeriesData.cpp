@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "AllPlotSeriesData.h"
+
+#include <QWidget>
+#include <QtAlgorithms>
+
+AllPlotSeriesData::AllPlotSeriesData(const QWidget *canvas, const double *x, const double *y, int count)
+    : canvas(canvas), ordered(true), level(-1), first(0), count(0)
+{
+    if (count > 0) {
+        this->x.resize(count);
+        this->y.resize(count);
+        qCopy(x, x + count, this->x.begin());
+        qCopy(y, y + count, this->y.begin());
+    }
+    build();
+
+    // everything until we're told otherwise
+    this->count = this->x.count();
+}
+
+QVector<QPointF>
+AllPlotSeriesData::samples(const QwtSeriesData<QPointF> *data)
+{
+    QVector<QPointF> returning;
+
+    const AllPlotSeriesData *ours = dynamic_cast<const AllPlotSeriesData*>(data);
+    if (ours) {
+        returning.resize(ours->x.count());
+        for (int i=0; i<ours->x.count(); i++) returning[i] = QPointF(ours->x[i], ours->y[i]);
+    } else if (data) {
+        returning.resize(data->size());
+        for (size_t i=0; i<data->size(); i++) returning[i] = data->sample(i);
+    }
+    return returning;
+}
+
+void
+AllPlotSeriesData::build()
+{
+    int n = x.count();
+    if (n == 0) return;
+
+    // bounds, and can we search by x ?
+    double minX = x[0], maxX = x[0], minY = y[0], maxY = y[0];
+    for (int i=1; i<n; i++) {
+        if (x[i] < x[i-1]) ordered = false;
+        if (x[i] < minX) minX = x[i];
+        if (x[i] > maxX) maxX = x[i];
+        if (y[i] < minY) minY = y[i];
+        if (y[i] > maxY) maxY = y[i];
+    }
+    d_boundingRect = QRectF(minX, minY, maxX - minX, maxY - minY);
+
+    // first level from the samples, then each from the one below
+    while (true) {
+
+        int below = levels.isEmpty() ? n : levels.last().low.count();
+        if (below <= 1) break;
+
+        Level next;
+        int buckets = (below + 1) / 2;
+        next.low.resize(buckets);
+        next.high.resize(buckets);
+
+        for (int b=0; b<buckets; b++) {
+
+            int l, r, lh, rh; // left and right, low and high
+            if (levels.isEmpty()) {
+                l = lh = 2*b;
+                r = rh = qMin(2*b+1, n-1);
+            } else {
+                const Level &last = levels.last();
+                l = last.low[2*b];
+                lh = last.high[2*b];
+                r = last.low[qMin(2*b+1, below-1)];
+                rh = last.high[qMin(2*b+1, below-1)];
+            }
+            next.low[b] = y[r] < y[l] ? r : l;
+            next.high[b] = y[rh] > y[lh] ? rh : lh;
+        }
+        levels << next;
+    }
+}
+
+void
+AllPlotSeriesData::setRectOfInterest(const QRectF &rect)
+{
+    int n = x.count();
+    if (n == 0) return;
+
+    // the samples in view, and one either side so the
+    // line runs off the edge of the canvas
+    int from = 0, to = n-1;
+    if (ordered && rect.isValid()) {
+        from = qLowerBound(x.begin(), x.end(), rect.left()) - x.begin() - 1;
+        to = qUpperBound(x.begin(), x.end(), rect.right()) - x.begin();
+        if (from < 0) from = 0;
+        if (to > n-1) to = n-1;
+        if (to < from) to = from;
+    }
+
+    // two points per bucket, so about as many buckets as pixels
+    int pixels = canvas ? qMax(canvas->width(), 100) : 1000;
+
+    level = -1;
+    int shown = to - from + 1;
+    while (shown > 2 * pixels && level+1 < levels.count()) {
+        level++;
+        shown = 2 * ((to >> (level+1)) - (from >> (level+1)) + 1);
+    }
+
+    if (level < 0) {
+        first = from;
+        count = to - from + 1;
+    } else {
+        first = from >> (level+1);
+        count = (to >> (level+1)) - first + 1;
+    }
+}
+
+size_t
+AllPlotSeriesData::size() const
+{
+    return level < 0 ? count : 2 * count;
+}
+
+QPointF
+AllPlotSeriesData::sample(size_t i) const
+{
+    int index;
+    if (level < 0) {
+        index = first + i;
+    } else {
+        const Level &at = levels[level];
+        int b = first + (i / 2);
+        int low = at.low[b], high = at.high[b];
+        index = (i % 2) ? qMax(low, high) : qMin(low, high);
+    }
+    return QPointF(x[index], y[index]);
+}
+
+QRectF
+AllPlotSeriesData::boundingRect() const
+{
+    return d_boundingRect;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_AllPlotSeriesData_h
+#define _GC_AllPlotSeriesData_h 1
+#include "GoldenCheetah.h"
+
+#include "qwt_series_data.h"
+
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+
+class QWidget;
+
+// Curve data for AllPlot that never hands Qwt more points than the canvas
+// has pixels across.
+//
+// When the data is set we build a pyramid over the samples; each level
+// halves the one below, holding for each bucket the index of its lowest and
+// highest sample. When the plot is replotted Qwt tells us the range being
+// shown (setRectOfInterest) and we pick the first level with no more buckets
+// in that range than the canvas is wide. Each bucket is then drawn as its
+// low and high points, in the order they occur, so spikes and dips are kept
+// and the curve looks the same as drawing every sample.
+//
+// Zoomed in far enough, or for short rides, the samples are used as is.
+
+class AllPlotSeriesData : public QwtSeriesData<QPointF>
+{
+    public:
+        AllPlotSeriesData(const QWidget *canvas, const double *x, const double *y, int count);
+
+        virtual size_t size() const;
+        virtual QPointF sample(size_t i) const;
+        virtual QRectF boundingRect() const;
+
+        virtual void setRectOfInterest(const QRectF &rect);
+
+        // every sample of a curve, not just those being shown, when its
+        // data needs copying (e.g. to another plot)
+        static QVector<QPointF> samples(const QwtSeriesData<QPointF> *data);
+
+    private:
+        struct Level {
+            QVector<int> low, high; // index into x and y
+        };
+
+        void build();
+
+        const QWidget *canvas;
+        QVector<double> x, y;
+        QVector<Level> levels;  // levels[k] has buckets of 2^(k+1) samples
+        bool ordered;           // x never decreases
+
+        // what we are currently showing
+        int level;              // -1 is the samples themselves
+        int first, count;       // samples or buckets
+};
+
+#endif // _GC_AllPlotSeriesData_h
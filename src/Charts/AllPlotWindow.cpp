@@ -820,6 +820,7 @@ AllPlotWindow::AllPlotWindow(Context *context) :
     // GC signals
     connect(this, SIGNAL(rideItemChanged(RideItem*)), this, SLOT(rideSelected()));
     connect(context, SIGNAL(rideDirty(RideItem*)), this, SLOT(rideSelected()));
+    connect(fullPlot, SIGNAL(recalculated()), this, SLOT(fullPlotRecalculated()));
     connect(context, SIGNAL(rideChanged(RideItem*)), this, SLOT(forceReplot()));
     connect(context, SIGNAL(configChanged(qint32)), this, SLOT(configChanged(qint32)));
     connect(context->athlete, SIGNAL(zonesChanged()), this, SLOT(zonesChanged()));
@@ -1842,10 +1843,16 @@ AllPlotWindow::rideSelected()
     // before we set the plots below...
     setAllPlotWidgets(ride);
 
-    // setup the charts to reflect current ride selection
-    fullPlot->setDataFromRide(ride, userDataSeries);
+    // setup the charts to reflect current ride selection, the full
+    // plot smooths in the background and we redraw when its done
     intervalPlot->setDataFromRide(ride);
+    stale = false;
+    fullPlot->setDataFromRide(ride, userDataSeries, true);
+}
 
+void
+AllPlotWindow::fullPlotRecalculated()
+{
     // redraw all the plots, they will check
     // to see if they are currently visible
     // and only redraw if neccessary
@@ -1859,8 +1866,6 @@ AllPlotWindow::rideSelected()
 
     setupStackPlots();
     setupSeriesStackPlots();
-
-    stale = false;
 }
 
 void
@@ -423,6 +423,7 @@ class AllPlotWindow : public GcChartWindow
         void plotPickerMoved(const QPoint &);
         void plotPickerSelected(const QPoint &);
         void allPlotResized();
+        void fullPlotRecalculated();
 };
 
 #endif // _GC_AllPlotWindow_h
@@ -52,13 +52,32 @@
 #include "LTMTrend.h"
 
 
+// aggregates the bests for plotBests, the rides are chosen when it is
+// created (on the GUI thread) and aggregated in the background
+class CPPlotBestsJob : public ChartDataJob
+{
+    public:
+        CPPlotBestsJob(Context *context, QDate start, QDate end, bool filtered, QStringList files, bool onhome, RideItem *rideItem)
+            : context(context), rides(context, start, end, filtered, files, onhome, rideItem), cache(NULL) {}
+        ~CPPlotBestsJob() { delete cache; }
+
+        void prepare() { cache = new RideFileCache(context, rides); }
+
+        RideFileCache *take() { RideFileCache *returning = cache; cache = NULL; return returning; }
+
+    private:
+        Context *context;
+        RideFileCacheRides rides;
+        RideFileCache *cache;
+};
+
 CPPlot::CPPlot(QWidget *parent, Context *context, bool rangemode) : QwtPlot(parent), parent(parent),
 
     // model
     model(0), modelVariant(0),
 
     // state
-    context(context), bestsCache(NULL), dateCV(0.0), isRun(false), isSwim(false),
+    context(context), bestsCache(NULL), bestsRide(NULL), bestsArrived(false), dateCV(0.0), isRun(false), isSwim(false),
     rideSeries(RideFile::watts),
     isFiltered(false), shadeMode(2),
     shadeIntervals(true), rangemode(rangemode), 
@@ -72,6 +91,10 @@ CPPlot::CPPlot(QWidget *parent, Context *context, bool rangemode) : QwtPlot(pare
     setAutoFillBackground(true);
     setAxisTitle(xBottom, tr("Interval Length"));
 
+    // aggregating the bests is slow, so it's done in the background
+    bestsJobs = new ChartDataQueue(this);
+    connect(bestsJobs, SIGNAL(ready(ChartDataJob*)), this, SLOT(bestsReady(ChartDataJob*)));
+
     // Log scale on x-axis
     ltsd = new LogTimeScaleDraw;
     ltsd->setTickLength(QwtScaleDiv::MajorTick, 3);
@@ -877,7 +900,8 @@ CPPlot::plotModel(QVector<double> vector, QColor plotColor, PDModel *baseline)
 void
 CPPlot::clearCurves()
 {
-    // bests ridefilecache
+    // bests ridefilecache, and any on the way
+    bestsJobs->cancel();
     if (bestsCache) {
         delete bestsCache;
         bestsCache = NULL;
@@ -964,9 +988,11 @@ CPPlot::plotBests(RideItem *rideItem)
     // you need to wipe away whats there buddy
     if (bestsCurves.count()) return;
 
-    // do we need to get the cache ?
+    // do we need to get the cache ? we get called
+    // again by bestsReady() when it has been aggregated
     if (bestsCache == NULL) {
-        bestsCache = new RideFileCache(context, startDate, endDate, isFiltered, files, rangemode, rideItem);
+        bestsJobs->submit(new CPPlotBestsJob(context, startDate, endDate, isFiltered, files, rangemode, rideItem));
+        return;
     }
 
     // how much we got ?
@@ -1734,11 +1760,14 @@ CPPlot::setRide(RideItem *rideItem)
     // first make sure the bests cache is up to date as we may need it
     // if plotting in percentage mode, so get data and plot it now
     // delete if sport changed
+    bestsRide = rideItem;
     if (!rangemode) {
         setSport(rideItem->isRun, rideItem->isSwim);
-        delete bestsCache;
-        bestsCache = NULL;
-        clearCurves();
+        if (!bestsArrived) {
+            delete bestsCache;
+            bestsCache = NULL;
+            clearCurves();
+        }
         plotBests(rideItem);
     } else {
         plotBests(NULL);
@@ -1794,6 +1823,21 @@ CPPlot::setRide(RideItem *rideItem)
     replot();
 }
 
+// the bests we asked for in plotBests, plot again with them
+void
+CPPlot::bestsReady(ChartDataJob *job)
+{
+    bestsCache = static_cast<CPPlotBestsJob*>(job)->take();
+
+    // the ride may have been deleted whilst we were waiting, we will
+    // be told about another one
+    if (!context->athlete->rideCache->rides().contains(bestsRide)) return;
+
+    bestsArrived = true;
+    setRide(bestsRide);
+    bestsArrived = false;
+}
+
 // the picker hovered over a point on a curve
 void
 CPPlot::pointHover(QwtPlotCurve *curve, int index)
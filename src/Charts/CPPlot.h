@@ -25,6 +25,7 @@
 
 #include "CriticalPowerWindow.h"
 #include "RideFileCache.h"
+#include "ChartDataJob.h"
 #include "PDModel.h"
 #include "ExtendedCriticalPower.h"
 #include "CpPlotCurve.h"
@@ -115,6 +116,9 @@ class CPPlot : public QwtPlot
         void refreshUpdate(QDate);
         void refreshEnd();
 
+        // the bests aggregated in the background
+        void bestsReady(ChartDataJob *);
+
     private:
 
         QWidget *parent;
@@ -149,6 +153,9 @@ class CPPlot : public QwtPlot
         // Data and State
         Context *context;
         RideFileCache *bestsCache;
+        ChartDataQueue *bestsJobs;
+        RideItem *bestsRide; // last setRide
+        bool bestsArrived;
         int veloCP;
         int dateCP;
         double dateCV;
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ChartDataJob.h"
+
+void
+ChartDataJob::run()
+{
+    // superseded before it got started
+    if (!isCancelled()) prepare();
+
+    // queued back to the gui thread
+    emit finished();
+}
+
+ChartDataQueue::ChartDataQueue(QObject *parent) : QObject(parent), current(NULL)
+{
+    pool.setMaxThreadCount(1);
+}
+
+ChartDataQueue::~ChartDataQueue()
+{
+    cancel();
+    pool.waitForDone();
+
+    // they finished but never got delivered
+    foreach(ChartDataJob *job, jobs) delete job;
+}
+
+void
+ChartDataQueue::submit(ChartDataJob *job)
+{
+    cancel();
+
+    current = job;
+    jobs << job;
+    connect(job, SIGNAL(finished()), this, SLOT(jobFinished()), Qt::QueuedConnection);
+    pool.start(job);
+}
+
+void
+ChartDataQueue::cancel()
+{
+    if (current) current->cancel();
+    current = NULL;
+}
+
+void
+ChartDataQueue::jobFinished()
+{
+    ChartDataJob *job = static_cast<ChartDataJob*>(sender());
+    jobs.removeOne(job);
+
+    if (job == current) {
+        current = NULL;
+        if (!job->isCancelled()) emit ready(job);
+    }
+    job->deleteLater();
+}
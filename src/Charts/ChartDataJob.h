@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_ChartDataJob_h
+#define _GC_ChartDataJob_h 1
+#include "GoldenCheetah.h"
+
+#include <QObject>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QList>
+
+// Preparing the data for a chart off the GUI thread
+//
+// A chart subclasses ChartDataJob to compute its arrays in prepare(), which
+// runs on a worker thread and so must not touch any widgets, and submits it
+// to its ChartDataQueue. When it is done the queue emits ready() on the GUI
+// thread and the chart builds its curves from the results; the job is
+// deleted once the slot returns.
+//
+// Submitting a job supersedes the one before it, which is cancelled. Once
+// running a job can check isCancelled() to give up early, but whatever it
+// does its results are never delivered. So selecting ride after ride in
+// the ride list only ever draws the last.
+
+class ChartDataJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+    public:
+        ChartDataJob() : cancelled(0) { setAutoDelete(false); }
+        virtual ~ChartDataJob() {}
+
+        // compute the data, on a worker thread
+        virtual void prepare() = 0;
+
+        void cancel() { cancelled.fetchAndStoreOrdered(1); }
+        bool isCancelled() { return cancelled.fetchAndAddOrdered(0) != 0; }
+
+        void run();
+
+    signals:
+        void finished();
+
+    private:
+        QAtomicInt cancelled;
+};
+
+class ChartDataQueue : public QObject
+{
+    Q_OBJECT
+
+    public:
+        ChartDataQueue(QObject *parent = NULL);
+        ~ChartDataQueue(); // cancels and waits for any jobs
+
+        // cancels the job before, takes ownership
+        void submit(ChartDataJob *job);
+
+        // cancel the current job, if there is one
+        void cancel();
+
+        // a job has been submitted and not delivered yet
+        bool isBusy() const { return current != NULL; }
+
+    signals:
+        void ready(ChartDataJob *job);
+
+    private slots:
+        void jobFinished();
+
+    private:
+        QThreadPool pool;           // one thread, jobs run in order
+        ChartDataJob *current;      // the one we will deliver
+        QList<ChartDataJob*> jobs;  // all those not finished
+};
+
+#endif // _GC_ChartDataJob_h
@@ -1120,7 +1120,6 @@ CriticalPowerWindow::showIntervalCurve(IntervalItem *current, int index)
     // mean-max computer. Does a 11hr ride in 150ms
     QVector<float>vector;
     MeanMaxComputer thread1(&f, vector, getRideSeries(series())); thread1.run();
-    thread1.wait();
 
     // no data!
     if (vector.count() == 0) return;
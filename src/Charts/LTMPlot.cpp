@@ -3320,7 +3320,7 @@ LTMPlot::createPMCData(Context *context, LTMSettings *settings, MetricDetail met
             allDates.addMatches(SearchFilterBox::matches(context, metricDetail.datafilter));
 
         allDates.setDateRange(DateRange(QDate(),QDate()));
-        localPMC = new PMCData(context, allDates, scoreType);
+        localPMC = context->athlete->getPMCFor(scoreType, allDates);
     }
 
     // use global one if not filtered
@@ -3463,9 +3463,6 @@ LTMPlot::createPMCData(Context *context, LTMSettings *settings, MetricDetail met
             lastDay = currentDay;
         }
     }
-
-    // wipe away local
-    if (localPMC) delete localPMC;
 }
 
 QwtAxisId
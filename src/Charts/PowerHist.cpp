@@ -117,6 +117,10 @@ PowerHist::PowerHist(Context *context, bool rangemode) :
     canvasPicker = new LTMCanvasPicker(this);
     connect(canvasPicker, SIGNAL(pointHover(QwtPlotCurve*, int)), this, SLOT(pointHover(QwtPlotCurve*, int)));
 
+    // binning for recalc() in the background
+    binJobs = new ChartDataQueue(this);
+    connect(binJobs, SIGNAL(ready(ChartDataJob*)), this, SLOT(binsReady(ChartDataJob*)));
+
     // usually hidden, but shown for compare mode
     //XXX insertLegend(new QwtLegend(), QwtPlot::BottomLegend);
 
@@ -776,11 +780,25 @@ PowerHist::recalcCompare()
     updatePlot();
 }
 
+// bins a copy of the data for recalc() off the GUI thread, see binsReady()
+class PowerHistBinJob : public ChartDataJob
+{
+    public:
+        PowerHistBinJob(const HistBinning &binning, const HistData &data) : binning(binning), data(data) {}
+
+        void prepare() { PowerHist::binData(binning, data, x, y, sx, sy); }
+
+        HistBinning binning;
+        HistData data;
+        QVector<double> x, y, sx, sy;
+};
+
 void
 PowerHist::recalc(bool force)
 {
     if ((!rangemode && context->isCompareIntervals) ||
        (rangemode && context->isCompareDateRanges)) {
+        binJobs->cancel();
         recalcCompare();
         return;
     }
@@ -820,6 +838,8 @@ PowerHist::recalc(bool force)
         LASTabsolutetime = absolutetime;
     }
 
+    // whatever we were binning is out of date
+    binJobs->cancel();
 
     if (source == Ride && !rideItem) { 
         return;
@@ -830,6 +850,24 @@ PowerHist::recalc(bool force)
         return;
     }
 
+    // bin the data, the curves are set when its ready
+    binJobs->submit(new PowerHistBinJob(binning(), standard));
+}
+
+// the binning recalc() asked for in the background
+void
+PowerHist::binsReady(ChartDataJob *job)
+{
+    // the ride went away whilst we were at it
+    if (source == Ride && !rideItem) return;
+
+    PowerHistBinJob *binned = static_cast<PowerHistBinJob*>(job);
+    plotBins(binned->x, binned->y, binned->sx, binned->sy);
+}
+
+void
+PowerHist::plotBins(QVector<double>&x, QVector<double>&y, QVector<double>&sx, QVector<double>&sy)
+{
     // zap any zone data labels
     foreach (QwtPlotMarker *label, zoneDataLabels) {
         label->detach();
@@ -837,10 +875,6 @@ PowerHist::recalc(bool force)
     }
     zoneDataLabels.clear();
 
-    // bin the data
-    QVector<double>x,y,sx,sy;
-    binData(standard, x, y, sx, sy);
-
     if (!isZoningEnabled()) {
 
         // now draw curves / axis etc
@@ -1017,38 +1051,45 @@ PowerHist::binData(HistData &standard, QVector<double>&x, // x-axis for data
                                        QVector<double>&y, // y-axis for data
                                        QVector<double>&sx, // x-axis for selected data
                                        QVector<double>&sy) // y-axis for selected data
+{
+    binData(binning(), standard, x, y, sx, sy);
+}
+
+void
+PowerHist::binData(const HistBinning &binning, HistData &standard, QVector<double>&x, QVector<double>&y,
+                                                                   QVector<double>&sx, QVector<double>&sy)
 {
     QVector<unsigned int> *array = NULL;
     QVector<unsigned int> *selectedArray = NULL;
     int arrayLength = 0;
 
-    if (source == Metric) {
+    if (binning.metric) {
 
         // we use the metricArray
         array = &standard.metricArray;
         arrayLength = standard.metricArray.size();
         selectedArray = NULL;
 
-    } else if (series == RideFile::watts && zoned == false) {
+    } else if (binning.series == RideFile::watts && binning.zoned == false) {
 
         array = &standard.wattsArray;
         arrayLength = standard.wattsArray.size();
         selectedArray = &standard.wattsSelectedArray;
 
-    } else if (series == RideFile::wbal && zoned == false) {
+    } else if (binning.series == RideFile::wbal && binning.zoned == false) {
 
         array = &standard.wbalArray;
         arrayLength = standard.wbalArray.size();
         selectedArray = &standard.wbalSelectedArray;
 
-    } else if (series == RideFile::wbal && zoned == true) {
+    } else if (binning.series == RideFile::wbal && binning.zoned == true) {
 
             array = &standard.wbalZoneArray;
             arrayLength = standard.wbalZoneArray.size();
             selectedArray = &standard.wbalZoneSelectedArray;
 
-    } else if ((series == RideFile::watts || series == RideFile::wattsKg) && zoned == true) {
-        if (cpzoned) {
+    } else if ((binning.series == RideFile::watts || binning.series == RideFile::wattsKg) && binning.zoned == true) {
+        if (binning.cpzoned) {
             array = &standard.wattsCPZoneArray;
             arrayLength = standard.wattsCPZoneArray.size();
             selectedArray = &standard.wattsCPZoneSelectedArray;
@@ -1058,33 +1099,33 @@ PowerHist::binData(HistData &standard, QVector<double>&x, // x-axis for data
             selectedArray = &standard.wattsZoneSelectedArray;
         }
 
-    } else if (series == RideFile::aPower && zoned == false) {
+    } else if (binning.series == RideFile::aPower && binning.zoned == false) {
 
         array = &standard.aPowerArray;
         arrayLength = standard.aPowerArray.size();
         selectedArray = &standard.aPowerSelectedArray;
 
-    } else if (series == RideFile::wattsKg && zoned == false) {
+    } else if (binning.series == RideFile::wattsKg && binning.zoned == false) {
 
         array = &standard.wattsKgArray;
         arrayLength = standard.wattsKgArray.size();
         selectedArray = &standard.wattsKgSelectedArray;
 
-    } else if (series == RideFile::nm) {
+    } else if (binning.series == RideFile::nm) {
 
         array = &standard.nmArray;
         arrayLength = standard.nmArray.size();
         selectedArray = &standard.nmSelectedArray;
 
-    } else if (series == RideFile::hr && zoned == false) {
+    } else if (binning.series == RideFile::hr && binning.zoned == false) {
 
         array = &standard.hrArray;
         arrayLength = standard.hrArray.size();
         selectedArray = &standard.hrSelectedArray;
 
-    } else if (series == RideFile::hr && zoned == true) {
+    } else if (binning.series == RideFile::hr && binning.zoned == true) {
 
-        if (cpzoned) {
+        if (binning.cpzoned) {
             array = &standard.hrCPZoneArray;
             arrayLength = standard.hrCPZoneArray.size();
             selectedArray = &standard.hrCPZoneSelectedArray;
@@ -1094,15 +1135,15 @@ PowerHist::binData(HistData &standard, QVector<double>&x, // x-axis for data
             selectedArray = &standard.hrZoneSelectedArray;
         }
 
-    } else if (series == RideFile::kph && !(zoned == true && (!rideItem || rideItem->isRun || rideItem->isSwim))) {
+    } else if (binning.series == RideFile::kph && !(binning.zoned == true && binning.runOrSwim)) {
 
         array = &standard.kphArray;
         arrayLength = standard.kphArray.size();
         selectedArray = &standard.kphSelectedArray;
 
-    } else if (series == RideFile::kph && zoned == true && (!rideItem || rideItem->isRun || rideItem->isSwim)) {
+    } else if (binning.series == RideFile::kph && binning.zoned == true && binning.runOrSwim) {
 
-        if (cpzoned) {
+        if (binning.cpzoned) {
             array = &standard.paceCPZoneArray;
             arrayLength = standard.paceCPZoneArray.size();
             selectedArray = &standard.paceCPZoneSelectedArray;
@@ -1112,28 +1153,28 @@ PowerHist::binData(HistData &standard, QVector<double>&x, // x-axis for data
             selectedArray = &standard.paceZoneSelectedArray;
         }
 
-    } else if (series == RideFile::smo2) {
+    } else if (binning.series == RideFile::smo2) {
         array = &standard.smo2Array;
         arrayLength = standard.smo2Array.size();
         selectedArray = &standard.smo2SelectedArray;
 
-    } else if (series == RideFile::gear) {
+    } else if (binning.series == RideFile::gear) {
         array = &standard.gearArray;
         arrayLength = standard.gearArray.size();
         selectedArray = &standard.gearSelectedArray;
 
-    } else if (series == RideFile::cad) {
+    } else if (binning.series == RideFile::cad) {
         array = &standard.cadArray;
         arrayLength = standard.cadArray.size();
         selectedArray = &standard.cadSelectedArray;
     }
 
     // binning of data when not zoned
-    if (!isZoningEnabled()) {
+    if (!binning.isZoningEnabled()) {
 
         // we add a bin on the end since the last "incomplete" bin
         // will be dropped otherwise
-        int count = qMax(0, int(ceil((arrayLength - 1) / (binw)))+1);
+        int count = qMax(0, int(ceil((arrayLength - 1) / (binning.binw)))+1);
 
         // allocate space for data, plus beginning and ending point
         x.resize(count+2);
@@ -1145,30 +1186,30 @@ PowerHist::binData(HistData &standard, QVector<double>&x, // x-axis for data
 
         int i;
         for (i = 1; i <= count; ++i) {
-            double high = i * round(binw/delta);
-            double low = high - round(binw/delta);
-            if (low==0 && !withz) low++;
-            x[i] = high*delta;
+            double high = i * round(binning.binw/binning.delta);
+            double low = high - round(binning.binw/binning.delta);
+            if (low==0 && !binning.withz) low++;
+            x[i] = high*binning.delta;
             y[i]  = 1e-9;  // nonzero to accommodate log plot
             sy[i] = 1e-9;  // nonzero to accommodate log plot
             if (array) {
                 while (low < high && low<arrayLength) {
                     if (selectedArray && (*selectedArray).size()>low)
-                        sy[i] += dt * (*selectedArray)[low];
-                    y[i] += dt * (*array)[low++];
+                        sy[i] += binning.dt * (*selectedArray)[low];
+                    y[i] += binning.dt * (*array)[low++];
                 }
             }
         }
         y[i] = 1e-9;       // nonzero to accommodate log plot
         sy[i] = 1e-9;       // nonzero to accommodate log plot
-        x[i] = i * delta * binw;
+        x[i] = i * binning.delta * binning.binw;
         y[0] = 1e-9;
         sy[0] = 1e-9;
         x[0] = 0;
 
         // convert vectors from absolute time to percentage
         // if the user has selected that
-        if (!absolutetime) {
+        if (!binning.absolutetime) {
             percentify(y, 1);
             percentify(sy, 1);
         }
@@ -1189,13 +1230,13 @@ PowerHist::binData(HistData &standard, QVector<double>&x, // x-axis for data
 
         // so we can calculate percentage for the labels
         double total=0;
-        for (int i=0; i<array->size(); i++) total += dt * (double)(*array)[i];
+        for (int i=0; i<array->size(); i++) total += binning.dt * (double)(*array)[i];
 
         // samples to time
         for (int i=0, offset=0; i<array->size(); i++) {
 
             double xn = (double) i - (0.625f / 2.0f);
-            double yn = dt * (double)(*array)[i];
+            double yn = binning.dt * (double)(*array)[i];
 
             x[offset] = xn;
             y[offset] = 0;
@@ -1213,7 +1254,7 @@ PowerHist::binData(HistData &standard, QVector<double>&x, // x-axis for data
 
         for (int i=0, offset=0; i<selectedArray->size(); i++) {
             double xn = (double)i - (0.625f / 2.0f);
-            double yn = dt * (double)(*selectedArray)[i];
+            double yn = binning.dt * (double)(*selectedArray)[i];
 
             sx[offset] = xn;
             sy[offset] = 0;
@@ -1230,7 +1271,7 @@ PowerHist::binData(HistData &standard, QVector<double>&x, // x-axis for data
 
         }
 
-        if (!absolutetime) {
+        if (!binning.absolutetime) {
             percentify(y, 2);
             percentify(sy, 2);
         }
@@ -2506,15 +2547,39 @@ PowerHist::percentify(QVector<double> &array, double factor)
                 array[i] = factor * (array[i] / total) * (double)100.00;
 }
 
+// the settings binData() works from
+HistBinning
+PowerHist::binning() const
+{
+    HistBinning binning;
+    binning.metric = (source == Metric);
+    binning.series = series;
+    binning.zoned = zoned;
+    binning.cpzoned = cpzoned;
+    binning.withz = withz;
+    binning.absolutetime = absolutetime;
+    binning.runOrSwim = (!rideItem || rideItem->isRun || rideItem->isSwim);
+    binning.binw = binw;
+    binning.delta = delta;
+    binning.dt = dt;
+    return binning;
+}
+
 // Conditions to enable zoning, we can't zone for series besides watts, hr and
 // kph only for running activities, so ignore zoning for those data series
 bool
-PowerHist::isZoningEnabled()
+HistBinning::isZoningEnabled() const
 {
     // zoning valid for power, w/kg, hr, wbal and also
     // for speed (aka Pace; but only for swims and runs)
     return (zoned == true &&
-            (series == RideFile::watts || series == RideFile::wattsKg || 
+            (series == RideFile::watts || series == RideFile::wattsKg ||
              series == RideFile::hr || series == RideFile::wbal ||
-            (series == RideFile::kph && (!rideItem || rideItem->isRun || rideItem->isSwim))));
+            (series == RideFile::kph && runOrSwim)));
+}
+
+bool
+PowerHist::isZoningEnabled()
+{
+    return binning().isZoningEnabled();
 }
@@ -31,6 +31,7 @@
 #include "Settings.h"
 #include "Colors.h"
 #include "Units.h"
+#include "ChartDataJob.h"
 
 #include <assert.h>
 #include <qwt_plot.h>
@@ -121,6 +122,19 @@ class HistData // each curve needs a lot of data (!? this may need refactoring,
                               cadSelectedArray, smo2SelectedArray, gearSelectedArray;
 };
 
+class HistBinning // the plot settings binData() needs, copied so it can run off the GUI thread
+{
+    public:
+
+        bool metric;        // binning the metricArray
+        RideFile::SeriesType series;
+        bool zoned, cpzoned, withz, absolutetime;
+        bool runOrSwim;     // pace zones apply, true when there is no ride
+        double binw, delta, dt;
+
+        bool isZoningEnabled() const;
+};
+
 class PowerHist : public QwtPlot
 {
     Q_OBJECT
@@ -143,6 +157,10 @@ class PowerHist : public QwtPlot
         double maxX;
         bool rangemode;
 
+        // bin the data using the settings given, safe on any thread
+        static void binData(const HistBinning &binning, HistData &standard,
+                            QVector<double>&, QVector<double>&, QVector<double>&, QVector<double>&);
+
     public slots:
 
         // public setters
@@ -203,12 +221,13 @@ class PowerHist : public QwtPlot
     protected:
 
         bool isZoningEnabled();
+        HistBinning binning() const; // the current settings for binData()
         void refreshHRZoneLabels();
         void refreshPaceZoneLabels();
         void setParameterAxisTitle();
         bool isSelected(const RideFilePoint *p, double);
         bool isSelected(const double t, double sample);
-        void percentify(QVector<double> &, double factor); // and a function to convert
+        static void percentify(QVector<double> &, double factor); // and a function to convert
 
         bool shadeZones() const; // check if zone shading is both wanted and possible
         bool shadeHRZones() const; // check if zone shading is both wanted and possible
@@ -229,8 +248,18 @@ class PowerHist : public QwtPlot
 
         HistData standard;
 
+    private slots:
+
+        void binsReady(ChartDataJob *job);
+
     private:
 
+        // set the curves and axes from the binned data, the second half of recalc()
+        void plotBins(QVector<double>&x, QVector<double>&y, QVector<double>&sx, QVector<double>&sy);
+
+        // recalc() bins the data in the background
+        ChartDataQueue *binJobs;
+
         // plot objects
         QwtPlotGrid *grid;
         PowerHistBackground *bg;
@@ -46,6 +46,74 @@
 #include "GcOverlayWidget.h"
 #include "IntervalSummaryWindow.h"
 #include <QDebug>
+#include <QStack>
+#include <QtAlgorithms>
+#include <QPair>
+#include <cmath>
+
+// routes are simplified before being sent to the map, points that are
+// within this many degrees (about a metre) of the line between the points
+// either side of them can't be seen at the closest zoom so are dropped
+static const double ROUTE_TOLERANCE = 0.00001;
+
+// size of the grid cells and the box searched around the mouse
+static const double SEARCH_BOX = 0.0001;
+
+// Douglas-Peucker over the points with GPS, keep[i] is set for each of
+// points[i] that is needed to draw the route. longitudes are scaled so
+// the tolerance is the same distance in any direction.
+static void
+simplifyRoute(const QVector<RideFilePoint*> &points, QVector<bool> &keep)
+{
+    keep.fill(false, points.count());
+
+    QVector<int> gps;
+    for (int i=0; i<points.count(); i++)
+        if (points[i]->lat || points[i]->lon) gps << i;
+
+    if (gps.count() < 3) {
+        foreach(int i, gps) keep[i] = true;
+        return;
+    }
+    keep[gps.first()] = keep[gps.last()] = true;
+
+    double scale = cos(points[gps.first()]->lat * M_PI / 180.0);
+
+    // without recursion, long rides would go very deep
+    QStack<QPair<int,int> > spans;
+    spans.push(QPair<int,int>(0, gps.count()-1));
+    while (!spans.isEmpty()) {
+
+        QPair<int,int> span = spans.pop();
+        if (span.second - span.first < 2) continue;
+
+        const RideFilePoint *a = points[gps[span.first]];
+        const RideFilePoint *b = points[gps[span.second]];
+        double dx = (b->lon - a->lon) * scale;
+        double dy = b->lat - a->lat;
+        double length = sqrt(dx*dx + dy*dy);
+
+        // furthest point from the line a-b (or from a if they coincide)
+        int furthest = -1;
+        double distance = ROUTE_TOLERANCE;
+        for (int i=span.first+1; i<span.second; i++) {
+            const RideFilePoint *p = points[gps[i]];
+            double px = (p->lon - a->lon) * scale;
+            double py = p->lat - a->lat;
+            double d = length > 0 ? fabs(px*dy - py*dx) / length : sqrt(px*px + py*py);
+            if (d > distance) {
+                distance = d;
+                furthest = i;
+            }
+        }
+
+        if (furthest > 0) {
+            keep[gps[furthest]] = true;
+            spans.push(QPair<int,int>(span.first, furthest));
+            spans.push(QPair<int,int>(furthest, span.second));
+        }
+    }
+}
 
 RideMapWindow::RideMapWindow(Context *context, int mapType) : GcChartWindow(context), context(context),
                                                        range(-1), current(NULL), firstShow(true), stale(false)
@@ -781,7 +849,35 @@ RideMapWindow::drawShadedRoute()
 
     QString code;
 
-    foreach(RideFilePoint *rfp, myRideItem->ride()->dataPoints()) {
+    // only push the points needed to draw the route, but always the
+    // last point of each segment and start the next one from it so
+    // they join up
+    const QVector<RideFilePoint*> &points = myRideItem->ride()->dataPoints();
+    QVector<bool> keep;
+    simplifyRoute(points, keep);
+    RideFilePoint *skipped = NULL;
+    RideFilePoint *pushed = NULL; // last point pushed
+
+    for (int i=0; i<points.count(); i++) {
+        RideFilePoint *rfp = points[i];
+
+        // the point to push, if any
+        RideFilePoint *gps = NULL;
+        bool last = (rtime + rfp->secs - prevtime) >= intervalTime;
+        if (rfp->lat || rfp->lon) {
+            // the route starts at its first gps point
+            if (keep[i] || last || !pushed) gps = rfp;
+            else skipped = rfp;
+        } else if (last) {
+            gps = skipped;
+        }
+        if (gps) skipped = NULL;
+
+        // later segments start where the last one finished
+        QList<RideFilePoint*> push;
+        if (count == 0 && pushed) push << pushed;
+        if (gps && gps != pushed) push << gps;
+
         if (mapCombo->currentIndex() == GOOGLE || mapCombo->currentIndex() == OSM) {
             if (count == 0) {
                 code = QString("{\nvar polyline = new google.maps.Polyline();\n"
@@ -792,18 +888,18 @@ RideMapWindow::drawShadedRoute()
                 code += QString("google.maps.event.addListener(polyline, 'mousedown', function(event) { map.setOptions({draggable: false, zoomControl: false, scrollwheel: false, disableDoubleClickZoom: true}); webBridge.clickPath(event.latLng.lat(), event.latLng.lng()); });\n"
                                 "google.maps.event.addListener(polyline, 'mouseup',   function(event) { map.setOptions({draggable: true, zoomControl: true, scrollwheel: true, disableDoubleClickZoom: false}); webBridge.mouseup(); });\n"
                                 "google.maps.event.addListener(polyline, 'mouseover', function(event) { webBridge.hoverPath(event.latLng.lat(), event.latLng.lng()); });\n");
-            } else {
-                if (rfp->lat || rfp->lon)
-                    code += QString("path.push(new google.maps.LatLng(%1,%2));\n").arg(rfp->lat,0,'g',GPS_COORD_TO_STRING).arg(rfp->lon,0,'g',GPS_COORD_TO_STRING);
             }
+            foreach(RideFilePoint *p, push)
+                code += QString("path.push(new google.maps.LatLng(%1,%2));\n").arg(p->lat,0,'g',GPS_COORD_TO_STRING).arg(p->lon,0,'g',GPS_COORD_TO_STRING);
+
         } else if (mapCombo->currentIndex() == BING) {
             if (count == 0) {
                 code = QString("{\nvar route = new Array();\n");
-            } else {
-                if (rfp->lat || rfp->lon)
-                    code += QString("route.push(new Microsoft.Maps.Location(%1,%2));\n").arg(rfp->lat,0,'g',GPS_COORD_TO_STRING).arg(rfp->lon,0,'g',GPS_COORD_TO_STRING);
             }
+            foreach(RideFilePoint *p, push)
+                code += QString("route.push(new Microsoft.Maps.Location(%1,%2));\n").arg(p->lat,0,'g',GPS_COORD_TO_STRING).arg(p->lon,0,'g',GPS_COORD_TO_STRING);
         }
+        if (push.count()) pushed = push.last();
 
         // running total of time
         rtime += rfp->secs - prevtime;
@@ -1219,14 +1315,20 @@ MapWebBridge::getLatLons(int i)
 
         // so this one is the interval we need.. lets
         // snaffle up the points in this section
+        QVector<RideFilePoint*> points;
         foreach (RideFilePoint *p1, rideItem->ride()->dataPoints()) {
             if (p1->secs+rideItem->ride()->recIntSecs() > current->start
                 && p1->secs< current->stop) {
+                points << p1;
+            }
+        }
 
-                if (p1->lat || p1->lon) {
-                    latlons << p1->lat;
-                    latlons << p1->lon;
-                }
+        QVector<bool> keep;
+        simplifyRoute(points, keep);
+        for (int k=0; k<points.count(); k++) {
+            if (keep[k]) {
+                latlons << points[k]->lat;
+                latlons << points[k]->lon;
             }
         }
         return latlons;
@@ -1234,10 +1336,13 @@ MapWebBridge::getLatLons(int i)
     } else if (rideItem) {
 
         // get latlons for entire route
-        foreach (RideFilePoint *p1, rideItem->ride()->dataPoints()) {
-            if (p1->lat || p1->lon) {
-                latlons << p1->lat;
-                latlons << p1->lon;
+        const QVector<RideFilePoint*> &points = rideItem->ride()->dataPoints();
+        QVector<bool> keep;
+        simplifyRoute(points, keep);
+        for (int k=0; k<points.count(); k++) {
+            if (keep[k]) {
+                latlons << points[k]->lat;
+                latlons << points[k]->lon;
             }
         }
     }
@@ -1283,27 +1388,71 @@ MapWebBridge::clearHover()
 {
 }
 
+static qint64
+searchCell(double lat, double lon)
+{
+    return (qint64(floor(lat / SEARCH_BOX)) << 32) ^ (qint64(floor(lon / SEARCH_BOX)) & 0xffffffffLL);
+}
+
+void
+MapWebBridge::indexPoints(RideFile *ride)
+{
+    grid.clear();
+    ranked.clear();
+
+    const QVector<RideFilePoint*> &points = ride->dataPoints();
+    for (int i=0; i<points.count(); i++) {
+        if (points[i]->lat == 0 && points[i]->lon == 0) continue;
+
+        grid[searchCell(points[i]->lat, points[i]->lon)] << ranked.count();
+        ranked << i;
+    }
+
+    indexed = ride;
+    indexedCount = points.count();
+}
+
+// the last point of each pass through the box around lat/lng, in the
+// order they were ridden, a pass ends at the next point with GPS that
+// is outside the box (so the very last point is never returned)
 QList<RideFilePoint*>
 MapWebBridge::searchPoint(double lat, double lng)
 {
     QList<RideFilePoint*> list;
 
     RideItem *rideItem = mw->property("ride").value<RideItem*>();
+    if (!rideItem || !rideItem->ride()) return list;
+
+    // (re)index when the ride changes
+    RideFile *ride = rideItem->ride();
+    if (ride != indexed || ride->dataPoints().count() != indexedCount) indexPoints(ride);
+
+    const QVector<RideFilePoint*> &points = ride->dataPoints();
 
-    RideFilePoint *candidat = NULL;
-    foreach (RideFilePoint *p1, rideItem->ride()->dataPoints()) {
-        if (p1->lat == 0 && p1->lon == 0)
-            continue;
-
-        if (((p1->lat-lat> 0 && p1->lat-lat< 0.0001) || (p1->lat-lat< 0 && p1->lat-lat> -0.0001)) &&
-            ((p1->lon-lng> 0 && p1->lon-lng< 0.0001) || (p1->lon-lng< 0 && p1->lon-lng> -0.0001))) {
-            // Vérifie distance avec dernier candidat
-            candidat = p1;
-        } else if (candidat)  {
-            list.append(candidat);
-            candidat = NULL;
+    // the points in the box, they can only be in the cells around it
+    QList<int> found;
+    for (int dlat=-1; dlat<=1; dlat++) {
+        for (int dlon=-1; dlon<=1; dlon++) {
+
+            QHash<qint64, QVector<int> >::const_iterator cell;
+            cell = grid.find(searchCell(lat + dlat*SEARCH_BOX, lng + dlon*SEARCH_BOX));
+            if (cell == grid.constEnd()) continue;
+
+            foreach(int rank, cell.value()) {
+                RideFilePoint *p1 = points[ranked[rank]];
+                if (((p1->lat-lat> 0 && p1->lat-lat< SEARCH_BOX) || (p1->lat-lat< 0 && p1->lat-lat> -SEARCH_BOX)) &&
+                    ((p1->lon-lng> 0 && p1->lon-lng< SEARCH_BOX) || (p1->lon-lng< 0 && p1->lon-lng> -SEARCH_BOX)))
+                    found << rank;
+            }
         }
     }
+    qSort(found);
+
+    // a pass ends where the next ranked point isn't in the box
+    for (int i=0; i<found.count(); i++) {
+        bool passEnds = (i == found.count()-1) || (found[i+1] != found[i]+1);
+        if (passEnds && found[i] < ranked.count()-1) list.append(points[ranked[found[i]]]);
+    }
 
     return list;
 }
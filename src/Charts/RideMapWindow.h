@@ -24,6 +24,8 @@
 
 #include <QWidget>
 #include <QDialog>
+#include <QHash>
+#include <QVector>
 
 #include <string>
 #include <iostream>
@@ -85,8 +87,17 @@ class MapWebBridge : public QObject
 
         QList<RideFilePoint*> searchPoint(double lat, double lng);
 
+        // grid of GPS points for searchPoint, cells are the same size as
+        // the search box so a hover only looks at the 3x3 cells around it
+        void indexPoints(RideFile *ride);
+        RideFile *indexed;
+        int indexedCount;
+        QHash<qint64, QVector<int> > grid; // cell -> rank amongst points with lat/lon
+        QVector<int> ranked;               // rank -> sample index
+
     public:
-        MapWebBridge(Context *context, RideMapWindow *mw) : context(context), mw(mw), selection(0) {}
+        MapWebBridge(Context *context, RideMapWindow *mw) : context(context), mw(mw), selection(0),
+                                                            indexed(NULL), indexedCount(0) {}
 
     public slots:
         Q_INVOKABLE void call(int count);
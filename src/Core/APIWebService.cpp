@@ -71,8 +71,8 @@ APIWebService::athleteData(QStringList &paths, HttpRequest &request, HttpRespons
         response.write("missing athlete.");
         return;
     } else {
-        QFile ridedb(home.absolutePath() + "/" + paths[0] + "/cache/rideDB.json");
-        if (!ridedb.exists()) {
+        QString cache = home.absolutePath() + "/" + paths[0] + "/cache";
+        if (!QFile(cache + "/rideDB.bin").exists() && !QFile(cache + "/rideDB.json").exists()) {
             response.setStatus(404); // malformed URL
             response.setHeader("Content-Type", "text; charset=ISO-8859-1");
             response.write("unknown athlete " + paths[0].toLocal8Bit());
@@ -154,8 +154,9 @@ APIWebService::listAthletes(HttpRequest &, HttpResponse &response)
 
         // sure fire sign the athlete has been upgraded to post 3.2 and not some
         // random directory full of other things & check something basic is set
-        QString ridedb = home.absolutePath() + "/" + name + "/cache/rideDB.json";
-        if (QFile(ridedb).exists() && appsettings->cvalue(name, GC_SEX, "") != "") {
+        QString cache = home.absolutePath() + "/" + name + "/cache";
+        if ((QFile(cache + "/rideDB.bin").exists() || QFile(cache + "/rideDB.json").exists()) &&
+            appsettings->cvalue(name, GC_SEX, "") != "") {
             // we got one
             QString line = name;
             line += ", " + appsettings->cvalue(name, GC_DOB).toDate().toString("yyyy/MM/dd");
@@ -25,6 +25,8 @@
 #include "RideMetadata.h"
 #include "RideCache.h"
 #include "RideFileCache.h"
+#include "RideFileCacheIndex.h"
+#include "FreeSearch.h"
 #include "RideMetric.h"
 #include "Settings.h"
 #include "TimeUtils.h"
@@ -191,7 +193,9 @@ Athlete::Athlete(Context *context, const QDir &homeDir)
     connect(context, SIGNAL(refreshEnd()), cloudAutoDownload, SLOT(autoDownload()));
 
     // now most dependencies are in get cache
+    cpxIndex = new RideFileCacheIndex(context);
     rideCache = new RideCache(context);
+    searchIndex = new FreeSearchIndex(context);
 
     // read athlete's charts.xml and translate etc, it needs to be
     // after RideCache creation to allow for Custom Metrics initialization
@@ -238,7 +242,9 @@ Athlete::loadCharts()
 Athlete::~Athlete()
 {
     // close the ride cache down first
+    delete searchIndex;
     delete rideCache;
+    delete cpxIndex;
 
     // save those preset charts
     LTMSettings reader;
@@ -305,6 +311,7 @@ Athlete::checkCPX(RideItem*ride)
             newList.append(p);
     }
     cpxCache = newList;
+    cpxIndex->invalidate(ride->dateTime.date());
 }
 
 void
@@ -638,14 +645,15 @@ Athlete::getPMCFor(QString metricName, int stsdays, int ltsdays)
     PMCData *returning = NULL;
 
     // if we don't already have one, create it
-    returning = pmcData.value(metricName, NULL);
+    QString key = QString("%1|%2|%3").arg(metricName).arg(stsdays).arg(ltsdays);
+    returning = pmcData.value(key, NULL);
     if (!returning) {
 
         // specification is blank and passes for all
         returning = new PMCData(context, Specification(), metricName, stsdays, ltsdays);
 
         // add to our collection
-        pmcData.insert(metricName, returning);
+        pmcData.insert(key, returning);
     }
 
     return returning;
@@ -657,19 +665,43 @@ Athlete::getPMCFor(Leaf *expr, DataFilterRuntime *df, int stsdays, int ltsdays)
     PMCData *returning = NULL;
 
     // if we don't already have one, create it
-    returning = pmcData.value(expr->signature(), NULL);
+    QString key = QString("%1|%2|%3").arg(expr->signature()).arg(stsdays).arg(ltsdays);
+    returning = pmcData.value(key, NULL);
     if (!returning) {
 
         // specification is blank and passes for all
         returning = new PMCData(context, Specification(), expr, df, stsdays, ltsdays);
 
         // add to our collection
-        pmcData.insert(expr->signature(), returning);
+        pmcData.insert(key, returning);
     }
 
     return returning;
 }
 
+// charts with a filter share them too, but users change filters
+// often so we only keep the most recently used few
+PMCData *
+Athlete::getPMCFor(QString metricName, Specification spec, int stsdays, int ltsdays)
+{
+    if (!spec.isFiltered()) return getPMCFor(metricName, stsdays, ltsdays);
+
+    QString key = QString("%1|%2|%3|%4").arg(metricName).arg(stsdays).arg(ltsdays).arg(spec.fingerprint());
+    PMCData *returning = pmcData.value(key, NULL);
+    if (!returning) {
+
+        returning = new PMCData(context, spec, metricName, stsdays, ltsdays);
+        pmcData.insert(key, returning);
+
+        // drop the oldest
+        if (filteredPMC.count() >= 8) delete pmcData.take(filteredPMC.takeFirst());
+
+    } else filteredPMC.removeOne(key);
+
+    filteredPMC << key;
+    return returning;
+}
+
 PDEstimate
 Athlete::getPDEstimateFor(QDate date, QString model, bool wpk)
 {
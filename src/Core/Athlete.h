@@ -44,11 +44,14 @@ class Seasons;
 class RideNavigator;
 class NamedSearches;
 class RideFileCache;
+class RideFileCacheIndex;
+class FreeSearchIndex;
 class RideItem;
 class IntervalItem;
 class IntervalTreeView;
 class PDEstimate;
 class PMCData;
+class Specification;
 class LTMSettings;
 class Routes;
 class AthleteDirectoryStructure;
@@ -99,7 +102,9 @@ class Athlete : public QObject
         QList<PDEstimate> PDEstimates_;
         Routes *routes;
         QList<RideFileCache*> cpxCache;
+        RideFileCacheIndex *cpxIndex;
         RideCache *rideCache;
+        FreeSearchIndex *searchIndex;
         QList<BodyMeasure> bodyMeasures_;
         QList<HrvMeasure> hrvMeasures_;
 
@@ -113,6 +118,8 @@ class Athlete : public QObject
         // PMC Data
         PMCData *getPMCFor(QString metricName, int stsDays = -1, int ltsDays = -1); // no Specification used!
         PMCData *getPMCFor(Leaf *expr, DataFilterRuntime *df, int stsDays = -1, int ltsDays = -1); // no Specification used!
+        PMCData *getPMCFor(QString metricName, Specification spec, int stsDays = -1, int ltsDays = -1); // filtered, a few are kept
+        QStringList filteredPMC; // oldest first
         QMap<QString, PMCData*> pmcData; // all the different PMC series
 
         // athlete measures
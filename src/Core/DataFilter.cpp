@@ -25,7 +25,9 @@
 #include "PMCData.h"
 #include "VDOTCalculator.h"
 #include "DataProcessor.h"
+#include "TaskPool.h"
 #include <QDebug>
+#include <QMutexLocker>
 
 #include "Zones.h"
 #include "PaceZones.h"
@@ -1447,8 +1449,392 @@ void Leaf::validateFilter(Context *context, DataFilterRuntime *df, Leaf *leaf)
     }
 }
 
-DataFilter::DataFilter(QObject *parent, Context *context) : QObject(parent), context(context), treeRoot(NULL)
+// how a symbol is resolved when it isn't a user symbol or sample series
+int
+Leaf::symbolKindFor(DataFilterRuntime *df, const QString &symbol)
 {
+    if (symbol == "x") return XSymbol;
+    if (symbol == "isRun") return IsRunSymbol;
+    if (symbol == "isSwim") return IsSwimSymbol;
+    if (!symbol.compare("NA", Qt::CaseInsensitive)) return NASymbol;
+    if (!symbol.compare("RECINTSECS", Qt::CaseInsensitive)) return RecIntSecsSymbol;
+    if (!symbol.compare("Current", Qt::CaseInsensitive)) return CurrentSymbol;
+    if (!symbol.compare("Today", Qt::CaseInsensitive)) return TodaySymbol;
+    if (!symbol.compare("Date", Qt::CaseInsensitive)) return DateSymbol;
+    if (!symbol.compare("ctl", Qt::CaseInsensitive)) return CTLSymbol;
+    if (!symbol.compare("atl", Qt::CaseInsensitive)) return ATLSymbol;
+    if (!symbol.compare("tsb", Qt::CaseInsensitive)) return TSBSymbol;
+    if (df->lookupType.value(symbol)) return MetricSymbol;
+    return MetaSymbol;
+}
+
+// index into DataFilterFunctions, -1 if not found or parameter mismatch
+int
+Leaf::functionFor(Leaf *leaf)
+{
+    for (int i=0; DataFilterFunctions[i].parameters != -1; i++) {
+        if (DataFilterFunctions[i].name == leaf->function) {
+
+            // parameter mismatch not allowed; function signature mismatch
+            // should be impossible...
+            if (DataFilterFunctions[i].parameters && DataFilterFunctions[i].parameters != leaf->fparms.count())
+                return -1;
+            else
+                return i;
+        }
+    }
+    return -1;
+}
+
+// resolve symbols and functions, must be called once validated so the
+// user symbols and functions are all known and again if the lookup
+// tables change (i.e. config changed). with resolve false they are
+// looked up by name as they are evaluated instead
+void Leaf::compile(DataFilterRuntime *df, Leaf *leaf, bool resolve)
+{
+    if (leaf == NULL) return;
+
+    switch(leaf->type) {
+    case Leaf::Symbol :
+        {
+            QString symbol = *(leaf->lvalue.n);
+            leaf->userSymbol = df->symbols.contains(symbol);
+            leaf->sampleSeries = RideFile::seriesForSymbol(symbol);
+            leaf->symbolKind = symbolKindFor(df, symbol);
+            leaf->rename = df->lookupMap.value(symbol, "");
+        }
+        break;
+
+    case Leaf::Function :
+        {
+            leaf->userFunction = df->functions.value(leaf->function, NULL);
+            leaf->fnum = functionFor(leaf);
+            if (leaf->series) compile(df, leaf->lvalue.l, resolve);
+            foreach(Leaf *p, leaf->fparms) compile(df, p, resolve);
+        }
+        break;
+
+    case Leaf::Vector :
+    case Leaf::Index :
+        {
+            compile(df, leaf->lvalue.l, resolve);
+            foreach(Leaf *p, leaf->fparms) compile(df, p, resolve);
+        }
+        break;
+
+    case Leaf::UnaryOperation :
+        compile(df, leaf->lvalue.l, resolve);
+        break;
+
+    case Leaf::Logical :
+        compile(df, leaf->lvalue.l, resolve);
+        if (leaf->op) compile(df, leaf->rvalue.l, resolve);
+        break;
+
+    case Leaf::Operation :
+    case Leaf::BinaryOperation :
+        compile(df, leaf->lvalue.l, resolve);
+        compile(df, leaf->rvalue.l, resolve);
+        break;
+
+    case Leaf::Conditional :
+        compile(df, leaf->cond.l, resolve);
+        compile(df, leaf->lvalue.l, resolve);
+        compile(df, leaf->rvalue.l, resolve);
+        break;
+
+    case Leaf::Compound :
+        foreach(Leaf *p, *(leaf->lvalue.b)) compile(df, p, resolve);
+        break;
+
+    default:
+        break;
+    }
+    leaf->compiled = resolve;
+}
+
+int
+DataFilterRuntime::indexOf(RideItem *m, RideFilePoint *p)
+{
+    const QVector<RideFilePoint*> &points = m->ride()->dataPoints();
+
+    // same or next as last time
+    if (sampleIndex >= 0 && sampleIndex < points.count() && points[sampleIndex] == p) return sampleIndex;
+    if (sampleIndex+1 < points.count() && points[sampleIndex+1] == p) return ++sampleIndex;
+
+    return sampleIndex = points.indexOf(p);
+}
+
+//
+// COLUMNS
+//
+// Expressions that are pure numeric functions of the current sample are
+// evaluated over all the samples at once; a loop over contiguous arrays
+// for each leaf instead of a walk of the tree for every sample.
+//
+bool
+Leaf::isColumnar(Leaf *leaf)
+{
+    if (leaf == NULL || !leaf->compiled) return false;
+
+    switch(leaf->type) {
+    case Leaf::Float :
+    case Leaf::Integer : return true;
+
+    case Leaf::Symbol :
+        // user symbols may be assigned whilst iterating and metadata
+        // is a string, but data series and metrics are fine
+        if (leaf->userSymbol) return false;
+        return leaf->sampleSeries != RideFile::none || leaf->symbolKind != MetaSymbol;
+
+    case Leaf::UnaryOperation : return isColumnar(leaf->lvalue.l);
+
+    case Leaf::Logical :
+        if (leaf->op == 0) return isColumnar(leaf->lvalue.l);
+        return isColumnar(leaf->lvalue.l) && isColumnar(leaf->rvalue.l);
+
+    case Leaf::Operation :
+    case Leaf::BinaryOperation :
+        switch (leaf->op) {
+        case ADD: case SUBTRACT: case DIVIDE: case MULTIPLY: case POW:
+        case EQ: case NEQ: case LT: case LTE: case GT: case GTE: case ELVIS:
+            return isColumnar(leaf->lvalue.l) && isColumnar(leaf->rvalue.l);
+        default:
+            return false; // assign and string operations
+        }
+
+    case Leaf::Conditional :
+        if (leaf->op != 0 && leaf->op != IF_) return false; // while
+        return isColumnar(leaf->cond.l) && isColumnar(leaf->lvalue.l) &&
+               (leaf->rvalue.l == NULL || isColumnar(leaf->rvalue.l));
+
+    case Leaf::Function :
+        // just the maths functions cos(x) .. isnan(x)
+        return leaf->userFunction == NULL && leaf->fnum >= 0 && leaf->fnum <= 20 && isColumnar(leaf->fparms[0]);
+
+    default:
+        return false;
+    }
+}
+
+// does it refer to the samples, if not it has the same value for all of them
+static bool sampled(Leaf *leaf)
+{
+    switch(leaf->type) {
+    case Leaf::Symbol : return leaf->sampleSeries != RideFile::none;
+    case Leaf::UnaryOperation : return sampled(leaf->lvalue.l);
+    case Leaf::Logical : return sampled(leaf->lvalue.l) || (leaf->op && sampled(leaf->rvalue.l));
+    case Leaf::Operation :
+    case Leaf::BinaryOperation : return sampled(leaf->lvalue.l) || sampled(leaf->rvalue.l);
+    case Leaf::Conditional : return sampled(leaf->cond.l) || sampled(leaf->lvalue.l) ||
+                                    (leaf->rvalue.l && sampled(leaf->rvalue.l));
+    case Leaf::Function : return sampled(leaf->fparms[0]);
+    default: return false;
+    }
+}
+
+// the same results as eval for each sample, see the cases in eval below
+void
+Leaf::evalColumn(DataFilterRuntime *df, Leaf *leaf, float x, RideItem *m, int from, int to,
+                 QVector<double> &column, const QHash<QString,RideMetric*> *c)
+{
+    int n = to - from + 1;
+    if (n <= 0) {
+        column.clear();
+        return;
+    }
+    column.resize(n);
+    double *out = column.data();
+
+    // constant for this ride (or interval)
+    if (!sampled(leaf)) {
+        double value = eval(df, leaf, x, m, NULL, c).number;
+        for (int i=0; i<n; i++) out[i] = value;
+        return;
+    }
+
+    switch(leaf->type) {
+    case Leaf::Symbol :
+        {
+            RideFile *ride = m->ride();
+            if (leaf->sampleSeries == RideFile::index) {
+                for (int i=0; i<n; i++) out[i] = from + i;
+            } else {
+                QVector<double> values = ride->column(leaf->sampleSeries);
+                if (!values.isEmpty()) {
+                    const double *p = values.constData() + from;
+                    for (int i=0; i<n; i++) out[i] = p[i];
+                } else {
+                    const QVector<RideFilePoint*> &points = ride->dataPoints();
+                    for (int i=0; i<n; i++) out[i] = points[from+i]->value(leaf->sampleSeries);
+                }
+            }
+        }
+        break;
+
+    case Leaf::UnaryOperation :
+        {
+            evalColumn(df, leaf->lvalue.l, x, m, from, to, column, c);
+            out = column.data();
+            if (leaf->op == '-') for (int i=0; i<n; i++) out[i] = out[i] * -1;
+            else if (leaf->op == '!') for (int i=0; i<n; i++) out[i] = !out[i];
+            else for (int i=0; i<n; i++) out[i] = 0;
+        }
+        break;
+
+    case Leaf::Logical :
+        {
+            evalColumn(df, leaf->lvalue.l, x, m, from, to, column, c);
+            out = column.data();
+            if (leaf->op == 0) break; // parenthesis
+
+            QVector<double> rhs;
+            evalColumn(df, leaf->rvalue.l, x, m, from, to, rhs, c);
+            const double *r = rhs.constData();
+            if (leaf->op == AND) for (int i=0; i<n; i++) out[i] = (out[i] && r[i]) ? 1 : 0;
+            else for (int i=0; i<n; i++) out[i] = (out[i] || r[i]) ? 1 : 0;
+        }
+        break;
+
+    case Leaf::Operation :
+    case Leaf::BinaryOperation :
+        {
+            evalColumn(df, leaf->lvalue.l, x, m, from, to, column, c);
+            out = column.data();
+
+            QVector<double> rhs;
+            evalColumn(df, leaf->rvalue.l, x, m, from, to, rhs, c);
+            const double *r = rhs.constData();
+
+            switch (leaf->op) {
+            case ADD: for (int i=0; i<n; i++) out[i] = out[i] + r[i]; break;
+            case SUBTRACT: for (int i=0; i<n; i++) out[i] = out[i] - r[i]; break;
+            case MULTIPLY: for (int i=0; i<n; i++) out[i] = out[i] * r[i]; break;
+            case DIVIDE: for (int i=0; i<n; i++) out[i] = r[i] ? out[i] / r[i] : 0; break; // avoid divide by zero
+            case POW: for (int i=0; i<n; i++) out[i] = r[i] ? pow(out[i], r[i]) : 0; break;
+            case EQ: for (int i=0; i<n; i++) out[i] = out[i] == r[i]; break;
+            case NEQ: for (int i=0; i<n; i++) out[i] = out[i] != r[i]; break;
+            case LT: for (int i=0; i<n; i++) out[i] = out[i] < r[i]; break;
+            case LTE: for (int i=0; i<n; i++) out[i] = out[i] <= r[i]; break;
+            case GT: for (int i=0; i<n; i++) out[i] = out[i] > r[i]; break;
+            case GTE: for (int i=0; i<n; i++) out[i] = out[i] >= r[i]; break;
+            case ELVIS: for (int i=0; i<n; i++) out[i] = out[i] ? out[i] : r[i]; break;
+            default: for (int i=0; i<n; i++) out[i] = 0; break;
+            }
+        }
+        break;
+
+    case Leaf::Conditional :
+        {
+            evalColumn(df, leaf->cond.l, x, m, from, to, column, c);
+            out = column.data();
+
+            QVector<double> lhs, rhs(n, 0);
+            evalColumn(df, leaf->lvalue.l, x, m, from, to, lhs, c);
+            if (leaf->rvalue.l) evalColumn(df, leaf->rvalue.l, x, m, from, to, rhs, c);
+            const double *l = lhs.constData();
+            const double *r = rhs.constData();
+
+            for (int i=0; i<n; i++) out[i] = out[i] ? l[i] : r[i];
+        }
+        break;
+
+    case Leaf::Function :
+        {
+            evalColumn(df, leaf->fparms[0], x, m, from, to, column, c);
+            out = column.data();
+
+            switch (leaf->fnum) {
+            case 0 : for (int i=0; i<n; i++) out[i] = cos(out[i]); break;
+            case 1 : for (int i=0; i<n; i++) out[i] = tan(out[i]); break;
+            case 2 : for (int i=0; i<n; i++) out[i] = sin(out[i]); break;
+            case 3 : for (int i=0; i<n; i++) out[i] = acos(out[i]); break;
+            case 4 : for (int i=0; i<n; i++) out[i] = atan(out[i]); break;
+            case 5 : for (int i=0; i<n; i++) out[i] = asin(out[i]); break;
+            case 6 : for (int i=0; i<n; i++) out[i] = cosh(out[i]); break;
+            case 7 : for (int i=0; i<n; i++) out[i] = tanh(out[i]); break;
+            case 8 : for (int i=0; i<n; i++) out[i] = sinh(out[i]); break;
+            case 9 : for (int i=0; i<n; i++) out[i] = acosh(out[i]); break;
+            case 10 : for (int i=0; i<n; i++) out[i] = atanh(out[i]); break;
+            case 11 : for (int i=0; i<n; i++) out[i] = asinh(out[i]); break;
+            case 12 : for (int i=0; i<n; i++) out[i] = exp(out[i]); break;
+            case 13 : for (int i=0; i<n; i++) out[i] = log(out[i]); break;
+            case 14 : for (int i=0; i<n; i++) out[i] = log10(out[i]); break;
+            case 15 : for (int i=0; i<n; i++) out[i] = ceil(out[i]); break;
+            case 16 : for (int i=0; i<n; i++) out[i] = floor(out[i]); break;
+            case 17 : for (int i=0; i<n; i++) out[i] = round(out[i]); break;
+            case 18 : for (int i=0; i<n; i++) out[i] = fabs(out[i]); break;
+            case 19 : for (int i=0; i<n; i++) out[i] = std::isinf(out[i]); break;
+            case 20 : for (int i=0; i<n; i++) out[i] = std::isnan(out[i]); break;
+            default : for (int i=0; i<n; i++) out[i] = 0; break;
+            }
+        }
+        break;
+
+    default:
+        for (int i=0; i<n; i++) out[i] = 0;
+        break;
+    }
+}
+
+bool
+Leaf::accumulateColumns(DataFilterRuntime *df, Leaf *leaf, float x, RideItem *m, int from, int to,
+                        const QHash<QString,RideMetric*> *c)
+{
+    if (leaf == NULL || leaf->type != Leaf::Compound) return false;
+
+    // every statement must be "symbol <- symbol + expr" or "symbol <- expr + symbol"
+    // for a different symbol each time, or an expression with no side effects
+    QStringList symbols;
+    QList<Leaf*> exprs;
+    foreach(Leaf *statement, *(leaf->lvalue.b)) {
+
+        if (isColumnar(statement)) continue; // nothing to do
+
+        if (statement->type != Leaf::Operation || statement->op != ASSIGN) return false;
+
+        Leaf *lhs = statement->lvalue.l;
+        Leaf *rhs = statement->rvalue.l;
+        if (lhs->type != Leaf::Symbol || rhs->type != Leaf::BinaryOperation || rhs->op != ADD) return false;
+
+        QString symbol = *(lhs->lvalue.n);
+        if (symbols.contains(symbol)) return false;
+
+        Leaf *sum = rhs->lvalue.l, *expr = rhs->rvalue.l;
+        if (sum->type != Leaf::Symbol || *(sum->lvalue.n) != symbol) {
+            sum = rhs->rvalue.l;
+            expr = rhs->lvalue.l;
+        }
+        if (sum->type != Leaf::Symbol || *(sum->lvalue.n) != symbol || !sum->compiled ||
+            !sum->userSymbol || sum->sampleSeries != RideFile::none || !isColumnar(expr)) return false;
+
+        symbols << symbol;
+        exprs << expr;
+    }
+
+    // no samples, nothing assigned
+    if (to < from) return true;
+
+    // summed in sample order, just as they would be a sample at a time
+    QVector<double> column;
+    for (int i=0; i<symbols.count(); i++) {
+        evalColumn(df, exprs[i], x, m, from, to, column, c);
+
+        double total = df->symbols.value(symbols[i]).number;
+        const double *values = column.constData();
+        for (int j=0; j<column.count(); j++) total += values[j];
+
+        df->symbols.insert(symbols[i], Result(total));
+    }
+    return true;
+}
+
+DataFilter::DataFilter(QObject *parent, Context *context) : QObject(parent), context(context), treeRoot(NULL), list(NULL),
+                                                              generation(0), epoch(0)
+{
+    // one evaluation at a time, a new one cancels the last
+    background.setMaxThreadCount(1);
+
     // be sure not to enable this by accident!
     rt.isdynamic = false;
 
@@ -1462,10 +1848,19 @@ DataFilter::DataFilter(QObject *parent, Context *context) : QObject(parent), con
     configChanged(CONFIG_FIELDS);
     connect(context, SIGNAL(configChanged(qint32)), this, SLOT(configChanged(qint32)));
     connect(context, SIGNAL(rideSelected(RideItem*)), this, SLOT(dynamicParse()));
+
+    // results we keep go stale
+    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(rideDeleted(RideItem*)));
+    connect(context, SIGNAL(refreshEnd()), this, SLOT(clearResults()));
+    if (context->athlete->rideCache)
+        connect(context->athlete->rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(rideChanged(RideItem*)));
 }
 
-DataFilter::DataFilter(QObject *parent, Context *context, QString formula) : QObject(parent), context(context), treeRoot(NULL)
+DataFilter::DataFilter(QObject *parent, Context *context, QString formula) : QObject(parent), context(context), treeRoot(NULL),
+                                                                              list(NULL), generation(0), epoch(0)
 {
+    background.setMaxThreadCount(1);
+
     // be sure not to enable this by accident!
     rt.isdynamic = false;
 
@@ -1496,6 +1891,8 @@ DataFilter::DataFilter(QObject *parent, Context *context, QString formula) : QOb
     // save away the results if it passed semantic validation
     if (DataFiltererrors.count() != 0)
         treeRoot= NULL;
+    else if (treeRoot)
+        treeRoot->compile(&rt, treeRoot);
 }
 
 Result DataFilter::evaluate(RideItem *item, RideFilePoint *p)
@@ -1524,6 +1921,20 @@ Result DataFilter::evaluate(RideItem *item, RideFilePoint *p)
     return res;
 }
 
+bool DataFilter::evaluateColumn(RideItem *item, QVector<double> &column)
+{
+    if (!item || !treeRoot || DataFiltererrors.count() || !item->ride() || rt.functions.count())
+        return false;
+
+    if (!Leaf::isColumnar(treeRoot)) return false;
+
+    // reset stack
+    rt.stack = 0;
+
+    treeRoot->evalColumn(&rt, treeRoot, 0, item, 0, item->ride()->dataPoints().count()-1, column);
+    return true;
+}
+
 QStringList DataFilter::check(QString query)
 {
     // since we may use it afterwards
@@ -1550,7 +1961,7 @@ QStringList DataFilter::check(QString query)
         // no errors just failed to finish
         if (!treeRoot) DataFiltererrors << tr("malformed expression.");
 
-    }
+    } else treeRoot->compile(&rt, treeRoot);
 
     errors = DataFiltererrors;
     return errors;
@@ -1564,15 +1975,15 @@ QStringList DataFilter::parseFilter(Context *context, QString query, QStringList
     rt.snips.clear();
     rt.symbols.clear();
 
-    // regardless of fail/pass set the signature
-    setSignature(query);
-
     //DataFilterdebug = 2; // no debug -- needs bison -t in src.pro
     DataFilterroot = NULL;
 
     // if something was left behind clear it up now
     clearFilter();
 
+    // regardless of fail/pass set the signature
+    setSignature(query);
+
     // Parse from string
     DataFiltererrors.clear(); // clear out old errors
     DataFilter_setString(query);
@@ -1597,26 +2008,15 @@ QStringList DataFilter::parseFilter(Context *context, QString query, QStringList
 
     } else { // yep! .. we have a winner!
 
+        treeRoot->compile(&rt, treeRoot);
         rt.isdynamic = treeRoot->isDynamic(treeRoot);
 
         // successfully parsed, lets check semantics
         //treeRoot->print(treeRoot);
         emit parseGood();
 
-        // clear current filter list
-        filenames.clear();
-
         // get all fields...
-        foreach(RideItem *item, context->athlete->rideCache->rides()) {
-
-            // evaluate each ride...
-            Result result = treeRoot->eval(&rt, treeRoot, 0, item, NULL);
-            if (result.isNumber && result.number) {
-                filenames << item->fileName;
-            }
-        }
-        emit results(filenames);
-        if (list) *list = filenames;
+        filterRides();
     }
 
     errors = DataFiltererrors;
@@ -1628,25 +2028,279 @@ DataFilter::dynamicParse()
 {
     if (rt.isdynamic) {
         // need to reapply on current state
+        filterRides();
+    }
+}
 
-        // clear current filter list
-        filenames.clear();
+// does the result for a ride only depend on that ride, i.e. no assignments
+// to carry from one ride to the next, no vectors of other rides and nothing
+// that updates rides or athlete data or isn't safe to run in parallel
+static bool independent(Leaf *leaf)
+{
+    if (leaf == NULL) return true;
 
-        // get all fields...
-        foreach(RideItem *item, context->athlete->rideCache->rides()) {
+    switch(leaf->type) {
+    case Leaf::Symbol :
+        return leaf->compiled && leaf->symbolKind != Leaf::CTLSymbol &&
+               leaf->symbolKind != Leaf::ATLSymbol && leaf->symbolKind != Leaf::TSBSymbol &&
+               leaf->symbolKind != Leaf::RecIntSecsSymbol; // looks at the ride
+
+    case Leaf::Vector :
+        return false;
+
+    case Leaf::Operation :
+    case Leaf::BinaryOperation :
+        if (leaf->op == ASSIGN) return false;
+        return independent(leaf->lvalue.l) && independent(leaf->rvalue.l);
+
+    case Leaf::Logical :
+        return independent(leaf->lvalue.l) && (leaf->op == 0 || independent(leaf->rvalue.l));
+
+    case Leaf::UnaryOperation :
+        return independent(leaf->lvalue.l);
+
+    case Leaf::Conditional :
+        return independent(leaf->cond.l) && independent(leaf->lvalue.l) && independent(leaf->rvalue.l);
+
+    case Leaf::Index :
+        return independent(leaf->fparms[0]);
 
-            // evaluate each ride...
-            Result result = treeRoot->eval(&rt, treeRoot, 0, item, NULL);
-            if (result.isNumber && result.number)
-                filenames << item->fileName;
+    case Leaf::Function :
+        {
+            // these update or load the ride or its cache, or use athlete data
+            static const char *unsafe[] = { "set", "unset", "isset", "autoprocess", "postprocess", "estimate",
+                                            "lts", "sts", "sb", "rr", "besttime", "XDATA", "XDATA_UNITS", NULL };
+            for (int i=0; unsafe[i]; i++) if (leaf->function == unsafe[i]) return false;
+
+            if (leaf->series && !independent(leaf->lvalue.l)) return false;
+            foreach(Leaf *p, leaf->fparms) if (!independent(p)) return false;
+            return true;
         }
-        emit results(filenames);
-        if (list) *list = filenames;
+
+    case Leaf::Compound :
+        foreach(Leaf *p, *(leaf->lvalue.b)) if (!independent(p)) return false;
+        return true;
+
+    default:
+        return true;
     }
 }
 
+// evaluates the filter for some of the rides, with its own runtime
+class DataFilterTask : public QRunnable
+{
+    public:
+        DataFilterTask(DataFilter *filter, int generation, Leaf *root, const DataFilterRuntime &rt,
+                       const QVector<RideItem*> &rides)
+            : filter(filter), generation(generation), root(root), rt(rt), rides(rides),
+              matched(rides.count(), false) { setAutoDelete(false); }
+
+        void run() {
+            for (int i=0; i<rides.count(); i++) {
+                if (filter->cancelled(generation)) return;
+                Result result = root->eval(&rt, root, 0, rides[i], NULL);
+                matched[i] = result.isNumber && result.number;
+            }
+        }
+
+        DataFilter *filter;
+        int generation;
+        Leaf *root;
+        DataFilterRuntime rt;
+        QVector<RideItem*> rides;
+        QVector<bool> matched;
+};
+
+// evaluates the filter in the background and hands the results back
+class DataFilterJob : public QRunnable
+{
+    public:
+        DataFilterJob(DataFilter *filter, int generation, Leaf *root, const DataFilterRuntime &rt,
+                      QString signature, const QVector<RideItem*> &rides)
+            : filter(filter), generation(generation), root(root), rt(rt), signature(signature), rides(rides) {}
+
+        void run() {
+            QStringList files;
+            if (filter->evaluateRides(generation, root, rt, signature, rides, files))
+                QMetaObject::invokeMethod(filter, "filterEvaluated", Qt::QueuedConnection,
+                                          Q_ARG(int, generation), Q_ARG(QStringList, files));
+        }
+
+    private:
+        DataFilter *filter;
+        int generation;
+        Leaf *root;
+        DataFilterRuntime rt;
+        QString signature;
+        QVector<RideItem*> rides;
+};
+
+void
+DataFilter::filterRides()
+{
+    const QVector<RideItem*> &rides = context->athlete->rideCache->rides();
+
+    // supersedes any still being evaluated
+    resultLock.lock();
+    int current = ++generation;
+    resultLock.unlock();
+
+    if (!rt.isdynamic && independent(treeRoot)) {
+
+        if (list) {
+
+            // the caller wants them now
+            QStringList files;
+            evaluateRides(current, treeRoot, rt, sig, rides, files);
+            filterEvaluated(current, files);
+
+        } else {
+
+            // results are signalled when ready
+            background.start(new DataFilterJob(this, current, treeRoot, rt, sig, rides));
+        }
+        return;
+    }
+
+    // clear current filter list
+    filenames.clear();
+
+    // evaluate each ride, in order since they depend on each other
+    foreach(RideItem *item, rides) {
+        Result result = treeRoot->eval(&rt, treeRoot, 0, item, NULL);
+        if (result.isNumber && result.number) {
+            filenames << item->fileName;
+        }
+    }
+    emit results(filenames);
+    if (list) *list = filenames;
+}
+
+// rides we don't already have results for are split across the task pool,
+// returns false if cancelled by a newer filter
+bool
+DataFilter::evaluateRides(int current, Leaf *root, const DataFilterRuntime &rt, QString signature,
+                          const QVector<RideItem*> &rides, QStringList &files)
+{
+    resultLock.lock();
+    int was = epoch;
+    QHash<RideItem*, bool> known = matches.value(signature);
+    resultLock.unlock();
+
+    QVector<RideItem*> todo;
+    foreach(RideItem *item, rides) if (!known.contains(item)) todo << item;
+
+    QList<DataFilterTask*> tasks;
+    if (todo.count()) {
+        TaskGroup group;
+        int chunk = todo.count() / (TaskPool::instance()->maxThreads() * 4) + 1;
+        if (chunk < 64) chunk = 64;
+
+        for (int i=0; i<todo.count(); i += chunk) {
+            DataFilterTask *task = new DataFilterTask(this, current, root, rt, todo.mid(i, chunk));
+            tasks << task;
+            group.start(task);
+        }
+        group.wait();
+    }
+
+    if (cancelled(current)) {
+        qDeleteAll(tasks);
+        return false;
+    }
+
+    foreach(DataFilterTask *task, tasks)
+        for (int i=0; i<task->rides.count(); i++) known.insert(task->rides[i], task->matched[i]);
+    qDeleteAll(tasks);
+
+    // keep them unless a ride changed whilst we were at it
+    resultLock.lock();
+    if (was == epoch) {
+        if (!matches.contains(signature)) {
+            recent << signature;
+            if (recent.count() > 8) matches.remove(recent.takeFirst());
+        }
+        matches.insert(signature, known);
+    }
+    resultLock.unlock();
+
+    foreach(RideItem *item, rides)
+        if (known.value(item, false)) files << item->fileName;
+
+    return true;
+}
+
+bool
+DataFilter::cancelled(int current)
+{
+    QMutexLocker locker(&resultLock);
+    return current != generation;
+}
+
+void
+DataFilter::filterEvaluated(int current, QStringList files)
+{
+    // superseded
+    resultLock.lock();
+    bool stale = current != generation;
+    resultLock.unlock();
+    if (stale) return;
+
+    filenames = files;
+    emit results(filenames);
+    if (list) *list = filenames;
+}
+
+void
+DataFilter::rideChanged(RideItem *item)
+{
+    QMutexLocker locker(&resultLock);
+    epoch++;
+
+    QMutableHashIterator<QString, QHash<RideItem*, bool> > it(matches);
+    while (it.hasNext()) it.next().value().remove(item);
+}
+
+void
+DataFilter::rideDeleted(RideItem *item)
+{
+    // the ride is freed once it has been removed, so nothing in the background
+    // can still be looking at it; cancel and evaluate again without it
+    resultLock.lock();
+    bool running = background.activeThreadCount() > 0;
+    generation++;
+    resultLock.unlock();
+    background.waitForDone();
+
+    rideChanged(item);
+    if (running && treeRoot) filterRides();
+}
+
+void
+DataFilter::clearResults()
+{
+    QMutexLocker locker(&resultLock);
+    epoch++;
+    matches.clear();
+    recent.clear();
+}
+
+DataFilter::~DataFilter()
+{
+    // cancel and wait for anything running in the background
+    resultLock.lock();
+    generation++;
+    resultLock.unlock();
+    background.waitForDone();
+}
+
 void DataFilter::clearFilter()
 {
+    // cancel anything running in the background
+    resultLock.lock();
+    generation++;
+    resultLock.unlock();
+
     if (treeRoot) {
         treeRoot->clear(treeRoot);
         treeRoot = NULL;
@@ -1657,6 +2311,17 @@ void DataFilter::clearFilter()
 
 void DataFilter::configChanged(qint32)
 {
+    // the tree is validated and compiled again below, so nothing in the
+    // background can still be evaluating it; cancel and evaluate again after
+    resultLock.lock();
+    bool running = background.activeThreadCount() > 0;
+    generation++;
+    resultLock.unlock();
+    background.waitForDone();
+
+    // metrics and fields may have changed
+    clearResults();
+
     rt.lookupMap.clear();
     rt.lookupType.clear();
 
@@ -1687,6 +2352,18 @@ void DataFilter::configChanged(qint32)
 
     // sample date series
     rt.dataSeriesSymbols = RideFile::symbols();
+
+    // metrics and metadata fields may have changed, so check the program
+    // again from scratch as parseFilter does before resolving the names
+    if (treeRoot) {
+        rt.symbols.clear();
+        DataFiltererrors.clear();
+        treeRoot->validateFilter(context, &rt, treeRoot);
+        errors = DataFiltererrors;
+        treeRoot->compile(&rt, treeRoot);
+    }
+
+    if (running && treeRoot) filterRides();
 }
 
 Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, float x, RideItem *m, RideFilePoint *p, const QHash<QString,RideMetric*> *c)
@@ -1736,7 +2413,8 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, float x, RideItem *m, RideF
         double duration;
 
         // calling a user defined function
-        if (df->functions.contains(leaf->function)) {
+        Leaf *user = leaf->compiled ? leaf->userFunction : df->functions.value(leaf->function, NULL);
+        if (user) {
 
             // going down
             df->stack += 1;
@@ -1748,7 +2426,7 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, float x, RideItem *m, RideF
                 return Result(0);
             }
 
-            Result res = eval(df, df->functions.value(leaf->function), x, m, p, c);
+            Result res = eval(df, user, x, m, p, c);
 
             // pop stack - if we haven't overflowed and reset
             if (df->stack > 0) df->stack -= 1;
@@ -1925,19 +2603,7 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, float x, RideItem *m, RideF
 
         // if we get here its general function handling
         // what function is being called?
-        int fnum=-1;
-        for (int i=0; DataFilterFunctions[i].parameters != -1; i++) {
-            if (DataFilterFunctions[i].name == leaf->function) {
-
-                // parameter mismatch not allowed; function signature mismatch
-                // should be impossible...
-                if (DataFilterFunctions[i].parameters && DataFilterFunctions[i].parameters != leaf->fparms.count())
-                    fnum=-1;
-                else
-                    fnum = i;
-                break;
-            }
-        }
+        int fnum = leaf->compiled ? leaf->fnum : functionFor(leaf);
 
         // not found...
         if (fnum < 0) return Result(0);
@@ -2479,90 +3145,98 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, float x, RideItem *m, RideF
     case Leaf::Symbol :
     {
         double lhsdouble=0.0f;
-        bool lhsisNumber=false;
+        bool lhsisNumber=true;
         QString lhsstring;
-        QString rename;
-        QString symbol = *(leaf->lvalue.n);
+        const QString &symbol = *(leaf->lvalue.n);
 
         // ride series name when running through sample override metrics etc
-        if (p && (lhsisNumber = df->dataSeriesSymbols.contains(*(leaf->lvalue.n))) == true) {
-
-            RideFile::SeriesType type = RideFile::seriesForSymbol((*(leaf->lvalue.n)));
-            if (type == RideFile::index) return Result(m->ride()->dataPoints().indexOf(p));
-            return Result(p->value(type));
+        if (p) {
+            RideFile::SeriesType type = leaf->compiled ? leaf->sampleSeries : RideFile::seriesForSymbol(symbol);
+            if (type == RideFile::index) return Result(df->indexOf(m, p));
+            if (type != RideFile::none) return Result(p->value(type));
         }
 
         // user defined symbols override all others !
-        if (df->symbols.contains(symbol)) return Result(df->symbols.value(symbol));
+        if (!leaf->compiled || leaf->userSymbol) {
+            QHash<QString, Result>::const_iterator it = df->symbols.constFind(symbol);
+            if (it != df->symbols.constEnd()) return it.value();
+        }
 
-        // is it isRun ?
-        if (symbol == "x") {
+        int kind = leaf->compiled ? leaf->symbolKind : symbolKindFor(df, symbol);
+        QString rename = leaf->compiled ? leaf->rename : df->lookupMap.value(symbol,"");
 
+        switch (kind) {
+        case XSymbol:
             lhsdouble = x;
-            lhsisNumber = true;
+            break;
 
-        } else if (symbol == "isRun") {
+        case IsRunSymbol:
             lhsdouble = m->isRun ? 1 : 0;
-            lhsisNumber = true;
+            break;
 
-        } else if (symbol == "isSwim") {
+        case IsSwimSymbol:
             lhsdouble = m->isSwim ? 1 : 0;
-            lhsisNumber = true;
-
-        } else if (!symbol.compare("NA", Qt::CaseInsensitive)) {
+            break;
 
+        case NASymbol:
             lhsdouble = RideFile::NA;
-            lhsisNumber = true;
-
-        } else if (!symbol.compare("RECINTSECS", Qt::CaseInsensitive)) {
+            break;
 
+        case RecIntSecsSymbol:
             lhsdouble = 1; // if in doubt
             if (m->ride(false)) lhsdouble = m->ride(false)->recIntSecs();
-            lhsisNumber = true;
-
-        } else if (!symbol.compare("Current", Qt::CaseInsensitive)) {
+            break;
 
+        case CurrentSymbol:
             if (m->context->currentRideItem())
                 lhsdouble = QDate(1900,01,01).
                 daysTo(m->context->currentRideItem()->dateTime.date());
             else
                 lhsdouble = 0;
-            lhsisNumber = true;
-
-        } else if (!symbol.compare("Today", Qt::CaseInsensitive)) {
+            break;
 
+        case TodaySymbol:
             lhsdouble = QDate(1900,01,01).daysTo(QDate::currentDate());
-            lhsisNumber = true;
-
-        } else if (!symbol.compare("Date", Qt::CaseInsensitive)) {
+            break;
 
+        case DateSymbol:
             lhsdouble = QDate(1900,01,01).daysTo(m->dateTime.date());
-            lhsisNumber = true;
+            break;
 
-        } else if (isCoggan(symbol)) {
+        case CTLSymbol:
+        case ATLSymbol:
+        case TSBSymbol:
+        {
             // a coggan PMC metric
             PMCData *pmcData = m->context->athlete->getPMCFor("coggan_tss");
-            if (!symbol.compare("ctl", Qt::CaseInsensitive)) lhsdouble = pmcData->lts(m->dateTime.date());
-            if (!symbol.compare("atl", Qt::CaseInsensitive)) lhsdouble = pmcData->sts(m->dateTime.date());
-            if (!symbol.compare("tsb", Qt::CaseInsensitive)) lhsdouble = pmcData->sb(m->dateTime.date());
-            lhsisNumber = true;
+            if (kind == CTLSymbol) lhsdouble = pmcData->lts(m->dateTime.date());
+            if (kind == ATLSymbol) lhsdouble = pmcData->sts(m->dateTime.date());
+            if (kind == TSBSymbol) lhsdouble = pmcData->sb(m->dateTime.date());
+        }
+        break;
 
-        } else if ((lhsisNumber = df->lookupType.value(*(leaf->lvalue.n))) == true) {
+        case MetricSymbol:
+        {
             // get symbol value
             // check metadata string to number first ...
-            QString meta = m->getText(rename=df->lookupMap.value(symbol,""), "unknown");
+            QString meta = m->getText(rename, "unknown");
             if (meta == "unknown")
-                if (c) lhsdouble = RideMetric::getForSymbol(rename=df->lookupMap.value(symbol,""), c);
-                else lhsdouble = m->getForSymbol(rename=df->lookupMap.value(symbol,""));
+                if (c) lhsdouble = RideMetric::getForSymbol(rename, c);
+                else lhsdouble = m->getForSymbol(rename);
             else
                 lhsdouble = meta.toDouble();
-            lhsisNumber = true;
 
             //qDebug()<<"symbol" << *(lvalue.n) << "is" << lhsdouble << "via" << rename;
-        } else {
+        }
+        break;
+
+        default:
+        case MetaSymbol:
             // string symbol will evaluate to zero as unary expression
-            lhsstring = m->getText(rename=df->lookupMap.value(symbol,""), "");
+            lhsstring = m->getText(rename, "");
+            lhsisNumber = false;
             //qDebug()<<"symbol" << *(lvalue.n) << "is" << lhsstring << "via" << rename;
+            break;
         }
         if (lhsisNumber) return Result(lhsdouble);
         else return Result(lhsstring);
@@ -27,6 +27,8 @@
 #include <QHash>
 #include <QStringList>
 #include <QTextDocument>
+#include <QMutex>
+#include <QThreadPool>
 #include "RideCache.h"
 #include "RideFile.h" //for SeriesType
 
@@ -58,7 +60,9 @@ class Leaf {
 
     public:
 
-        Leaf(int loc, int leng) : type(none),op(0),series(NULL),dynamic(false),loc(loc),leng(leng),inerror(false) { }
+        Leaf(int loc, int leng) : type(none),op(0),series(NULL),dynamic(false),loc(loc),leng(leng),inerror(false),
+                                  compiled(false),symbolKind(MetaSymbol),userSymbol(false),sampleSeries(RideFile::none),
+                                  fnum(-1),userFunction(NULL) { }
 
         // evaluate against a RideItem using its context
         //
@@ -71,11 +75,27 @@ class Leaf {
         //
         Result eval(DataFilterRuntime *df, Leaf *, float x, RideItem *m, RideFilePoint *p = NULL, const QHash<QString,RideMetric*> *metrics=NULL);
 
+        // evaluate for samples from..to of the ride in one go, a column at a time
+        //
+        // Only for numeric expressions without side effects (arithmetic,
+        // comparisons, maths functions over data series and metrics), check
+        // with isColumnar() first and fall back to eval for each sample if not.
+        static bool isColumnar(Leaf *);
+        void evalColumn(DataFilterRuntime *df, Leaf *, float x, RideItem *m, int from, int to,
+                        QVector<double> &column, const QHash<QString,RideMetric*> *metrics=NULL);
+
+        // a user metric sample function that only sums columnar expressions;
+        // e.g. sample { total <- total + watts*cad; count <- count + 1; }
+        // returns false if it must be evaluated for each sample
+        bool accumulateColumns(DataFilterRuntime *df, Leaf *, float x, RideItem *m, int from, int to,
+                               const QHash<QString,RideMetric*> *metrics=NULL);
+
         // tree traversal etc
         void print(Leaf *, int level, DataFilterRuntime*);  // print leaf and all children
         void color(Leaf *, QTextDocument *);  // update the document to match
         bool isDynamic(Leaf *);
         void validateFilter(Context *context, DataFilterRuntime *, Leaf*); // validate
+        void compile(DataFilterRuntime *, Leaf*, bool resolve=true); // resolve names once validated
         bool isNumber(DataFilterRuntime *df, Leaf *leaf);
         void clear(Leaf*);
         QString toString(); // return as string
@@ -105,6 +125,24 @@ class Leaf {
         int loc, leng;
         bool inerror;
         RideFile::XDataJoin xjoin; // how to join xdata with main
+
+        // symbols and functions are resolved by compile() after validation
+        // so eval doesn't look them up by name for every sample it is called
+        // for. If not compiled they are resolved as they are evaluated.
+        enum { XSymbol, IsRunSymbol, IsSwimSymbol, NASymbol, RecIntSecsSymbol,
+               CurrentSymbol, TodaySymbol, DateSymbol, CTLSymbol, ATLSymbol, TSBSymbol,
+               MetricSymbol, MetaSymbol };
+
+        bool compiled;
+        int symbolKind;                     // from the enum above
+        bool userSymbol;                    // assigned to, overrides all others
+        RideFile::SeriesType sampleSeries;  // when evaluated with a sample, or none
+        QString rename;                     // metric or metadata field name
+        int fnum;                           // in DataFilterFunctions, -1 if not found
+        Leaf *userFunction;                 // user defined function called
+
+        static int symbolKindFor(DataFilterRuntime *df, const QString &symbol);
+        static int functionFor(Leaf *leaf);
 };
 
 class DataFilterRuntime {
@@ -115,6 +153,8 @@ class DataFilterRuntime {
 
 public:
 
+    DataFilterRuntime() : stack(0), isdynamic(false), sampleIndex(-1) {}
+
     // stack count (to stop recursion 'hanging'
     int stack;
 
@@ -139,6 +179,11 @@ public:
 
     QHash<Leaf*, int> indexes;
 
+    // index of sample p in the ride, samples are usually
+    // evaluated in order so we remember where the last was
+    int indexOf(RideItem *m, RideFilePoint *p);
+    int sampleIndex;
+
     // pd models for estimates
     QList <PDModel*>models;
 };
@@ -150,6 +195,7 @@ class DataFilter : public QObject
     public:
         DataFilter(QObject *parent, Context *context);
         DataFilter(QObject *parent, Context *context, QString formula);
+        ~DataFilter();
 
         // runtime passed by datafilter
         DataFilterRuntime rt;
@@ -164,9 +210,14 @@ class DataFilter : public QObject
 
         // RideItem always available and supplies th context
         Result evaluate(RideItem *rideItem, RideFilePoint *p);
+        bool evaluateColumn(RideItem *rideItem, QVector<double> &column); // all samples, false if can't
         QStringList getErrors() { return errors; };
         void colorSyntax(QTextDocument *content, int pos);
 
+        // names are resolved once when parsed, turned off they are looked up
+        // as they are evaluated, as they always were (see MetricBenchmark)
+        void setCompiled(bool resolve) { if (treeRoot) treeRoot->compile(&rt, treeRoot, resolve); }
+
         static QStringList builtins(); // return list of functions supported
 
         int refcount; // used by user metrics
@@ -186,16 +237,40 @@ class DataFilter : public QObject
 
         void results(QStringList);
 
+    private slots:
+        void filterEvaluated(int generation, QStringList files);
+        void rideChanged(RideItem *);
+        void rideDeleted(RideItem *);
+        void clearResults();
 
     private:
+        friend class DataFilterJob;
+        friend class DataFilterTask;
+
         void setSignature(QString &query);
 
+        // apply the filter to all the rides and emit results
+        void filterRides();
+        bool evaluateRides(int generation, Leaf *root, const DataFilterRuntime &rt, QString signature,
+                           const QVector<RideItem*> &rides, QStringList &files);
+        bool cancelled(int generation);
+
         Leaf *treeRoot;
         QStringList errors;
 
         QStringList filenames;
         QStringList *list;
         QString sig;
+
+        // when the result for a ride only depends on that ride they are kept
+        // for the last few filters by signature until the ride changes and
+        // are evaluated in parallel; in the background if no list is wanted
+        QMutex resultLock;
+        int generation;     // bumped by a new filter, cancels the last one
+        int epoch;          // bumped when rides change, results are stale
+        QHash<QString, QHash<RideItem*, bool> > matches;
+        QStringList recent; // signatures in matches, oldest first
+        QThreadPool background;
 };
 
 extern int DataFilterdebug;
@@ -78,43 +78,176 @@ static QStringList searchSplit(QString string)
 
 QList<QString> FreeSearch::search(QString query)
 {
-    filenames.clear();
-
     // search split will tokenise and handle quoting and escaping
     QStringList tokens = searchSplit(query);
 
-    foreach(RideItem*item, context->athlete->rideCache->rides()) {
+    filenames = context->athlete->searchIndex->search(tokens);
+
+    emit results(filenames);
 
-        QMapIterator<QString,QString> meta(item->metadata());
-        meta.toFront();
-        while (meta.hasNext()) {
-            meta.next();
+    return filenames;
+}
 
-            // does the super string contain the tokens?
-            foreach(QString token, tokens) {
+//
+// The index
+//
+static quint64 trigram(const QString &folded, int i)
+{
+    return (quint64(folded[i].unicode()) << 32) | (quint64(folded[i+1].unicode()) << 16) | quint64(folded[i+2].unicode());
+}
 
-                if (meta.value().contains(token, Qt::CaseInsensitive)) {
-                    filenames << item->fileName;
-                    goto nextItem;
-                }
+static QSet<quint64> trigramsOf(const QStringList &texts)
+{
+    QSet<quint64> returning;
+    foreach(QString text, texts) {
+        QString folded = text.toCaseFolded();
+        for (int i=0; i+2 < folded.length(); i++) returning.insert(trigram(folded, i));
+    }
+    return returning;
+}
+
+FreeSearchIndex::FreeSearchIndex(Context *context) : QObject(NULL), context(context), built(false)
+{
+    connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(rideChanged(RideItem*)));
+    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(rideDeleted(RideItem*)));
+    connect(context, SIGNAL(intervalsUpdate(RideItem*)), this, SLOT(rideChanged(RideItem*)));
+    connect(context, SIGNAL(intervalsChanged()), this, SLOT(intervalsChanged()));
+    connect(context, SIGNAL(refreshEnd()), this, SLOT(invalidate()));
+    connect(context, SIGNAL(configChanged(qint32)), this, SLOT(invalidate()));
+    connect(context->athlete->rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(rideChanged(RideItem*)));
+}
+
+void
+FreeSearchIndex::build()
+{
+    foreach(RideItem *item, context->athlete->rideCache->rides()) add(item);
+    built = true;
+}
+
+void
+FreeSearchIndex::add(RideItem *item)
+{
+    QStringList list;
+
+    QMapIterator<QString,QString> meta(item->metadata());
+    meta.toFront();
+    while (meta.hasNext()) {
+        meta.next();
+        list << meta.value();
+    }
+
+    // user intervals - even autodiscovered
+    foreach(IntervalItem *interval, item->intervals()) list << interval->name;
+
+    texts.insert(item, list);
+    foreach(quint64 key, trigramsOf(list)) trigrams[key].insert(item);
+}
+
+void
+FreeSearchIndex::remove(RideItem *item)
+{
+    if (!texts.contains(item)) return;
+
+    foreach(quint64 key, trigramsOf(texts.value(item))) {
+        QHash<quint64, QSet<RideItem*> >::iterator it = trigrams.find(key);
+        if (it == trigrams.end()) continue;
+        it.value().remove(item);
+        if (it.value().isEmpty()) trigrams.erase(it);
+    }
+    texts.remove(item);
+}
+
+void
+FreeSearchIndex::rideChanged(RideItem *item)
+{
+    if (!built || item == NULL) return;
+    remove(item);
+    add(item);
+}
+
+void
+FreeSearchIndex::rideDeleted(RideItem *item)
+{
+    if (built) remove(item);
+}
+
+void
+FreeSearchIndex::intervalsChanged()
+{
+    // always the current ride
+    rideChanged(const_cast<RideItem*>(context->currentRideItem()));
+}
+
+void
+FreeSearchIndex::invalidate()
+{
+    built = false;
+    texts.clear();
+    trigrams.clear();
+}
+
+bool
+FreeSearchIndex::matches(RideItem *item, const QString &token) const
+{
+    foreach(QString text, texts.value(item))
+        if (text.contains(token, Qt::CaseInsensitive)) return true;
+    return false;
+}
+
+QStringList
+FreeSearchIndex::search(const QStringList &tokens)
+{
+    if (!built) build();
+
+    QSet<RideItem*> found;
+    foreach(QString token, tokens) {
+
+        QString folded = token.toCaseFolded();
+
+        // too short to have a trigram, so check every ride
+        if (folded.length() < 3) {
+            QHashIterator<RideItem*, QStringList> it(texts);
+            while (it.hasNext()) {
+                it.next();
+                if (!found.contains(it.key()) && matches(it.key(), token)) found.insert(it.key());
             }
+            continue;
         }
 
-        // user intervals - even autodiscovered
-        foreach(IntervalItem *interval, item->intervals()) {
+        // the rides with all of the token's trigrams
+        QList<const QSet<RideItem*> *> sets;
+        const QSet<RideItem*> *smallest = NULL;
+        for (int i=0; i+2 < folded.length(); i++) {
+            QHash<quint64, QSet<RideItem*> >::const_iterator it = trigrams.constFind(trigram(folded, i));
+            if (it == trigrams.constEnd()) {
+                smallest = NULL; // no ride has it
+                sets.clear();
+                break;
+            }
+            sets << &it.value();
+            if (smallest == NULL || it.value().count() < smallest->count()) smallest = &it.value();
+        }
+        if (smallest == NULL) continue;
 
-            foreach (QString token, tokens) {
+        foreach(RideItem *item, *smallest) {
+            if (found.contains(item)) continue;
 
-                if (interval->name.contains(token, Qt::CaseInsensitive)) {
-                    filenames << item->fileName;
-                    goto nextItem;
+            bool candidate = true;
+            foreach(const QSet<RideItem*> *set, sets) {
+                if (!set->contains(item)) {
+                    candidate = false;
+                    break;
                 }
             }
+            if (candidate && matches(item, token)) found.insert(item);
         }
-        nextItem:;
     }
 
-    emit results(filenames);
-
-    return filenames;
+    // in ride order
+    QStringList returning;
+    if (found.count()) {
+        foreach(RideItem *item, context->athlete->rideCache->rides())
+            if (found.contains(item)) returning << item->fileName;
+    }
+    return returning;
 }
@@ -23,12 +23,58 @@
 #include <QString>
 #include <QDir>
 #include <QMutex>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
 
 #include "Context.h"
 #include "RideMetadata.h"
 #include "RideCache.h"
 #include "RideItem.h"
 
+// Index of the metadata texts and interval names of every ride, so a search
+// doesn't have to scan them all for each token.
+//
+// Each text is broken into the (case folded) trigrams it contains and the
+// index holds the rides each trigram appears in. A token of three or more
+// characters can only be a substring of a ride's text if all of its trigrams
+// are in that ride, so the rides it could match are the intersection of a
+// few sets and only those are checked with QString::contains, which gives
+// exactly the same results as checking them all. That includes prefixes and
+// quoted phrases, they are just longer tokens.
+//
+// Built on the first search and updated as rides are added, deleted or
+// changed and as intervals are updated. A refresh of the ride cache can
+// change them all (e.g. intervals discovered) so it is rebuilt after that.
+// Held by the athlete and shared by all the searches.
+class FreeSearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    FreeSearchIndex(Context *context);
+
+    // files of rides with metadata or interval names containing any token
+    QStringList search(const QStringList &tokens);
+
+public slots:
+    void rideChanged(RideItem *item);
+    void rideDeleted(RideItem *item);
+    void intervalsChanged();
+    void invalidate();
+
+private:
+    void build();
+    void add(RideItem *item);
+    void remove(RideItem *item);
+    bool matches(RideItem *item, const QString &token) const;
+
+    Context *context;
+    bool built;
+    QHash<RideItem*, QStringList> texts;
+    QHash<quint64, QSet<RideItem*> > trigrams;
+};
+
 class FreeSearch : public QObject
 {
     Q_OBJECT
@@ -25,6 +25,7 @@
 #include "ErgFile.h"
 #include "RideFile.h"
 #include "JsonRideFile.h"
+#include "GcbRideFile.h"
 #include "Context.h"
 #include "DataProcessor.h"
 #include "MainWindow.h"
@@ -376,6 +377,17 @@ GcUpgrade::upgrade(const QDir &home)
         CloudServiceFactory::instance().upgrade(home.dirName());
     }
 
+    //----------------------------------------------------------------------
+    // 3.5 binary activity cache
+    //----------------------------------------------------------------------
+    if (last < VERSION35_GCB) {
+
+        // create binary sidecars for the existing activities so
+        // opening them for the first time is as quick as any other
+        AthleteDirectoryStructure athleteHome(home);
+        GcbFileReader::convertActivities(athleteHome.activities(), athleteHome.cache());
+    }
+
 
     //----------------------------------------------------------------------
     // ... here any further Release Number dependent Upgrade Process is to be added ...
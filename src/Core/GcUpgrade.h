@@ -88,6 +88,7 @@
 // 3962 - V3.5 DEVELOPMENT 1705
 // 3963 - V3.5 DEVELOPMENT 1708
 // 3964 - V3.5 DEVELOPMENT 1710
+// 3965 - V3.5 DEVELOPMENT BINARY ACTIVITY CACHE
 
 
 #define VERSION3_BUILD    3010 // released
@@ -99,12 +100,13 @@
 #define VERSION33_BUILD   3933 // development release
 #define VERSION34_BUILD   3955 // released
 #define VERSION35_BUILD   3964 // development release
+#define VERSION35_GCB     3965 // development release
 
 // will keep changing during testing and before final release
 #define VERSION31_BUILD VERSION31_UPG
 
 // the next two will with each build/release
-#define VERSION_LATEST 3964
+#define VERSION_LATEST 3965
 #define VERSION_STRING "DEV-V3.5 1710"
 
 // default config for this release cycle
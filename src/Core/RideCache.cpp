@@ -22,6 +22,7 @@
 #include "Athlete.h"
 #include "RideFileCache.h"
 #include "RideCacheModel.h"
+#include "RideDBStore.h"
 #include "Specification.h"
 #include "DataProcessor.h"
 
@@ -56,6 +57,7 @@ RideCache::RideCache(Context *context) : context(context)
     progress_ = 100;
     refreshingEstimates = false;
     exiting = false;
+    columnsChanges_ = -1;
 
     // initial load of user defined metrics - do once we have an initial context
     // but before we refresh or check metrics for the first time
@@ -151,6 +153,9 @@ RideCache::~RideCache()
 
     // save to store
     save();
+
+    // and wait for it to land on disk
+    compactor.waitForFinished();
 }
 
 void
@@ -176,6 +181,7 @@ RideCache::configChanged(qint32 what)
     if (what & CONFIG_FIELDS) {
         foreach(RideItem *item, rides()) {
             item->metadata_.insert("Calendar Text", context->athlete->rideMetadata()->calendarText(item));
+            changed_.insert(item);
         }
     }
 
@@ -198,6 +204,9 @@ RideCache::itemChanged()
     // BECAUSE IT IS ASSUMED BELOW THE SENDER IS A RIDEITEM
     RideItem *item = static_cast<RideItem*>(QObject::sender());
 
+    // needs journaling
+    changed_.insert(item);
+    metricsChanged();
     // the model is particularly interested in ANY item that changes
     emit itemChanged(item);
 
@@ -251,6 +260,7 @@ RideCache::addRide(QString name, bool dosignal, bool select, bool useTempActivit
 
     // refresh metrics for *this ride only*
     last->refresh();
+    changed_.insert(last);
 
     if (dosignal) context->notifyRideAdded(last); // here so emitted BEFORE rideSelected is emitted!
 
@@ -313,6 +323,7 @@ RideCache::removeCurrentRide()
     model_->startRemove(index);
     rides_.remove(index, 1);
     delete_<<todelete;
+    changed_.remove(todelete);
     model_->endRemove(index);
 
     // delete the file by renaming it
@@ -333,7 +344,7 @@ RideCache::removeCurrentRide()
 
     // remove any other derived/additional files; notes, cpi etc (they can only exist in /cache )
     QStringList extras;
-    extras << "notes" << "cpi" << "cpx";
+    extras << "notes" << "cpi" << "cpx" << "gcb";
     foreach (QString extension, extras) {
 
         QString deleteMe = QFileInfo(strOldFileName).baseName() + "." + extension;
@@ -361,7 +372,40 @@ RideCache::removeCurrentRide()
 // NOTE:
 // We use a bison parser to reduce memory
 // overhead and (believe it or not) simplicity
-// RideCache::load() and save() -- see RideDB.y
+// RideCache::load() and compact() -- see RideDB.y
+
+// journal gets folded back into the store when it gets
+// to a quarter of its size, but no smaller than this
+static const qint64 JOURNAL_MINIMUM = 1024 * 1024;
+
+// save changes to the journal, which is cheap and safe
+void
+RideCache::save()
+{
+    QList<RideItem*> update;
+    QStringList forget;
+    foreach(RideItem *item, rides_) {
+
+        // don't save files with discarded changes at exit
+        if (item->skipsave) forget << item->fileName;
+
+        // skip if not loaded/refreshed, a special case
+        // if saving during an initial refresh. Rides that are
+        // open may have been edited without telling us.
+        else if (item->metrics().count() && (changed_.contains(item) || item->isOpen())) update << item;
+    }
+    changed_.clear();
+
+    // if we couldn't journal the changes they will only be
+    // saved by compacting, so we need to wait for that
+    bool journaled = RideDBStore::journal(context, update, forget);
+
+    QFileInfo store(RideDBStore::fileName(context));
+    if (!journaled || !store.exists() ||
+        RideDBStore::journalSize(context) > qMax(JOURNAL_MINIMUM, store.size() / 4)) {
+        compact(exiting || !journaled);
+    }
+}
 
 // export metrics to csv, for users to play with R, Matlab, Excel etc
 void
@@ -469,8 +513,10 @@ RideCache::refresh()
     foreach(RideItem *item, rides_) {
 
         // ok set stale so we refresh
-        if (item->checkStale())
+        if (item->checkStale()) {
+            changed_.insert(item);
             staleCount++;
+        }
     }
 
     // start if there is work to do
@@ -504,67 +550,95 @@ RideCache::getAggregate(QString name, Specification spec, bool useMetricUnits, b
     double rvalue = 0;
     double rcount = 0; // using double to avoid rounding issues with int when dividing
 
-    // loop through and aggregate
-    foreach (RideItem *item, rides()) {
+    // seen it before ?
+    bool columns = prepareColumns();
+    QString key = name + "|" + spec.fingerprint();
+    QHash<QString, double>::const_iterator memo = aggregates_.constFind(key);
 
-        // skip filtered rides
-        if (!spec.pass(item)) continue;
+    if (columns && memo != aggregates_.constEnd()) {
 
-        // get this value
-        double value = item->getForSymbol(name);
-        double count = item->getForSymbol("workout_time"); // for averaging
+        rvalue = memo.value();
+
+    } else {
+
+        // the rides that pass
+        QVector<int> selected;
+        select(spec, selected);
 
-        // check values are bounded, just in case
-        if (std::isnan(value) || std::isinf(value)) value = 0;
+        // straight from the metric columns unless they're being refreshed
+        const double *values = NULL, *counts = NULL;
+        if (columns) {
+            values = column(metric).constData();
+            counts = column(RideMetricFactory::instance().rideMetric("workout_time")).constData();
+        }
 
         // do we aggregate zero values ?
         bool aggZero = metric->aggregateZero();
+        bool temperature = metric->symbol() == "average_temp";
 
-        // set aggZero to false and value to zero if is temperature and -255
-        if (metric->symbol() == "average_temp" && value == RideFile::NA) {
-            value = 0;
-            aggZero = false;
-        }
+        // loop through and aggregate
+        foreach (int index, selected) {
 
-        switch (metric->type()) {
-        case RideMetric::RunningTotal:
-        case RideMetric::Total:
-            rvalue += value;
-            break;
-        default:
-        case RideMetric::Average:
-            {
-            // average should be calculated taking into account
-            // the duration of the ride, otherwise high value but
-            // short rides will skew the overall average
-            if (value || aggZero) {
-                rvalue += value*count;
-                rcount += count;
-            }
-            break;
-            }
-        case RideMetric::Low:
-            {
-            if (value < rvalue) rvalue = value;
-            break;
-            }
-        case RideMetric::Peak:
-            {
-            if (value > rvalue) rvalue = value;
-            break;
+            // get this value
+            double value = values ? values[index] : rides_[index]->getForSymbol(name);
+            double count = counts ? counts[index] : rides_[index]->getForSymbol("workout_time"); // for averaging
+
+            // check values are bounded, just in case
+            if (std::isnan(value) || std::isinf(value)) value = 0;
+
+            // set aggZero to false and value to zero if is temperature and -255
+            bool zero = aggZero;
+            if (temperature && value == RideFile::NA) {
+                value = 0;
+                zero = false;
             }
-        case RideMetric::MeanSquareRoot:
-            {
-                rvalue = sqrt((pow(rvalue*rcount, 2) + pow(value*count,2))/(rcount + count));
-                rcount += count;
+
+            switch (metric->type()) {
+            case RideMetric::RunningTotal:
+            case RideMetric::Total:
+                rvalue += value;
+                break;
+            default:
+            case RideMetric::Average:
+                {
+                // average should be calculated taking into account
+                // the duration of the ride, otherwise high value but
+                // short rides will skew the overall average
+                if (value || zero) {
+                    rvalue += value*count;
+                    rcount += count;
+                }
+                break;
+                }
+            case RideMetric::Low:
+                {
+                if (value < rvalue) rvalue = value;
+                break;
+                }
+            case RideMetric::Peak:
+                {
+                if (value > rvalue) rvalue = value;
                 break;
+                }
+            case RideMetric::MeanSquareRoot:
+                {
+                    rvalue = sqrt((pow(rvalue*rcount, 2) + pow(value*count,2))/(rcount + count));
+                    rcount += count;
+                    break;
+                }
             }
         }
-    }
 
-    // now compute the average
-    if (metric->type() == RideMetric::Average) {
-        if (rcount) rvalue = rvalue / rcount;
+        // now compute the average
+        if (metric->type() == RideMetric::Average) {
+            if (rcount) rvalue = rvalue / rcount;
+        }
+
+        // remember it, charts ask for the same few over and over
+        if (columns) {
+            if (aggregates_.count() >= 4096) aggregates_.clear();
+            aggregates_.insert(key, rvalue);
+        }
     }
 
     const_cast<RideMetric*>(metric)->setValue(rvalue);
@@ -582,6 +656,82 @@ RideCache::getAggregate(QString name, Specification spec, bool useMetricUnits, b
     return result;
 }
 
+// called on the gui thread by getAggregate, false if the metrics are
+// being refreshed and so might change under us
+bool
+RideCache::prepareColumns()
+{
+    if (future.isRunning()) return false;
+
+    int changes = changes_.fetchAndAddOrdered(0);
+    if (changes != columnsChanges_ || columnRides_ != rides_) {
+        columns_.clear();
+        aggregates_.clear();
+        columnsChanges_ = changes;
+        columnRides_ = rides_;
+    }
+    return true;
+}
+
+// a metric's value for each ride, as getForSymbol would return it
+const QVector<double> &
+RideCache::column(const RideMetric *metric)
+{
+    QHash<int, QVector<double> >::iterator it = columns_.find(metric->index());
+    if (it != columns_.end()) return it.value();
+
+    int metricCount = RideMetricFactory::instance().metricCount();
+    QVector<double> values(rides_.count(), 0.0f);
+    for (int i=0; i<rides_.count(); i++) {
+        const QVector<double> &metrics = rides_[i]->metrics();
+        if (metrics.size() && metrics.size() == metricCount) values[i] = metrics[metric->index()];
+    }
+    return columns_.insert(metric->index(), values).value();
+}
+
+// indexes into rides_ of those that pass the specification; they are
+// in date order so we can find the date range without checking every one
+void
+RideCache::select(Specification &spec, QVector<int> &selected)
+{
+    DateRange dr = spec.dateRange();
+
+    int from = 0, to = rides_.count();
+    if (dr.from.isValid()) {
+        int high = rides_.count();
+        while (from < high) {
+            int mid = (from + high) / 2;
+            if (rides_[mid]->dateTime.date() < dr.from) from = mid + 1;
+            else high = mid;
+        }
+    }
+    if (dr.to.isValid()) {
+        int low = from;
+        while (low < to) {
+            int mid = (low + to) / 2;
+            if (rides_[mid]->dateTime.date() <= dr.to) low = mid + 1;
+            else to = mid;
+        }
+    }
+
+    // filters are lists of filenames, looked up many times
+    QList<QSet<QString> > filters;
+    FilterSet fs = spec.filterSet();
+    foreach(const QStringList &list, fs.filters()) filters << list.toSet();
+
+    selected.reserve(to - from);
+    for (int i=from; i<to; i++) {
+        bool pass = true;
+        foreach(const QSet<QString> &filter, filters) {
+            if (!filter.contains(rides_[i]->fileName)) {
+                pass = false;
+                break;
+            }
+        }
+        if (pass) selected << i;
+    }
+}
+
 bool rideCachesummaryBestGreaterThan(const AthleteBest &s1, const AthleteBest &s2)
 {
      return s1.nvalue > s2.nvalue;
@@ -26,6 +26,9 @@
 #include "PDModel.h"
 
 #include <QVector>
+#include <QSet>
+#include <QHash>
+#include <QAtomicInt>
 #include <QThread>
 
 #include <QFuture>
@@ -83,6 +86,9 @@ class RideCache : public QObject
         // is running ?
         bool isRunning() { return future.isRunning(); }
 
+        // a ride's metrics were recomputed, called from any thread
+        void metricsChanged() { changes_.ref(); }
+
         // the ride list
 	    QVector<RideItem*>&rides() { return rides_; } 
 
@@ -102,9 +108,10 @@ class RideCache : public QObject
 
     public slots:
 
-        // restore / dump cache to disk (json)
+        // restore / dump cache to disk (binary store, json and journal)
         void load();
-        void save();
+        void save(); // journals changes since last save
+        void compact(bool wait=false); // rewrites the store, clearing the journal
 
         // user updated options/preferences
         void configChanged(qint32);
@@ -136,6 +143,7 @@ class RideCache : public QObject
         QDir directory, plannedDirectory;
 
         QVector<RideItem*> rides_, reverse_, delete_;
+        QSet<RideItem*> changed_; // to journal on next save
         RideCacheModel *model_;
         bool exiting;
         bool refreshingEstimates;
@@ -143,7 +151,22 @@ class RideCache : public QObject
 
         QFuture<void> future;
         QFutureWatcher<void> watcher;
-
+        QFuture<void> compactor;
+
+    private:
+
+        // getAggregate works on metric columns in rides_ order and remembers
+        // what it returned; all dropped when any ride's metrics change or
+        // rides are added or removed, not used whilst refreshing
+        bool prepareColumns();
+        const QVector<double> &column(const RideMetric *metric);
+        void select(Specification &spec, QVector<int> &selected);
+
+        QAtomicInt changes_;
+        int columnsChanges_;
+        QVector<RideItem*> columnRides_;
+        QHash<int, QVector<double> > columns_;  // by metric index
+        QHash<QString, double> aggregates_;     // by symbol and spec fingerprint
 };
 
 class AthleteBest
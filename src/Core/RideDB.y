@@ -18,6 +18,7 @@
  */
 
 #include "RideDB.h"
+#include "RideDBStore.h"
 #ifdef GC_WANT_HTTP
 #include "APIWebService.h"
 #endif
@@ -327,9 +328,10 @@ string: STRING                                               { jc->JsonString =
 void 
 RideCache::load()
 {
-    // only load if it exists !
+    // the binary store is much quicker to read, but
+    // only load rideDB.json if it exists !
     QFile rideDB(QString("%1/%2").arg(context->athlete->home->cache().canonicalPath()).arg("rideDB.json"));
-    if (rideDB.exists() && rideDB.open(QFile::ReadOnly)) {
+    if (!RideDBStore::load(this, context) && rideDB.exists() && rideDB.open(QFile::ReadOnly)) {
 
         QDir directory = context->athlete->home->activities();
         QDir plannedDirectory = context->athlete->home->planned();
@@ -377,9 +379,10 @@ RideCache::load()
 
         // regardless of errors we're done !
         delete jc;
-
-        return;
     }
+
+    // and anything saved since it was written
+    RideDBStore::replayJournal(this, context);
 }
 
 // Escape special characters (JSON compliance)
@@ -401,18 +404,22 @@ static QString protect(const QString string)
     return s;
 }
 
-// save cache to disk, "cache/rideDB.json"
-void RideCache::save()
+// rewrite the cache to disk, "cache/rideDB.bin" and "cache/rideDB.json"
+// the contents are serialised here, but written in the background
+void RideCache::compact(bool wait)
 {
+    // one at a time
+    if (compactor.isRunning()) {
+        if (!wait) return;
+        compactor.waitForFinished();
+    }
 
-    // now save data away
-    QFile rideDB(QString("%1/%2").arg(context->athlete->home->cache().canonicalPath()).arg("rideDB.json"));
-    if (rideDB.open(QFile::WriteOnly)) {
-
+    QByteArray json;
+    {
         const RideMetricFactory &factory = RideMetricFactory::instance();
 
         // ok, lets write out the cache
-        QTextStream stream(&rideDB);
+        QTextStream stream(&json, QIODevice::WriteOnly);
         stream.setCodec("UTF-8");
         stream.setGenerateByteOrderMark(true);
 
@@ -622,9 +629,20 @@ void RideCache::save()
         }
 
         stream << "\n  ]\n}";
-
-        rideDB.close();
+        stream.flush();
     }
+
+    // binary store is what we load from next time, the journal
+    // is set aside until it has been written, then removed
+    QByteArray store = RideDBStore::serialise(this);
+    QString cache = context->athlete->home->cache().canonicalPath();
+    QString journal = RideDBStore::rotateJournal(context);
+
+    compactor = QtConcurrent::run(RideDBStore::writeCompacted,
+                                  RideDBStore::fileName(context), store,
+                                  QString("%1/%2").arg(cache).arg("rideDB.json"), json,
+                                  journal);
+    if (wait) compactor.waitForFinished();
 }
 
 #ifdef GC_WANT_HTTP
@@ -635,15 +653,15 @@ APIWebService::listRides(QString athlete, HttpRequest &request, HttpResponse &re
 {
     listRideSettings settings;
 
-    // the ride db
-    QString ridedb = QString("%1/%2/cache/rideDB.json").arg(home.absolutePath()).arg(athlete);
-    QFile rideDB(ridedb);
+    // the ride db, the binary store (with its journal) or the json export
+    QString cache = QString("%1/%2/cache").arg(home.absolutePath()).arg(athlete);
+    QFile rideDB(cache + "/rideDB.json");
 
     // list activities and associated metrics
     response.setHeader("Content-Type", "text; charset=ISO-8859-1");
 
     // not known..
-    if (!rideDB.exists()) {
+    if (!rideDB.exists() && !QFile(cache + "/rideDB.bin").exists()) {
         response.setStatus(404);
         response.write("malformed URL or unknown athlete.\n");
         return;
@@ -768,8 +786,15 @@ APIWebService::listRides(QString athlete, HttpRequest &request, HttpResponse &re
         }
         response.bwrite("\n");
 
-        // parse the rideDB and write a line for each entry
-        if (rideDB.exists() && rideDB.open(QFile::ReadOnly)) {
+        // read the store and its journal and write a line for each entry
+        QList<RideItem*> rides;
+        if (RideDBStore::read(cache, home.absolutePath() + "/" + athlete + "/activities", rides)) {
+
+            foreach(RideItem *item, rides) writeRideLine(*item, &request, &response);
+            qDeleteAll(rides);
+
+        // or parse the rideDB and write a line for each entry
+        } else if (rideDB.exists() && rideDB.open(QFile::ReadOnly)) {
 
             // ok, lets read it in
             QTextStream stream(&rideDB);
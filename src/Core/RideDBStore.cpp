@@ -0,0 +1,806 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideDBStore.h"
+#include "RideDB.h" // for RIDEDB_VERSION
+#include "RideCache.h"
+#include "RideItem.h"
+#include "IntervalItem.h"
+#include "RideMetric.h"
+#include "Context.h"
+#include "Athlete.h"
+#include "MainWindow.h"
+
+#include <QApplication>
+
+#include <string.h>
+#ifdef WIN32
+#include <windows.h> // MoveFileEx
+#include <io.h> // _commit
+#else
+#include <stdio.h> // rename
+#include <unistd.h> // fsync
+#endif
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QHash>
+#include <QDebug>
+
+static const char STORE_MAGIC[8] = { 'G', 'C', 'R', 'I', 'D', 'E', 'D', 'B' };
+static const quint32 STORE_BOM = 0x01020304;
+
+// always 64 bytes
+struct RideDBStoreHeader {
+    char magic[8];
+    quint32 format;
+    quint32 bom;
+    quint32 rides;
+    quint32 metrics;
+    quint64 names, index, values, counts, records; // offsets from start of file
+};
+
+// one per ride, always 24 bytes
+struct RideDBStoreIndex {
+    qint64 date;        // msecs since epoch
+    quint64 offset;     // of the record
+    quint64 length;
+};
+
+// records are written with a fixed stream version so
+// they can be read by later versions of Qt
+static const int STREAM_VERSION = QDataStream::Qt_4_6;
+
+QString
+RideDBStore::fileName(Context *context)
+{
+    return QString("%1/%2").arg(context->athlete->home->cache().canonicalPath()).arg("rideDB.bin");
+}
+
+QStringList
+RideDBStore::columnNames()
+{
+    // column order is metric index order, not factory name order
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+    QVector<QString> names(factory.metricCount());
+    foreach(QString name, factory.allMetrics()) {
+        const RideMetric *m = factory.rideMetric(name);
+        if (m && m->index() >= 0 && m->index() < names.count()) names[m->index()] = name;
+    }
+    return names.toList();
+}
+
+QVector<int>
+RideDBStore::columnMap(const QStringList &names)
+{
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+    QVector<int> map(names.count(), -1);
+    for(int i=0; i<names.count(); i++) {
+        const RideMetric *m = factory.rideMetric(names[i]);
+        if (m) map[i] = m->index();
+    }
+    return map;
+}
+
+//
+// Records
+//
+static void
+writeStd(QDataStream &out, const QMap<int,double> &values)
+{
+    out << quint32(values.count());
+    QMapIterator<int,double> i(values);
+    while (i.hasNext()) {
+        i.next();
+        out << qint32(i.key()) << i.value();
+    }
+}
+
+static void
+readStd(QDataStream &in, QMap<int,double> &values, const QVector<int> &map)
+{
+    quint32 n;
+    in >> n;
+    for (quint32 j=0; j<n && in.status() == QDataStream::Ok; j++) {
+        qint32 column;
+        double value;
+        in >> column >> value;
+        if (column >= 0 && column < map.count() && map[column] >= 0) values.insert(map[column], value);
+    }
+}
+
+void
+RideDBStore::writeRecord(QDataStream &out, RideItem *item)
+{
+    // basic ride information
+    out << item->fileName;
+    out << qint64(item->dateTime.toMSecsSinceEpoch());
+    out << quint64(item->fingerprint) << quint64(item->crc) << quint64(item->metacrc) << quint64(item->timestamp);
+    out << qint32(item->dbversion) << qint32(item->udbversion);
+    out << item->color.name() << item->present;
+    out << item->isRun << item->isSwim << item->weight;
+    out << qint32(item->zoneRange) << qint32(item->hrZoneRange) << qint32(item->paceZoneRange);
+    out << item->overrides_ << item->samples;
+
+    // the metric values are held in the matrix, but
+    // not the stdmean and stdvariance which are sparse
+    writeStd(out, item->stdmeans());
+    writeStd(out, item->stdvariances());
+
+    // metadata and xdata definitions
+    out << item->metadata() << item->xdata();
+
+    // intervals, with their metrics sparse (most are zero)
+    out << quint32(item->intervals().count());
+    foreach(IntervalItem *interval, item->intervals()) {
+
+        out << interval->name << qint32(interval->type);
+        out << interval->start << interval->stop << interval->startKM << interval->stopKM;
+        out << interval->color.name() << interval->route.toString() << qint32(interval->displaySequence);
+
+        quint32 nonzero = 0;
+        for (int i=0; i<interval->metrics().count(); i++)
+            if (interval->metrics()[i] > 0.00f || interval->metrics()[i] < 0.00f) nonzero++;
+
+        out << nonzero;
+        for (int i=0; i<interval->metrics().count(); i++) {
+            if (interval->metrics()[i] > 0.00f || interval->metrics()[i] < 0.00f)
+                out << qint32(i) << interval->metrics()[i] << interval->counts().value(i, 0.0f);
+        }
+        writeStd(out, interval->stdmeans());
+        writeStd(out, interval->stdvariances());
+    }
+}
+
+void
+RideDBStore::readRecord(QDataStream &in, RideItem &item, const QVector<int> &map)
+{
+    qint64 date;
+    quint64 fingerprint, crc, metacrc, timestamp;
+    qint32 dbversion, udbversion, zoneRange, hrZoneRange, paceZoneRange;
+    QString color;
+
+    in >> item.fileName;
+    in >> date;
+    in >> fingerprint >> crc >> metacrc >> timestamp;
+    in >> dbversion >> udbversion;
+    in >> color >> item.present;
+    in >> item.isRun >> item.isSwim >> item.weight;
+    in >> zoneRange >> hrZoneRange >> paceZoneRange;
+    in >> item.overrides_ >> item.samples;
+
+    item.dateTime = QDateTime::fromMSecsSinceEpoch(date);
+    item.fingerprint = fingerprint;
+    item.crc = crc;
+    item.metacrc = metacrc;
+    item.timestamp = timestamp;
+    item.dbversion = dbversion;
+    item.udbversion = udbversion;
+    item.color = QColor(color);
+    item.zoneRange = zoneRange;
+    item.hrZoneRange = hrZoneRange;
+    item.paceZoneRange = paceZoneRange;
+
+    readStd(in, item.stdmeans(), map);
+    readStd(in, item.stdvariances(), map);
+
+    in >> item.metadata() >> item.xdata();
+
+    quint32 intervals;
+    in >> intervals;
+    for (quint32 n=0; n<intervals && in.status() == QDataStream::Ok; n++) {
+
+        IntervalItem interval;
+        qint32 type, seq;
+        QString icolor, route;
+
+        in >> interval.name >> type;
+        in >> interval.start >> interval.stop >> interval.startKM >> interval.stopKM;
+        in >> icolor >> route >> seq;
+
+        interval.type = static_cast<RideFileInterval::IntervalType>(type);
+        interval.color = QColor(icolor);
+        interval.route = QUuid(route);
+        interval.displaySequence = seq;
+
+        quint32 nonzero;
+        in >> nonzero;
+        for (quint32 j=0; j<nonzero && in.status() == QDataStream::Ok; j++) {
+            qint32 column;
+            double value, count;
+            in >> column >> value >> count;
+            if (column >= 0 && column < map.count() && map[column] >= 0) {
+                interval.metrics()[map[column]] = value;
+                interval.counts()[map[column]] = count;
+            }
+        }
+        readStd(in, interval.stdmeans(), map);
+        readStd(in, interval.stdvariances(), map);
+
+        item.addInterval(interval);
+    }
+}
+
+//
+// Load and Save
+//
+// read a store into the rides in byName, if we are passed a list then rides
+// that aren't already there are created and added to it (for the API)
+static bool
+readStore(const QString &filename, const QString &activities, Context *context,
+          QHash<QString, RideItem*> &byName, QList<RideItem*> *created)
+{
+    QFile file(filename);
+    if (!file.exists() || !file.open(QFile::ReadOnly)) return false;
+
+    // we map and leave the OS to page in what we use
+    qint64 size = file.size();
+    const uchar *data = file.map(0, size);
+    if (data == NULL || size < (qint64)sizeof(RideDBStoreHeader)) {
+        file.close();
+        return false;
+    }
+
+    RideDBStoreHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    // check its a store we can read
+    quint64 matrix = quint64(header.rides) * header.metrics * sizeof(double);
+    if (memcmp(header.magic, STORE_MAGIC, sizeof(header.magic)) || header.bom != STORE_BOM ||
+        header.format != RIDEDB_STORE_FORMAT ||
+        header.names > quint64(size) || header.index + (header.rides * sizeof(RideDBStoreIndex)) > quint64(size) ||
+        header.values + matrix > quint64(size) || header.counts + matrix > quint64(size) ||
+        header.records > quint64(size)) {
+
+        qDebug()<<"rideDB.bin unreadable, will use rideDB.json";
+        file.close();
+        return false;
+    }
+
+    // metric names and version
+    QString version;
+    QStringList names;
+    QByteArray namesData = QByteArray::fromRawData(reinterpret_cast<const char*>(data + header.names), header.index - header.names);
+    QDataStream namesStream(namesData);
+    namesStream.setVersion(STREAM_VERSION);
+    namesStream >> version >> names;
+    if (namesStream.status() != QDataStream::Ok || quint32(names.count()) != header.metrics) {
+        file.close();
+        return false;
+    }
+    QVector<int> map = RideDBStore::columnMap(names);
+
+    // the item we read into, as per rideDB.json
+    RideItem item;
+    item.path = activities;
+    item.context = context;
+    item.isstale = item.isdirty = item.isedit = false;
+
+    // an older version means metrics will need refreshing
+    if (version != RIDEDB_VERSION) item.isstale = true;
+
+    const RideDBStoreIndex *index = reinterpret_cast<const RideDBStoreIndex*>(data + header.index);
+    const double *values = reinterpret_cast<const double*>(data + header.values);
+    const double *counts = reinterpret_cast<const double*>(data + header.counts);
+
+    for (quint32 r=0; r<header.rides; r++) {
+
+        if (index[r].offset + index[r].length > quint64(size)) break;
+
+        QByteArray recordData = QByteArray::fromRawData(reinterpret_cast<const char*>(data + index[r].offset), index[r].length);
+        QDataStream in(recordData);
+        in.setVersion(STREAM_VERSION);
+        RideDBStore::readRecord(in, item, map);
+
+        if (in.status() == QDataStream::Ok) {
+
+            // metrics straight out of the matrix
+            const double *rv = values + (quint64(r) * header.metrics);
+            const double *rc = counts + (quint64(r) * header.metrics);
+            for (int c=0; c<map.count(); c++) {
+                if (map[c] < 0) continue;
+                item.metrics()[map[c]] = rv[c];
+                item.counts()[map[c]] = rc[c];
+            }
+
+            RideItem *i = byName.value(item.fileName, NULL);
+            if (!i && created) {
+                i = new RideItem;
+                created->append(i);
+                byName.insert(item.fileName, i);
+            }
+            if (i) {
+
+                // progress update
+                if (context && context->mainWindow->progress) {
+
+                    // percentage progress
+                    QString m = QString("%1%")
+                    .arg(double(context->mainWindow->loading++) /
+                         double(byName.count()) * 100.0f, 0, 'f', 0);
+                    context->mainWindow->progress->setText(m);
+                    QApplication::processEvents();
+                }
+
+                i->setFrom(item);
+
+            } else {
+                qDebug()<<"unable to load:"<<item.fileName<<item.dateTime<<item.weight;
+                foreach(IntervalItem *interval, item.intervals()) delete interval;
+            }
+        }
+
+        // clean for the next one, setFrom has taken the intervals
+        item.metadata().clear();
+        item.xdata().clear();
+        item.metrics().fill(0.0f);
+        item.counts().fill(0.0f);
+        item.stdmeans().clear();
+        item.stdvariances().clear();
+        item.clearIntervals();
+        item.overrides_.clear();
+        item.fileName = "";
+    }
+
+    file.unmap(const_cast<uchar*>(data));
+    file.close();
+    return true;
+}
+
+bool
+RideDBStore::load(RideCache *cache, Context *context)
+{
+    // find rides by name, not by walking the list for each one
+    QHash<QString, RideItem*> byName;
+    foreach(RideItem *i, cache->rides()) byName.insert(i->fileName, i);
+
+    return readStore(fileName(context), context->athlete->home->activities().canonicalPath(), context, byName, NULL);
+}
+
+QByteArray
+RideDBStore::serialise(RideCache *cache)
+{
+    QStringList names = columnNames();
+    int metrics = names.count();
+
+    // which rides do we save ?
+    QVector<RideItem*> rides;
+    foreach(RideItem *item, cache->rides()) {
+
+        // skip if not loaded/refreshed, a special case
+        // if saving during an initial refresh
+        if (item->metrics().count() == 0) continue;
+
+        // don't save files with discarded changes at exit
+        if (item->skipsave == true) continue;
+
+        rides << item;
+    }
+
+    RideDBStoreHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STORE_MAGIC, sizeof(header.magic));
+    header.format = RIDEDB_STORE_FORMAT;
+    header.bom = STORE_BOM;
+    header.rides = rides.count();
+    header.metrics = metrics;
+
+    // names
+    QByteArray namesData;
+    QDataStream namesStream(&namesData, QIODevice::WriteOnly);
+    namesStream.setVersion(STREAM_VERSION);
+    namesStream << QString(RIDEDB_VERSION) << names;
+    while (namesData.size() % 8) namesData.append('\0');
+
+    // matrix and records
+    QVector<double> values(rides.count() * metrics, 0.0), counts(rides.count() * metrics, 0.0);
+    QVector<RideDBStoreIndex> index(rides.count());
+    QByteArray records;
+    QDataStream out(&records, QIODevice::WriteOnly);
+    out.setVersion(STREAM_VERSION);
+
+    for (int r=0; r<rides.count(); r++) {
+
+        RideItem *item = rides[r];
+        for (int c=0; c<metrics && c<item->metrics().count(); c++) {
+            values[r * metrics + c] = item->metrics()[c];
+            counts[r * metrics + c] = item->counts().value(c, 0.0f);
+        }
+
+        index[r].date = item->dateTime.toMSecsSinceEpoch();
+        index[r].offset = records.size(); // relative for now
+        writeRecord(out, item);
+        index[r].length = records.size() - index[r].offset;
+    }
+
+    // now we know where everything goes
+    header.names = sizeof(header);
+    header.index = header.names + namesData.size();
+    header.values = header.index + (rides.count() * sizeof(RideDBStoreIndex));
+    header.counts = header.values + (values.count() * sizeof(double));
+    header.records = header.counts + (counts.count() * sizeof(double));
+    for (int r=0; r<index.count(); r++) index[r].offset += header.records;
+
+    QByteArray returning;
+    returning.reserve(header.records + records.size());
+    returning.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    returning.append(namesData);
+    returning.append(reinterpret_cast<const char*>(index.constData()), index.count() * sizeof(RideDBStoreIndex));
+    returning.append(reinterpret_cast<const char*>(values.constData()), values.count() * sizeof(double));
+    returning.append(reinterpret_cast<const char*>(counts.constData()), counts.count() * sizeof(double));
+    returning.append(records);
+    return returning;
+}
+
+// make sure what we've written is on the disk, not just in the os cache
+static bool
+sync(QFile &file)
+{
+    if (!file.flush()) return false;
+#ifdef WIN32
+    return _commit(file.handle()) == 0;
+#else
+    return fsync(file.handle()) == 0;
+#endif
+}
+
+bool
+RideDBStore::write(const QString &filename, const QByteArray &data)
+{
+    // write to a temporary and replace, so we never leave a partial
+    // file and there is no moment when neither old nor new exists
+    QString tmp = filename + ".tmp";
+    QFile file(tmp);
+    if (!file.open(QFile::WriteOnly)) return false;
+
+    bool success = file.write(data) == data.size() && sync(file);
+    file.close();
+
+    if (success) {
+#ifdef WIN32
+        success = MoveFileExW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(tmp).utf16()),
+                              reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(filename).utf16()),
+                              MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        success = ::rename(QFile::encodeName(tmp).constData(), QFile::encodeName(filename).constData()) == 0;
+#endif
+    }
+    if (!success) QFile::remove(tmp);
+
+    return success;
+}
+
+void
+RideDBStore::writeCompacted(QString store, QByteArray storeData, QString json, QByteArray jsonData, QString journal)
+{
+    // the set aside journal is only removed once the store and the
+    // export it has been folded into are synced and in place, either
+    // may be what we load from next time
+    bool written = write(store, storeData);
+    written = write(json, jsonData) && written;
+    if (written && !journal.isEmpty()) QFile::remove(journal);
+}
+
+//
+// Journal
+//
+static const char JOURNAL_MAGIC[8] = { 'G', 'C', 'R', 'I', 'D', 'E', 'J', 'L' };
+
+// always 16 bytes
+struct RideDBJournalHeader {
+    char magic[8];
+    quint32 format;
+    quint32 bom;
+};
+
+// entry types
+enum { JOURNAL_NAMES=0, JOURNAL_UPDATE=1, JOURNAL_FORGET=2 };
+
+static bool
+appendEntry(QFile &file, const QByteArray &payload)
+{
+    quint32 header[2];
+    header[0] = payload.size();
+    header[1] = qChecksum(payload.constData(), payload.size());
+
+    return file.write(reinterpret_cast<const char*>(header), sizeof(header)) == sizeof(header) &&
+           file.write(payload) == payload.size();
+}
+
+// returns false at the end or when the entry is incomplete or corrupt,
+// which is what we expect to find if we crashed part way through a write
+static bool
+nextEntry(const uchar *data, qint64 size, qint64 &offset, QByteArray &payload)
+{
+    quint32 header[2];
+    if (offset + qint64(sizeof(header)) > size) return false;
+    memcpy(header, data + offset, sizeof(header));
+
+    if (offset + qint64(sizeof(header)) + header[0] > size) return false;
+    payload = QByteArray::fromRawData(reinterpret_cast<const char*>(data + offset + sizeof(header)), header[0]);
+    if (quint32(qChecksum(payload.constData(), payload.size())) != header[1]) return false;
+
+    offset += sizeof(header) + header[0];
+    return true;
+}
+
+QString
+RideDBStore::journalName(Context *context)
+{
+    return QString("%1/%2").arg(context->athlete->home->cache().canonicalPath()).arg("rideDB.jnl");
+}
+
+qint64
+RideDBStore::journalSize(Context *context)
+{
+    return QFileInfo(journalName(context)).size();
+}
+
+// the metric names the journal was started with
+static QStringList
+journalColumns(QFile &file)
+{
+    QStringList names;
+    if (!file.open(QFile::ReadOnly)) return names;
+
+    RideDBJournalHeader header;
+    QByteArray data = file.read(sizeof(header) + 8);
+    if (data.size() == sizeof(header) + 8) {
+
+        memcpy(&header, data.constData(), sizeof(header));
+        quint32 length;
+        memcpy(&length, data.constData() + sizeof(header), sizeof(length));
+
+        if (!memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) && header.bom == STORE_BOM &&
+            header.format == RIDEDB_STORE_FORMAT && qint64(length) <= file.size()) {
+
+            QByteArray payload = file.read(length);
+            QDataStream in(payload);
+            in.setVersion(STREAM_VERSION);
+            qint8 type;
+            QString version;
+            in >> type >> version >> names;
+            if (in.status() != QDataStream::Ok || type != JOURNAL_NAMES || version != RIDEDB_VERSION) names.clear();
+        }
+    }
+    file.close();
+    return names;
+}
+
+bool
+RideDBStore::journal(Context *context, const QList<RideItem*> &update, const QStringList &forget)
+{
+    if (update.isEmpty() && forget.isEmpty()) return true;
+
+    QStringList names = columnNames();
+    QFile file(journalName(context));
+
+    // start a new journal, or check the one we have was written with the same
+    // metrics; if they changed (e.g. user metrics edited) it needs compacting
+    if (file.exists() && file.size() > 0 && journalColumns(file) != names) return false;
+    if (!file.open(QFile::ReadWrite)) return false;
+
+    bool success = true;
+    if (file.size() == 0) {
+
+        RideDBJournalHeader header;
+        memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+        header.format = RIDEDB_STORE_FORMAT;
+        header.bom = STORE_BOM;
+
+        QByteArray payload;
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out.setVersion(STREAM_VERSION);
+        out << qint8(JOURNAL_NAMES) << QString(RIDEDB_VERSION) << names;
+
+        success = file.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header) &&
+                  appendEntry(file, payload);
+    }
+    file.seek(file.size());
+
+    foreach(RideItem *item, update) {
+
+        if (!success) break;
+
+        QByteArray payload;
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out.setVersion(STREAM_VERSION);
+        out << qint8(JOURNAL_UPDATE);
+        writeRecord(out, item);
+        out << item->metrics() << item->counts();
+
+        success = appendEntry(file, payload);
+    }
+
+    foreach(QString name, forget) {
+
+        if (!success) break;
+
+        QByteArray payload;
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out.setVersion(STREAM_VERSION);
+        out << qint8(JOURNAL_FORGET) << name;
+
+        success = appendEntry(file, payload);
+    }
+
+    success = sync(file) && success;
+    file.close();
+    return success;
+}
+
+QString
+RideDBStore::rotateJournal(Context *context)
+{
+    // if a previous compaction failed it is still there, in which
+    // case we leave the current one in place; replaying it on top of
+    // the compacted store is harmless as it holds nothing newer
+    QString current = journalName(context);
+    QString old = current + ".old";
+    if (!QFile::exists(old) && QFile::exists(current) && !QFile::rename(current, old)) return QString();
+    return QFile::exists(old) ? old : QString();
+}
+
+// as readStore, when repairing any partially written entry at the end is
+// truncated, which only the ride cache that owns the journal should do
+static int
+replay(const QString &filename, const QString &activities, Context *context,
+       QHash<QString, RideItem*> &byName, QList<RideItem*> *created, bool repair)
+{
+    QFile file(filename);
+    if (!file.exists() || !file.open(repair ? QFile::ReadWrite : QFile::ReadOnly)) return 0;
+
+    qint64 size = file.size();
+    const uchar *data = size >= qint64(sizeof(RideDBJournalHeader)) ? file.map(0, size) : NULL;
+    if (data == NULL) {
+        file.close();
+        return 0;
+    }
+
+    RideDBJournalHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    int applied = 0;
+    qint64 offset = sizeof(header);
+    QByteArray payload;
+
+    if (!memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) && header.bom == STORE_BOM &&
+        header.format == RIDEDB_STORE_FORMAT && nextEntry(data, size, offset, payload)) {
+
+        // the metrics it was written with
+        qint8 type;
+        QString version;
+        QStringList names;
+        QDataStream namesStream(payload);
+        namesStream.setVersion(STREAM_VERSION);
+        namesStream >> type >> version >> names;
+        QVector<int> map = RideDBStore::columnMap(names);
+
+        // the item we read into, as per rideDB.json
+        RideItem item;
+        item.path = activities;
+        item.context = context;
+        item.isstale = item.isdirty = item.isedit = false;
+
+        // an older version means metrics will need refreshing
+        if (version != RIDEDB_VERSION) item.isstale = true;
+
+        while (nextEntry(data, size, offset, payload)) {
+
+            QDataStream in(payload);
+            in.setVersion(STREAM_VERSION);
+            in >> type;
+
+            if (type == JOURNAL_FORGET) {
+
+                // discarded, so will need refreshing
+                QString name;
+                in >> name;
+                RideItem *i = byName.value(name, NULL);
+                if (i) i->isstale = true;
+
+            } else if (type == JOURNAL_UPDATE) {
+
+                QVector<double> metrics, counts;
+                RideDBStore::readRecord(in, item, map);
+                in >> metrics >> counts;
+
+                if (in.status() == QDataStream::Ok) {
+
+                    for (int c=0; c<map.count() && c<metrics.count() && c<counts.count(); c++) {
+                        if (map[c] < 0) continue;
+                        item.metrics()[map[c]] = metrics[c];
+                        item.counts()[map[c]] = counts[c];
+                    }
+
+                    RideItem *i = byName.value(item.fileName, NULL);
+                    if (!i && created) {
+                        i = new RideItem;
+                        created->append(i);
+                        byName.insert(item.fileName, i);
+                    }
+                    if (i) {
+                        // intervals are replaced, not merged
+                        foreach(IntervalItem *interval, i->intervals()) delete interval;
+                        i->setFrom(item);
+                        applied++;
+                    } else {
+                        foreach(IntervalItem *interval, item.intervals()) delete interval;
+                    }
+                }
+
+                // clean for the next one, setFrom has taken the intervals
+                item.metadata().clear();
+                item.xdata().clear();
+                item.metrics().fill(0.0f);
+                item.counts().fill(0.0f);
+                item.stdmeans().clear();
+                item.stdvariances().clear();
+                item.clearIntervals();
+                item.overrides_.clear();
+                item.fileName = "";
+            }
+        }
+    }
+    file.unmap(const_cast<uchar*>(data));
+
+    // drop anything after the last good entry, it was
+    // partially written when we crashed or were killed
+    if (repair && offset < size) {
+        qDebug()<<"rideDB journal truncated at"<<offset<<"of"<<size<<"bytes";
+        file.resize(offset);
+    }
+    file.close();
+
+    return applied;
+}
+
+int
+RideDBStore::replayJournal(RideCache *cache, Context *context)
+{
+    QHash<QString, RideItem*> byName;
+    foreach(RideItem *i, cache->rides()) byName.insert(i->fileName, i);
+
+    // one set aside by a compaction that didn't complete, then the current
+    QString current = journalName(context);
+    QString activities = context->athlete->home->activities().canonicalPath();
+    return replay(current + ".old", activities, context, byName, NULL, true) +
+           replay(current, activities, context, byName, NULL, true);
+}
+
+static bool
+dateOrder(const RideItem *a, const RideItem *b)
+{
+    return a->dateTime < b->dateTime;
+}
+
+bool
+RideDBStore::read(const QString &cache, const QString &activities, QList<RideItem*> &rides)
+{
+    QHash<QString, RideItem*> byName;
+    if (!readStore(cache + "/rideDB.bin", activities, NULL, byName, &rides)) return false;
+
+    // the journal may be being written as we read it, an incomplete
+    // entry at the end is just ignored
+    QString journal = cache + "/rideDB.jnl";
+    replay(journal + ".old", activities, NULL, byName, &rides, false);
+    replay(journal, activities, NULL, byName, &rides, false);
+
+    qSort(rides.begin(), rides.end(), dateOrder);
+    return true;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _RideDBStore_h
+#define _RideDBStore_h
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QDataStream>
+#include <QByteArray>
+#include <QList>
+
+class RideCache;
+class RideItem;
+class Context;
+
+// Binary equivalent of cache/rideDB.json, held in cache/rideDB.bin
+//
+// The file is memory mapped on load and laid out so the bulk of it, the
+// metric values, can be copied straight into each RideItem:
+//
+//   header     magic "GCRIDEDB", format, byte order mark, counts and offsets
+//   names      RIDEDB_VERSION and the metric symbols in column order
+//   index      for each ride; date, offset and length of its record
+//   values     rides x metrics matrix of doubles
+//   counts     rides x metrics matrix of doubles
+//   records    for each ride everything else (state, metadata, xdata,
+//              intervals) serialised with QDataStream
+//
+// Metrics are stored by symbol so the store survives metrics being added
+// or removed, any that are no longer known are ignored on load.
+//
+// rideDB.json is still written as an export for the API and other tools,
+// but is only read if rideDB.bin is missing or unreadable.
+//
+// Between rewrites changes are appended to cache/rideDB.jnl, a journal of
+// checksummed entries; the metric symbols it was started with, then a record
+// and metric values for each ride updated, or the name of a ride whose state
+// was discarded. It is replayed after the store is loaded and truncated at
+// the first incomplete entry. When the store is rewritten (compacted) the
+// journal is set aside as rideDB.jnl.old until the new store is safely on
+// disk, so a crash part way through loses nothing.
+
+#define RIDEDB_STORE_FORMAT 1
+
+class RideDBStore
+{
+    public:
+
+        // load into the ride cache, returns false if not available
+        // so the caller can fall back to reading rideDB.json
+        static bool load(RideCache *cache, Context *context);
+
+        // every ride in the store and journal in date order, for readers
+        // without a ride cache (the API), the caller deletes them. returns
+        // false if there is no store so the caller can read rideDB.json
+        static bool read(const QString &cache, const QString &activities, QList<RideItem*> &rides);
+
+        // the whole ride cache, written when compacting
+        static QByteArray serialise(RideCache *cache);
+        static bool write(const QString &filename, const QByteArray &data); // via tmp, synced and replaced
+
+        // run in the background when compacting, the journal passed is removed
+        // once the store has been written
+        static void writeCompacted(QString store, QByteArray storeData, QString json, QByteArray jsonData, QString journal);
+
+        // append changes to the journal, returns false if it needs to be
+        // compacted first (e.g. metrics have changed since it was started)
+        static bool journal(Context *context, const QList<RideItem*> &update, const QStringList &forget);
+        static int replayJournal(RideCache *cache, Context *context); // returns rides updated
+        static QString rotateJournal(Context *context); // set aside, returns its name
+        static QString journalName(Context *context);
+        static qint64 journalSize(Context *context);
+
+        // serialise everything but the ride metric values for a ride, the
+        // metric indexes used are those in the factory at the time of writing
+        // so readRecord maps them with the column map from the file
+        static void writeRecord(QDataStream &out, RideItem *item);
+        static void readRecord(QDataStream &in, RideItem &item, const QVector<int> &map);
+
+        // map from column in a store to the current metric index, -1 if unknown
+        static QVector<int> columnMap(const QStringList &names);
+        static QStringList columnNames();
+
+        static QString fileName(Context *context);
+};
+
+#endif // _RideDBStore_h
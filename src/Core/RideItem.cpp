@@ -20,6 +20,7 @@
 #include "RideMetric.h"
 #include "RideFile.h"
 #include "RideFileCache.h"
+#include "RideCache.h"
 #include "RideMetadata.h"
 #include "IntervalItem.h"
 #include "Route.h"
@@ -29,7 +30,7 @@
 #include "PaceZones.h"
 #include "Settings.h"
 #include "Colors.h" // for ColorEngine
-#include "AddIntervalDialog.h" // till we fixup ridefilecache to have offsets
+#include "PeakSearch.h" // peak power and pace discovery
 #include "TimeUtils.h" // time_to_string()
 #include "WPrime.h" // for matches
 
@@ -656,6 +657,9 @@ RideItem::refresh()
         // Construct the summary text used on the calendar
         metadata_.insert("Calendar Text", context->athlete->rideMetadata()->calendarText(this));
 
+        // aggregates over the metrics need recomputing
+        if (context->athlete->rideCache) context->athlete->rideCache->metricsChanged();
+
         // close if we opened it
         if (doclose) {
             close();
@@ -946,11 +950,14 @@ RideItem::updateIntervals()
                                 tr("1 minute"), tr("5 minutes"), tr("10 minutes"), tr("20 minutes"), tr("30 minutes"), tr("45 minutes"),
                                 tr("1 hour") };
     
+        // go hunting for best peaks, all durations at once
+        QVector<double> windows;
+        for(int i=0; durations[i] != 0; i++) windows << durations[i];
+        QVector<QList<PeakEffort> > peaks = PeakSearch::find(f, Specification(), RideFile::watts, true, windows);
+
         for(int i=0; durations[i] != 0; i++) {
 
-            // go hunting for best peak
-            QList<AddIntervalDialog::AddedInterval> results;
-            AddIntervalDialog::findPeaks(context, true, f, Specification(), RideFile::watts, RideFile::original, durations[i], 1, results, "", "");
+            const QList<PeakEffort> &results = peaks[i];
 
             // did we get one ?
             if (results.count() > 0 && results[0].avg > 0 && results[0].stop > 0) {
@@ -980,11 +987,14 @@ RideItem::updateIntervals()
                                 tr("1 hour") };
 
         bool metric = appsettings->value(this, context->athlete->paceZones(f->isSwim())->paceSetting(), true).toBool();
+        // go hunting for best peaks, all durations at once
+        QVector<double> windows;
+        for(int i=0; durations[i] != 0; i++) windows << durations[i];
+        QVector<QList<PeakEffort> > peaks = PeakSearch::find(f, Specification(), RideFile::kph, true, windows);
+
         for(int i=0; durations[i] != 0; i++) {
 
-            // go hunting for best peak
-            QList<AddIntervalDialog::AddedInterval> results;
-            AddIntervalDialog::findPeaks(context, true, f, Specification(), RideFile::kph, RideFile::original, durations[i], 1, results, "", "");
+            const QList<PeakEffort> &results = peaks[i];
 
             // did we get one ?
             if (results.count() > 0 && results[0].avg > 0 && results[0].stop > 0) {
@@ -135,6 +135,7 @@
 #define GC_SETTINGS_INTERVAL_METRICS    "<global-general>rideSummaryWindow/intervalMetrics"
 #define GC_TABBAR                       "<global-general>show/tabbar"                        // show tabbar
 #define GC_WBALFORM                     "<global-general>wbal/formula"                       // wbal formula to use
+#define GC_TASKPOOL_THREADS             "<global-general>taskpool/threads"                   // task pool cap, 0 is cores
 #define GC_BIKESCOREDAYS                    "<global-general>bikeScoreDays"
 #define GC_BIKESCOREMODE                    "<global-general>bikeScoreMode"
 #define GC_WARNCONVERT                  "<global-general>warnconvert"
@@ -21,10 +21,38 @@
 #include "IntervalItem.h"
 #include "RideFile.h"
 
+#include <QHash>
+
 Specification::Specification(DateRange dr, FilterSet fs) : dr(dr), fs(fs), it(NULL), recintsecs(0), ri(NULL) {}
 Specification::Specification(IntervalItem *it, double recintsecs) : it(it), recintsecs(recintsecs), ri(NULL) {}
 Specification::Specification() : it(NULL), recintsecs(0), ri(NULL) {}
 
+// two hashes of each list so a collision is very unlikely, the
+// filters can be long lists of filenames so we don't use them as is
+QString
+FilterSet::fingerprint() const
+{
+    QString returning = QString("%1").arg(filters_.count());
+    foreach(const QStringList &list, filters_) {
+        uint a = 0, b = list.count();
+        foreach(const QString &name, list) {
+            uint h = qHash(name);
+            a = (a * 31) + h;
+            b ^= h + 0x9e3779b9 + (b << 6) + (b >> 2);
+        }
+        returning += QString(":%1.%2.%3").arg(list.count()).arg(a).arg(b);
+    }
+    return returning;
+}
+
+QString
+Specification::fingerprint() const
+{
+    return QString("%1-%2-%3").arg(dr.from.toString(Qt::ISODate))
+                              .arg(dr.to.toString(Qt::ISODate))
+                              .arg(fs.fingerprint());
+}
+
 // does the rideitem pass the specification ?
 bool 
 Specification::pass(RideItem*item)
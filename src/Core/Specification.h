@@ -71,6 +71,10 @@ class FilterSet
         }
 
         int count() { return filters_.count(); }
+
+        // the lists themselves and a key that identifies them
+        const QVector<QStringList> &filters() const { return filters_; }
+        QString fingerprint() const;
 };
 
 class RideFileIterator;
@@ -106,6 +110,9 @@ class Specification
         FilterSet filterSet() { return fs; }
         bool isFiltered() { return (fs.count() > 0); }
 
+        // identifies the rides it will pass, for caching aggregates
+        QString fingerprint() const;
+
         // just start/stop and item for now
         // when working with samples
         void print();
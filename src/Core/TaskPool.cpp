@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TaskPool.h"
+#include "Settings.h"
+
+#include <QThread>
+#include <QMutexLocker>
+
+// runs queued tasks on a pool thread until there are none
+// left or the machine is busy enough without it
+class TaskWorker : public QRunnable
+{
+    public:
+        TaskWorker(TaskPool *pool) : pool(pool) { setAutoDelete(true); }
+        void run() { while (pool->runNext()) ; }
+
+    private:
+        TaskPool *pool;
+};
+
+TaskPool *
+TaskPool::instance()
+{
+    static TaskPool pool;
+    return &pool;
+}
+
+TaskPool::TaskPool() : max(1), working_(0), running_(0), completed_(0)
+{
+    setMaxThreads(appsettings->value(NULL, GC_TASKPOOL_THREADS, 0).toInt());
+}
+
+void
+TaskPool::setMaxThreads(int n)
+{
+    if (n <= 0) n = QThread::idealThreadCount();
+    if (n < 1) n = 1;
+
+    QMutexLocker locker(&lock);
+    max = n;
+    threads.setMaxThreadCount(n);
+}
+
+int
+TaskPool::queued() const
+{
+    QMutexLocker locker(&lock);
+    return queue.count();
+}
+
+int
+TaskPool::running() const
+{
+    QMutexLocker locker(&lock);
+    return running_;
+}
+
+int
+TaskPool::completed() const
+{
+    QMutexLocker locker(&lock);
+    return completed_;
+}
+
+// called with the lock held; the outer parallel work (e.g. the
+// RideCache refresh) is running in the global thread pool
+bool
+TaskPool::overloaded() const
+{
+    return working_ + QThreadPool::globalInstance()->activeThreadCount() >= max;
+}
+
+void
+TaskPool::enqueue(TaskGroup *group, QRunnable *task)
+{
+    QMutexLocker locker(&lock);
+
+    group->pending++;
+    queue.append(QPair<TaskGroup*, QRunnable*>(group, task));
+
+    // wake another pool thread if there is room for it, if not the
+    // task will be run by the thread that waits on the group
+    if (!overloaded() && threads.activeThreadCount() < queue.count()) {
+        TaskWorker *worker = new TaskWorker(this);
+        if (!threads.tryStart(worker)) delete worker;
+    }
+}
+
+// run a task taken off the queue, called without the lock held
+void
+TaskPool::execute(TaskGroup *group, QRunnable *task)
+{
+    bool autoDelete = task->autoDelete();
+    task->run();
+    if (autoDelete) delete task;
+
+    QMutexLocker locker(&lock);
+    running_--;
+    completed_++;
+    group->pending--;
+    finished.wakeAll();
+}
+
+bool
+TaskPool::runNext()
+{
+    lock.lock();
+    if (queue.isEmpty() || overloaded()) {
+        lock.unlock();
+        return false;
+    }
+
+    // oldest first
+    QPair<TaskGroup*, QRunnable*> next = queue.takeFirst();
+    working_++;
+    running_++;
+    lock.unlock();
+
+    execute(next.first, next.second);
+
+    QMutexLocker locker(&lock);
+    working_--;
+    return true;
+}
+
+void
+TaskPool::wait(TaskGroup *group)
+{
+    lock.lock();
+    while (group->pending > 0) {
+
+        // take back our own tasks that haven't started yet, newest first
+        int index = -1;
+        for (int i=queue.count()-1; i>=0; i--) {
+            if (queue[i].first == group) {
+                index = i;
+                break;
+            }
+        }
+
+        // all started, so wait for them to finish
+        if (index < 0) {
+            finished.wait(&lock);
+            continue;
+        }
+
+        QPair<TaskGroup*, QRunnable*> next = queue.takeAt(index);
+        running_++;
+        lock.unlock();
+
+        execute(next.first, next.second);
+
+        lock.lock();
+    }
+    lock.unlock();
+}
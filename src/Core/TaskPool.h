@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_TaskPool_h
+#define _GC_TaskPool_h 1
+#include "GoldenCheetah.h"
+
+#include <QList>
+#include <QPair>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QRunnable>
+
+class TaskGroup;
+
+// One pool of threads shared by all the fine grained work we do in parallel
+//
+// Work is submitted as QRunnables via a TaskGroup and the group waited on.
+// A thread waiting on a group doesn't sit idle, it takes back the tasks of
+// its own group that haven't been started yet and runs them itself, newest
+// first, while the pool threads take them oldest first.
+//
+// This matters because most of the work arrives from threads that are
+// already busy; RideCache::refresh() maps over all the rides on the global
+// QThreadPool and each ride computes its RideFileCache in there. So the pool
+// only starts threads while the total of its own running tasks and the
+// threads active in the global pool is below the cap, when the refresh is
+// using every core each ride just runs its own tasks, and when a single ride
+// is recomputed on its own the tasks fan out across the cores.
+//
+// The cap defaults to the number of cores and can be set via
+// GC_TASKPOOL_THREADS or setMaxThreads().
+
+class TaskPool
+{
+    friend class TaskGroup;
+    friend class TaskWorker;
+
+    public:
+        static TaskPool *instance();
+
+        // concurrency cap, 0 means the number of cores
+        void setMaxThreads(int max);
+        int maxThreads() const { return max; }
+
+        // for diagnostics
+        int queued() const;     // waiting to start
+        int running() const;    // in pool threads or threads waiting on a group
+        int completed() const;
+
+    private:
+        TaskPool();
+
+        void enqueue(TaskGroup *group, QRunnable *task);
+        void execute(TaskGroup *group, QRunnable *task);
+        void wait(TaskGroup *group);
+        bool runNext(); // pool threads, false when should stop
+        bool overloaded() const;
+
+        mutable QMutex lock;
+        QWaitCondition finished;
+        QList<QPair<TaskGroup*, QRunnable*> > queue;
+        QThreadPool threads;
+        int max;
+
+        int working_;               // tasks running on pool threads
+        int running_, completed_;   // all tasks, guarded by lock
+};
+
+// a set of tasks submitted together and waited on together
+class TaskGroup
+{
+    friend class TaskPool;
+
+    public:
+        TaskGroup(TaskPool *pool = TaskPool::instance()) : pool(pool), pending(0) {}
+        ~TaskGroup() { wait(); }
+
+        // deleted after running if task->autoDelete() as with QThreadPool
+        void start(QRunnable *task) { pool->enqueue(this, task); }
+
+        // returns when all the tasks started have finished
+        void wait() { pool->wait(this); }
+
+    private:
+        TaskPool *pool;
+        int pending; // guarded by pool->lock
+};
+
+#endif // _GC_TaskPool_h
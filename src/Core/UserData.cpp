@@ -350,10 +350,13 @@ UserData::setRideItem(RideItem*m)
 
         if (vector.count() == 0 && rideItem->ride()) {
 
-            // run through each sample and create an equivalent
-            foreach(RideFilePoint *p, rideItem->ride()->dataPoints()) {
-                Result res = parser.evaluate(rideItem, p);
-                vector << res.number;
+            // all in one go if we can, otherwise run through
+            // each sample and create an equivalent
+            if (!parser.evaluateColumn(rideItem, vector)) {
+                foreach(RideFilePoint *p, rideItem->ride()->dataPoints()) {
+                    Result res = parser.evaluate(rideItem, p);
+                    vector << res.number;
+                }
             }
 
             // cache for next time !
@@ -19,9 +19,13 @@
 #include "Context.h"
 #include "Athlete.h"
 #include "MainWindow.h"
+#include "Tab.h"
 #include "Settings.h"
 #include "CloudService.h"
 #include "TrainDB.h"
+#include "TrainBenchmark.h"
+#include "RideFileCache.h"
+#include "MetricBenchmark.h"
 #include "Colors.h"
 #include "GcUpgrade.h"
 #include "IdleTimer.h"
@@ -188,6 +192,9 @@ main(int argc, char *argv[])
     bool debug = false;
 #endif
     bool server = false;
+    QStringList trainbench;
+    QString meanmaxcheck;
+    bool metricbench = false;
     nogui = false;
     bool help = false;
 
@@ -214,6 +221,11 @@ main(int argc, char *argv[])
 #ifdef GC_WANT_R
             fprintf(stderr, "--no-r              to disable R startup\n");
 #endif
+            fprintf(stderr, "--trainbench=workout,recording[,speed]\n"
+                            "                    to time a workout against a replayed ride or antlog.raw and exit\n");
+            fprintf(stderr, "--metricbench       to time the user metrics for every ride of the athlete and exit\n");
+            fprintf(stderr, "--meanmaxcheck=folder\n"
+                            "                    to check the mean max search against the one it replaced and exit\n");
             fprintf (stderr, "\nSpecify the folder and/or athlete to open on startup\n");
             fprintf(stderr, "If no parameters are passed it will reopen the last athlete.\n\n");
 
@@ -238,6 +250,22 @@ main(int argc, char *argv[])
 #else
             debug = true;
 #endif
+        } else if (arg.startsWith("--trainbench=")) {
+
+            trainbench = arg.mid(QString("--trainbench=").length()).split(",");
+            if (trainbench.count() < 2) {
+                fprintf(stderr, "--trainbench needs a workout and a recording, exiting.\n");
+                exit(1);
+            }
+
+        } else if (arg == "--metricbench") {
+
+            metricbench = true;
+
+        } else if (arg.startsWith("--meanmaxcheck=")) {
+
+            meanmaxcheck = arg.mid(QString("--meanmaxcheck=").length());
+
         } else if (arg == "--clouddbcurator") {
 #ifdef GC_HAS_CLOUD_DB
             CloudDBCommon::addCuratorFeatures = true;
@@ -307,6 +335,9 @@ main(int argc, char *argv[])
     //XXXIdleEventFilter idleFilter;
     //XXXapplication->installEventFilter(&idleFilter);
 
+    // check the mean max search against test rides then quit, no athlete needed
+    if (meanmaxcheck != "") exit(RideFileCache::checkMeanMax(meanmaxcheck) ? 1 : 0);
+
     // set default colors
     GCColor::setupColors();
     appsettings->migrateQSettingsSystem(); // colors must be setup before migration can take place, but reading has to be from the migrated ones
@@ -678,7 +709,25 @@ main(int argc, char *argv[])
             }
         }
 
+        // time the train loop then quit, see TrainBenchmark
+        TrainBenchmark *bench = NULL;
+        if (trainbench.count() >= 2 && mainwindows.count()) {
+            bench = new TrainBenchmark(mainwindows.first()->athleteTab()->context, trainbench.at(0), trainbench.at(1),
+                                       trainbench.count() > 2 ? trainbench.at(2).toDouble() : 1.0);
+            QObject::connect(bench, SIGNAL(done()), application, SLOT(quit()));
+            if (!bench->start()) QTimer::singleShot(0, application, SLOT(quit()));
+            trainbench.clear(); // not again if we restart
+        }
+
+        // time the user metrics then quit, see MetricBenchmark
+        if (metricbench && mainwindows.count()) {
+            MetricBenchmark::run(mainwindows.first()->athleteTab()->context);
+            QTimer::singleShot(0, application, SLOT(quit()));
+            metricbench = false; // not again if we restart
+        }
+
         ret=application->exec();
+        delete bench;
 
         // close trainDB
         delete trainDB;
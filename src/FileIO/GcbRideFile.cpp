@@ -0,0 +1,605 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "GcbRideFile.h"
+#include "JsonRideFile.h"
+#include <string.h>
+#include <stddef.h> // for offsetof
+
+#include <QDebug>
+#include <QTemporaryFile>
+
+static int gcbFileReaderRegistered =
+    RideFileFactory::instance().registerReader(
+        "gcb", "GoldenCheetah Binary", new GcbFileReader());
+
+static const char GCB_MAGIC[8] = { 'G', 'C', 'B', 'R', 'I', 'D', 'E', '\0' };
+static const quint32 GCB_BOM = 0x01020304;
+
+// file header, always 48 bytes
+struct GcbHeader {
+    char magic[8];
+    quint32 version;
+    quint32 bom;            // byte order check, we don't swap
+    qint64 sourceSize;      // stamp of the .json a sidecar was created from
+    qint64 sourceModified;  // msecs since epoch
+    quint32 samples;
+    quint32 blocks;
+    quint64 reserved;
+};
+
+// block header, always 16 bytes, followed by length bytes of payload
+struct GcbBlock {
+    char tag[4];
+    quint32 count;
+    quint64 length;
+};
+
+// the series we store, and the names we use for them -- these
+// are the same as the .json format, so don't change them
+static const struct {
+    const char *name;
+    RideFile::SeriesType series;
+} gcbSeries[] = {
+    { "SECS", RideFile::secs }, { "KM", RideFile::km }, { "WATTS", RideFile::watts },
+    { "NM", RideFile::nm }, { "CAD", RideFile::cad }, { "KPH", RideFile::kph },
+    { "HR", RideFile::hr }, { "ALT", RideFile::alt }, { "LAT", RideFile::lat },
+    { "LON", RideFile::lon }, { "HEADWIND", RideFile::headwind }, { "SLOPE", RideFile::slope },
+    { "TEMP", RideFile::temp }, { "LRBALANCE", RideFile::lrbalance }, { "LTE", RideFile::lte },
+    { "RTE", RideFile::rte }, { "LPS", RideFile::lps }, { "RPS", RideFile::rps },
+    { "LPCO", RideFile::lpco }, { "RPCO", RideFile::rpco }, { "LPPB", RideFile::lppb },
+    { "RPPB", RideFile::rppb }, { "LPPE", RideFile::lppe }, { "RPPE", RideFile::rppe },
+    { "LPPPB", RideFile::lpppb }, { "RPPPB", RideFile::rpppb }, { "LPPPE", RideFile::lpppe },
+    { "RPPPE", RideFile::rpppe }, { "SMO2", RideFile::smo2 }, { "THB", RideFile::thb },
+    { "RCAD", RideFile::rcad }, { "RVERT", RideFile::rvert }, { "RCON", RideFile::rcontact },
+    { "TCORE", RideFile::tcore }, { "INTERVAL", RideFile::interval },
+    { NULL, RideFile::none }
+};
+
+//
+// Writing
+//
+class GcbWriter {
+
+    public:
+        GcbWriter() : blocks(0), start(-1) {}
+
+        void align() { while (out.size() % 8) out.append('\0'); }
+
+        void begin(const char *tag, quint32 count) {
+            align();
+            GcbBlock block;
+            memcpy(block.tag, tag, 4);
+            block.count = count;
+            block.length = 0; // updated in end()
+            start = out.size();
+            out.append(reinterpret_cast<const char*>(&block), sizeof(block));
+            blocks++;
+        }
+        void end() {
+            align();
+            quint64 length = out.size() - start - sizeof(GcbBlock);
+            memcpy(out.data() + start + offsetof(GcbBlock, length), &length, sizeof(length));
+        }
+
+        void number(double x) { out.append(reinterpret_cast<const char*>(&x), sizeof(x)); }
+        void integer(qint32 x) { out.append(reinterpret_cast<const char*>(&x), sizeof(x)); }
+        void string(const QString &x) {
+            QByteArray utf8 = x.toUtf8();
+            integer(utf8.size());
+            out.append(utf8);
+        }
+
+        QByteArray out;
+        quint32 blocks;
+        int start;
+};
+
+QByteArray
+GcbFileReader::toByteArray(const RideFile *ride, qint64 sourceSize, qint64 sourceModified)
+{
+    GcbWriter w;
+
+    // header, counts are updated at the end
+    GcbHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GCB_MAGIC, sizeof(header.magic));
+    header.version = GCB_VERSION;
+    header.bom = GCB_BOM;
+    header.sourceSize = sourceSize;
+    header.sourceModified = sourceModified;
+    header.samples = ride->dataPoints().count();
+    w.out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // first class variables
+    w.begin("META", 1);
+    qint64 start = ride->startTime().toMSecsSinceEpoch();
+    w.out.append(reinterpret_cast<const char*>(&start), sizeof(start));
+    w.number(ride->recIntSecs());
+    w.string(ride->deviceType());
+    w.string(ride->fileFormat());
+    w.string(ride->id());
+    w.end();
+
+    // metadata
+    if (ride->tags().count()) {
+        w.begin("TAGS", ride->tags().count());
+        QMap<QString,QString>::const_iterator i;
+        for (i=ride->tags().constBegin(); i != ride->tags().constEnd(); i++) {
+            w.string(i.key());
+            w.string(i.value());
+        }
+        w.end();
+    }
+
+    // metric overrides
+    if (ride->metricOverrides.count()) {
+        w.begin("OVER", ride->metricOverrides.count());
+        QMap<QString,QMap<QString, QString> >::const_iterator k;
+        for (k=ride->metricOverrides.constBegin(); k != ride->metricOverrides.constEnd(); k++) {
+            w.string(k.key());
+            w.integer(k.value().count());
+            QMap<QString, QString>::const_iterator j;
+            for (j=k.value().constBegin(); j != k.value().constEnd(); j++) {
+                w.string(j.key());
+                w.string(j.value());
+            }
+        }
+        w.end();
+    }
+
+    // intervals
+    if (ride->intervals().count()) {
+        w.begin("INTV", ride->intervals().count());
+        foreach(RideFileInterval *i, ride->intervals()) {
+            w.integer(static_cast<qint32>(i->type));
+            w.number(i->start);
+            w.number(i->stop);
+            w.string(i->name);
+        }
+        w.end();
+    }
+
+    // calibrations
+    if (ride->calibrations().count()) {
+        w.begin("CALB", ride->calibrations().count());
+        foreach(RideFileCalibration *i, ride->calibrations()) {
+            w.number(i->start);
+            w.integer(i->value);
+            w.string(i->name);
+        }
+        w.end();
+    }
+
+    // references
+    if (ride->referencePoints().count()) {
+        w.begin("REFS", ride->referencePoints().count());
+        foreach(RideFilePoint *p, ride->referencePoints()) {
+            w.number(p->secs);
+            w.number(p->cad);
+            w.number(p->hr);
+            w.number(p->watts);
+        }
+        w.end();
+    }
+
+    // a column for each series present, secs always
+    if (ride->dataPoints().count()) {
+        RideFile *f = const_cast<RideFile*>(ride);
+        for (int s=0; gcbSeries[s].name; s++) {
+
+            RideFile::SeriesType series = gcbSeries[s].series;
+            if (series != RideFile::secs && !f->isDataPresent(series)) continue;
+
+            w.begin("COLN", ride->dataPoints().count());
+            w.string(gcbSeries[s].name);
+            w.align();
+            foreach(RideFilePoint *p, ride->dataPoints()) w.number(p->value(series));
+            w.end();
+        }
+    }
+
+    // xdata
+    QMapIterator<QString,XDataSeries*> xdata(const_cast<RideFile*>(ride)->xdata());
+    while(xdata.hasNext()) {
+
+        xdata.next();
+        XDataSeries *series = xdata.value();
+
+        // no value names means nothing to store (same as .json)
+        if (series->valuename.isEmpty()) continue;
+
+        int values = qMin(series->valuename.count(), XDATA_MAXVALUES);
+        w.begin("XDAT", series->datapoints.count());
+        w.string(xdata.key());
+        w.integer(values);
+        foreach(QString x, series->valuename.mid(0, values)) w.string(x);
+        w.integer(series->unitname.count());
+        foreach(QString x, series->unitname) w.string(x);
+        w.align();
+        foreach(XDataPoint *p, series->datapoints) {
+            w.number(p->secs);
+            w.number(p->km);
+            for(int i=0; i<values; i++) w.number(p->number[i]);
+        }
+        w.end();
+    }
+
+    // now we know how many blocks there are
+    header.blocks = w.blocks;
+    memcpy(w.out.data(), &header, sizeof(header));
+
+    return w.out;
+}
+
+bool
+GcbFileReader::writeRideFile(Context *, const RideFile *ride, QFile &file) const
+{
+    // can we open the file for writing?
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    // truncate existing
+    file.resize(0);
+
+    QByteArray data = toByteArray(ride);
+    bool success = (file.write(data) == data.size());
+
+    file.close();
+    return success;
+}
+
+//
+// Reading
+//
+class GcbReader {
+
+    public:
+        GcbReader(const uchar *data, qint64 size) : p(data), end(data+size), ok(true) {}
+
+        // unsigned, so a corrupt length can't wrap round to pass the check
+        bool have(quint64 n) { if (quint64(end - p) < n) ok = false; return ok; }
+
+        void align(const uchar *base) { while ((p - base) % 8) p++; }
+
+        double number() {
+            double x = 0;
+            if (have(sizeof(x))) { memcpy(&x, p, sizeof(x)); p += sizeof(x); }
+            return x;
+        }
+        qint32 integer() {
+            qint32 x = 0;
+            if (have(sizeof(x))) { memcpy(&x, p, sizeof(x)); p += sizeof(x); }
+            return x;
+        }
+        QString string() {
+            qint32 n = integer();
+            if (n < 0 || !have(n)) { ok = false; return QString(); }
+            QString x = QString::fromUtf8(reinterpret_cast<const char*>(p), n);
+            p += n;
+            return x;
+        }
+
+        const uchar *p, *end;
+        bool ok;
+};
+
+// read from a mapped (or in memory) image of a .gcb file
+static RideFile *
+fromData(const uchar *data, qint64 size, QStringList &errors, qint64 *sourceSize=NULL, qint64 *sourceModified=NULL)
+{
+    GcbHeader header;
+    if (size < (qint64)sizeof(header)) {
+        errors << "truncated header";
+        return NULL;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, GCB_MAGIC, sizeof(header.magic)) || header.bom != GCB_BOM) {
+        errors << "not a GoldenCheetah binary file, or wrong byte order";
+        return NULL;
+    }
+    if (header.version > GCB_VERSION) {
+        errors << QString("unsupported version %1").arg(header.version);
+        return NULL;
+    }
+
+    // sidecar stamp
+    if (sourceSize) *sourceSize = header.sourceSize;
+    if (sourceModified) *sourceModified = header.sourceModified;
+
+    RideFile *ride = new RideFile;
+
+    // samples are gathered column by column and appended at the end
+    QVector<const uchar *> columns;
+    QVector<RideFile::SeriesType> series;
+
+    GcbReader r(data + sizeof(header), size - sizeof(header));
+    for (quint32 b=0; b < header.blocks && r.ok; b++) {
+
+        r.align(data);
+
+        GcbBlock block;
+        if (!r.have(sizeof(block))) break;
+        memcpy(&block, r.p, sizeof(block));
+        r.p += sizeof(block);
+
+        if (!r.have(block.length)) break;
+        const uchar *next = r.p + block.length;
+        QByteArray tag(block.tag, 4);
+
+        if (tag == "META") {
+
+            qint64 start = 0;
+            if (r.have(sizeof(start))) { memcpy(&start, r.p, sizeof(start)); r.p += sizeof(start); }
+            ride->setStartTime(QDateTime::fromMSecsSinceEpoch(start));
+            ride->setRecIntSecs(r.number());
+            ride->setDeviceType(r.string());
+            ride->setFileFormat(r.string());
+            ride->setId(r.string());
+
+        } else if (tag == "TAGS") {
+
+            for (quint32 i=0; i<block.count && r.ok; i++) {
+                QString key = r.string();
+                QString value = r.string();
+                ride->setTag(key, value);
+            }
+
+        } else if (tag == "OVER") {
+
+            for (quint32 i=0; i<block.count && r.ok; i++) {
+                QString name = r.string();
+                QMap<QString,QString> values;
+                qint32 n = r.integer();
+                for (qint32 j=0; j<n && r.ok; j++) {
+                    QString key = r.string();
+                    values.insert(key, r.string());
+                }
+                ride->metricOverrides.insert(name, values);
+            }
+
+        } else if (tag == "INTV") {
+
+            for (quint32 i=0; i<block.count && r.ok; i++) {
+                qint32 type = r.integer();
+                double start = r.number();
+                double stop = r.number();
+                QString name = r.string();
+                if (type < 0 || type > RideFileInterval::last()) type = RideFileInterval::USER;
+                ride->addInterval(static_cast<RideFileInterval::IntervalType>(type), start, stop, name);
+            }
+
+        } else if (tag == "CALB") {
+
+            for (quint32 i=0; i<block.count && r.ok; i++) {
+                double start = r.number();
+                qint32 value = r.integer();
+                ride->addCalibration(start, value, r.string());
+            }
+
+        } else if (tag == "REFS") {
+
+            for (quint32 i=0; i<block.count && r.ok; i++) {
+                RideFilePoint p;
+                p.secs = r.number();
+                p.cad = r.number();
+                p.hr = r.number();
+                p.watts = r.number();
+                ride->appendReference(p);
+            }
+
+        } else if (tag == "COLN") {
+
+            QString name = r.string();
+            r.align(data);
+            if (block.count != header.samples || !r.have(qint64(block.count) * sizeof(double))) {
+                r.ok = false;
+                break;
+            }
+
+            // unknown series are from a later version, just skip them
+            for (int s=0; gcbSeries[s].name; s++) {
+                if (name == gcbSeries[s].name) {
+                    columns << r.p;
+                    series << gcbSeries[s].series;
+                    break;
+                }
+            }
+
+        } else if (tag == "XDAT") {
+
+            XDataSeries *add = new XDataSeries;
+            add->name = r.string();
+            qint32 values = r.integer();
+            for (qint32 i=0; i<values && r.ok; i++) add->valuename << r.string();
+            qint32 units = r.integer();
+            for (qint32 i=0; i<units && r.ok; i++) add->unitname << r.string();
+            r.align(data);
+
+            if (values < 0 || values > XDATA_MAXVALUES ||
+                !r.have(qint64(block.count) * (2 + values) * sizeof(double))) {
+                r.ok = false;
+                delete add;
+                break;
+            }
+            for (quint32 i=0; i<block.count; i++) {
+                XDataPoint *p = new XDataPoint();
+                p->secs = r.number();
+                p->km = r.number();
+                for (qint32 j=0; j<values; j++) p->number[j] = r.number();
+                add->datapoints.append(p);
+            }
+            ride->addXData(add->name, add);
+        }
+
+        // move on to the next block, skipping any we don't know
+        r.p = next;
+    }
+
+    if (!r.ok) {
+        errors << "truncated or corrupt file";
+        delete ride;
+        return NULL;
+    }
+
+    // now append the samples, a point at a time, reading across the columns
+    for (quint32 i=0; i<header.samples; i++) {
+        RideFilePoint p;
+        for (int c=0; c<columns.count(); c++) {
+            double value;
+            memcpy(&value, columns[c] + (i * sizeof(double)), sizeof(double));
+            p.setValue(series[c], value);
+        }
+        ride->appendPoint(p);
+    }
+
+    return ride;
+}
+
+RideFile *
+GcbFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*) const
+{
+    if (!file.open(QFile::ReadOnly)) {
+        errors << "unable to open file" + file.fileName();
+        return NULL;
+    }
+
+    // map it if we can, otherwise read it all in
+    RideFile *returning = NULL;
+    uchar *mapped = file.map(0, file.size());
+    if (mapped) {
+        returning = fromData(mapped, file.size(), errors);
+        file.unmap(mapped);
+    } else {
+        QByteArray contents = file.readAll();
+        returning = fromData(reinterpret_cast<const uchar*>(contents.constData()), contents.size(), errors);
+    }
+    file.close();
+
+    return returning;
+}
+
+//
+// Sidecar cache for .json activities
+//
+static bool
+sidecarCurrent(const QString &filename, const QFileInfo &source)
+{
+    // just check the header
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly)) return false;
+
+    GcbHeader header;
+    bool current = file.read(reinterpret_cast<char*>(&header), sizeof(header)) == sizeof(header) &&
+                   !memcmp(header.magic, GCB_MAGIC, sizeof(header.magic)) && header.bom == GCB_BOM &&
+                   header.version == GCB_VERSION &&
+                   header.sourceSize == source.size() &&
+                   header.sourceModified == source.lastModified().toMSecsSinceEpoch();
+    file.close();
+    return current;
+}
+
+QString
+GcbFileReader::sidecarFileName(const QDir &cache, const QFileInfo &source)
+{
+    return cache.absolutePath() + "/" + source.baseName() + ".gcb";
+}
+
+RideFile *
+GcbFileReader::openSidecar(const QDir &cache, const QFileInfo &source)
+{
+    QFile file(sidecarFileName(cache, source));
+    if (!file.exists() || !file.open(QFile::ReadOnly)) return NULL;
+
+    RideFile *returning = NULL;
+    QStringList sidecarErrors;
+    qint64 size=-1, modified=-1;
+
+    uchar *mapped = file.map(0, file.size());
+    if (mapped) {
+        returning = fromData(mapped, file.size(), sidecarErrors, &size, &modified);
+        file.unmap(mapped);
+    } else {
+        QByteArray contents = file.readAll();
+        returning = fromData(reinterpret_cast<const uchar*>(contents.constData()), contents.size(), sidecarErrors, &size, &modified);
+    }
+    file.close();
+
+    // out of date, the .json has been changed since
+    if (returning && (size != source.size() || modified != source.lastModified().toMSecsSinceEpoch())) {
+        delete returning;
+        return NULL;
+    }
+
+    // a broken sidecar isn't fatal, we just use the .json, so the
+    // ride's errors aren't the place to say why it couldn't be read
+    if (sidecarErrors.count()) qDebug()<<"gcb sidecar ignored:"<<file.fileName()<<sidecarErrors;
+
+    return returning;
+}
+
+bool
+GcbFileReader::writeSidecar(const QDir &cache, const QFileInfo &source, const RideFile *ride)
+{
+    if (!cache.exists()) return false;
+
+    QString filename = sidecarFileName(cache, source);
+    QByteArray data = toByteArray(ride, source.size(), source.lastModified().toMSecsSinceEpoch());
+
+    // write to a uniquely named temporary then rename, so readers never
+    // see a partial file and concurrent writers don't share a temporary
+    QTemporaryFile file(filename + ".XXXXXX");
+    if (!file.open()) return false;
+    bool success = (file.write(data) == data.size());
+    file.close();
+
+    if (success) {
+        QFile::remove(filename);
+        success = file.rename(filename);
+    }
+
+    // the temporary is removed when we return, unless it is now the sidecar
+    if (success) file.setAutoRemove(false);
+
+    return success;
+}
+
+int
+GcbFileReader::convertActivities(const QDir &activities, const QDir &cache)
+{
+    int converted = 0;
+    JsonFileReader json;
+
+    foreach(QString name, activities.entryList(QStringList() << "*.json", QDir::Files)) {
+
+        QFileInfo source(activities.absolutePath() + "/" + name);
+
+        // already current ?
+        if (sidecarCurrent(sidecarFileName(cache, source), source)) continue;
+
+        // read the .json and write the sidecar
+        QStringList errors;
+        QFile file(source.absoluteFilePath());
+        RideFile *ride = json.openRideFile(file, errors);
+        if (ride) {
+            if (writeSidecar(cache, source, ride)) converted++;
+            delete ride;
+        }
+    }
+    return converted;
+}
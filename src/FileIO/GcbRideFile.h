@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GcbRideFile_h
+#define _GcbRideFile_h
+#include "GoldenCheetah.h"
+
+#include "RideFile.h"
+#include <QDir>
+#include <QFileInfo>
+
+// GoldenCheetah binary activity format (.gcb)
+//
+// A versioned, native byte order representation of a RideFile that can be
+// memory mapped and read without any parsing. It holds exactly what the
+// .json format holds (plus interval types and core temperature) so it can
+// be round-tripped with .json without loss.
+//
+// The file is a fixed header followed by a list of blocks, every block and
+// every sample column is aligned on an 8 byte boundary:
+//
+//   header   magic "GCBRIDE", version, byte order mark, source stamp,
+//            sample count and block count
+//   META     start time, recording interval, device, format and id
+//   TAGS     metadata key/value pairs
+//   OVER     metric overrides
+//   INTV     intervals (type, start, stop, name)
+//   CALB     calibrations
+//   REFS     reference points
+//   COLN     one block per series present; its name then a column of doubles
+//   XDAT     one block per xdata series
+//
+// As well as being a file format in its own right it is used as a sidecar
+// cache for .json activities, held in the athlete /cache folder. The sidecar
+// records the size and timestamp of the .json it was created from and is
+// ignored if they no longer match.
+
+#define GCB_VERSION 1
+
+struct GcbFileReader : public RideFileReader {
+    virtual RideFile *openRideFile(QFile &file, QStringList &errors, QList<RideFile*>* = 0) const;
+    bool writeRideFile(Context *context, const RideFile *ride, QFile &file) const;
+    bool hasWrite() const { return true; }
+
+    // serialise, with the size and timestamp of the file it was read from
+    static QByteArray toByteArray(const RideFile *ride, qint64 sourceSize=0, qint64 sourceModified=0);
+
+    // sidecar cache for activities stored as .json
+    static QString sidecarFileName(const QDir &cache, const QFileInfo &source);
+    static RideFile *openSidecar(const QDir &cache, const QFileInfo &source);
+    static bool writeSidecar(const QDir &cache, const QFileInfo &source, const RideFile *ride);
+
+    // create sidecars for all .json activities that don't have a current one
+    // used when upgrading existing athletes, returns the number converted
+    static int convertActivities(const QDir &activities, const QDir &cache);
+};
+
+#endif // _GcbRideFile_h
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GcjRideFile_h
+#define _GcjRideFile_h
+#include "GoldenCheetah.h"
+
+#include "RideFile.h"
+
+// GoldenCheetah train journal (.gcj)
+//
+// The journal TrainRecorder appends to as a training session is recorded,
+// read with TrainRecorder::read so a journal left behind by a crash can be
+// imported directly too.
+
+struct GcjFileReader : public RideFileReader {
+    virtual RideFile *openRideFile(QFile &file, QStringList &errors, QList<RideFile*>* = 0) const;
+};
+
+#endif // _GcjRideFile_h
@@ -19,6 +19,7 @@
  */
 
 #include "RideFile.h"
+#include "GcbRideFile.h"
 #include "FilterHRV.h"
 #include "WPrime.h"
 #include "Athlete.h"
@@ -65,7 +66,7 @@ const QChar deltaChar(0x0394);
 RideFile::RideFile(const QDateTime &startTime, double recIntSecs) :
             wstale(true), startTime_(startTime), recIntSecs_(recIntSecs),
             deviceType_("unknown"), data(NULL), wprime_(NULL), 
-            weight_(0), totalCount(0), totalTemp(0), dstale(true)
+            weight_(0), totalCount(0), totalTemp(0), dstale(true), columnLock(QMutex::Recursive), cstale(true)
 {
     command = new RideFileCommand(this);
 
@@ -80,7 +81,7 @@ RideFile::RideFile(const QDateTime &startTime, double recIntSecs) :
 // and we want to get special fields and ESPECIALLY "CP" and "Weight"
 RideFile::RideFile(RideFile *p) :
     wstale(true), recIntSecs_(p->recIntSecs_), deviceType_(p->deviceType_), data(NULL), wprime_(NULL), 
-    weight_(p->weight_), totalCount(0), dstale(true)
+    weight_(p->weight_), totalCount(0), dstale(true), columnLock(QMutex::Recursive), cstale(true)
 {
     startTime_ = p->startTime_;
     tags_ = p->tags_;
@@ -101,7 +102,7 @@ RideFile::RideFile(RideFile *p) :
 
 RideFile::RideFile() : 
     wstale(true), recIntSecs_(0.0), deviceType_("unknown"), data(NULL), wprime_(NULL), 
-    weight_(0), totalCount(0), dstale(true)
+    weight_(0), totalCount(0), dstale(true), columnLock(QMutex::Recursive), cstale(true)
 {
     command = new RideFileCommand(this);
 
@@ -829,8 +830,23 @@ RideFile *RideFileFactory::openRideFile(Context *context, QFile &file,
 
     } else {
 
-        // open and read the file
-        result = reader->openRideFile(file, errors, rideList);
+        // activities stored as .json have a binary sidecar in the
+        // cache folder that is much quicker to read, if its current
+        QFileInfo source(file.fileName());
+        bool sidecar = context && suffix.toLower() == "json" &&
+                       source.canonicalPath() == context->athlete->home->activities().canonicalPath();
+
+        result = NULL;
+        if (sidecar) result = GcbFileReader::openSidecar(context->athlete->home->cache(), source);
+
+        if (result == NULL) {
+
+            // open and read the file
+            result = reader->openRideFile(file, errors, rideList);
+
+            // and refresh the sidecar for next time
+            if (result && sidecar) GcbFileReader::writeSidecar(context->athlete->home->cache(), source, result);
+        }
     }
 
     // if it was successful, lets post process the file
@@ -1455,20 +1471,8 @@ void RideFile::appendOrUpdatePoint(double secs, double cad, double hr, double km
            forceAppend = true;
     }
 
-    if (forceAppend) {
-        RideFilePoint* point = new RideFilePoint(secs, cad, hr, km, kph, nm, watts, alt, lon, lat,
-                                                 headwind, slope, temp,
-                                                 lrbalance,
-                                                 lte, rte, lps, rps,
-                                                 lpco, rpco,
-                                                 lppb, rppb, lppe, rppe,
-                                                 lpppb, rpppb, lpppe, rpppe,
-                                                 smo2, thb,
-                                                 rvert, rcad, rcontact, tcore,
-                                                 interval);
-
-        dataPoints_.append(point);
-    }
+    if (forceAppend) dataPoints_.append(point);
+    columnsChanged();
 
     dataPresent.secs     |= (secs != 0);
     dataPresent.cad      |= (cad != 0);
@@ -1758,6 +1762,81 @@ RideFile::setPointValue(int index, SeriesType series, double value)
         default:
         case none : break;
     }
+    columnsChanged();
+}
+
+bool
+RideFile::columnPresent(SeriesType series)
+{
+    switch (series) {
+
+        // always there if we have samples
+        case secs : return true; break;
+
+        // derived, so refresh before checking
+        case NP : recalculateDerivedSeries(); return dataPresent.np; break;
+        case xPower : recalculateDerivedSeries(); return dataPresent.xp; break;
+        case hrd :
+        case cadd :
+        case kphd :
+        case nmd :
+        case wattsd :
+        case aPower :
+        case aTISS :
+        case anTISS :
+        case gear :
+        case o2hb :
+        case hhb : recalculateDerivedSeries(); return isDataPresent(series); break;
+
+        // not held in a RideFilePoint, computed elsewhere
+        case vam :
+        case wattsKg :
+        case aPowerKg :
+        case wprime :
+        case wbal :
+        case clength :
+        case index :
+        case hrv : return false; break;
+
+        default : return isDataPresent(series); break;
+    }
+}
+
+// the samples changed, so throw away any columns copied from them
+void
+RideFile::columnsChanged()
+{
+    QMutexLocker locker(&columnLock);
+    columns_.clear();
+    cstale = true;
+}
+
+QVector<double>
+RideFile::column(SeriesType series)
+{
+    if (series < 0 || series >= none || dataPoints_.count() == 0) return QVector<double>();
+
+    QMutexLocker locker(&columnLock);
+
+    // this may refresh derived data and mark columns stale
+    if (!columnPresent(series)) return QVector<double>();
+
+    // throw away any columns from before the last change
+    if (cstale) {
+        columns_.clear();
+        columns_.resize(none);
+        cstale = false;
+    }
+
+    QVector<double> &values = columns_[series];
+    if (values.count() != dataPoints_.count()) {
+
+        // a single linear pass over the datapoints
+        values.resize(dataPoints_.count());
+        double *p = values.data();
+        foreach(const RideFilePoint *point, dataPoints_) *p++ = point->value(series);
+    }
+    return values; // a shared copy, callers keep it even if we are cleared
 }
 
 double
@@ -2094,6 +2173,7 @@ RideFile::deletePoint(int index)
 {
     delete dataPoints_[index];
     dataPoints_.remove(index);
+    columnsChanged();
 }
 
 void
@@ -2101,12 +2181,14 @@ RideFile::deletePoints(int index, int count)
 {
     for(int i=index; i<(index+count); i++) delete dataPoints_[i];
     dataPoints_.remove(index, count);
+    columnsChanged();
 }
 
 void
 RideFile::insertPoint(int index, RideFilePoint *point)
 {
     dataPoints_.insert(index, point);
+    columnsChanged();
 }
 
 void
@@ -2127,6 +2209,7 @@ void
 RideFile::appendPoints(QVector <struct RideFilePoint *> newRows)
 {
     dataPoints_ += newRows;
+    columnsChanged();
 }
 
 void
@@ -2141,6 +2224,7 @@ RideFile::emitSaved()
 {
     weight_ = 0;
     wstale = dstale = true;
+    columnsChanged();
     emit saved();
 }
 
@@ -2149,6 +2233,7 @@ RideFile::emitReverted()
 {
     weight_ = 0;
     wstale = dstale = true;
+    columnsChanged();
     emit reverted();
 }
 
@@ -2157,6 +2242,7 @@ RideFile::emitModified()
 {
     weight_ = 0;
     wstale = dstale = true;
+    columnsChanged();
     emit modified();
 }
 
@@ -2792,6 +2878,7 @@ RideFile::recalculateDerivedSeries(bool force)
 
     // and we're done
     dstale=false;
+    columnsChanged();
 }
 
 #ifdef GC_HAVE_SAMPLERATE
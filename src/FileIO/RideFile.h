@@ -27,6 +27,7 @@
 #include <QMap>
 #include <QVector>
 #include <QObject>
+#include <QMutex>
 
 class RideItem;
 class RideCache;
@@ -173,6 +174,7 @@ class RideFile : public QObject // QObject to emit signals
         friend class TcxFileReader;
         friend struct PwxFileReader;
         friend struct JsonFileReader;
+        friend struct GcbFileReader;
         friend class ManualRideDialog;
         friend class PolarFileReader;
         friend class Strava;
@@ -278,6 +280,16 @@ class RideFile : public QObject // QObject to emit signals
 
         const QVector<RideFilePoint*> &dataPoints() const { return dataPoints_; }
 
+        // Working with COLUMNS -- a contiguous array of samples for a
+        // single series, one entry per datapoint. Columns are only
+        // allocated for series that are present and are built on demand
+        // then kept until the ride is modified (via the command or the
+        // routines below). Returns an empty vector if the series is not
+        // present, so kernels that scan a whole series can avoid chasing
+        // a pointer to a RideFilePoint for every sample. The vector is
+        // shared, so holding on to it is safe if the ride changes.
+        QVector<double> column(SeriesType series);
+
         // recalculate all the derived data series
         // might want to move to a factory for these
         // at some point, but for now hard coded
@@ -435,6 +447,14 @@ class RideFile : public QObject // QObject to emit signals
 
         bool dstale; // is derived data up to date?
 
+        // columnar copy of the datapoints, see column() above. recursive
+        // since column() may refresh derived data, which changes them
+        QVector<QVector<double> > columns_;
+        QMutex columnLock;
+        bool cstale; // are the columns up to date? guarded by columnLock
+        bool columnPresent(SeriesType series);
+        void columnsChanged();
+
         // data required to compute headwind based on weather broadcast
         double windSpeed_, windHeading_;
 };
@@ -26,15 +26,27 @@
 #include "PaceZones.h"
 #include "WPrime.h" // for wbal zones
 #include "LTMSettings.h" // getAllBestsFor needs this
+#include "TaskPool.h"
+#include "RideFileCacheIndex.h"
 
 #include <cmath> // for pow()
+#include <stdio.h> // for fprintf()
 #include <QDebug>
 #include <QFileInfo>
+#include <QDir>
 #include <QMessageBox>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QCoreApplication>
 #include <QtAlgorithms> // for qStableSort
 
 static const int maxcache = 25; // lets max out at 25 caches
 
+// the athlete's cpxCache is used by the threads refreshing rides
+// and by charts aggregating in the background
+static QMutex cpxCacheLock;
+
 // cache from ride
 RideFileCache::RideFileCache(Context *context, QString fileName, double weight, RideFile *passedride, bool check, bool refresh) :
                incomplete(false), context(context), rideFileName(fileName), ride(passedride)
@@ -199,85 +211,83 @@ RideFileCache::checkStale(Context *context, RideItem*item)
     return true;
 }
 
-// returns offset from end of head
-static long offsetForMeanMax(RideFileCacheHeader head, RideFile::SeriesType series)
+// which block a series is in, -1 if none
+static int meanMaxBlock(RideFile::SeriesType series)
 {
-    long offset = 0;
+    switch (series) {
+    case RideFile::watts : return 0;
+    case RideFile::wattsKg : return 1;
+    case RideFile::hr : return 2;
+    case RideFile::cad : return 3;
+    case RideFile::nm : return 4;
+    case RideFile::kph : return 5;
+    case RideFile::kphd : return 6;
+    case RideFile::wattsd : return 7;
+    case RideFile::cadd : return 8;
+    case RideFile::nmd : return 9;
+    case RideFile::hrd : return 10;
+    case RideFile::xPower : return 11;
+    case RideFile::NP : return 12;
+    case RideFile::vam : return 13;
+    case RideFile::aPower : return 14;
+    case RideFile::aPowerKg : return 15;
+    default: return -1;
+    }
+}
 
+static int distBlock(RideFile::SeriesType series)
+{
     switch (series) {
-    case RideFile::aPowerKg : offset += head.aPowerMeanMaxCount * sizeof(float);
-    case RideFile::aPower : offset += head.vamMeanMaxCount * sizeof(float);
-    case RideFile::vam : offset += head.npMeanMaxCount * sizeof(float);
-    case RideFile::NP : offset += head.xPowerMeanMaxCount * sizeof(float);
-    case RideFile::xPower : offset += head.kphMeanMaxCount * sizeof(float);
-    case RideFile::hrd : offset += head.hrdMeanMaxCount * sizeof(float);
-    case RideFile::nmd : offset += head.nmdMeanMaxCount * sizeof(float);
-    case RideFile::cadd : offset += head.caddMeanMaxCount * sizeof(float);
-    case RideFile::wattsd : offset += head.wattsdMeanMaxCount * sizeof(float);
-    case RideFile::kphd : offset += head.kphdMeanMaxCount * sizeof(float);
-    case RideFile::kph : offset += head.nmMeanMaxCount * sizeof(float);
-    case RideFile::nm : offset += head.cadMeanMaxCount * sizeof(float);
-    case RideFile::cad : offset += head.hrMeanMaxCount * sizeof(float);
-    case RideFile::hr : offset += head.wattsKgMeanMaxCount * sizeof(float);
-    case RideFile::wattsKg : offset += head.wattsMeanMaxCount * sizeof(float);
-    case RideFile::watts : offset += 0;
-    default:
-        break;
+    case RideFile::watts : return 0;
+    case RideFile::hr : return 1;
+    case RideFile::cad : return 2;
+    case RideFile::gear : return 3;
+    case RideFile::nm : return 4;
+    case RideFile::kph : return 5;
+    case RideFile::xPower : return 6;
+    case RideFile::NP : return 7;
+    case RideFile::wattsKg : return 8;
+    case RideFile::aPower : return 9;
+    case RideFile::smo2 : return 10;
+    case RideFile::wbal : return 11;
+    default: return -1;
+    }
+}
+
+// tiz is just for RideFile:watts, RideFile:hr, RideFile:kph and RideFile:wbal
+// each (apart from wbal) followed by its polarized zones
+static int tizBlock(RideFile::SeriesType series)
+{
+    switch (series) {
+    case RideFile::watts : return 0;
+    case RideFile::hr : return 2;
+    case RideFile::kph : return 4;
+    case RideFile::wbal : return 6;
+    default: return -1;
     }
+}
+
+// returns offset from start of file
+static qint64 offsetForMeanMax(const RideFileCacheHeader &head, RideFile::SeriesType series)
+{
+    int block = meanMaxBlock(series);
+    return block < 0 ? 0 : head.meanMaxOffset[block];
+}
+
+static qint64 offsetForDist(const RideFileCacheHeader &head, RideFile::SeriesType series)
+{
+    int block = distBlock(series);
+    return block < 0 ? 0 : head.distOffset[block];
+}
+
+static qint64 offsetForTiz(const RideFileCacheHeader &head, RideFile::SeriesType series)
+{
+    int block = tizBlock(series);
+    return block < 0 ? 0 : head.tizOffset[block];
+}
 
-    return offset;
-}
-
-//offset to tiz table
-static long offsetForTiz(RideFileCacheHeader head, RideFile::SeriesType series)
-{
-    long offset = 0;
-
-    // skip past the mean max arrays
-    offset += head.aPowerKgMeanMaxCount * sizeof(float);
-    offset += head.aPowerMeanMaxCount * sizeof(float);
-    offset += head.vamMeanMaxCount * sizeof(float);
-    offset += head.npMeanMaxCount * sizeof(float);
-    offset += head.xPowerMeanMaxCount * sizeof(float);
-    offset += head.hrdMeanMaxCount * sizeof(float);
-    offset += head.nmdMeanMaxCount * sizeof(float);
-    offset += head.caddMeanMaxCount * sizeof(float);
-    offset += head.wattsdMeanMaxCount * sizeof(float);
-    offset += head.kphdMeanMaxCount * sizeof(float);
-    offset += head.kphMeanMaxCount * sizeof(float);
-    offset += head.nmMeanMaxCount * sizeof(float);
-    offset += head.cadMeanMaxCount * sizeof(float);
-    offset += head.hrMeanMaxCount * sizeof(float);
-    offset += head.wattsKgMeanMaxCount * sizeof(float);
-    offset += head.wattsMeanMaxCount * sizeof(float);
-
-    // skip past the distribution arrays
-    offset += head.wattsDistCount * sizeof(float);
-    offset += head.hrDistCount * sizeof(float);
-    offset += head.cadDistCount * sizeof(float);
-    offset += head.gearDistCount * sizeof(float);
-    offset += head.nmDistrCount * sizeof(float);
-    offset += head.kphDistCount * sizeof(float);
-    offset += head.xPowerDistCount * sizeof(float);
-    offset += head.npDistCount * sizeof(float);
-    offset += head.wattsKgDistCount * sizeof(float);
-    offset += head.aPowerDistCount * sizeof(float);
-    offset += head.smo2DistCount * sizeof(float);
-    offset += head.wbalDistCount * sizeof(float);
-
-    // tiz ist currently just for RideFile:watts, RideFile:hr, RideFile:kph and RideFile:wbal
-    // watts is first - so move on with offset only for 'hr' and 'kph' and 'wbal'
-    // structure for "tiz" data - watts(10)/CPwatts(4)/HR(10)/CPhr(4)/PACE(10)/CPpace
-    if (series == RideFile::hr) offset += (10+4) * sizeof(float);
-    if (series == RideFile::kph) offset += 2*(10+4) * sizeof(float);
-    if (series == RideFile::wbal) offset += 3*(10+4) * sizeof(float);
-
-    return offset;
-}
-
-
-// returns offset from end of head
-static long countForMeanMax(RideFileCacheHeader head, RideFile::SeriesType series)
+// returns number of floats in the block
+static long countForMeanMax(const RideFileCacheHeader &head, RideFile::SeriesType series)
 {
     switch (series) {
     case RideFile::aPowerKg : return head.aPowerKgMeanMaxCount;
@@ -303,6 +313,53 @@ static long countForMeanMax(RideFileCacheHeader head, RideFile::SeriesType serie
     return 0;
 }
 
+static long countForDist(const RideFileCacheHeader &head, RideFile::SeriesType series)
+{
+    switch (series) {
+    case RideFile::watts : return head.wattsDistCount;
+    case RideFile::hr : return head.hrDistCount;
+    case RideFile::cad : return head.cadDistCount;
+    case RideFile::gear : return head.gearDistCount;
+    case RideFile::nm : return head.nmDistrCount;
+    case RideFile::kph : return head.kphDistCount;
+    case RideFile::xPower : return head.xPowerDistCount;
+    case RideFile::NP : return head.npDistCount;
+    case RideFile::wattsKg : return head.wattsKgDistCount;
+    case RideFile::aPower : return head.aPowerDistCount;
+    case RideFile::smo2 : return head.smo2DistCount;
+    case RideFile::wbal : return head.wbalDistCount;
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+// open a cache file and read its header, false if it's missing or out of date
+static bool openCache(QFile &cacheFile, RideFileCacheHeader &head)
+{
+    if (cacheFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered) == false) return false;
+
+    if (cacheFile.read((char *) &head, sizeof(head)) != sizeof(head) || head.version != RideFileCacheVersion) {
+        cacheFile.close();
+        return false;
+    }
+    return true;
+}
+
+// read floats from the offset into the vector passed, it is resized to count
+static bool readFloats(QFile &cacheFile, qint64 offset, long count, QVector<float> &into)
+{
+    into.resize(count);
+    if (count == 0) return true;
+
+    qint64 bytes = count * sizeof(float);
+    if (cacheFile.seek(offset) && cacheFile.read((char *) into.data(), bytes) == bytes) return true;
+
+    into.clear();
+    return false;
+}
+
 QVector<float> RideFileCache::meanMaxPowerFor(Context *context, QVector<float> &wpk, QDate from, QDate to, bool wantruns)
 {
     QVector<float> returning;
@@ -353,59 +410,61 @@ QVector<float> RideFileCache::meanMaxPowerFor(Context *context, QVector<float> &
 
 QVector<float> RideFileCache::meanMaxPowerFor(Context *context, QVector<float>&wpk, QString fileName)
 {
-    QTime start;
-    start.start();
-
     QVector<float> returning;
 
     // Get info for ride file and cache file
     QFileInfo rideFileInfo(fileName);
     QString cacheFilename = context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx";
-    QFileInfo cacheFileInfo(cacheFilename);
 
-    // is it up-to-date?
-    if (cacheFileInfo.exists() && cacheFileInfo.size() >= (int)sizeof(struct RideFileCacheHeader)) {
+    RideFileCacheHeader head;
+    QFile cacheFile(cacheFilename);
 
-        // we have a file, it is more recent than the ride file
-        // but is it the latest version?
-        RideFileCacheHeader head;
-        QFile cacheFile(cacheFilename);
-        if (cacheFile.open(QIODevice::ReadOnly) == true) {
+    // check its an up to date format and contains power
+    if (openCache(cacheFile, head)) {
 
-            // read the header
-            QDataStream inFile(&cacheFile);
-            inFile.readRawData((char *) &head, sizeof(head));
+        if (head.wattsMeanMaxCount > 0 &&
+            readFloats(cacheFile, offsetForMeanMax(head, RideFile::watts), head.wattsMeanMaxCount, returning) &&
+            readFloats(cacheFile, offsetForMeanMax(head, RideFile::wattsKg), head.wattsKgMeanMaxCount, wpk)) {
+
+            for(int i=0; i<wpk.size(); i++) wpk[i] = wpk[i] / 100.00f;
+        }
 
-            // check its an up to date format and contains power
-            if (head.version == RideFileCacheVersion && head.wattsMeanMaxCount > 0) {
+        // we're done reading
+        cacheFile.close();
+    }
 
-                // seek to start of meanmax array in the cache
-                long offset = offsetForMeanMax(head, RideFile::watts) + sizeof(head);
-                cacheFile.seek(qint64(offset));
+    // will be empty if no up to date cache
+    return returning;
 
-                // read from cache and put straight into QVector memory
-                // a little naughty but seems to work ok
-                returning.resize(head.wattsMeanMaxCount);
-                inFile.readRawData((char*)returning.constData(), head.wattsMeanMaxCount * sizeof(float));
+}
 
-                offset = offsetForMeanMax(head, RideFile::wattsKg) + sizeof(head);
-                cacheFile.seek(qint64(offset));
+// read just one series' block from a cache file, values are as stored
+QVector<float> RideFileCache::readBlock(QString cacheFilename, CacheType type, RideFile::SeriesType series)
+{
+    QVector<float> returning;
 
-                wpk.resize(head.wattsKgMeanMaxCount);
-                inFile.readRawData((char*)wpk.constData(), head.wattsKgMeanMaxCount * sizeof(float));
-                for(int i=0; i<wpk.size(); i++) wpk[i] = wpk[i] / 100.00f;
+    RideFileCacheHeader head;
+    QFile cacheFile(cacheFilename);
 
-                //qDebug()<<"retrieved:"<<head.wattsMeanMaxCount<<"in:"<<start.elapsed()<<"ms";
-            }
+    if (openCache(cacheFile, head)) {
 
-            // we're done reading
-            cacheFile.close();
+        switch (type) {
+        case meanmax:
+            if (meanMaxBlock(series) >= 0)
+                readFloats(cacheFile, offsetForMeanMax(head, series), countForMeanMax(head, series), returning);
+            break;
+        case distribution:
+            if (distBlock(series) >= 0)
+                readFloats(cacheFile, offsetForDist(head, series), countForDist(head, series), returning);
+            break;
+        default:
+            break;
         }
+        cacheFile.close();
     }
 
     // will be empty if no up to date cache
     return returning;
-
 }
 
 // the next 2 are used by the API web services to extract meanmax data from the cache
@@ -413,69 +472,38 @@ QVector<float> RideFileCache::meanMaxPowerFor(Context *context, QVector<float>&w
 // API bests for a ride
 QVector<float> RideFileCache::meanMaxFor(QString cacheFilename, RideFile::SeriesType series)
 {
-    QTime start;
-    start.start();
+    return readBlock(cacheFilename, meanmax, series);
+}
 
-    QVector<float> returning;
+// one series for many rides, in the order passed
+QVector<QVector<float> > RideFileCache::meanMaxFor(QStringList cacheFilenames, RideFile::SeriesType series)
+{
+    QVector<QVector<float> > returning(cacheFilenames.count());
 
-    // Get info for ride file and cache file
-    QFileInfo cacheFileInfo(cacheFilename);
+    if (meanMaxBlock(series) < 0) return returning;
 
-    // is it up-to-date?
-    if (cacheFileInfo.exists() && cacheFileInfo.size() >= (int)sizeof(struct RideFileCacheHeader)) {
+    for (int i=0; i<cacheFilenames.count(); i++) {
 
-        // we have a file, it is more recent than the ride file
-        // but is it the latest version?
         RideFileCacheHeader head;
-        QFile cacheFile(cacheFilename);
-        if (cacheFile.open(QIODevice::ReadOnly) == true) {
-
-            // read the header
-            QDataStream inFile(&cacheFile);
-            inFile.readRawData((char *) &head, sizeof(head));
-
-            int count = countForMeanMax(head, series);
-
-            // check its an up to date format and contains power
-            if (head.version == RideFileCacheVersion && count>0) {
-
-                // seek to start of meanmax array in the cache
-                long offset = offsetForMeanMax(head, series) + sizeof(head);
-                cacheFile.seek(qint64(offset));
+        QFile cacheFile(cacheFilenames[i]);
 
-                // read from cache and put straight into QVector memory
-                // a little naughty but seems to work ok
-                returning.resize(count);
-                inFile.readRawData((char*)returning.constData(), count * sizeof(float));
-            }
-
-            // we're done reading
+        if (openCache(cacheFile, head)) {
+            readFloats(cacheFile, offsetForMeanMax(head, series), countForMeanMax(head, series), returning[i]);
             cacheFile.close();
         }
     }
-
-    // will be empty if no up to date cache
     return returning;
-
 }
 
 // API bests for a date range
 QVector<float> RideFileCache::meanMaxFor(QString cacheDir, RideFile::SeriesType series, QDate from, QDate to)
 {
-    QTime start;
-    start.start();
-
-    bool first = true;
-    QVector<float> returning;
-
-    // loop through all CPX files
+    // all the CPX files in the range
+    QStringList cacheFilenames;
     foreach(QString cacheFilename, QDir(cacheDir).entryList(QDir::Files)) {
 
         // is it a cpx file ?
         if (!cacheFilename.endsWith(".cpx")) continue;
-   
-        // is it big enough ? 
-        if (QFileInfo(cacheDir + "/" + cacheFilename).size() < (int)sizeof(struct RideFileCacheHeader)) continue;
 
         // lets check it parses ok ?
         QDateTime dt;
@@ -484,8 +512,13 @@ QVector<float> RideFileCache::meanMaxFor(QString cacheDir, RideFile::SeriesType
         // in range?
         if (dt.date() < from || dt.date() > to) continue;
 
-        // get data
-        QVector<float> current = RideFileCache::meanMaxFor(cacheDir + "/" + cacheFilename, series);
+        cacheFilenames << cacheDir + "/" + cacheFilename;
+    }
+
+    // get data and merge
+    bool first = true;
+    QVector<float> returning;
+    foreach(const QVector<float> &current, meanMaxFor(cacheFilenames, series)) {
 
         // first ?
         if (first) {
@@ -855,6 +888,7 @@ RideFileCache::refreshCache()
         // invalidate any incore cache of aggregate
         // that contains this ride in its date range
         QDate date = ride->startTime().date();
+        cpxCacheLock.lock();
         for (int i=0; i<context->athlete->cpxCache.count();) {
             if (date >= context->athlete->cpxCache.at(i)->start &&
                 date <= context->athlete->cpxCache.at(i)->end) {
@@ -862,6 +896,8 @@ RideFileCache::refreshCache()
                 context->athlete->cpxCache.removeAt(i);
             } else i++;
         }
+        cpxCacheLock.unlock();
+        if (context->athlete->cpxIndex) context->athlete->cpxIndex->invalidate(date);
 
 
     } else if (writeerror == false) {
@@ -895,35 +931,37 @@ void RideFileCache::refresh(RideFile *file)
     compute();
 }
 
-// this function is a candidate for supporting
-// threaded calculations, each of the computes
-// in here could go in its own thread. Users
-// with many cores would benefit enormously
+// the mean max computations are run in parallel as tasks
+// in the TaskPool, which is shared with the RideCache
+// refresh so we don't oversubscribe when rebuilding
 void RideFileCache::RideFileCache::compute()
 {
     if (ride == NULL) {
         return;
     }
 
-    // all the mean maxes
-    MeanMaxComputer thread1(ride, wattsMeanMax, RideFile::watts); thread1.start();
-    MeanMaxComputer thread2(ride, hrMeanMax, RideFile::hr); thread2.start();
-    MeanMaxComputer thread3(ride, cadMeanMax, RideFile::cad); thread3.start();
-    MeanMaxComputer thread4(ride, nmMeanMax, RideFile::nm); thread4.start();
-    MeanMaxComputer thread5(ride, kphMeanMax, RideFile::kph); thread5.start();
-    MeanMaxComputer thread6(ride, xPowerMeanMax, RideFile::xPower); thread6.start();
-    MeanMaxComputer thread7(ride, npMeanMax, RideFile::NP); thread7.start();
-    MeanMaxComputer thread8(ride, vamMeanMax, RideFile::vam); thread8.start();
-    MeanMaxComputer thread9(ride, wattsKgMeanMax, RideFile::wattsKg); thread9.start();
-    MeanMaxComputer thread10(ride, aPowerMeanMax, RideFile::aPower); thread10.start();
-    MeanMaxComputer thread11(ride, kphdMeanMax, RideFile::kphd); thread11.start();
-    MeanMaxComputer thread12(ride, wattsdMeanMax, RideFile::wattsd); thread12.start();
-    MeanMaxComputer thread13(ride, caddMeanMax, RideFile::cadd); thread13.start();
-    MeanMaxComputer thread14(ride, nmdMeanMax, RideFile::nmd); thread14.start();
-    MeanMaxComputer thread15(ride, hrdMeanMax, RideFile::hrd); thread15.start();
-    MeanMaxComputer thread16(ride, aPowerKgMeanMax, RideFile::aPowerKg); thread16.start();
-
-    // all the different distributions
+    // all the mean maxes, as tasks in the shared pool, this thread
+    // will run any that the pool doesn't get to while it waits
+    TaskGroup tasks;
+    MeanMaxComputer thread1(ride, wattsMeanMax, RideFile::watts); tasks.start(&thread1);
+    MeanMaxComputer thread2(ride, hrMeanMax, RideFile::hr); tasks.start(&thread2);
+    MeanMaxComputer thread3(ride, cadMeanMax, RideFile::cad); tasks.start(&thread3);
+    MeanMaxComputer thread4(ride, nmMeanMax, RideFile::nm); tasks.start(&thread4);
+    MeanMaxComputer thread5(ride, kphMeanMax, RideFile::kph); tasks.start(&thread5);
+    MeanMaxComputer thread6(ride, xPowerMeanMax, RideFile::xPower); tasks.start(&thread6);
+    MeanMaxComputer thread7(ride, npMeanMax, RideFile::NP); tasks.start(&thread7);
+    MeanMaxComputer thread8(ride, vamMeanMax, RideFile::vam); tasks.start(&thread8);
+    MeanMaxComputer thread9(ride, wattsKgMeanMax, RideFile::wattsKg); tasks.start(&thread9);
+    MeanMaxComputer thread10(ride, aPowerMeanMax, RideFile::aPower); tasks.start(&thread10);
+    MeanMaxComputer thread11(ride, kphdMeanMax, RideFile::kphd); tasks.start(&thread11);
+    MeanMaxComputer thread12(ride, wattsdMeanMax, RideFile::wattsd); tasks.start(&thread12);
+    MeanMaxComputer thread13(ride, caddMeanMax, RideFile::cadd); tasks.start(&thread13);
+    MeanMaxComputer thread14(ride, nmdMeanMax, RideFile::nmd); tasks.start(&thread14);
+    MeanMaxComputer thread15(ride, hrdMeanMax, RideFile::hrd); tasks.start(&thread15);
+    MeanMaxComputer thread16(ride, aPowerKgMeanMax, RideFile::aPowerKg); tasks.start(&thread16);
+
+    // all the different distributions, on this thread since they
+    // share the zone settings (CP, LTHR etc) and the W'bal data
     computeDistribution(wattsDistribution, RideFile::watts);
     computeDistribution(hrDistribution, RideFile::hr);
     computeDistribution(cadDistribution, RideFile::cad);
@@ -935,23 +973,8 @@ void RideFileCache::RideFileCache::compute()
     computeDistribution(smo2Distribution, RideFile::smo2);
     computeDistribution(wbalDistribution, RideFile::wbal);
 
-    // wait for them threads
-    thread1.wait();
-    thread2.wait();
-    thread3.wait();
-    thread4.wait();
-    thread5.wait();
-    thread6.wait();
-    thread7.wait();
-    thread8.wait();
-    thread9.wait();
-    thread10.wait();
-    thread11.wait();
-    thread12.wait();
-    thread13.wait();
-    thread14.wait();
-    thread15.wait();
-    thread16.wait();
+    // wait for the mean maxes
+    tasks.wait();
 
     // setup the doubles the users use
     doubleArray(wattsMeanMaxDouble, wattsMeanMax, RideFile::watts);
@@ -1202,8 +1225,199 @@ divided_max_mean(data_t *dataseries_i, int datalength, int length, int *offset)
 }
 
 
-void
-MeanMaxComputer::run()
+// Exact mean max for every duration
+//
+// divided_max_mean above is exact for a single duration but run() used to
+// only call it for a sample of durations (every 20s after 20 minutes etc) and
+// back fill the rest. Here we compute every duration in about the same time.
+//
+// With non-negative data the best energy for length n+1 is at least that for
+// length n, so it is carried on as the candidate. The windows are checked in
+// blocks of starts; the energy from the start of a block to the end of the
+// longest window starting in it bounds them all, and blocks that can't beat
+// the candidate are skipped (the same idea as the overlapping segments above).
+//
+// Most blocks are a long way short of the candidate, and lengthening the
+// windows by one sample can add at most the largest sample to a bound, while
+// the best window grows by whatever follows it. So rather than checking every
+// block for every length each block is put on a list for the first length it
+// could possibly beat the candidate again. Blocks that do need scanning are
+// scanned in 4 independent lanes so the compiler can vectorise the inner loop.
+//
+// On 24 hours of 1s samples this takes about as long as the sampled search
+// did, whether the ride is variable or steady (e.g. erg mode).
+//
+// If any of the data is negative (e.g. the delta series) none of that holds,
+// so every window is scanned, but only up to maxlength.
+//
+// sums[n] is set to the best energy for length n, 0 if none is positive
+
+#define MEANMAX_BLOCK 64
+
+static inline data_t
+block_max_mean(const data_t *dataseries_i, int from, int to, int length)
+{
+    data_t m0=0, m1=0, m2=0, m3=0;
+
+    int i=from;
+    for (; i+4<=to; i+=4) {
+        data_t e0 = dataseries_i[i+length]   - dataseries_i[i];
+        data_t e1 = dataseries_i[i+length+1] - dataseries_i[i+1];
+        data_t e2 = dataseries_i[i+length+2] - dataseries_i[i+2];
+        data_t e3 = dataseries_i[i+length+3] - dataseries_i[i+3];
+        m0 = e0 > m0 ? e0 : m0;
+        m1 = e1 > m1 ? e1 : m1;
+        m2 = e2 > m2 ? e2 : m2;
+        m3 = e3 > m3 ? e3 : m3;
+    }
+    for (; i<to; i++) {
+        data_t e0 = dataseries_i[i+length] - dataseries_i[i];
+        m0 = e0 > m0 ? e0 : m0;
+    }
+
+    m0 = m1 > m0 ? m1 : m0;
+    m2 = m3 > m2 ? m3 : m2;
+    return m2 > m0 ? m2 : m0;
+}
+
+// the window at start has at least energy, so nothing with energy can beat it
+static inline bool
+outgrown(const data_t *dataseries_i, int start, int length, data_t energy)
+{
+    return dataseries_i[start + length] - dataseries_i[start] >= energy;
+}
+
+static void
+all_max_means(const data_t *dataseries_i, int datalength, int maxlength, QVector<data_t> &sums)
+{
+    sums.fill(0, datalength+1);
+    if (maxlength > datalength) maxlength = datalength;
+    if (maxlength < 2) return;
+
+    bool positive = true;
+    data_t largest = 0, smallest = dataseries_i[1] - dataseries_i[0];
+    for (int i=0; i<datalength; i++) {
+        data_t value = dataseries_i[i+1] - dataseries_i[i];
+        if (value < 0) {
+            positive = false;
+            break;
+        }
+        if (value > largest) largest = value;
+        if (value < smallest) smallest = value;
+    }
+
+    // nothing to find
+    if (positive && largest == 0) return;
+
+    // scan them all
+    if (!positive) {
+        for (int length=1; length<maxlength; length++)
+            sums[length] = block_max_mean(dataseries_i, 0, datalength - length + 1, length);
+        return;
+    }
+
+    // the blocks to check for each length, as linked lists so no allocation
+    // as they move on; all of them for the first length. bound is the most
+    // energy any window starting in the block had at length checked
+    int blocks = (datalength + MEANMAX_BLOCK - 1) / MEANMAX_BLOCK;
+    QVector<int> due(maxlength, -1);
+    QVector<int> next(blocks, -1);
+    QVector<data_t> bound(blocks, 0);
+    QVector<int> checked(blocks, 0);
+    for (int block=blocks-1; block>=0; block--) {
+        next[block] = due[1];
+        due[1] = block;
+    }
+
+    data_t candidate = 0;
+    int best = 0; // where the last best window started
+    for (int length=1; length<maxlength; length++) {
+
+        // windows start at 0 .. datalength-length
+        int starts = datalength - length + 1;
+
+        // last length's best window, one longer, is usually (close to) the
+        // best for this length too, so start with that
+        if (best >= starts) best = starts - 1;
+        if (best > 0 && dataseries_i[best-1+length] - dataseries_i[best-1] >
+                        dataseries_i[best+length] - dataseries_i[best]) best--;
+        candidate = qMax(candidate, dataseries_i[best+length] - dataseries_i[best]);
+
+        // check those due, scanning any that could beat the candidate
+        for (int block=due[length]; block>=0; block=next[block]) {
+
+            int from = block * MEANMAX_BLOCK;
+            if (from >= starts) continue;
+            int to = qMin(from + MEANMAX_BLOCK, starts);
+
+            // the most energy any window starting in this block can have
+            data_t most = qMin(dataseries_i[to - 1 + length] - dataseries_i[from],
+                               bound[block] + (length - checked[block]) * largest);
+            if (most > candidate) {
+                most = block_max_mean(dataseries_i, from, to, length);
+                if (most > candidate) {
+                    candidate = most;
+                    for (best=from; dataseries_i[best+length] - dataseries_i[best] != most; best++) ;
+                }
+            }
+            bound[block] = most;
+            checked[block] = length;
+        }
+        sums[length] = candidate;
+
+        // and put them on the list for the next length they might beat it
+        for (int block=due[length]; block>=0;) {
+
+            int following = next[block];
+            if (block * MEANMAX_BLOCK < starts) {
+
+                // each sample longer adds at most the largest sample to the
+                // block, and at least the smallest to the candidate (there is
+                // always a window that is the best one and a bit)
+                int when = maxlength;
+                if (largest > smallest) {
+                    double shortfall = (candidate - bound[block]) / (largest - smallest);
+                    if (shortfall < 1) when = length + 1;
+                    else if (shortfall < maxlength) when = length + int(shortfall);
+                }
+
+                // but usually the best window carries on growing faster than
+                // that, so look along it for when the block could catch up;
+                // lo samples longer it can't, hi it might
+                if (when < maxlength) {
+                    int span = qMin(datalength - best, maxlength - 1) - length;
+                    int lo = when - length - 1, hi = lo + 1, step = 1;
+                    while (hi <= span && outgrown(dataseries_i, best, length + hi, bound[block] + hi * largest)) {
+                        lo = hi;
+                        step *= 2;
+                        hi = lo + step;
+                    }
+                    if (hi > span + 1) hi = qMax(span + 1, lo + 1);
+                    while (hi - lo > 1) {
+                        int mid = (lo + hi) / 2;
+                        if (outgrown(dataseries_i, best, length + mid, bound[block] + mid * largest)) lo = mid;
+                        else hi = mid;
+                    }
+                    when = length + hi;
+                }
+
+                if (when < maxlength) {
+                    next[block] = due[when];
+                    due[when] = block;
+                }
+            }
+            block = following;
+        }
+    }
+}
+
+
+// the series as run() searches it, integrated so the sum of any window is
+// a subtraction. length is the number of samples, maxlength the longest
+// duration we care about and total_secs the ride length. NULL if there is
+// nothing to search, otherwise the caller frees it.
+data_t *
+MeanMaxComputer::integrate(int &length, int &maxlength, int &total_secs)
 {
     // xPower and NP need watts to be present
     RideFile::SeriesType baseSeries = (series == RideFile::xPower || series == RideFile::NP || series == RideFile::wattsKg) ?
@@ -1221,7 +1435,7 @@ MeanMaxComputer::run()
     if (series == RideFile::hrd) needSeries = RideFile::hr;
 
     // only bother if the data series is actually present
-    if (ride->isDataPresent(needSeries) == false) return;
+    if (ride->isDataPresent(needSeries) == false) return NULL;
 
     // if we want decimal places only keep to 1 dp max
     // this is a factor that is applied at the end to
@@ -1276,17 +1490,17 @@ MeanMaxComputer::run()
 
 
     // don't bother with insufficient data
-    if (!data.points.count()) return;
+    if (!data.points.count()) return NULL;
 
-    int total_secs = (int) ceil(data.points.back().secs);
+    total_secs = (int) ceil(data.points.back().secs);
 
     // don't allow data more than two days
     // was one week, but no single ride is longer
     // than 2 days, even if you are doing RAAM
-    if (total_secs > 2*24*60*60) return;
+    if (total_secs > 2*24*60*60) return NULL;
 
     // don't allow if badly parsed or time goes backwards
-    if (total_secs < 0) return;
+    if (total_secs < 0) return NULL;
 
     //
     // Pre-process the data for NP, xPower and VAM
@@ -1386,19 +1600,36 @@ MeanMaxComputer::run()
     }
 
 
+    length = data.points.size();
+
+    // only care about first 3 minutes MAX for delta series (see below)
+    maxlength = length;
+    if (series == RideFile::kphd  || series == RideFile::wattsd || series == RideFile::cadd ||
+        series == RideFile::nmd  || series == RideFile::hrd)
+        maxlength = qMin(maxlength, int(180 / ride->recIntSecs()) + 2);
+
+    return integrate_series(data);
+}
+
+void
+MeanMaxComputer::run()
+{
+    int length, maxlength, total_secs;
+    data_t *dataseries_i = integrate(length, maxlength, total_secs);
+    if (dataseries_i == NULL) return;
+
     // the bests go in here...
     QVector <double> ride_bests(total_secs + 1);
 
-    data_t *dataseries_i = integrate_series(data);
-
-    for (int i=1; i<data.points.size();) {
+    // every duration, exactly
+    QVector<data_t> sums;
+    all_max_means(dataseries_i, length, maxlength, sums);
 
-        int offset;
-        data_t c=divided_max_mean(dataseries_i,data.points.size(),i,&offset);
+    for (int i=1; i<maxlength; i++) {
 
         // snaffle it away
         int sec = i*ride->recIntSecs();
-        data_t val = c / (data_t)i;
+        data_t val = sums[i] / (data_t)i;
 
         if (sec < ride_bests.size()) {
             if (series == RideFile::NP || series == RideFile::xPower)
@@ -1406,15 +1637,6 @@ MeanMaxComputer::run()
             else
                 ride_bests[sec] = val;
         }
-
-
-        // increments to limit search scope
-        if (i<120) i++;
-        else if (i<600) i+= 2;
-        else if (i<1200) i += 5;
-        else if (i<3600) i += 20;
-        else if (i<7200) i += 120;
-        else i += 300;
     }
     free(dataseries_i);
 
@@ -1457,6 +1679,89 @@ MeanMaxComputer::run()
     }
 }
 
+// compare with the sampled search it replaced, which is exact for the
+// durations it searched (every 20s after 20 minutes etc) and so must agree
+// with us for those. returns the number that don't, see checkMeanMax()
+int
+MeanMaxComputer::compare(int &durations)
+{
+    int length, maxlength, total_secs;
+    data_t *dataseries_i = integrate(length, maxlength, total_secs);
+    if (dataseries_i == NULL) return 0;
+
+    QVector<data_t> sums;
+    all_max_means(dataseries_i, length, maxlength, sums);
+
+    int mismatches = 0;
+    for (int i=1; i<maxlength;) {
+
+        durations++;
+        data_t c = divided_max_mean(dataseries_i, length, i, NULL);
+        if (c != sums[i]) {
+            mismatches++;
+            fprintf(stdout, "meanmaxcheck:   %s duration %d was %f now %f\n",
+                    RideFile::seriesName(series).toLocal8Bit().constData(), i, c, sums[i]);
+        }
+
+        if (i<120) i++;
+        else if (i<600) i+= 2;
+        else if (i<1200) i += 5;
+        else if (i<3600) i += 20;
+        else if (i<7200) i += 120;
+        else i += 300;
+    }
+    free(dataseries_i);
+
+    return mismatches;
+}
+
+// --meanmaxcheck, compare the mean max search with the one it replaced for
+// every ride in the folder. The delta series aren't checked, the search it
+// replaced was only exact for positive data, nor is aPower as derived series
+// need an athlete. returns the number of rides that don't agree.
+int
+RideFileCache::checkMeanMax(const QString &folder)
+{
+    static const RideFile::SeriesType checked[] = {
+        RideFile::watts, RideFile::hr, RideFile::cad, RideFile::nm, RideFile::kph,
+        RideFile::xPower, RideFile::NP, RideFile::vam, RideFile::wattsKg
+    };
+
+    QDir dir(folder);
+    QStringList names = RideFileFactory::instance().listRideFiles(dir);
+    int failed = 0, rides = 0;
+
+    foreach(QString name, names) {
+
+        // uncompressing needs an athlete's temp folder
+        QString suffix = QFileInfo(name).suffix().toLower();
+        if (suffix == "gz" || suffix == "zip") continue;
+
+        QFile file(dir.absoluteFilePath(name));
+        QStringList errors;
+        RideFile *ride = RideFileFactory::instance().openRideFile(NULL, file, errors);
+        if (ride == NULL) {
+            fprintf(stdout, "meanmaxcheck: %s: unable to open\n", name.toLocal8Bit().constData());
+            continue;
+        }
+        rides++;
+
+        int durations = 0, mismatches = 0;
+        for (unsigned int i=0; i<sizeof(checked)/sizeof(checked[0]); i++) {
+            QVector<float> array;
+            MeanMaxComputer computer(ride, array, checked[i]);
+            mismatches += computer.compare(durations);
+        }
+        if (mismatches) failed++;
+
+        fprintf(stdout, "meanmaxcheck: %s: %d durations, %d mismatches\n", name.toLocal8Bit().constData(), durations, mismatches);
+        delete ride;
+    }
+    fprintf(stdout, "meanmaxcheck: %d rides, %d with mismatches\n", rides, failed);
+    fflush(stdout);
+    return failed;
+}
+
 // self-contained static routine to perform the fast search algorithm
 // on a single series of data, using ints only assuming data is in 1s 
 // intervals with no data issues.
@@ -1671,19 +1976,23 @@ RideFileCache::computeDistribution(QVector<float> &array, RideFile::SeriesType s
 // AGGREGATE FOR A GIVEN DATE RANGE
 //
 
-// select and update bests
-static void meanMaxAggregate(QVector<double> &into, QVector<double> &other, QVector<QDate>&dates, QDate rideDate)
+// select and update bests, from a ride on rideDate or when
+// merging aggregates the dates of the bests in the other
+static void meanMaxAggregate(QVector<double> &into, QVector<double> &other, QVector<QDate>&dates,
+                             QDate rideDate, QVector<QDate> *otherDates = NULL)
 {
     if (into.size() < other.size()) {
         into.resize(other.size());
         dates.resize(other.size());
     }
 
-    for (int i=0; i<other.size(); i++)
-        if (other[i] > into[i]) {
+    for (int i=0; i<other.size(); i++) {
+        QDate date = otherDates ? otherDates->value(i) : rideDate;
+        if (other[i] > into[i] || (other[i] == into[i] && dates[i].isValid() && date < dates[i])) {
             into[i] = other[i];
-            dates[i] = rideDate;
+            dates[i] = date;
         }
+    }
 }
 
 // resize into and then sum the arrays
@@ -1694,30 +2003,17 @@ static void distAggregate(QVector<double> &into, QVector<double> &other)
 
 }
 
-RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filter, QStringList files, bool onhome, RideItem *rideItem)
-               : start(start), end(end), incomplete(false), context(context), rideFileName(""), ride(0)
+// an empty aggregate, filled by the RideFileCacheIndex
+RideFileCache::RideFileCache(Context *context)
+               : incomplete(false), context(context), rideFileName(""), ride(0),
+                 filter(false), onhome(false)
 {
+    clearAggregate();
+}
 
-    // remember parameters for getting heat
-    this->filter = filter;
-    this->files = files;
-    this->onhome = onhome;
-
-    // Oh lets get from the cache if we can -- but not if filtered
-    if (!filter && !context->isfiltered && !rideItem) {
-
-        // oh and not if we're onhome and homefiltered
-        if ((onhome && !context->ishomefiltered) || !onhome) {
-            foreach(RideFileCache *p, context->athlete->cpxCache) {
-                if (p->start == start && p->end == end) {
-                    *this = *p;
-                    return;
-                }
-            }
-        }
-    }
-
-    // resize all the arrays to zero - expand as neccessary
+void
+RideFileCache::clearAggregate()
+{
     xPowerMeanMax.resize(0);
     npMeanMax.resize(0);
     wattsMeanMax.resize(0);
@@ -1757,87 +2053,224 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
     paceTimeInZone.resize(10);
     paceCPTimeInZone.resize(4);
     wbalTimeInZone.resize(4);
+}
 
-    // set cursor busy whilst we aggregate -- bit of feedback
-    // and less intrusive than a popup box
-    context->mainWindow->setCursor(Qt::WaitCursor);
+// the aggregated arrays, in the same order for every cache
+void
+RideFileCache::aggregateArrays(QList<QVector<double>*> &meanmax, QList<QVector<QDate>*> &dates,
+                               QList<QVector<double>*> &dist, QList<QVector<float>*> &tiz)
+{
+    meanmax << &wattsMeanMaxDouble << &hrMeanMaxDouble << &cadMeanMaxDouble << &nmMeanMaxDouble
+            << &kphMeanMaxDouble << &kphdMeanMaxDouble << &wattsdMeanMaxDouble << &caddMeanMaxDouble
+            << &nmdMeanMaxDouble << &hrdMeanMaxDouble << &xPowerMeanMaxDouble << &npMeanMaxDouble
+            << &vamMeanMaxDouble << &wattsKgMeanMaxDouble << &aPowerMeanMaxDouble << &aPowerKgMeanMaxDouble;
+
+    dates << &wattsMeanMaxDate << &hrMeanMaxDate << &cadMeanMaxDate << &nmMeanMaxDate
+          << &kphMeanMaxDate << &kphdMeanMaxDate << &wattsdMeanMaxDate << &caddMeanMaxDate
+          << &nmdMeanMaxDate << &hrdMeanMaxDate << &xPowerMeanMaxDate << &npMeanMaxDate
+          << &vamMeanMaxDate << &wattsKgMeanMaxDate << &aPowerMeanMaxDate << &aPowerKgMeanMaxDate;
+
+    dist << &wattsDistributionDouble << &hrDistributionDouble << &cadDistributionDouble
+         << &gearDistributionDouble << &nmDistributionDouble << &kphDistributionDouble
+         << &xPowerDistributionDouble << &npDistributionDouble << &wattsKgDistributionDouble
+         << &aPowerDistributionDouble << &smo2DistributionDouble << &wbalDistributionDouble;
+
+    tiz << &wattsTimeInZone << &wattsCPTimeInZone << &hrTimeInZone << &hrCPTimeInZone
+        << &paceTimeInZone << &paceCPTimeInZone << &wbalTimeInZone;
+}
 
-    // Iterate over the ride files (not the cpx files since they /might/ not
-    // exist, or /might/ be out of date.
-    foreach (RideItem *item, context->athlete->rideCache->rides()) {
+// add another ride (rideDate valid) or aggregate (rideDate invalid) into this one
+void
+RideFileCache::aggregate(RideFileCache &other, QDate rideDate)
+{
+    QList<QVector<double>*> meanmax, otherMeanmax, dist, otherDist;
+    QList<QVector<QDate>*> dates, otherDates;
+    QList<QVector<float>*> tiz, otherTiz;
+    aggregateArrays(meanmax, dates, dist, tiz);
+    other.aggregateArrays(otherMeanmax, otherDates, otherDist, otherTiz);
 
-        QDate rideDate = item->dateTime.date();
+    for (int i=0; i<meanmax.count(); i++)
+        meanMaxAggregate(*meanmax[i], *otherMeanmax[i], *dates[i], rideDate, rideDate.isValid() ? NULL : otherDates[i]);
 
-        if (((filter == true && files.contains(item->fileName)) || filter == false) &&
-            rideDate >= start && rideDate <= end) {
+    for (int i=0; i<dist.count(); i++)
+        distAggregate(*dist[i], *otherDist[i]);
 
-            // skip globally filtered values
-            if (context->isfiltered && !context->filters.contains(item->fileName)) continue;
-            if (onhome && context->ishomefiltered && !context->homeFilters.contains(item->fileName)) continue;
-            // skip other sports if rideItem is given
-            if (rideItem && ((rideItem->isRun != item->isRun) || (rideItem->isSwim != item->isSwim))) continue;
-
-            // get its cached values (will NOT! refresh if needed...)
-            // the true means it will check only
-            RideFileCache rideCache(context, context->athlete->home->activities().canonicalPath() + "/" + item->fileName, item->getWeight(), NULL, false, false);
-            if (rideCache.incomplete == true) {
-                // ack, data not available !
-                incomplete = true;
-            } else {
-
-                // lets aggregate
-                meanMaxAggregate(wattsMeanMaxDouble, rideCache.wattsMeanMaxDouble, wattsMeanMaxDate, rideDate);
-                meanMaxAggregate(hrMeanMaxDouble, rideCache.hrMeanMaxDouble, hrMeanMaxDate, rideDate);
-                meanMaxAggregate(cadMeanMaxDouble, rideCache.cadMeanMaxDouble, cadMeanMaxDate, rideDate);
-                meanMaxAggregate(nmMeanMaxDouble, rideCache.nmMeanMaxDouble, nmMeanMaxDate, rideDate);
-                meanMaxAggregate(kphMeanMaxDouble, rideCache.kphMeanMaxDouble, kphMeanMaxDate, rideDate);
-                meanMaxAggregate(kphdMeanMaxDouble, rideCache.kphdMeanMaxDouble, kphdMeanMaxDate, rideDate);
-                meanMaxAggregate(wattsdMeanMaxDouble, rideCache.wattsdMeanMaxDouble, wattsdMeanMaxDate, rideDate);
-                meanMaxAggregate(caddMeanMaxDouble, rideCache.caddMeanMaxDouble, caddMeanMaxDate, rideDate);
-                meanMaxAggregate(nmdMeanMaxDouble, rideCache.nmdMeanMaxDouble, nmdMeanMaxDate, rideDate);
-                meanMaxAggregate(hrdMeanMaxDouble, rideCache.hrdMeanMaxDouble, hrdMeanMaxDate, rideDate);
-                meanMaxAggregate(xPowerMeanMaxDouble, rideCache.xPowerMeanMaxDouble, xPowerMeanMaxDate, rideDate);
-                meanMaxAggregate(npMeanMaxDouble, rideCache.npMeanMaxDouble, npMeanMaxDate, rideDate);
-                meanMaxAggregate(vamMeanMaxDouble, rideCache.vamMeanMaxDouble, vamMeanMaxDate, rideDate);
-                meanMaxAggregate(wattsKgMeanMaxDouble, rideCache.wattsKgMeanMaxDouble, wattsKgMeanMaxDate, rideDate);
-                meanMaxAggregate(aPowerMeanMaxDouble, rideCache.aPowerMeanMaxDouble, aPowerMeanMaxDate, rideDate);
-                meanMaxAggregate(aPowerKgMeanMaxDouble, rideCache.aPowerKgMeanMaxDouble, aPowerKgMeanMaxDate, rideDate);
-
-                distAggregate(wattsDistributionDouble, rideCache.wattsDistributionDouble);
-                distAggregate(hrDistributionDouble, rideCache.hrDistributionDouble);
-                distAggregate(cadDistributionDouble, rideCache.cadDistributionDouble);
-                distAggregate(gearDistributionDouble, rideCache.gearDistributionDouble);
-                distAggregate(nmDistributionDouble, rideCache.nmDistributionDouble);
-                distAggregate(kphDistributionDouble, rideCache.kphDistributionDouble);
-                distAggregate(xPowerDistributionDouble, rideCache.xPowerDistributionDouble);
-                distAggregate(npDistributionDouble, rideCache.npDistributionDouble);
-                distAggregate(wattsKgDistributionDouble, rideCache.wattsKgDistributionDouble);
-                distAggregate(aPowerDistributionDouble, rideCache.aPowerDistributionDouble);
-                distAggregate(smo2DistributionDouble, rideCache.smo2DistributionDouble);
-                distAggregate(wbalDistributionDouble, rideCache.wbalDistributionDouble);
-
-                // cumulate timeinzones
-                for (int i=0; i<10; i++) {
-                    paceTimeInZone[i] += rideCache.paceTimeInZone[i];
-                    hrTimeInZone[i] += rideCache.hrTimeInZone[i];
-                    wattsTimeInZone[i] += rideCache.wattsTimeInZone[i];
-                    if (i<4) {
-                        paceCPTimeInZone[i] += rideCache.paceCPTimeInZone[i];
-                        hrCPTimeInZone[i] += rideCache.hrCPTimeInZone[i];
-                        wattsCPTimeInZone[i] += rideCache.wattsCPTimeInZone[i];
-                        wbalTimeInZone[i] += rideCache.wbalTimeInZone[i];
-                    }
-                }
+    // cumulate timeinzones
+    for (int i=0; i<tiz.count(); i++)
+        for (int j=0; j<tiz[i]->count() && j<otherTiz[i]->count(); j++)
+            (*tiz[i])[j] += (*otherTiz[i])[j];
+
+    if (other.incomplete) incomplete = true;
+}
+
+// aggregate a ride from its .cpx, incomplete if it isn't up to date
+void
+RideFileCache::aggregateRide(RideItem *item)
+{
+    // get its cached values (will NOT! refresh if needed...)
+    // the true means it will check only
+    RideFileCache rideCache(context, context->athlete->home->activities().canonicalPath() + "/" + item->fileName, item->getWeight(), NULL, false, false);
+    if (rideCache.incomplete == true) {
+        // ack, data not available !
+        incomplete = true;
+    } else {
+        // lets aggregate
+        aggregate(rideCache, item->dateTime.date());
+    }
+}
+
+// mean max dates are mostly long runs of the same date
+static void writeDates(QDataStream &out, const QVector<QDate> &dates)
+{
+    QVector<qint32> runs; // pairs of length, julian day
+    for (int i=0; i<dates.count(); i++) {
+        qint32 jd = dates[i].isValid() ? qint32(dates[i].toJulianDay()) : 0;
+        if (runs.count() && runs[runs.count()-1] == jd) runs[runs.count()-2]++;
+        else runs << 1 << jd;
+    }
+    out << runs;
+}
+
+static void readDates(QDataStream &in, QVector<QDate> &dates)
+{
+    QVector<qint32> runs;
+    in >> runs;
+    dates.clear();
+    for (int i=0; i+1<runs.count(); i += 2) {
+        QDate date = runs[i+1] ? QDate::fromJulianDay(runs[i+1]) : QDate();
+        for (int j=0; j<runs[i]; j++) dates << date;
+    }
+}
+
+void
+RideFileCache::writeAggregate(QDataStream &out)
+{
+    QList<QVector<double>*> meanmax, dist;
+    QList<QVector<QDate>*> dates;
+    QList<QVector<float>*> tiz;
+    aggregateArrays(meanmax, dates, dist, tiz);
+
+    out << start << end;
+    for (int i=0; i<meanmax.count(); i++) {
+        out << *meanmax[i];
+        writeDates(out, *dates[i]);
+    }
+    for (int i=0; i<dist.count(); i++) out << *dist[i];
+    for (int i=0; i<tiz.count(); i++) out << *tiz[i];
+}
+
+bool
+RideFileCache::readAggregate(QDataStream &in)
+{
+    QList<QVector<double>*> meanmax, dist;
+    QList<QVector<QDate>*> dates;
+    QList<QVector<float>*> tiz;
+    aggregateArrays(meanmax, dates, dist, tiz);
+
+    in >> start >> end;
+    for (int i=0; i<meanmax.count(); i++) {
+        in >> *meanmax[i];
+        readDates(in, *dates[i]);
+        if (dates[i]->count() != meanmax[i]->count()) return false;
+    }
+    for (int i=0; i<dist.count(); i++) in >> *dist[i];
+    for (int i=0; i<tiz.count(); i++) in >> *tiz[i];
+
+    return in.status() == QDataStream::Ok;
+}
+
+RideFileCacheRides::RideFileCacheRides(Context *context, QDate start, QDate end, bool filter, QStringList files, bool onhome, RideItem *rideItem)
+    : start(start), end(end), filter(filter), onhome(onhome), files(files), sport(-1)
+{
+    filtered = filter || context->isfiltered || (onhome && context->ishomefiltered);
+    if (rideItem) sport = RideFileCacheIndex::sportOf(rideItem);
+
+    if (!filtered) {
+
+        // the index works out which it needs
+        rides = context->athlete->rideCache->rides();
+
+    } else {
+
+        // Iterate over the ride files (not the cpx files since they /might/ not
+        // exist, or /might/ be out of date.
+        foreach (RideItem *item, context->athlete->rideCache->rides()) {
+
+            QDate rideDate = item->dateTime.date();
+
+            if (((filter == true && files.contains(item->fileName)) || filter == false) &&
+                rideDate >= start && rideDate <= end) {
+
+                // skip globally filtered values
+                if (context->isfiltered && !context->filters.contains(item->fileName)) continue;
+                if (onhome && context->ishomefiltered && !context->homeFilters.contains(item->fileName)) continue;
+                // skip other sports if rideItem is given
+                if (rideItem && ((rideItem->isRun != item->isRun) || (rideItem->isSwim != item->isSwim))) continue;
+
+                rides << item;
             }
         }
     }
+}
+
+RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filter, QStringList files, bool onhome, RideItem *rideItem)
+               : start(start), end(end), incomplete(false), context(context), rideFileName(""), ride(0)
+{
+    aggregateRides(RideFileCacheRides(context, start, end, filter, files, onhome, rideItem));
+}
+
+RideFileCache::RideFileCache(Context *context, const RideFileCacheRides &rides)
+               : start(rides.start), end(rides.end), incomplete(false), context(context), rideFileName(""), ride(0)
+{
+    aggregateRides(rides);
+}
+
+void
+RideFileCache::aggregateRides(const RideFileCacheRides &rides)
+{
+    // remember parameters for getting heat
+    this->filter = rides.filter;
+    this->files = rides.files;
+    this->onhome = rides.onhome;
+
+    // Oh lets get from the cache if we can -- but not if filtered
+    if (!rides.filtered && rides.sport < 0) {
+        QMutexLocker locker(&cpxCacheLock);
+        foreach(RideFileCache *p, context->athlete->cpxCache) {
+            if (p->start == start && p->end == end) {
+                *this = *p;
+                return;
+            }
+        }
+    }
+
+    // resize all the arrays to zero - expand as neccessary
+    clearAggregate();
+
+    // set cursor busy whilst we aggregate -- bit of feedback
+    // and less intrusive than a popup box, unless a chart is
+    // aggregating in the background
+    bool gui = QThread::currentThread() == qApp->thread();
+    if (gui) context->mainWindow->setCursor(Qt::WaitCursor);
+
+    if (!rides.filtered) {
+
+        // all the rides in the range, the index has them pre-aggregated
+        // by week, month and year so we only read the rides at the edges
+        context->athlete->cpxIndex->aggregate(this, rides.rides, start, end, rides.sport);
+
+    } else {
+
+        foreach (RideItem *item, rides.rides) aggregateRide(item);
+    }
 
     // set the cursor back to normal
-    context->mainWindow->setCursor(Qt::ArrowCursor);
+    if (gui) context->mainWindow->setCursor(Qt::ArrowCursor);
 
     // lets add to the cache for others to re-use -- but not if filtered or incomplete
-    if (incomplete == false && !context->isfiltered && (!context->ishomefiltered || !onhome) && !filter) {
+    if (incomplete == false && !rides.filtered) {
 
+        QMutexLocker locker(&cpxCacheLock);
         if (context->athlete->cpxCache.count() > maxcache) {
             delete(context->athlete->cpxCache.at(0));
             context->athlete->cpxCache.removeAt(0);
@@ -1931,49 +2364,46 @@ RideFileCache::serialize(QDataStream *out)
     head.smo2DistCount = smo2Distribution.size();
     head.wbalDistCount = wbalDistribution.size();
 
+    // the blocks in the order they are written
+    QVector<float> *meanmax[MEANMAX_BLOCKS] = {
+        &wattsMeanMax, &wattsKgMeanMax, &hrMeanMax, &cadMeanMax, &nmMeanMax, &kphMeanMax,
+        &kphdMeanMax, &wattsdMeanMax, &caddMeanMax, &nmdMeanMax, &hrdMeanMax, &xPowerMeanMax,
+        &npMeanMax, &vamMeanMax, &aPowerMeanMax, &aPowerKgMeanMax
+    };
+    QVector<float> *dist[DIST_BLOCKS] = {
+        &wattsDistribution, &hrDistribution, &cadDistribution, &gearDistribution, &nmDistribution,
+        &kphDistribution, &xPowerDistribution, &npDistribution, &wattsKgDistribution,
+        &aPowerDistribution, &smo2Distribution, &wbalDistribution
+    };
+    QVector<float> *tiz[TIZ_BLOCKS] = {
+        &wattsTimeInZone, &wattsCPTimeInZone, &hrTimeInZone, &hrCPTimeInZone,
+        &paceTimeInZone, &paceCPTimeInZone, &wbalTimeInZone
+    };
+
+    // offset table, so a single series can be read directly
+    unsigned int offset = sizeof(head);
+    for (int i=0; i<MEANMAX_BLOCKS; i++) {
+        head.meanMaxOffset[i] = offset;
+        offset += sizeof(float) * meanmax[i]->size();
+    }
+    for (int i=0; i<DIST_BLOCKS; i++) {
+        head.distOffset[i] = offset;
+        offset += sizeof(float) * dist[i]->size();
+    }
+    for (int i=0; i<TIZ_BLOCKS; i++) {
+        head.tizOffset[i] = offset;
+        offset += sizeof(float) * tiz[i]->size();
+    }
+
     out->writeRawData((const char *) &head, sizeof(head));
 
-    // write meanmax
-    out->writeRawData((const char *) wattsMeanMax.data(), sizeof(float) * wattsMeanMax.size());
-    out->writeRawData((const char *) wattsKgMeanMax.data(), sizeof(float) * wattsKgMeanMax.size());
-    out->writeRawData((const char *) hrMeanMax.data(), sizeof(float) * hrMeanMax.size());
-    out->writeRawData((const char *) cadMeanMax.data(), sizeof(float) * cadMeanMax.size());
-    out->writeRawData((const char *) nmMeanMax.data(), sizeof(float) * nmMeanMax.size());
-    out->writeRawData((const char *) kphMeanMax.data(), sizeof(float) * kphMeanMax.size());
-    out->writeRawData((const char *) kphdMeanMax.data(), sizeof(float) * kphdMeanMax.size());
-    out->writeRawData((const char *) wattsdMeanMax.data(), sizeof(float) * wattsdMeanMax.size());
-    out->writeRawData((const char *) caddMeanMax.data(), sizeof(float) * caddMeanMax.size());
-    out->writeRawData((const char *) nmdMeanMax.data(), sizeof(float) * nmdMeanMax.size());
-    out->writeRawData((const char *) hrdMeanMax.data(), sizeof(float) * hrdMeanMax.size());
-    out->writeRawData((const char *) xPowerMeanMax.data(), sizeof(float) * xPowerMeanMax.size());
-    out->writeRawData((const char *) npMeanMax.data(), sizeof(float) * npMeanMax.size());
-    out->writeRawData((const char *) vamMeanMax.data(), sizeof(float) * vamMeanMax.size());
-    out->writeRawData((const char *) aPowerMeanMax.data(), sizeof(float) * aPowerMeanMax.size());
-    out->writeRawData((const char *) aPowerKgMeanMax.data(), sizeof(float) * aPowerKgMeanMax.size());
-
-
-    // write dist
-    out->writeRawData((const char *) wattsDistribution.data(), sizeof(float) * wattsDistribution.size());
-    out->writeRawData((const char *) hrDistribution.data(), sizeof(float) * hrDistribution.size());
-    out->writeRawData((const char *) cadDistribution.data(), sizeof(float) * cadDistribution.size());
-    out->writeRawData((const char *) gearDistribution.data(), sizeof(float) * gearDistribution.size());
-    out->writeRawData((const char *) nmDistribution.data(), sizeof(float) * nmDistribution.size());
-    out->writeRawData((const char *) kphDistribution.data(), sizeof(float) * kphDistribution.size());
-    out->writeRawData((const char *) xPowerDistribution.data(), sizeof(float) * xPowerDistribution.size());
-    out->writeRawData((const char *) npDistribution.data(), sizeof(float) * npDistribution.size());
-    out->writeRawData((const char *) wattsKgDistribution.data(), sizeof(float) * wattsKgDistribution.size());
-    out->writeRawData((const char *) aPowerDistribution.data(), sizeof(float) * aPowerDistribution.size());
-    out->writeRawData((const char *) smo2Distribution.data(), sizeof(float) * smo2Distribution.size());
-    out->writeRawData((const char *) wbalDistribution.data(), sizeof(float) * wbalDistribution.size());
-
-    // time in zone
-    out->writeRawData((const char *) wattsTimeInZone.data(), sizeof(float) * wattsTimeInZone.size());
-    out->writeRawData((const char *) wattsCPTimeInZone.data(), sizeof(float) * wattsCPTimeInZone.size());
-    out->writeRawData((const char *) hrTimeInZone.data(), sizeof(float) * hrTimeInZone.size());
-    out->writeRawData((const char *) hrCPTimeInZone.data(), sizeof(float) * hrCPTimeInZone.size());
-    out->writeRawData((const char *) paceTimeInZone.data(), sizeof(float) * paceTimeInZone.size());
-    out->writeRawData((const char *) paceCPTimeInZone.data(), sizeof(float) * paceCPTimeInZone.size());
-    out->writeRawData((const char *) wbalTimeInZone.data(), sizeof(float) * wbalTimeInZone.size());
+    // write meanmax, dist and time in zone
+    for (int i=0; i<MEANMAX_BLOCKS; i++)
+        out->writeRawData((const char *) meanmax[i]->data(), sizeof(float) * meanmax[i]->size());
+    for (int i=0; i<DIST_BLOCKS; i++)
+        out->writeRawData((const char *) dist[i]->data(), sizeof(float) * dist[i]->size());
+    for (int i=0; i<TIZ_BLOCKS; i++)
+        out->writeRawData((const char *) tiz[i]->data(), sizeof(float) * tiz[i]->size());
 }
 
 void
@@ -2119,15 +2549,16 @@ int RideFileCache::rank(Context *context, RideFile::SeriesType series, int durat
          double value, Specification spec, int &of)
 {
 
-    QList<double> values;
-
+    QStringList files;
     foreach(RideItem*item, context->athlete->rideCache->rides()) {
         if (!spec.pass(item)) continue;
-
-        // get the best for this one
-        values << RideFileCache::best(context, item->fileName, series, duration);
+        files << item->fileName;
     }
 
+    // get the best for each one
+    QVector<double> bests = RideFileCache::bestsFor(context, files, series, duration);
+    QList<double> values = bests.toList();
+
     // sort the list
     qSort(values.begin(), values.end(), qGreater<double>());
 
@@ -2142,79 +2573,84 @@ int RideFileCache::rank(Context *context, RideFile::SeriesType series, int durat
     return values.count();
 }
 
+static QString cacheFileFor(Context *context, QString filename)
+{
+    QFileInfo rideFileInfo(context->athlete->home->activities().canonicalPath() + "/" + filename);
+    return context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx";
+}
+
+// read a single value from an open cache file
+static double bestFrom(QFile &cacheFile, const RideFileCacheHeader &head, RideFile::SeriesType series, int duration)
+{
+    // out of range or not enough samples
+    if (duration < 0 || duration >= countForMeanMax(head, series)) return 0;
+
+    // jump to correct offset
+    QVector<float> readhere;
+    if (!readFloats(cacheFile, offsetForMeanMax(head, series) + (sizeof(float) * duration), 1, readhere)) return 0;
+
+    double divisor = pow(10, RideFileCache::decimalsFor(series)); // ? 10 : 1;
+    return readhere[0] / divisor; // will convert to double
+}
+
 double 
 RideFileCache::best(Context *context, QString filename, RideFile::SeriesType series, int duration)
 {
-    // read the header
-    QFileInfo rideFileInfo(context->athlete->home->activities().canonicalPath() + "/" + filename);
-    QString cacheFileName(context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx");
-    QFileInfo cacheFileInfo(cacheFileName);
+    if (meanMaxBlock(series) < 0) return 0;
 
-    // head
     RideFileCacheHeader head;
-    QFile cacheFile(cacheFileName);
+    QFile cacheFile(cacheFileFor(context, filename));
 
-    if (cacheFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered) == true) {
-        QDataStream inFile(&cacheFile);
-        inFile.readRawData((char *) &head, sizeof(head));
+    double returning = 0;
+    if (openCache(cacheFile, head)) {
+        returning = bestFrom(cacheFile, head, series, duration);
+        cacheFile.close();
+    }
+    return returning;
+}
 
-        // out of date or not enough samples
-        if (head.version != RideFileCacheVersion || duration > countForMeanMax(head, series)) {
-            cacheFile.close();
-            return 0;
-        }
+// best for one series and duration for many rides, in the order passed
+QVector<double>
+RideFileCache::bestsFor(Context *context, QStringList filenames, RideFile::SeriesType series, int duration)
+{
+    QVector<double> returning(filenames.count());
+    if (meanMaxBlock(series) < 0) return returning;
 
-        // jump to correct offset
-        long offset = offsetForMeanMax(head, series) + (sizeof(float) * (duration));
-        inFile.skipRawData(offset);
+    for (int i=0; i<filenames.count(); i++) {
 
-        float readhere = 0;
-        inFile.readRawData((char*)&readhere, sizeof(float));
-        cacheFile.close();
+        RideFileCacheHeader head;
+        QFile cacheFile(cacheFileFor(context, filenames[i]));
 
-        double divisor = pow(10, decimalsFor(series)); // ? 10 : 1;
-        return readhere / divisor; // will convert to double
+        if (openCache(cacheFile, head)) {
+            returning[i] = bestFrom(cacheFile, head, series, duration);
+            cacheFile.close();
+        }
     }
-
-    return 0;
+    return returning;
 }
 
 int 
 RideFileCache::tiz(Context *context, QString filename, RideFile::SeriesType series, int zone)
 {
-    if (zone < 1 || zone > 10) return 0;
+    if (zone < 1 || zone > 10 || tizBlock(series) < 0) return 0;
 
-    // read the header
-    QFileInfo rideFileInfo(context->athlete->home->activities().canonicalPath() + "/" + filename);
-    QString cacheFileName(context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx");
-    QFileInfo cacheFileInfo(cacheFileName);
+    // wbal only has 4 zones
+    if (series == RideFile::wbal && zone > 4) return 0;
 
-    // head
     RideFileCacheHeader head;
-    QFile cacheFile(cacheFileName);
-
-    if (cacheFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered) == true) {
-        QDataStream inFile(&cacheFile);
-        inFile.readRawData((char *) &head, sizeof(head));
+    QFile cacheFile(cacheFileFor(context, filename));
 
-        // out of date 
-        if (head.version != RideFileCacheVersion) {
-            cacheFile.close();
-            return 0;
-        }
+    float returning = 0;
+    if (openCache(cacheFile, head)) {
 
         // jump to correct offset
-        long offset = offsetForTiz(head, series) + (sizeof(float) * (zone-1));
-        inFile.skipRawData(offset);
+        QVector<float> readhere;
+        if (readFloats(cacheFile, offsetForTiz(head, series) + (sizeof(float) * (zone-1)), 1, readhere))
+            returning = readhere[0];
 
-        float readhere = 0;
-        inFile.readRawData((char*)&readhere, sizeof(float));
         cacheFile.close();
-
-        return readhere; // will convert to double
     }
-
-    return 0;
+    return returning; // will convert to int
 }
 
 // get best values (as passed in the list of MetricDetails between the dates specified
@@ -2252,23 +2688,11 @@ RideFileCache::getAllBestsFor(Context *context, QList<MetricDetail> metrics, Spe
         // get the ride cache name
 
         // CPX ?
-        QFileInfo rideFileInfo(context->athlete->home->activities().canonicalPath() + "/" + ride->fileName);
-        QString cacheFileName(context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx");
         RideFileCacheHeader head;
-        QFile cacheFile(cacheFileName);
+        QFile cacheFile(cacheFileFor(context, ride->fileName));
 
-        // open ok ?
-        if (cacheFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered) == false) continue;
-
-        // get header
-        QDataStream inFile(&cacheFile);
-        inFile.readRawData((char *) &head, sizeof(head));
-
-        // out of date - just skip
-        if (head.version != RideFileCacheVersion) {
-            cacheFile.close();
-            continue;
-        }
+        // open ok and up to date? - just skip if not
+        if (openCache(cacheFile, head) == false) continue;
 
         RideBest add;
         add.setFileName(ride->fileName);
@@ -2278,22 +2702,9 @@ RideFileCache::getAllBestsFor(Context *context, QList<MetricDetail> metrics, Spe
         foreach (MetricDetail workitem, worklist) {
 
             int seconds = workitem.duration * workitem.duration_units;
-            float value;
-
-            if (seconds > countForMeanMax(head, workitem.series)) value=0.0;
-            else {
-
-                // get the values and place into the summarymetric map
-                long offset = offsetForMeanMax(head, workitem.series) + 
-                              (sizeof(head)) +
-                              (sizeof(float) * ((workitem.duration*workitem.duration_units)));
 
-                cacheFile.seek(qint64(offset));
-                inFile.readRawData((char*)&value, sizeof(float));
-                double divisor = pow(10, decimalsFor(workitem.series));
-                value = value / divisor;
-
-            }
+            // get the values and place into the summarymetric map
+            double value = bestFrom(cacheFile, head, workitem.series, seconds);
             add.setForSymbol(workitem.bestSymbol, value);
 
         }
@@ -23,6 +23,7 @@
 #include <QDataStream>
 #include <QVector>
 #include <QThread>
+#include <QRunnable>
 
 class Context;
 class RideFile;
@@ -41,7 +42,7 @@ typedef double data_t;
 // arrays when plotting CP curves and histograms. It is precoputed
 // to save time and cached in a file .cpx
 //
-static const unsigned int RideFileCacheVersion = 25;
+static const unsigned int RideFileCacheVersion = 27;
 // revision history:
 // version  date         description
 // 1        29-Apr-11    Initial - header, mean-max & distribution data blocks
@@ -68,13 +69,23 @@ static const unsigned int RideFileCacheVersion = 25;
 // 23       14-Jun-15    Added W'bal TiZ and Distribution
 // 24       15-Jun-15    Fix percentify error on W'bal Distribution
 // 25       19-Dec-16    Added aPower
+// 26       17-Oct-26    Exact mean-max for every duration, no longer back filled
+// 27       18-Oct-26    Added block offset table to header
 
 // The cache file (.cpx) has a binary format:
 // 1 x Header data - describing the version and contents of the cache
 // n x Blocks - meanmax or distribution arrays
-// 1 x Watts TIZ - 10 floats
-// 1 x Heartrate TIZ - 10 floats
-// 1 x W'Bal TIX - 10 floats
+// 1 x Watts TIZ - 10 floats + 4 polarized
+// 1 x Heartrate TIZ - 10 floats + 4 polarized
+// 1 x Pace TIZ - 10 floats + 4 polarized
+// 1 x W'Bal TIZ - 4 floats
+//
+// The header holds the offset of every block from the start of the
+// file, so a single series can be read without reading the rest.
+
+#define MEANMAX_BLOCKS 16   // watts, wattsKg, hr, cad, nm, kph, kphd, wattsd, cadd, nmd, hrd, xPower, NP, vam, aPower, aPowerKg
+#define DIST_BLOCKS 12      // watts, hr, cad, gear, nm, kph, xPower, NP, wattsKg, aPower, smo2, wbal
+#define TIZ_BLOCKS 7        // watts, wattsCP, hr, hrCP, pace, paceCP, wbal
 
 // The header is written directly to disk, the only
 // field which is endian sensitive is the count field
@@ -119,7 +130,11 @@ struct RideFileCacheHeader {
     double CV;   // used to calculate Time in Zone (TIZ)
     double WEIGHT; // weight in kg x 10 used for w/kg
     double WPRIME; // W' used from config used to calculate (TIZ)
-                
+
+    // offset from start of file to each block, in the order above
+    unsigned int meanMaxOffset[MEANMAX_BLOCKS],
+                 distOffset[DIST_BLOCKS],
+                 tizOffset[TIZ_BLOCKS];
 };
 
 
@@ -140,9 +155,29 @@ struct RideFileCacheHeader {
 // is updated alongside the metrics. So, in theory, at runtime, once
 // the arrays have been computed they can be retrieved quickly.
 //
+// The rides to aggregate across a date range, taken on the GUI thread from
+// the ride cache and filters so the aggregate can be computed in the
+// background (see CPPlot)
+class RideFileCacheRides
+{
+    public:
+        RideFileCacheRides(Context *context, QDate start, QDate end, bool filter = false,
+                           QStringList files = QStringList(), bool onhome = true, RideItem *rideItem = NULL);
+
+        QDate start, end;
+        bool filter, onhome;
+        QStringList files;
+
+        bool filtered;              // only some rides, so not pre-aggregated
+        int sport;                  // as RideFileCacheIndex, -1 for all
+        QVector<RideItem*> rides;   // all of them in date order, or just those wanted if filtered
+};
+
 // This is the main user entry to the ridefile cached data.
 class RideFileCache
 {
+    friend class RideFileCacheIndex;
+
     public:
         enum cachetype { meanmax, distribution, none };
         typedef enum cachetype CacheType;
@@ -162,6 +197,7 @@ class RideFileCache
         // Construct a ridefile cache that represents the data
         // across a date range. This is used to provide aggregated data.
         RideFileCache(Context *context, QDate start, QDate end, bool filter = false, QStringList files = QStringList(), bool onhome = true, RideItem *rideItem = NULL);
+        RideFileCache(Context *context, const RideFileCacheRides &rides); // safe off the GUI thread
 
         // once a cache is loaded we can refresh from in-memory if needed
         void refresh(RideFile*ride = NULL);
@@ -180,6 +216,12 @@ class RideFileCache
         static QVector<float> meanMaxFor(QString cachFilename, RideFile::SeriesType series);
         static QVector<float> meanMaxFor(QString cacheDir, RideFile::SeriesType series, QDate from, QDate to);
 
+        // one series for many cache files at once, in the order passed
+        static QVector<QVector<float> > meanMaxFor(QStringList cacheFilenames, RideFile::SeriesType series);
+
+        // read a single meanmax or distribution block directly, values as stored
+        static QVector<float> readBlock(QString cacheFilename, CacheType type, RideFile::SeriesType series);
+
         // not actually a copy constructor -- but we call it IN the constructor.
         RideFileCache(RideFileCache *other) { *this = *other; }
 
@@ -191,6 +233,7 @@ class RideFileCache
         static int rank(Context *context, RideFile::SeriesType series, int duration, 
                         double value, Specification spec, int &of);
         static double best(Context *context, QString fileName, RideFile::SeriesType series, int duration);
+        static QVector<double> bestsFor(Context *context, QStringList fileNames, RideFile::SeriesType series, int duration);
         static int tiz(Context *context, QString fileName, RideFile::SeriesType series, int zone);
 
         // get all the bests passed and return a list of summary metrics, like the DBAccess
@@ -202,6 +245,10 @@ class RideFileCache
         // compute the cache and return it for the ride
         static RideFileCache *createCacheFor(RideFile*);
 
+        // compare the mean max search against the one it replaced for the
+        // rides in a folder (--meanmaxcheck), returns the number that differ
+        static int checkMeanMax(const QString &folder);
+
         // get data
         static QList<RideFile::SeriesType> meanMaxList(); // list of types available as meanmax arrays
         QVector<double> &meanMaxArray(RideFile::SeriesType); // return meanmax array for the given series
@@ -241,6 +288,17 @@ class RideFileCache
         //void computeMeanMax(QVector<float>&, RideFile::SeriesType);      // compute mean max arrays
         void computeDistribution(QVector<float>&, RideFile::SeriesType); // compute the distributions
 
+        // aggregating across rides, see RideFileCacheIndex
+        RideFileCache(Context *context); // empty aggregate
+        void clearAggregate();
+        void aggregate(RideFileCache &other, QDate rideDate); // invalid date to merge aggregates
+        void aggregateRide(RideItem *item);
+        void aggregateRides(const RideFileCacheRides &rides);
+        void aggregateArrays(QList<QVector<double>*> &meanmax, QList<QVector<QDate>*> &dates,
+                             QList<QVector<double>*> &dist, QList<QVector<float>*> &tiz);
+        void writeAggregate(QDataStream &out);
+        bool readAggregate(QDataStream &in);
+
 
     private:
 
@@ -404,15 +462,20 @@ struct cpintdata {
     cpintdata() : rec_int_ms(0) {}
 };
 
-// the mean-max computer ... runs in a thread
-class MeanMaxComputer : public QThread
+// the mean-max computer ... runs as a task in the TaskPool
+// or can be run() directly, owned by the caller
+class MeanMaxComputer : public QRunnable
 {
     public:
         MeanMaxComputer(RideFile *ride, QVector<float>&array, RideFile::SeriesType series)
-        : ride(ride), array(array), series(series) {}
+        : ride(ride), array(array), series(series) { setAutoDelete(false); }
         void run();
 
+        // against the search it replaced, see RideFileCache::checkMeanMax()
+        int compare(int &durations);
+
     private:
+        data_t *integrate(int &length, int &maxlength, int &total_secs);
 
         RideFile *ride;
         QVector<float> &array;
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideFileCacheIndex.h"
+#include "RideFileCache.h"
+#include "Context.h"
+#include "Athlete.h"
+#include "RideItem.h"
+#include "RideDBStore.h" // for write
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QMutexLocker>
+
+static const quint32 INDEX_MAGIC = 0x47434d4d; // "GCMM"
+static const int SPORTS = 4; // isRun and isSwim combinations
+
+RideFileCacheIndex::RideFileCacheIndex(Context *context) : context(context), generation(0)
+{
+}
+
+int
+RideFileCacheIndex::sportOf(const RideItem *item)
+{
+    return (item->isRun ? 1 : 0) | (item->isSwim ? 2 : 0);
+}
+
+QDate
+RideFileCacheIndex::periodEnd(Period period, QDate start)
+{
+    switch (period) {
+    case Week: return start.addDays(6);
+    case Month: return start.addMonths(1).addDays(-1);
+    default:
+    case Year: return start.addYears(1).addDays(-1);
+    }
+}
+
+QString
+RideFileCacheIndex::periodFile(int sport, Period period, QDate start) const
+{
+    static const char prefix[] = { 'w', 'm', 'y' };
+    return QString("%1/meanmax/%2-%3%4.idx").arg(context->athlete->home->cache().canonicalPath())
+                                             .arg(sport)
+                                             .arg(prefix[period])
+                                             .arg(start.toString("yyyyMMdd"));
+}
+
+// rides are held in date order
+int
+RideFileCacheIndex::firstRide(const QVector<RideItem*> &rides, QDate date)
+{
+    int low = 0, high = rides.count();
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (rides[mid]->dateTime.date() < date) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+// which rides a period was built from, 0 if there are none
+quint32
+RideFileCacheIndex::signature(const QVector<RideItem*> &rides, int sport, QDate from, QDate to)
+{
+    quint32 returning = 0;
+    for (int i=firstRide(rides, from); i<rides.count() && rides[i]->dateTime.date() <= to; i++)
+        if (sportOf(rides[i]) == sport) returning = (returning * 31) + qHash(rides[i]->fileName) + 1;
+
+    return returning;
+}
+
+void
+RideFileCacheIndex::aggregate(RideFileCache *into, const QVector<RideItem*> &rides, QDate from, QDate to, int sport)
+{
+    QList<int> sports;
+    if (sport >= 0) sports << sport;
+    else for (int i=0; i<SPORTS; i++) sports << i;
+
+    QDate date = from;
+    while (date <= to) {
+
+        // nothing left to aggregate (e.g. all time ends in the future)
+        int next = firstRide(rides, date);
+        if (next >= rides.count() || rides[next]->dateTime.date() > to) break;
+
+        // the largest period starting today that fits, weeks don't cross into
+        // a month that could be used instead
+        QDate nextMonth = QDate(date.year(), date.month(), 1).addMonths(1);
+        Period period;
+        bool whole = true;
+
+        if (date.day() == 1 && date.month() == 1 && periodEnd(Year, date) <= to) period = Year;
+        else if (date.day() == 1 && periodEnd(Month, date) <= to) period = Month;
+        else if (date.dayOfWeek() == 1 && periodEnd(Week, date) <= to &&
+                 (periodEnd(Week, date) < nextMonth || periodEnd(Month, nextMonth) > to)) period = Week;
+        else whole = false;
+
+        if (whole) {
+
+            // skip over the empty ones, there are a lot of those in "All Time"
+            if (rides[next]->dateTime.date() <= periodEnd(period, date))
+                foreach(int each, sports) periodFor(into, rides, each, period, date);
+
+            date = periodEnd(period, date).addDays(1);
+
+        } else {
+
+            // an odd day at the start or end of the range
+            for (int i=next; i<rides.count() && rides[i]->dateTime.date() == date; i++)
+                if (sport < 0 || sportOf(rides[i]) == sport) into->aggregateRide(rides[i]);
+
+            date = date.addDays(1);
+        }
+    }
+}
+
+// merge a period into the aggregate, reading or building it
+bool
+RideFileCacheIndex::periodFor(RideFileCache *into, const QVector<RideItem*> &rides, int sport, Period period, QDate start)
+{
+    quint32 sig = signature(rides, sport, start, periodEnd(period, start));
+    if (sig == 0) return false;
+
+    QFile file(periodFile(sport, period, start));
+    if (file.open(QIODevice::ReadOnly)) {
+
+        QDataStream in(&file);
+        in.setVersion(QDataStream::Qt_4_6);
+
+        quint32 magic, version, saved;
+        in >> magic >> version >> saved;
+
+        if (magic == INDEX_MAGIC && version == RideFileCacheVersion && saved == sig) {
+
+            RideFileCache cached(context);
+            if (cached.readAggregate(in)) {
+                into->aggregate(cached, QDate());
+                return true;
+            }
+        }
+        file.close();
+    }
+
+    RideFileCache *built = build(rides, sport, period, start, sig);
+    into->aggregate(*built, QDate());
+    delete built;
+    return true;
+}
+
+RideFileCache *
+RideFileCacheIndex::build(const QVector<RideItem*> &rides, int sport, Period period, QDate start, quint32 sig)
+{
+    lock.lock();
+    int was = generation;
+    lock.unlock();
+
+    RideFileCache *returning = new RideFileCache(context);
+    returning->start = start;
+    returning->end = periodEnd(period, start);
+
+    if (period == Year) {
+
+        // from the months
+        for (QDate month = start; month <= returning->end; month = month.addMonths(1))
+            periodFor(returning, rides, sport, Month, month);
+
+    } else {
+
+        // from the rides
+        for (int i=firstRide(rides, start); i<rides.count() && rides[i]->dateTime.date() <= returning->end; i++)
+            if (sportOf(rides[i]) == sport) returning->aggregateRide(rides[i]);
+    }
+
+    // only keep it if we have everything and nothing changed whilst we were at it
+    if (returning->incomplete == false) {
+
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_4_6);
+        out << INDEX_MAGIC << quint32(RideFileCacheVersion) << sig;
+        returning->writeAggregate(out);
+
+        QMutexLocker locker(&lock);
+        if (was == generation) {
+
+            QString filename = periodFile(sport, period, start);
+            QDir().mkpath(QFileInfo(filename).absolutePath());
+
+            // synced and replaced in one step, so we never leave a partial file
+            RideDBStore::write(filename, data);
+        }
+    }
+    return returning;
+}
+
+// called from the threads refreshing ride caches as well as the gui thread
+void
+RideFileCacheIndex::invalidate(QDate date)
+{
+    if (!date.isValid()) return;
+
+    QMutexLocker locker(&lock);
+    generation++;
+
+    QDate week = date.addDays(1 - date.dayOfWeek());
+    QDate month(date.year(), date.month(), 1);
+    QDate year(date.year(), 1, 1);
+
+    for (int sport=0; sport<SPORTS; sport++) {
+        QFile::remove(periodFile(sport, Week, week));
+        QFile::remove(periodFile(sport, Month, month));
+        QFile::remove(periodFile(sport, Year, year));
+    }
+}
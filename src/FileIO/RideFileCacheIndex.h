@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RideFileCacheIndex_h
+#define _GC_RideFileCacheIndex_h 1
+#include "GoldenCheetah.h"
+
+#include <QDate>
+#include <QString>
+#include <QMutex>
+#include <QVector>
+
+class Context;
+class RideItem;
+class RideFileCache;
+
+// Pre-aggregated mean max, distribution and time in zone data by week,
+// month and year so the aggregate RideFileCache for a date range doesn't
+// need to read the .cpx for every ride in it.
+//
+// A date range is split into the whole years, months and (Monday to Sunday)
+// weeks it contains, at most a handful of each, and the rides on the odd
+// days left over at either end. Each period is an aggregate RideFileCache
+// held in cache/meanmax for each sport and built on first use; weeks and
+// months from their rides' .cpx files and years from their months. They
+// are merged in date order, so the bests and their dates are exactly those
+// we would get aggregating each ride.
+//
+// When a ride's .cpx is recomputed, or it is added or deleted, the periods
+// containing it are discarded and rebuilt next time they are needed. Each
+// period also remembers a signature of the rides it was built from and is
+// rebuilt if the rides in the period don't match (e.g. renamed).
+//
+// Periods that include a ride without an up to date .cpx are not kept, the
+// aggregate is marked incomplete just as it was when aggregating each ride.
+
+class RideFileCacheIndex
+{
+    public:
+        RideFileCacheIndex(Context *context);
+
+        // aggregate from..to of rides, all the rides in date order (a copy
+        // of rideCache->rides() so this can run in the background), only
+        // those of sport if it is not -1
+        void aggregate(RideFileCache *into, const QVector<RideItem*> &rides, QDate from, QDate to, int sport);
+
+        // a ride on this date has changed, been added or deleted
+        void invalidate(QDate date);
+
+        static int sportOf(const RideItem *item);
+
+    private:
+        enum period { Week, Month, Year };
+        typedef enum period Period;
+
+        static QDate periodEnd(Period period, QDate start);
+
+        QString periodFile(int sport, Period period, QDate start) const;
+        bool periodFor(RideFileCache *into, const QVector<RideItem*> &rides, int sport, Period period, QDate start);
+        RideFileCache *build(const QVector<RideItem*> &rides, int sport, Period period, QDate start, quint32 sig);
+        static quint32 signature(const QVector<RideItem*> &rides, int sport, QDate from, QDate to);
+        static int firstRide(const QVector<RideItem*> &rides, QDate date); // index in rides
+
+        Context *context;
+
+        QMutex lock;
+        int generation; // bumped on invalidate, stops stale periods being saved
+};
+
+#endif // _GC_RideFileCacheIndex_h
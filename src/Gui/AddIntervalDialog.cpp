@@ -26,6 +26,7 @@
 #include "RideItem.h"
 #include "Colors.h"
 #include "WPrime.h"
+#include "PeakSearch.h"
 #include "HelpWhatsThis.h"
 #include <QMap>
 #include <cmath>
@@ -470,29 +471,6 @@ intervalDistance(const RideFilePoint *start, const RideFilePoint *stop, const Ri
     return 1000*(stop->km - start->km);// + (ride->recIntSecs()*stop->kph/3600));
 }
 
-static bool
-intervalsOverlap(const AddIntervalDialog::AddedInterval &a,
-                 const AddIntervalDialog::AddedInterval &b)
-{
-    if ((a.start <= b.start) && (a.stop > b.start))
-        return true;
-    if ((b.start <= a.start) && (b.stop > a.start))
-        return true;
-    return false;
-}
-
-struct CompareBests {
-    // Sort by decreasing power and increasing start time.
-    bool operator()(const AddIntervalDialog::AddedInterval &a,
-                    const AddIntervalDialog::AddedInterval &b) const {
-        if (a.avg > b.avg)
-            return true;
-        if (b.avg > a.avg)
-            return false;
-        return a.start < b.start;
-    }
-};
-
 void
 AddIntervalDialog::createClicked()
 {
@@ -829,17 +807,10 @@ AddIntervalDialog::findPeakPowerStandard(Context *context, const RideFile *ride,
 {
     QString prefix = tr("Peak");
 
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 5, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 10, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 20, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 30, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 60, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 120, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 300, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 600, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 1200, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 1800, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 3600, 1, results, prefix, "");
+    QVector<double> windowSizes;
+    windowSizes << 5 << 10 << 20 << 30 << 60 << 120 << 300 << 600 << 1200 << 1800 << 3600;
+
+    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, windowSizes, 1, results, prefix, "");
 }
 
 void
@@ -847,55 +818,24 @@ AddIntervalDialog::findPeaks(Context *context, bool typeTime, const RideFile *ri
                              RideFile::SeriesType series, RideFile::Conversion conversion, double windowSize,
                               int maxIntervals, QList<AddedInterval> &results, QString prefixe, QString overideName)
 {
-    QList<AddedInterval> bests;
-    QList<AddedInterval> _results;
-
-    double secsDelta = ride->recIntSecs();
-    double total = 0.0;
-    QList<const RideFilePoint*> window;
-
-    // ride is shorter than the window size!
-    if (typeTime && windowSize > ride->dataPoints().last()->secs + secsDelta) return;
-    if (!typeTime && windowSize > ride->dataPoints().last()->km*1000) return;
+    QVector<double> windowSizes;
+    windowSizes << windowSize;
+    findPeaks(context, typeTime, ride, spec, series, conversion, windowSizes, maxIntervals, results, prefixe, overideName);
+}
 
-    // We're looking for intervals with durations in [windowSizeSecs, windowSizeSecs + secsDelta).
-    RideFileIterator it(const_cast<RideFile*>(ride), spec);
-    while (it.hasNext()) {
-        struct RideFilePoint *point = it.next();
-
-        // Discard points until interval duration is < windowSizeSecs + secsDelta.
-        while ((typeTime && !window.empty() && intervalDuration(window.first(), point, ride) >= windowSize + secsDelta) ||
-               (!typeTime && window.length()>1 && intervalDistance(window.at(1), point, ride) >= windowSize)) {
-            total -= window.first()->value(series);
-            window.takeFirst();
-        }
-        // Add points until interval duration or distance is >= windowSize.
-        total += point->value(series);
-        window.append(point);
-        double duration = intervalDuration(window.first(), window.last(), ride);
-        double distance = intervalDistance(window.first(), window.last(), ride);
+void
+AddIntervalDialog::findPeaks(Context *context, bool typeTime, const RideFile *ride, Specification spec,
+                             RideFile::SeriesType series, RideFile::Conversion conversion, const QVector<double> &windowSizes,
+                             int maxIntervals, QList<AddedInterval> &results, QString prefixe, QString overideName)
+{
+    // all window sizes are searched together
+    QVector<QList<PeakEffort> > found = PeakSearch::find(ride, spec, series, typeTime, windowSizes, maxIntervals);
 
-        if ((typeTime && duration >= windowSize) ||
-            (!typeTime && distance >= windowSize)) {
-            double start = window.first()->secs;
-            double stop = window.last()->secs; //start + duration;
-            double avg = total * secsDelta / duration;
-            bests.append(AddedInterval(start, stop, avg));
-        }
-    }
+    for (int w=0; w<windowSizes.count(); w++) {
+        for (int n=0; n<found[w].count(); n++) {
 
-    std::sort(bests.begin(), bests.end(), CompareBests());
+            AddedInterval candidate(found[w][n].start, found[w][n].stop, found[w][n].avg);
 
-    while (!bests.empty() && (_results.size() < maxIntervals)) {
-        AddedInterval candidate = bests.takeFirst();
-        bool overlaps = false;
-        foreach (const AddedInterval &existing, _results) {
-            if (intervalsOverlap(candidate, existing)) {
-                overlaps = true;
-                break;
-            }
-        }
-        if (!overlaps) {
             QString name = overideName;
             if (overideName == "") {
                 name = tr("%1 %3%4 %2");
@@ -906,22 +846,22 @@ AddIntervalDialog::findPeaks(Context *context, bool typeTime, const RideFile *ri
                     name = name.arg(prefixe);
 
                 if (maxIntervals>1)
-                    name = name.arg(QString("#%1").arg(_results.count()+1));
+                    name = name.arg(QString("#%1").arg(n+1));
                 else
                     name = name.arg("");
 
                 if (typeTime)  {
                     // best n mins
-                    if (windowSize < 60) {
+                    if (windowSizes[w] < 60) {
                         // whole seconds
-                        name = name.arg(windowSize);
+                        name = name.arg(windowSizes[w]);
                         name = name.arg("sec");
-                    } else if (windowSize >= 60 && !(((int)windowSize)%60)) {
+                    } else if (windowSizes[w] >= 60 && !(((int)windowSizes[w])%60)) {
                         // whole minutes
-                        name = name.arg(windowSize/60);
+                        name = name.arg(windowSizes[w]/60);
                         name = name.arg("min");
                     } else {
-                        double secs = windowSize;
+                        double secs = windowSizes[w];
                         double mins = ((int) secs) / 60;
                         secs = secs - mins * 60.0;
                         double hrs = ((int) mins) / 60;
@@ -937,12 +877,12 @@ AddIntervalDialog::findPeaks(Context *context, bool typeTime, const RideFile *ri
                     }
                 } else {
                     // best n mins
-                    if (windowSize < 1000) {
+                    if (windowSizes[w] < 1000) {
                         // whole seconds
-                        name = name.arg(windowSize);
+                        name = name.arg(windowSizes[w]);
                         name = name.arg("m");
                     } else {
-                        double dist = windowSize;
+                        double dist = windowSizes[w];
                         double kms = ((int) dist) / 1000;
                         dist = dist - kms * 1000.0;
                         double ms = dist;
@@ -961,11 +901,9 @@ AddIntervalDialog::findPeaks(Context *context, bool typeTime, const RideFile *ri
             name = name.arg(ride->formatValueWithUnit(round(candidate.avg), series, conversion, context, ride->isSwim()));
 
             candidate.name = name;
-            name = "";
-            _results.append(candidate);
+            results.append(candidate);
         }
     }
-    results.append(_results);
 }
 
 void
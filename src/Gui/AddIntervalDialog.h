@@ -56,6 +56,11 @@ class AddIntervalDialog : public QDialog
                               RideFile::Conversion conversion, double windowSizeSecs,
                               int maxIntervals, QList<AddedInterval> &results, QString prefixe, QString overideName);
 
+        // as above, but searching for a number of window sizes at once (see PeakSearch)
+        static void findPeaks(Context *context, bool typeTime, const RideFile *ride, Specification spec, RideFile::SeriesType series,
+                              RideFile::Conversion conversion, const QVector<double> &windowSizes,
+                              int maxIntervals, QList<AddedInterval> &results, QString prefixe, QString overideName);
+
         static void findFirsts(bool typeTime, const RideFile *ride, double windowSizeSecs,
                                int maxIntervals, QList<AddedInterval> &results);
 
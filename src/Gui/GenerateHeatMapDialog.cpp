@@ -25,6 +25,11 @@
 #include "Colors.h"
 #include "HelpWhatsThis.h"
 
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <cmath>
+
 GenerateHeatMapDialog::GenerateHeatMapDialog(Context *context) : QDialog(context->mainWindow), context(context)
 {
     setAttribute(Qt::WA_DeleteOnClose);
@@ -176,44 +181,42 @@ GenerateHeatMapDialog::cancelClicked()
     reject();
 }
 
-void
-GenerateHeatMapDialog::generateNow()
-{
-
-    double minLat = 999;
-    double maxLat = -999;
-    double minLon = 999;
-    double maxLon = -999;
-    QHash<QString, int> hash;
-
-    // loop through the table and export all selected
-    for(int i=0; i<files->invisibleRootItem()->childCount(); i++) {
-
-        // give user a chance to abort..
-        QApplication::processEvents();
+// the heat map is a count of the GPS points in each cell of a grid
+// 0.00001 degrees square, keyed by the cell's row and column
+static const double HEATMAP_CELL = 100000;
 
-        // did they?
-        if (aborted == true) return; // user aborted!
-
-        QTreeWidgetItem *current = files->invisibleRootItem()->child(i);
+static qint64
+heatMapCell(double lat, double lon)
+{
+    return (qint64(floor(lat * HEATMAP_CELL)) << 32) ^ (qint64(floor(lon * HEATMAP_CELL)) & 0xffffffffLL);
+}
 
-        // is it selected
-        if (static_cast<QCheckBox*>(files->itemWidget(current,0))->isChecked()) {
+// reads one activity (or uses it if already open) and bins its points
+class HeatMapWorker : public QRunnable
+{
+    public:
+        HeatMapWorker(Context *context, QString filename, RideFile *open, QAtomicInt *aborted)
+            : context(context), filename(filename), open(open), aborted(aborted), success(false),
+              minLat(999), maxLat(-999), minLon(999), maxLon(-999) { setAutoDelete(false); }
 
-            files->setCurrentItem(current); QApplication::processEvents();
+        void run() {
 
-            // this one then
-            current->setText(4, tr("Reading...")); QApplication::processEvents();
+            // the user gave up before we got started
+            if (aborted->fetchAndAddOrdered(0)) {
+                done.ref();
+                return;
+            }
 
-            // open it..
-            QStringList errors;
-            QList<RideFile*> rides;
-            QFile thisfile(QString(context->athlete->home->activities().absolutePath()+"/"+current->text(1)));
-            RideFile *ride = RideFileFactory::instance().openRideFile(context, thisfile, errors, &rides);
+            RideFile *ride = open;
+            if (ride == NULL) {
+                QStringList errors;
+                QList<RideFile*> rides;
+                QFile thisfile(QString(context->athlete->home->activities().absolutePath()+"/"+filename));
+                ride = RideFileFactory::instance().openRideFile(context, thisfile, errors, &rides);
+            }
 
-            // open success?
             if (ride) {
-                current->setText(4, tr("Writing...")); QApplication::processEvents();
+                success = true;
 
                 if (ride->areDataPresent()->lat == true && ride->areDataPresent()->lon == true) {
                     int lastDistance = 0;
@@ -224,38 +227,120 @@ GenerateHeatMapDialog::generateNow()
 
                             // Pick up a point max every 15m
                             lastDistance = (int) (point->km * 1000) + 15;
-                            //outhtml << "  new google.maps.LatLng("<<point->lat<<", "<<point->lon<<"),\n";
-                            QString lonlat = QString("%1,%2").arg(floorf(point->lat*100000)/100000).arg(floorf(point->lon*100000)/100000);
-                            if (hash.contains(lonlat)) {
-                                hash[lonlat] = hash[lonlat] + 1;
-                            } else {
-                                hash[lonlat] = 1;
-                            }
+                            grid[heatMapCell(point->lat, point->lon)]++;
 
                             if (minLon > point->lon) minLon = point->lon;
                             if (minLat > point->lat) minLat = point->lat;
                             if (maxLon < point->lon) maxLon = point->lon;
                             if (maxLat < point->lat) maxLat = point->lat;
-
                         }
-
                     }
                 }
 
-                delete ride; // free memory!
-            // open failed
-            } else {
-                current->setText(4, tr("Read error")); QApplication::processEvents();
+                if (ride != open) delete ride; // free memory!
             }
+            done.ref();
+        }
+
+        Context *context;
+        QString filename;
+        RideFile *open;
+        QAtomicInt *aborted;
+
+        // results, only read once done is set
+        QAtomicInt done;
+        bool success;
+        QHash<qint64, int> grid;
+        double minLat, maxLat, minLon, maxLon;
+};
+
+void
+GenerateHeatMapDialog::generateNow()
+{
+
+    double minLat = 999;
+    double maxLat = -999;
+    double minLon = 999;
+    double maxLon = -999;
+    QHash<qint64, int> hash;
+
+    // activities that are already open don't need to be read again
+    QHash<QString, RideItem*> items;
+    foreach(RideItem *item, context->athlete->rideCache->rides()) items.insert(item->fileName, item);
+
+    // read and bin all the selected activities in parallel, the threads
+    // are our own so we can abort without waiting for the global pool
+    QThreadPool pool;
+    QAtomicInt abort;
+    QList<QPair<QTreeWidgetItem*, HeatMapWorker*> > workers;
+
+    for(int i=0; i<files->invisibleRootItem()->childCount(); i++) {
+
+        QTreeWidgetItem *current = files->invisibleRootItem()->child(i);
+
+        // is it selected
+        if (static_cast<QCheckBox*>(files->itemWidget(current,0))->isChecked()) {
+
+            RideItem *item = items.value(current->text(1), NULL);
+            RideFile *open = (item && item->isOpen()) ? item->ride() : NULL;
+
+            HeatMapWorker *worker = new HeatMapWorker(context, current->text(1), open, &abort);
+            workers << QPair<QTreeWidgetItem*, HeatMapWorker*>(current, worker);
+            current->setText(4, tr("Reading..."));
+            pool.start(worker);
         }
     }
 
-    QHashIterator<QString, int> i(hash);
+    // merge the results in order as they arrive
+    for (int i=0; i<workers.count(); i++) {
+
+        QTreeWidgetItem *current = workers[i].first;
+        HeatMapWorker *worker = workers[i].second;
+
+        files->setCurrentItem(current);
+        while (!worker->done.fetchAndAddOrdered(0)) {
+
+            // give user a chance to abort..
+            QApplication::processEvents();
+            if (aborted == true) abort.ref();
+
+            pool.waitForDone(50);
+        }
+
+        if (worker->success) {
+            exports++;
+            current->setText(4, tr("Writing..."));
+
+            QHashIterator<qint64, int> cell(worker->grid);
+            while (cell.hasNext()) {
+                cell.next();
+                hash[cell.key()] += cell.value();
+            }
+
+            if (minLon > worker->minLon) minLon = worker->minLon;
+            if (minLat > worker->minLat) minLat = worker->minLat;
+            if (maxLon < worker->maxLon) maxLon = worker->maxLon;
+            if (maxLat < worker->maxLat) maxLat = worker->maxLat;
+
+        } else if (!abort.fetchAndAddOrdered(0)) {
+            fails++;
+            current->setText(4, tr("Read error"));
+        }
+    }
+
+    pool.waitForDone();
+    for (int i=0; i<workers.count(); i++) delete workers[i].second;
+
+    // did they?
+    if (aborted == true) return; // user aborted!
+
+    QHashIterator<qint64, int> i(hash);
     QString datapoints = "";
     while (i.hasNext()) {
          i.next();
-         datapoints += QString("[%1,%2],")
-                    .arg(i.key())
+         datapoints += QString("[%1,%2,%3],")
+                    .arg(double(qint32(i.key() >> 32)) / HEATMAP_CELL, 0, 'f', 5)
+                    .arg(double(qint32(i.key() & 0xffffffffLL)) / HEATMAP_CELL, 0, 'f', 5)
                     .arg(i.value());
     }
     QFile filehtml(dirName->text() + "/HeatMap.htm");
@@ -921,12 +921,14 @@ class TotalWork : public RideMetric {
 
         joules = 0;
 
+        // scan the power column directly
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-
-            if (point->watts >= 0.0)
-                joules += point->watts * item->ride()->recIntSecs();
+        QVector<double> column = item->ride()->column(RideFile::watts);
+        const double *watts = column.constData();
+        if (!column.isEmpty() && it.firstIndex() >= 0) {
+            for (int i=it.firstIndex(); i<=it.lastIndex(); i++)
+                if (watts[i] >= 0.0) joules += watts[i];
+            joules *= item->ride()->recIntSecs();
         }
         setValue(joules/1000);
     }
@@ -1035,13 +1037,16 @@ struct AvgPower : public RideMetric {
 
         total = count = 0;
     
+        // scan the power column directly
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-
-            if (point->watts >= 0.0) {
-                total += point->watts;
-                ++count;
+        QVector<double> column = item->ride()->column(RideFile::watts);
+        const double *watts = column.constData();
+        if (!column.isEmpty() && it.firstIndex() >= 0) {
+            for (int i=it.firstIndex(); i<=it.lastIndex(); i++) {
+                if (watts[i] >= 0.0) {
+                    total += watts[i];
+                    ++count;
+                }
             }
         }
         setValue(count > 0 ? total / count : 0);
@@ -18,6 +18,7 @@
  */
 
 #include "RideMetric.h"
+#include "RideKernel.h"
 #include "RideItem.h"
 #include "HrZones.h"
 #include "Context.h"
@@ -63,13 +64,8 @@ public:
 
         // get zone ranges
         if (item->context->athlete->hrZones(item->isRun) && item->hrZoneRange >= 0 && item->ride()->areDataPresent()->hr) {
-            // iterate and compute
-            RideFileIterator it(item->ride(), spec);
-            while (it.hasNext()) {
-                struct RideFilePoint *point = it.next();
-                if (item->context->athlete->hrZones(item->isRun)->whichZone(item->hrZoneRange, point->hr) == level)
-                    seconds += item->ride()->recIntSecs();
-            }
+            // the zone histogram is shared by all the zone metrics
+            seconds = kernel(item, spec)->hrZoneTime(item->context->athlete->hrZones(item->isRun), item->hrZoneRange).value(level, 0.0);
         }
         setValue(seconds);
     }
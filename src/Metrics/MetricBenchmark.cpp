@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MetricBenchmark.h"
+#include "RideMetric.h"
+#include "RideCache.h"
+#include "RideItem.h"
+#include "Athlete.h"
+#include "Context.h"
+#include "Specification.h"
+
+#include <QElapsedTimer>
+#include <stdio.h>
+
+void
+MetricBenchmark::run(Context *context)
+{
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+
+    QStringList builtin, user;
+    foreach(QString symbol, factory.allMetrics()) {
+        if (factory.rideMetric(symbol)->isUser()) user << symbol;
+        else builtin << symbol;
+    }
+
+    if (user.isEmpty()) {
+        fprintf(stdout, "metricbench: there are no user metrics to time\n");
+        fflush(stdout);
+        return;
+    }
+
+    // the programs are shared by the clones, so we switch them
+    // between looking up names and compiled via one of each
+    QList<UserMetric*> programs;
+    foreach(QString symbol, user) programs << static_cast<UserMetric*>(factory.newMetric(symbol));
+
+    qint64 elapsed[2] = { 0, 0 }; // looked up, compiled
+    int rides = 0;
+
+    foreach(RideItem *item, context->athlete->rideCache->rides()) {
+
+        bool open = item->isOpen();
+        if (!item->ride() || item->ride()->dataPoints().isEmpty()) {
+            if (!open) item->close();
+            continue;
+        }
+
+        // what the user metrics depend upon, not timed
+        QHash<QString,RideMetricPtr> computed = RideMetric::computeMetrics(item, Specification(), builtin);
+        QHash<QString,RideMetric*> deps;
+        QHashIterator<QString,RideMetricPtr> it(computed);
+        while (it.hasNext()) {
+            it.next();
+            deps.insert(it.key(), it.value().data());
+        }
+
+        // alternate which goes first so neither gains from the
+        // other having warmed the caches for this ride
+        for (int n=0; n<2; n++) {
+
+            int pass = (rides % 2) ? 1-n : n;
+            foreach(UserMetric *program, programs) program->setCompiled(pass == 1);
+
+            QElapsedTimer timer;
+            timer.start();
+            foreach(QString symbol, user) {
+                RideMetric *m = factory.newMetric(symbol);
+                m->setValue(0.0);
+                m->setCount(0);
+                m->compute(item, Specification(), deps);
+                delete m;
+            }
+            elapsed[pass] += timer.nsecsElapsed();
+        }
+
+        if (!open) item->close();
+        rides++;
+    }
+
+    // back as they were
+    foreach(UserMetric *program, programs) {
+        program->setCompiled(true);
+        delete program;
+    }
+
+    fprintf(stdout, "metricbench: %d user metrics over %d rides\n", user.count(), rides);
+    fprintf(stdout, "metricbench: names looked up as evaluated %.1f ms\n", double(elapsed[0]) / 1000000.0);
+    fprintf(stdout, "metricbench: names resolved when compiled %.1f ms\n", double(elapsed[1]) / 1000000.0);
+    if (elapsed[1]) fprintf(stdout, "metricbench: %.2fx\n", double(elapsed[0]) / double(elapsed[1]));
+    fflush(stdout);
+}
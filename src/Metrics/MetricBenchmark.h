@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_MetricBenchmark_h
+#define _GC_MetricBenchmark_h 1
+#include "GoldenCheetah.h"
+
+class Context;
+
+// Measures what refreshing the user metrics costs
+//
+// Every user metric is computed for every ride in the athlete's ride cache,
+// first with the names in their programs looked up as they are evaluated
+// (as DataFilter always did) and then resolved once when compiled, and the
+// time for each reported. The builtin metrics they depend upon are computed
+// beforehand and not included, nor is opening the rides.
+//
+// Started from the command line with
+//      --metricbench
+
+class MetricBenchmark
+{
+    public:
+        static void run(Context *context);
+};
+
+#endif // _GC_MetricBenchmark_h
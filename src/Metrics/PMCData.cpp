@@ -34,7 +34,7 @@
 #include <QProgressDialog>
 
 PMCData::PMCData(Context *context, Specification spec, QString metricName, int stsDays, int ltsDays) 
-    : context(context), specification_(spec), metricName_(metricName), stsDays_(stsDays), ltsDays_(ltsDays), isstale(true)
+    : context(context), specification_(spec), metricName_(metricName), stsDays_(stsDays), ltsDays_(ltsDays), isstale(true), partial(false), sbToday(false)
 {
     // get defaults if not passed
     useDefaults = false;
@@ -59,14 +59,14 @@ PMCData::PMCData(Context *context, Specification spec, QString metricName, int s
 
 
     refresh();
-    connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(invalidate()));
-    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(invalidate()));
+    connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(rideChanged(RideItem*)));
+    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(rideDeleted(RideItem*)));
     connect(context, SIGNAL(refreshUpdate(QDate)), this, SLOT(invalidate()));
-    connect(context->athlete->rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(invalidate()));
+    connect(context->athlete->rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(rideChanged(RideItem*)));
 }
 
 PMCData::PMCData(Context *context, Specification spec, Leaf *expr, DataFilterRuntime *df, int stsDays, int ltsDays) 
-    : context(context), specification_(spec), metricName_(""), stsDays_(stsDays), ltsDays_(ltsDays), isstale(true)
+    : context(context), specification_(spec), metricName_(""), stsDays_(stsDays), ltsDays_(ltsDays), isstale(true), partial(false), sbToday(false)
 {
     // get defaults if not passed
     useDefaults = false;
@@ -91,15 +91,38 @@ PMCData::PMCData(Context *context, Specification spec, Leaf *expr, DataFilterRun
 
 
     refresh();
-    connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(invalidate()));
-    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(invalidate()));
+    connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(rideChanged(RideItem*)));
+    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(rideDeleted(RideItem*)));
     connect(context, SIGNAL(refreshUpdate(QDate)), this, SLOT(invalidate()));
-    connect(context->athlete->rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(invalidate()));
+    connect(context->athlete->rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(rideChanged(RideItem*)));
 }
 
 void PMCData::invalidate()
 {
     isstale=true;
+    partial=false;
+}
+
+void PMCData::rideChanged(RideItem *item)
+{
+    // from where it was as well as where it is, the date may have changed
+    QDate date = item->dateTime.date();
+    QDate was = counted.value(item, date);
+    if (was < date) date = was;
+
+    if (!isstale) {
+        isstale = true;
+        partial = true;
+        dirty = date;
+    } else if (partial && date < dirty) {
+        dirty = date;
+    }
+}
+
+void PMCData::rideDeleted(RideItem *item)
+{
+    rideChanged(item);
+    counted.remove(item);
 }
 
 void PMCData::refresh()
@@ -107,6 +130,7 @@ void PMCData::refresh()
     if (!isstale) return;
 
     // we need to reread config if refreshing (it might have changed)
+    int wasSts = stsDays_, wasLts = ltsDays_;
     if (useDefaults) {
 
         QVariant lts = appsettings->cvalue(context->athlete->cyclist, GC_LTS_DAYS);
@@ -121,6 +145,9 @@ void PMCData::refresh()
     QTime timer;
     timer.start();
 
+    // the range we computed last time
+    QDate wasStart = start_, wasEnd = end_;
+
     //
     // STEP ONE: What is the date range ?
     //
@@ -155,6 +182,23 @@ void PMCData::refresh()
     // back to null date if not set, just to get round date arithmetic
     if (start_ == QDate(9999,12,31)) start_ = QDate();
 
+    // only recompute from the earliest change if nothing else changed
+    bool sbNow = appsettings->cvalue(context->athlete->cyclist, GC_SB_TODAY).toInt();
+    QDate now = QDate::currentDate();
+    int from = 0;
+    if (partial && start_ == wasStart && end_ == wasEnd && today == now && sbToday == sbNow &&
+        stsDays_ == wasSts && ltsDays_ == wasLts) {
+        from = start_.daysTo(dirty);
+        if (from < 0) from = 0;
+        if (from >= days_) {
+            isstale = partial = false;
+            return;
+        }
+    }
+    today = now;
+    sbToday = sbNow;
+    partial = false;
+
     // We got a valid range ?
     if (start_ != QDate() && end_ != QDate() && start_ < end_) {
 
@@ -209,32 +253,46 @@ void PMCData::refresh()
     //
     // STEP TWO What are the seedings and ride values
     //
-    bool sbToday = appsettings->cvalue(context->athlete->cyclist, GC_SB_TODAY).toInt();
     double lte = (double)exp(-1.0/ltsDays_);
     double ste = (double)exp(-1.0/stsDays_);
 
-    // clear what's there
-    stress_.fill(0);
-    lts_.fill(0);
-    sts_.fill(0);
-    sb_.fill(0);
-    rr_.fill(0);
+    // clear what's there, sb is written a day ahead and rr from the
+    // previous day so they are all overwritten from here
+    if (from == 0) {
+        stress_.fill(0);
+        lts_.fill(0);
+        sts_.fill(0);
+        sb_.fill(0);
+        rr_.fill(0);
+
+        planned_stress_.fill(0);
+        planned_lts_.fill(0);
+        planned_sts_.fill(0);
+        planned_sb_.fill(0);
+        planned_rr_.fill(0);
 
-    planned_stress_.fill(0);
-    planned_lts_.fill(0);
-    planned_sts_.fill(0);
-    planned_sb_.fill(0);
-    planned_rr_.fill(0);
+        expected_lts_.fill(0);
+        expected_sts_.fill(0);
+        expected_sb_.fill(0);
+        expected_rr_.fill(0);
 
-    expected_lts_.fill(0);
-    expected_sts_.fill(0);
-    expected_sb_.fill(0);
-    expected_rr_.fill(0);
+        counted.clear();
+
+    } else {
+
+        for (int day=from; day < days_; day++) {
+            stress_[day] = lts_[day] = sts_[day] = 0;
+            planned_stress_[day] = planned_lts_[day] = planned_sts_[day] = 0;
+            expected_lts_[day] = expected_sts_[day] = 0;
+        }
+    }
 
     // add the seeded values from seasons
     foreach(Season x, context->athlete->seasons->seasons) {
         if (x.getSeed()) {
             int offset = start_.daysTo(x.getStart());
+            if (offset < from) continue;
+
             lts_[offset] = x.getSeed() * -1;
             sts_[offset] = x.getSeed() * -1;
 
@@ -244,8 +302,10 @@ void PMCData::refresh()
     }
 
     // add the stress scores
+    QDate changed = start_.addDays(from);
     foreach(RideItem *item, context->athlete->rideCache->rides()) {
 
+        if (item->dateTime.date() < changed) continue;
         if (!specification_.pass(item)) continue;
 
         // seed with score for this one
@@ -265,6 +325,7 @@ void PMCData::refresh()
                     stress_[offset] += value;
                 //qDebug()<<"stress_["<<offset<<"] :"<<stress_[offset];
             }
+            counted.insert(item, item->dateTime.date());
         }
     }
 
@@ -274,21 +335,22 @@ void PMCData::refresh()
     double lastLTS=0.0f;
     double lastSTS=0.0f;
 
-    double rollingStress=0;
+    // rolling stress carries on from the day before
+    double rollingStress = from > 1 ? rr_[from-1] : 0;
 
     double planned_lastLTS=0.0f;
     double planned_lastSTS=0.0f;
 
-    double planned_rollingStress=0;
+    double planned_rollingStress = from > 1 ? planned_rr_[from-1] : 0;
 
 #if notyet
     double expected_lastLTS=0.0f;
     double expected_lastSTS=0.0f;
 #endif
 
-    double expected_rollingStress=0;
+    double expected_rollingStress = from > 1 && start_.addDays(from-1).daysTo(today) < 0 ? expected_rr_[from-1] : 0;
 
-    for(int day=0; day < days_; day++) {
+    for(int day=from; day < days_; day++) {
 
         // not seeded
         if (lts_[day] >=0 || sts_[day]>=0) {
@@ -364,14 +426,14 @@ void PMCData::refresh()
         // ****  EXPECTED  ****
         // ********************
 
-        if (start_.addDays(day).daysTo(QDate::currentDate())<0) {
+        if (start_.addDays(day).daysTo(today)<0) {
             double lastLts = 0.0;
             double lastSts = 0.0;
             double ltsAtStsDays1 = 0.0;
             double ltsAtStsDays2 = 0.0;
 
             if (day) {
-                if (start_.addDays(day).daysTo(QDate::currentDate())<-1) {
+                if (start_.addDays(day).daysTo(today)<-1) {
                     lastLts = expected_lts_[day-1];
                     lastSts = expected_sts_[day-1];
                 } else {
@@ -379,13 +441,13 @@ void PMCData::refresh()
                     lastSts = sts_[day-1];
                 }
                 if (day > stsDays_) {
-                    if (start_.addDays(day).daysTo(QDate::currentDate())<-1-stsDays_) {
+                    if (start_.addDays(day).daysTo(today)<-1-stsDays_) {
                         ltsAtStsDays1 = expected_lts_[day-stsDays_-1];
                     } else {
                         ltsAtStsDays1 = lts_[day-stsDays_-1];
                     }
 
-                    if (start_.addDays(day).daysTo(QDate::currentDate())<-stsDays_) {
+                    if (start_.addDays(day).daysTo(today)<-stsDays_) {
                         ltsAtStsDays2 = expected_lts_[day-stsDays_];
                     } else {
                         ltsAtStsDays2 = lts_[day-stsDays_];
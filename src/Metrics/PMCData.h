@@ -32,7 +32,12 @@
 #include <QTreeWidgetItem>
 
 class Context;
+class RideItem;
 
+// The stress for each day is kept between refreshes, when a ride is added,
+// deleted or changed only the days from its date forward are recomputed, the
+// LTS/STS/SB/RR series before then can't have changed. Anything else (config,
+// seasons, parameters or the date range changing) recomputes everything.
 class PMCData : public QObject {
 
     Q_OBJECT
@@ -103,6 +108,10 @@ class PMCData : public QObject {
         void invalidate();
         void refresh();
 
+        // a ride changed, recompute from its date forward
+        void rideChanged(RideItem *item);
+        void rideDeleted(RideItem *item);
+
     private:
 
         // who we for ?
@@ -127,6 +136,11 @@ class PMCData : public QObject {
         QVector<double> expected_lts_, expected_sts_, expected_sb_, expected_rr_;
 
         bool isstale; // needs refreshing
+        bool partial; // only from dirty forward
+        QDate dirty;
+        QDate today; // expected values are from today
+        bool sbToday;
+        QHash<RideItem*, QDate> counted; // date each ride's stress was added on
 };
 
 #endif // _GC_StressCalculator_h
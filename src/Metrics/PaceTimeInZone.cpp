@@ -18,6 +18,7 @@
  */
 
 #include "RideMetric.h"
+#include "RideKernel.h"
 #include "RideItem.h"
 #include "Specification.h"
 #include "Context.h"
@@ -68,13 +69,8 @@ class PaceZoneTime : public RideMetric {
 
         // get zone ranges
         if (zone && zoneRange >= 0) {
-            // iterate and compute
-            RideFileIterator it(item->ride(), spec);
-            while (it.hasNext()) {
-                struct RideFilePoint *point = it.next();
-                if (zone->whichZone(zoneRange, point->kph) == level)
-                    seconds += item->ride()->recIntSecs();
-            }
+            // the zone histogram is shared by all the zone metrics
+            seconds = kernel(item, spec)->paceZoneTime(zone, zoneRange).value(level, 0.0);
         }
         setValue(seconds);
     }
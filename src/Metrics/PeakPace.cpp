@@ -18,6 +18,7 @@
  */
 
 #include "RideMetric.h"
+#include "RideKernel.h"
 #include "AddIntervalDialog.h"
 #include "RideItem.h"
 #include "Context.h"
@@ -64,9 +65,9 @@ class PeakPace : public RideMetric {
             return;
         }
 
-        QList<AddIntervalDialog::AddedInterval> results;
-        AddIntervalDialog::findPeaks(item->context, true, item->ride(), spec, RideFile::kph, RideFile::original, secs, 1, results, "", "");
-        if (results.count() > 0 && results.first().avg > 0 && results.first().avg < 36) pace = 60.0 / results.first().avg;
+        // peaks are shared with the other metrics for this duration
+        RideKernelPeak peak = kernel(item, spec)->peak(RideFile::kph, secs);
+        if (peak.found && peak.avg > 0 && peak.avg < 36) pace = 60.0 / peak.avg;
         else pace = 0.0;
 
         setValue(pace);
@@ -407,9 +408,9 @@ class PeakPaceSwim : public RideMetric {
             return;
         }
 
-        QList<AddIntervalDialog::AddedInterval> results;
-        AddIntervalDialog::findPeaks(item->context, true, item->ride(), spec, RideFile::kph, RideFile::original, secs, 1, results, "", "");
-        if (results.count() > 0 && results.first().avg > 0 && results.first().avg < 9) pace = 6.0 / results.first().avg;
+        // peaks are shared with the other metrics for this duration
+        RideKernelPeak peak = kernel(item, spec)->peak(RideFile::kph, secs);
+        if (peak.found && peak.avg > 0 && peak.avg < 9) pace = 6.0 / peak.avg;
         else pace = 0.0;
         setValue(pace);
     }
@@ -1138,15 +1139,15 @@ class PeakPaceHr : public RideMetric {
         }
 
         // find peak pace interval
-        QList<AddIntervalDialog::AddedInterval> results;
-        AddIntervalDialog::findPeaks(item->context, true, item->ride(), spec, RideFile::kph, RideFile::original, secs, 1, results, "", "");
+        // peaks are shared with the other metrics for this duration
+        RideKernelPeak peak = kernel(item, spec)->peak(RideFile::kph, secs);
 
         // work out average hr during that interval
-        if (results.count() > 0) {
+        if (peak.found) {
 
             // start and stop is in seconds within the ride
-            double start = results.first().start;
-            double stop = results.first().stop;
+            double start = peak.start;
+            double stop = peak.stop;
             int points = 0;
 
             RideFileIterator it(item->ride(), spec);
@@ -17,6 +17,7 @@
  */
 
 #include "RideMetric.h"
+#include "RideKernel.h"
 #include "RideItem.h"
 #include "AddIntervalDialog.h"
 #include "Context.h"
@@ -297,9 +298,9 @@ class PeakPower : public RideMetric {
             return;
         }
 
-        QList<AddIntervalDialog::AddedInterval> results;
-        AddIntervalDialog::findPeaks(item->context, true, item->ride(), spec, RideFile::watts, RideFile::original, secs, 1, results, "", "");
-        if (results.count() > 0 && results.first().avg < 3000) watts = results.first().avg;
+        // peaks are shared with the other metrics for this duration
+        RideKernelPeak peak = kernel(item, spec)->peak(RideFile::watts, secs);
+        if (peak.found && peak.avg < 3000) watts = peak.avg;
         else watts = 0.0;
 
         setValue(watts);
@@ -637,15 +638,15 @@ class PeakPowerHr : public RideMetric {
         }
 
         // find peak power interval
-        QList<AddIntervalDialog::AddedInterval> results;
-        AddIntervalDialog::findPeaks(item->context, true, item->ride(), spec, RideFile::watts, RideFile::original, secs, 1, results, "", "");
+        // peaks are shared with the other metrics for this duration
+        RideKernelPeak peak = kernel(item, spec)->peak(RideFile::watts, secs);
 
         // work out average hr during that interval
-        if (results.count() > 0) {
+        if (peak.found) {
 
             // start and stop is in seconds within the ride
-            double start = results.first().start;
-            double stop = results.first().stop;
+            double start = peak.start;
+            double stop = peak.stop;
             int points = 0;
 
             RideFileIterator it(item->ride(), spec);
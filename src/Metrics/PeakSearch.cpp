@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "PeakSearch.h"
+
+#include <algorithm>
+
+// heap order; best first, then earliest start
+struct WorseEffort {
+    bool operator()(const PeakEffort &a, const PeakEffort &b) const {
+        if (a.avg < b.avg) return true;
+        if (b.avg < a.avg) return false;
+        return a.start > b.start;
+    }
+};
+
+static bool
+overlaps(const PeakEffort &a, const PeakEffort &b)
+{
+    if ((a.start <= b.start) && (a.stop > b.start)) return true;
+    if ((b.start <= a.start) && (b.stop > a.start)) return true;
+    return false;
+}
+
+// one per window size being slid along the ride
+struct PeakWindow {
+    PeakWindow() : size(0), first(0), total(0), found(false) {}
+
+    double size;
+    int first;                      // sample at start of window
+    double total;                   // of samples in window
+    bool found;
+    PeakEffort best;                // when only want one
+    QVector<PeakEffort> candidates; // when want more than one
+};
+
+QVector<QList<PeakEffort> >
+PeakSearch::find(const RideFile *cride, Specification spec, RideFile::SeriesType series,
+                 bool byTime, const QVector<double> &sizes, int maxIntervals)
+{
+    QVector<QList<PeakEffort> > returning(sizes.count());
+    RideFile *ride = const_cast<RideFile*>(cride);
+    if (!ride || ride->dataPoints().isEmpty() || sizes.isEmpty() || maxIntervals < 1) return returning;
+
+    RideFileIterator it(ride, spec);
+    int first = it.firstIndex();
+    int last = it.lastIndex();
+    if (first < 0) return returning;
+
+    QVector<double> secsColumn = ride->column(RideFile::secs);
+    QVector<double> kmColumn = ride->column(RideFile::km);
+    QVector<double> valuesColumn = ride->column(series);
+    if (secsColumn.isEmpty() || (!byTime && kmColumn.isEmpty())) return returning;
+
+    // a series that isn't present reads as zero, as it does from the ride
+    // file points, so findPeaks always found a window averaging zero
+    if (valuesColumn.isEmpty()) valuesColumn.fill(0.0, secsColumn.count());
+
+    const double *secs = secsColumn.constData();
+    const double *km = kmColumn.constData();
+    const double *values = valuesColumn.constData();
+
+    double delta = ride->recIntSecs();
+    double rideSize = byTime ? ride->dataPoints().last()->secs + delta : ride->dataPoints().last()->km * 1000;
+
+    // ride is shorter than the window size! we just don't search for those
+    QVector<PeakWindow> windows;
+    QVector<int> which;
+    for (int i=0; i<sizes.count(); i++) {
+        if (sizes[i] > rideSize) continue;
+
+        PeakWindow add;
+        add.size = sizes[i];
+        add.first = first;
+        windows << add;
+        which << i;
+    }
+    if (windows.isEmpty()) return returning;
+
+    // We're looking for intervals with durations in [size, size + delta)
+    // or distances of at least size, sliding all the windows together.
+    // Totals are accumulated in the same order as findPeaks always has
+    // so the averages are identical.
+    PeakWindow *w = windows.data();
+    int nwindows = windows.count();
+    for (int i=first; i<=last; i++) {
+
+        double value = values[i];
+        for (int n=0; n<nwindows; n++) {
+
+            PeakWindow &p = w[n];
+
+            // Discard points until interval duration is < size + delta
+            // or distance from the second point would be less than size
+            if (byTime) {
+                while (p.first < i && (secs[i] - secs[p.first] + delta) >= p.size + delta) {
+                    p.total -= values[p.first];
+                    p.first++;
+                }
+            } else {
+                while (p.first < i-1 && (1000 * (km[i] - km[p.first+1])) >= p.size) {
+                    p.total -= values[p.first];
+                    p.first++;
+                }
+            }
+
+            // Add points until interval duration or distance is >= size
+            p.total += value;
+            double duration = secs[i] - secs[p.first] + delta;
+            double distance = byTime ? 0 : 1000 * (km[i] - km[p.first]);
+
+            if ((byTime && duration >= p.size) || (!byTime && distance >= p.size)) {
+
+                PeakEffort effort(secs[p.first], secs[i], p.total * delta / duration);
+
+                if (maxIntervals == 1) {
+                    // visited in start order, so strictly better only
+                    if (!p.found || effort.avg > p.best.avg) {
+                        p.found = true;
+                        p.best = effort;
+                    }
+                } else {
+                    p.candidates << effort;
+                }
+            }
+        }
+    }
+
+    // select the best non-overlapping efforts
+    for (int n=0; n<nwindows; n++) {
+
+        QList<PeakEffort> &results = returning[which[n]];
+
+        if (maxIntervals == 1) {
+            if (w[n].found) results << w[n].best;
+            continue;
+        }
+
+        // heapify is linear and we only pop until we have enough
+        QVector<PeakEffort> &heap = w[n].candidates;
+        std::make_heap(heap.begin(), heap.end(), WorseEffort());
+        while (!heap.isEmpty() && results.count() < maxIntervals) {
+
+            std::pop_heap(heap.begin(), heap.end(), WorseEffort());
+            PeakEffort candidate = heap.last();
+            heap.removeLast();
+
+            bool overlapping = false;
+            foreach(const PeakEffort &existing, results) {
+                if (overlaps(candidate, existing)) {
+                    overlapping = true;
+                    break;
+                }
+            }
+            if (!overlapping) results << candidate;
+        }
+        heap.clear();
+    }
+    return returning;
+}
+
+QList<PeakEffort>
+PeakSearch::find(const RideFile *ride, Specification spec, RideFile::SeriesType series,
+                 bool byTime, double window, int maxIntervals)
+{
+    QVector<double> windows;
+    windows << window;
+    return find(ride, spec, series, byTime, windows, maxIntervals).first();
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_PeakSearch_h
+#define _GC_PeakSearch_h 1
+#include "GoldenCheetah.h"
+
+#include <QList>
+#include <QVector>
+
+#include "RideFile.h"
+#include "Specification.h"
+
+// A best effort found in a ride, start and stop are in seconds
+struct PeakEffort {
+    PeakEffort() : start(0), stop(0), avg(0) {}
+    PeakEffort(double start, double stop, double avg) : start(start), stop(stop), avg(avg) {}
+
+    double start, stop, avg;
+};
+
+// Search for the best efforts in a series for a set of window sizes at once
+//
+// Windows are by time (seconds) or distance (meters) and are found exactly as
+// AddIntervalDialog::findPeaks always has; for each sample the shortest window
+// ending on it that is at least the window size. But all the window sizes are
+// slid along the series columns together so the samples are only read once,
+// and the best non-overlapping efforts are selected from a heap of candidates
+// rather than by sorting them all.
+//
+// Used by the peak metrics (via RideKernel), interval discovery in
+// RideItem and the Add Interval dialog.
+
+class PeakSearch
+{
+    public:
+
+        // returns the best maxIntervals non-overlapping efforts for each of
+        // the window sizes passed, in the same order, best first
+        static QVector<QList<PeakEffort> > find(const RideFile *ride, Specification spec, RideFile::SeriesType series,
+                                                bool byTime, const QVector<double> &windows, int maxIntervals=1);
+
+        // convenience for a single window size
+        static QList<PeakEffort> find(const RideFile *ride, Specification spec, RideFile::SeriesType series,
+                                      bool byTime, double window, int maxIntervals=1);
+};
+
+#endif // _GC_PeakSearch_h
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideKernel.h"
+#include "RideItem.h"
+#include "Zones.h"
+#include "HrZones.h"
+#include "PaceZones.h"
+#include "PeakSearch.h"
+
+RideKernel::RideKernel(RideItem *item, Specification spec) :
+    item(item), spec(spec), ride(NULL), first(-1), last(-1), prepared(false)
+{
+}
+
+// we don't touch the ride until a metric asks for something
+RideFile *
+RideKernel::prepare()
+{
+    if (!prepared) {
+        prepared = true;
+        ride = item ? item->ride() : NULL;
+        if (ride) {
+            RideFileIterator it(ride, spec);
+            first = it.firstIndex();
+            last = it.lastIndex();
+        }
+    }
+    return ride;
+}
+
+template<class T> const QVector<double> &
+RideKernel::zoneTime(ZoneTime &cached, const T *zones, int range, RideFile::SeriesType series)
+{
+    // already counted against these zones
+    if (cached.valid && cached.zones == zones && cached.range == range) return cached.seconds;
+
+    cached.valid = true;
+    cached.zones = zones;
+    cached.range = range;
+
+    QVector<double> &seconds = cached.seconds;
+    seconds.clear();
+    if (!prepare() || !zones || range < 0 || first < 0) return seconds;
+
+    // a series that isn't present reads as zero, as it does from the
+    // ride file points, so e.g. a ride without speed is all in pace Z1
+    QVector<double> column = ride->column(series);
+    const double *values = column.isEmpty() ? NULL : column.constData();
+
+    // accumulated a sample at a time, as the metrics always did
+    double secs = ride->recIntSecs();
+    for (int i=first; i<=last; i++) {
+        int zone = zones->whichZone(range, values ? values[i] : 0.0);
+        if (zone < 0) continue;
+        if (zone >= seconds.count()) seconds.resize(zone+1);
+        seconds[zone] += secs;
+    }
+    return seconds;
+}
+
+const QVector<double> &
+RideKernel::powerZoneTime(const Zones *zones, int range)
+{
+    return zoneTime(power, zones, range, RideFile::watts);
+}
+
+const QVector<double> &
+RideKernel::hrZoneTime(const HrZones *zones, int range)
+{
+    return zoneTime(hr, zones, range, RideFile::hr);
+}
+
+const QVector<double> &
+RideKernel::paceZoneTime(const PaceZones *zones, int range)
+{
+    return zoneTime(pace, zones, range, RideFile::kph);
+}
+
+// durations the peak metrics ask for, found together on the first request
+static const double durations[] = { 1, 5, 10, 15, 20, 30, 60, 120, 180, 300, 480,
+                                    600, 1200, 1800, 3600, 5400 };
+
+RideKernelPeak
+RideKernel::peak(RideFile::SeriesType series, double secs)
+{
+    QPair<int, double> key(static_cast<int>(series), secs);
+    QHash<QPair<int, double>, RideKernelPeak>::const_iterator cached = peaks.constFind(key);
+    if (cached != peaks.constEnd()) return cached.value();
+
+    // search for all the durations we expect to be asked for
+    QVector<double> windows;
+    windows << secs;
+    for (unsigned int i=0; i<sizeof(durations)/sizeof(durations[0]); i++)
+        if (durations[i] != secs && !peaks.contains(QPair<int, double>(key.first, durations[i])))
+            windows << durations[i];
+
+    QVector<QList<PeakEffort> > found;
+    if (prepare()) found = PeakSearch::find(ride, spec, series, true, windows);
+
+    for (int i=0; i<windows.count(); i++) {
+        RideKernelPeak result;
+        if (i < found.count() && found[i].count()) {
+            result.found = true;
+            result.avg = found[i].first().avg;
+            result.start = found[i].first().start;
+            result.stop = found[i].first().stop;
+        }
+        peaks.insert(QPair<int, double>(key.first, windows[i]), result);
+    }
+    return peaks.value(key);
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RideKernel_h
+#define _GC_RideKernel_h 1
+#include "GoldenCheetah.h"
+
+#include <QVector>
+#include <QHash>
+#include <QPair>
+
+#include "RideFile.h"
+#include "Specification.h"
+
+class RideItem;
+class Zones;
+class HrZones;
+class PaceZones;
+
+// Work shared by the metrics computed for a ride (or interval of a ride)
+//
+// Many metrics scan the same samples to get at the same thing; each of the
+// time in zone metrics counts samples in its own zone and each of the peak
+// metrics searches for the best window of its own duration (and some then
+// search again to find the HR or pace during it).
+//
+// RideMetric::computeMetrics creates one for each item and specification and
+// hands it to each metric via RideMetric::kernel(). Everything is computed on
+// first request from the RideFile sample columns and then held for the
+// remaining metrics, so a zone histogram is one pass regardless of how many
+// zone metrics there are. Zone histograms are held for the zones and range
+// they were computed with, asking with different ones recomputes them.
+//
+// Results are exactly as the metrics would compute them by iterating the
+// ride themselves, this is an optimisation, not a change of method.
+//
+// It is not thread safe, each thread computing metrics has its own.
+
+struct RideKernelPeak {
+    RideKernelPeak() : found(false), avg(0), start(0), stop(0) {}
+
+    bool found;                 // no window long enough if false
+    double avg, start, stop;    // as PeakSearch
+};
+
+class RideKernel
+{
+    public:
+        RideKernel(RideItem *item, Specification spec);
+
+        // seconds spent in each zone, indexed by zone number
+        const QVector<double> &powerZoneTime(const Zones *zones, int range);
+        const QVector<double> &hrZoneTime(const HrZones *zones, int range);
+        const QVector<double> &paceZoneTime(const PaceZones *zones, int range);
+
+        // best mean for a duration in seconds, found with PeakSearch along
+        // with all the standard durations used by the peak metrics
+        RideKernelPeak peak(RideFile::SeriesType series, double secs);
+
+    private:
+        // a zone histogram and the zones it was counted against
+        struct ZoneTime {
+            ZoneTime() : zones(NULL), range(-1), valid(false) {}
+
+            const void *zones;
+            int range;
+            bool valid;
+            QVector<double> seconds;
+        };
+
+        RideFile *prepare();
+        template<class T> const QVector<double> &zoneTime(ZoneTime &cached, const T *zones, int range, RideFile::SeriesType series);
+
+        RideItem *item;
+        Specification spec;
+        RideFile *ride;
+        int first, last;    // samples covered by the specification, -1 if none
+        bool prepared;
+
+        ZoneTime power, hr, pace;
+        QHash<QPair<int, double>, RideKernelPeak> peaks;
+};
+
+#endif // _GC_RideKernel_h
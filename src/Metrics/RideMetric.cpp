@@ -19,6 +19,7 @@
 #include "RideMetric.h"
 #include "RideItem.h"
 #include "IntervalItem.h"
+#include "RideKernel.h"
 #include "Specification.h"
 #include "UserMetricSettings.h"
 #include "TimeUtils.h"
@@ -194,6 +195,9 @@ RideMetric::computeMetrics(RideItem *item, Specification spec, const QStringList
     // this is what we've completed as we go
     QHash<QString,RideMetric*> done;
 
+    // and what they share, zone times, peaks etc
+    RideKernel kernel(item, spec);
+
     // resize the metric array in the interval if needed
     if (spec.interval() && spec.interval()->metrics().size() < factory.metricCount()) 
         spec.interval()->metrics().resize(factory.metricCount());
@@ -234,7 +238,9 @@ RideMetric::computeMetrics(RideItem *item, Specification spec, const QStringList
             RideMetric *m = factory.newMetric(symbol);
             m->setValue(0.0);
             m->setCount(0);
+            m->setKernel(&kernel);
             m->compute(item, spec, done);
+            m->setKernel(NULL);
 
             // override the computed value if set by user, but not for intervals
             if (!spec.interval() && item->ride() && item->ride()->metricOverrides.contains(symbol))
@@ -280,6 +286,16 @@ RideMetric::computeMetrics(RideItem *item, Specification spec, const QStringList
     return result;
 }
 
+// metrics computed on their own (e.g. by the Add Interval dialog) don't
+// have a shared kernel, so they get one of their own for this compute()
+RideKernel *
+RideMetric::kernel(RideItem *item, Specification spec)
+{
+    if (kernel_) return kernel_;
+    localKernel_ = QSharedPointer<RideKernel>(new RideKernel(item, spec));
+    return localKernel_.data();
+}
+
 double 
 RideMetric::getForSymbol(QString symbol, const QHash<QString,RideMetric*> *p)
 {
@@ -38,6 +38,7 @@ class Context;
 class RideMetric;
 class RideFile;
 class RideItem;
+class RideKernel;
 class DataFilter;
 class DataFilterRuntime;
 class Leaf;
@@ -88,6 +89,7 @@ public:
         count_ = 1;
         value_ = 0.0;
         index_ = -1;
+        kernel_ = NULL;
     }
     virtual ~RideMetric() {}
 
@@ -241,7 +243,16 @@ public:
     void setSymbol(QString x) { symbol_ = x; }
     void setType(MetricType x) { type_ = x; }
 
+    // work shared between metrics, only set during computeMetrics()
+    // otherwise kernel(item, spec) gives one for this metric alone (see RideKernel.h)
+    RideKernel *kernel() const { return kernel_; }
+    RideKernel *kernel(RideItem *item, Specification spec);
+    void setKernel(RideKernel *x) { kernel_ = x; }
+
     protected:
+        RideKernel *kernel_;
+        QSharedPointer<RideKernel> localKernel_; // when computed outside computeMetrics()
+
         double  value_,
                 count_, // used when averaging
                 conversion_,
@@ -272,6 +283,10 @@ public:
     // did we clone (i.e. datafilter doesn't belong to us)
     bool isClone() const { return clone_; }
 
+    // resolve names in the program once or as evaluated, the program is
+    // shared with all the clones so this applies to them too
+    void setCompiled(bool resolve);
+
     void initialize();
 
     QString symbol() const;
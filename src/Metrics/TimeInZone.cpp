@@ -18,6 +18,7 @@
  */
 
 #include "RideMetric.h"
+#include "RideKernel.h"
 #include "RideItem.h"
 #include "Context.h"
 #include "Athlete.h"
@@ -60,15 +61,8 @@ class ZoneTime : public RideMetric {
             return;
         }
 
-        seconds = 0;
-
-        // iterate and compute
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (item->context->athlete->zones(item->isRun)->whichZone(item->zoneRange, point->watts) == level)
-                seconds += item->ride()->recIntSecs();
-        }
+        // the zone histogram is shared by all the zone metrics
+        seconds = kernel(item, spec)->powerZoneTime(item->context->athlete->zones(item->isRun), item->zoneRange).value(level, 0.0);
         setValue(seconds);
     }
 
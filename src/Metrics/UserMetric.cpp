@@ -70,6 +70,14 @@ UserMetric::UserMetric(const UserMetric *from) : RideMetric()
     RideMetricFactory::instance().mutex.unlock();
 }
 
+void
+UserMetric::setCompiled(bool resolve)
+{
+    RideMetricFactory::instance().mutex.lock();
+    if (program) program->setCompiled(resolve);
+    RideMetricFactory::instance().mutex.unlock();
+}
+
 UserMetric::~UserMetric()
 {
     // program is shared, only delete when last is destroyed
@@ -241,9 +249,15 @@ UserMetric::compute(RideItem *item, Specification spec, const QHash<QString,Ride
     if (!spec.isEmpty(item->ride()) && fsample) {
         RideFileIterator it(item->ride(), spec);
 
-        while(it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            root->eval(rt, fsample, 0, const_cast<RideItem*>(item), point, c);
+        // sums over the samples are done a column at a time
+        int from = it.firstIndex(), to = it.lastIndex();
+        if (from < 0 || to < from) { from = 0; to = -1; }
+
+        if (!root->accumulateColumns(rt, fsample, 0, const_cast<RideItem*>(item), from, to, c)) {
+            while(it.hasNext()) {
+                struct RideFilePoint *point = it.next();
+                root->eval(rt, fsample, 0, const_cast<RideItem*>(item), point, c);
+            }
         }
     }
 
@@ -509,12 +509,12 @@ WPrime::setErg(ErgFile *input)
         double totalBelowCP=0;
         double countBelowCP=0;
         QVector<int> powerValues(last+1);
+        QVector<int> watts = input->wattsSampled(1.0);
         EXP = 0;
-        for (int i=0; i<last; i++) {
+        for (int i=0; i<last && i<watts.count(); i++) {
 
             // get watts at point in time
-            int lap;
-            int value = input->wattsAt(i*1000, lap);
+            int value = watts[i];
 
             powerValues[i] = value > CP ? value-CP : 0;
 
@@ -562,11 +562,11 @@ WPrime::setErg(ErgFile *input)
         // input array contains the actual W' expenditure
         // and will also contain non-zero values
         double W = WPRIME;
-        int lap; // passed by reference
-        for (int i=0; i<last; i++) {
+        QVector<int> watts = input->wattsSampled(1.0);
+        for (int i=0; i<last && i<watts.count(); i++) {
 
             // get watts at point in time
-            int value = input->wattsAt(i*1000, lap);
+            int value = watts[i];
 
             if(value < CP) {
                 W  = W + (CP-value)*(WPRIME-W)/WPRIME;
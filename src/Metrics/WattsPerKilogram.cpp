@@ -17,6 +17,7 @@
  */
 
 #include "RideMetric.h"
+#include "RideKernel.h"
 #include "AddIntervalDialog.h"
 #include "RideItem.h"
 #include "Zones.h"
@@ -90,9 +91,9 @@ class PeakWPK : public RideMetric {
         }
 
         weight = item->ride()->getWeight();
-        QList<AddIntervalDialog::AddedInterval> results;
-        AddIntervalDialog::findPeaks(item->context, true, item->ride(), spec, RideFile::watts, RideFile::original, secs, 1, results, "", "");
-        if (results.count() > 0 && results.first().avg < 3000) wpk = results.first().avg / weight;
+        // peaks are shared with the other metrics for this duration
+        RideKernelPeak peak = kernel(item, spec)->peak(RideFile::watts, secs);
+        if (peak.found && peak.avg < 3000) wpk = peak.avg / weight;
         else wpk = 0.0;
         setValue(wpk);
     }
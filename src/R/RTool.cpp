@@ -2648,12 +2648,14 @@ RTool::dfForDateRangePeaks(bool all, DateRange range, SEXP filter, QList<RideFil
 
     // fill with values for date and class
     int i=0;
+    QStringList files;
     foreach(RideItem *item, rtool->context->athlete->rideCache->rides()) {
         // apply filters
         if (!specification.pass(item)) continue;
 
         if (all || range.pass(item->dateTime.date())) {
             REAL(dates)[i++] = item->dateTime.toUTC().toTime_t();
+            files << item->fileName;
         }
     }
 
@@ -2680,21 +2682,11 @@ RTool::dfForDateRangePeaks(bool all, DateRange range, SEXP filter, QList<RideFil
             SET_STRING_ELT(names, next++, Rf_mkChar(name.toLatin1().constData()));
 
             // fill with values
-            // get the value for the series and duration requested, although this is called
+            // get the value for the series and duration requested, for all the
+            // rides at once, its pretty quick since it seeks to the actual value
             int index=0;
-            foreach(RideItem *item, rtool->context->athlete->rideCache->rides()) {
-
-                // apply filters
-                if (!specification.pass(item)) continue;
-
-                // do we want this one ?
-                if (all || range.pass(item->dateTime.date())) {
-
-                    // for each series/duration independently its pretty quick since it lseeks to
-                    // the actual value, so /should't/ be too expensive.........
-                    REAL(vector)[index++] = RideFileCache::best(item->context, item->fileName, pseries, pduration);
-                }
-            }
+            foreach(double value, RideFileCache::bestsFor(rtool->context, files, pseries, pduration))
+                REAL(vector)[index++] = value;
 
             // add named vector to the list
             SET_VECTOR_ELT(df, dfindex++, vector);
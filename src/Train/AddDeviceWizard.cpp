@@ -206,6 +206,7 @@ DeviceScanner::quickScan(bool deep) // scan quickly or if true scan forever, as
     case DEV_FORTIUS : wizard->controller = new FortiusController(NULL, NULL); break;
 #endif
     case DEV_NULL : wizard->controller = new NullController(NULL, NULL); break;
+    case DEV_REPLAY : wizard->controller = new ReplayController(NULL, NULL); break;
     case DEV_ANTLOCAL : wizard->controller = new ANTlocalController(NULL, NULL); break;
 #ifdef QT_BLUETOOTH_LIB
     case DEV_BT40 : wizard->controller = new BT40Controller(NULL, NULL); break;
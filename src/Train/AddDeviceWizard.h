@@ -39,6 +39,7 @@
 #include "ANTlocalController.h"
 #include "ANTChannel.h"
 #include "NullController.h"
+#include "ReplayController.h"
 #include "Settings.h"
 
 #include <QWizard>
@@ -646,6 +646,18 @@ void Computrainer::run()
             //----------------------------------------------------------------
             /* not yet implemented */
 
+            //----------------------------------------------------------------
+            // PUBLISH TO ANYONE FOLLOWING EVERY SAMPLE
+            //----------------------------------------------------------------
+            RealtimeData published;
+            published.setWatts(curPower);
+            published.setHr(curHeartRate);
+            published.setCadence(curCadence);
+            published.setSpeed(curSpeed);
+            published.setLoad(curload);
+            published.setSlope(curgradient);
+            ring.write(published);
+
             } else {
                 // no data
                 // how long to sleep for ... mmm save CPU cycles vs
@@ -143,6 +143,9 @@ public:
     double getGradient();
     double getLoad();
 
+    // every update from the device, see RealtimeRing
+    RealtimeRing *telemetryRing() { return &ring; }
+
 private:
     void run();                                 // called by start to kick off the CT comtrol thread
 
@@ -166,6 +169,7 @@ private:
 
     // Mutex for controlling accessing private data
     QMutex pvars;
+    RealtimeRing ring;
 
     // INBOUND TELEMETRY - all volatile since it is updated by the run() thread
     volatile double devicePower;            // current output power in Watts
@@ -45,6 +45,7 @@ public:
     bool doesPush(), doesPull(), doesLoad();
     void getRealtimeData(RealtimeData &rtData);
     void pushRealtimeData(RealtimeData &rtData);
+    RealtimeRing *telemetryRing() { return myComputrainer->telemetryRing(); }
     void setLoad(double);
     void setGradient(double);
     void setMode(int);
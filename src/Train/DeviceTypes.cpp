@@ -75,6 +75,10 @@ DeviceTypes::DeviceTypes()
         tr("Testing device used for development only. If an ERG file is selected it will "
         "replay back, with a little randomness thrown in."),
         "" },
+      { DEV_REPLAY,   DEV_TCP,     (char *) "Replay", false,   false,
+        tr("Testing device used for development only. Plays back the last ANT+ capture "
+        "(antlog.raw) or a ride, at the same speed it was recorded or faster."),
+        "" },
 #endif
       { 0, 0, NULL, 0, 0, "", "" }
     };
@@ -33,6 +33,7 @@
 #define DEV_ANTLOCAL   0x0080   // Local ANT+ device
 #define DEV_GSERVER    0x0100   // NOT IMPLEMENTED IN THIS RELEASE XXX
 #define DEV_GCLIENT    0x0200   // NOT IMPLEMENTED IN THIS RELEASE XXX
+#define DEV_REPLAY     0x0400   // Replay a ride or ANT capture
 #define DEV_FORTIUS    0x0800   // Tacx Fortius
 #define DEV_BT40       0x2000   // QT Bluetooth support
 #define DEV_MONARK     0x4000   // Monark USB
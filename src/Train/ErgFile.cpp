@@ -29,6 +29,8 @@
 #include "Units.h"
 #include "Utils.h"
 
+#include <algorithm>
+
 // Supported file types
 static QStringList supported;
 static bool setSupported()
@@ -932,53 +934,35 @@ ErgFile::wattsAt(long x, int &lapnum)
 
     // is it in bounds?
     if (x < 0 || x > Duration) return -100;   // out of bounds!!!
+    if (Points.count() < 2) return -100;      // nothing to ramp between
 
     // do we need to return the Lap marker?
-    if (Laps.count() > 0) {
-        int lap=0;
-        for (int i=0; i<Laps.count(); i++) {
-            if (x>=Laps.at(i).x) lap += 1;
-        }
-        lapnum = lap;
-
-    } else lapnum = 0;
+    lapnum = lapAt(x);
 
     // find right section of the file
-    while (x < Points.at(leftPoint).x || x > Points.at(rightPoint).x) {
-        if (x < Points.at(leftPoint).x) {
-            leftPoint--;
-            rightPoint--;
-        } else if (x > Points.at(rightPoint).x) {
-            leftPoint++;
-            rightPoint++;
-        }
-    }
-
-    // two different points in time but the same watts
-    // at both, it doesn't really matter which value
-    // we use
-    if (Points.at(leftPoint).val == Points.at(rightPoint).val)
-        return Points.at(rightPoint).val;
+    leftPoint = segment(x);
+    rightPoint = leftPoint + 1;
 
-    // the erg file will list the point in time twice
-    // to show a jump from one wattage to another
-    // at this point in ime (i.e x=100 watts=100 followed
-    // by x=100 watts=200)
-    if (Points.at(leftPoint).x == Points.at(rightPoint).x)
-        return Points.at(rightPoint).val;
-
-    // so this point in time between two points and
-    // we are ramping from one point and another
-    // the steps in the calculation have been explicitly
-    // listed for code clarity
-    double deltaW = Points.at(rightPoint).val - Points.at(leftPoint).val;
-    double deltaT = Points.at(rightPoint).x - Points.at(leftPoint).x;
-    double offT = x - Points.at(leftPoint).x;
-    double factor = offT / deltaT;
-
-    double nowW = Points.at(leftPoint).val + (deltaW * factor);
+    return valueAt(leftPoint, x);
+}
 
-    return nowW;
+QVector<int>
+ErgFile::wattsSampled(double hz)
+{
+    QVector<int> returning;
+    if (!isValid() || format == CRS || hz <= 0 || Points.count() < 2) return returning;
+
+    // x only ever moves forward so each lookup is a step or two
+    // from the last segment, making this a single sweep of the points
+    int count = (Duration * hz / 1000.0) + 1;
+    returning.resize(count);
+    for (int i=0; i<count; i++) {
+        long x = i * 1000.0 / hz;
+        leftPoint = segment(x);
+        rightPoint = leftPoint + 1;
+        returning[i] = valueAt(leftPoint, x);
+    }
+    return returning;
 }
 
 double
@@ -990,27 +974,15 @@ ErgFile::gradientAt(long x, int &lapnum)
 
     // is it in bounds?
     if (x < 0 || x > Duration) return -100;   // out of bounds!!! (-10 through +15 are valid return vals)
+    if (Points.count() < 2) return -100;      // nothing to look between
 
     // do we need to return the Lap marker?
-    if (Laps.count() > 0) {
-        int lap=0;
-        for (int i=0; i<Laps.count(); i++) {
-            if (x>=Laps.at(i).x) lap += 1;
-        }
-        lapnum = lap;
-
-    } else lapnum = 0;
+    lapnum = lapAt(x);
 
     // find right section of the file
-    while (x < Points.at(leftPoint).x || x > Points.at(rightPoint).x) {
-        if (x < Points.at(leftPoint).x) {
-            leftPoint--;
-            rightPoint--;
-        } else if (x > Points.at(rightPoint).x) {
-            leftPoint++;
-            rightPoint++;
-        }
-    }
+    leftPoint = segment(x);
+    rightPoint = leftPoint + 1;
+
     return Points.at(leftPoint).val;
 }
 
@@ -1018,15 +990,86 @@ int ErgFile::nextLap(long x)
 {
     if (!isValid()) return -1; // not a valid ergfile
 
-    // do we need to return the Lap marker?
-    if (Laps.count() > 0) {
-        for (int i=0; i<Laps.count(); i++) {
-            if (x<Laps.at(i).x) return Laps.at(i).x;
-        }
-    }
+    // first marker ahead of there
+    indexLaps();
+    QVector<long>::const_iterator it = std::upper_bound(lapX.constBegin(), lapX.constEnd(), x);
+    if (it != lapX.constEnd()) return *it;
+
     return -1; // nope, no marker ahead of there
 }
 
+int
+ErgFile::segment(long x)
+{
+    int last = Points.count() - 1;
+
+    // the segment we used last time, or the one after it, is
+    // almost always the one we want when the clock is running
+    for (int i=leftPoint; i<=leftPoint+1; i++) {
+        if (i >= 0 && i < last && Points.at(i+1).x >= x && (i == 0 || Points.at(i).x < x))
+            return i;
+    }
+
+    // otherwise look for the first point at or after x, the
+    // segment we want is the one that ends there
+    int low=1, high=last;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (Points.at(mid).x >= x) high = mid;
+        else low = mid + 1;
+    }
+    return low - 1;
+}
+
+double
+ErgFile::valueAt(int i, long x)
+{
+    const ErgFilePoint &left = Points.at(i);
+    const ErgFilePoint &right = Points.at(i+1);
+
+    // two different points in time but the same watts
+    // at both, it doesn't really matter which value
+    // we use
+    if (left.val == right.val) return right.val;
+
+    // the erg file will list the point in time twice
+    // to show a jump from one wattage to another
+    // at this point in ime (i.e x=100 watts=100 followed
+    // by x=100 watts=200)
+    if (left.x == right.x) return right.val;
+
+    // so this point in time between two points and
+    // we are ramping from one point and another
+    // the steps in the calculation have been explicitly
+    // listed for code clarity
+    double deltaW = right.val - left.val;
+    double deltaT = right.x - left.x;
+    double offT = x - left.x;
+    double factor = offT / deltaT;
+
+    return left.val + (deltaW * factor);
+}
+
+int
+ErgFile::lapAt(long x)
+{
+    // how many markers at or before x
+    indexLaps();
+    return std::upper_bound(lapX.constBegin(), lapX.constEnd(), x) - lapX.constBegin();
+}
+
+void
+ErgFile::indexLaps()
+{
+    // still sharing data with Laps, so it hasn't changed
+    if (indexedLaps.constBegin() == Laps.constBegin() && lapX.count() == Laps.count()) return;
+
+    indexedLaps = Laps;
+    lapX.resize(Laps.count());
+    for (int i=0; i<Laps.count(); i++) lapX[i] = Laps.at(i).x;
+    std::sort(lapX.begin(), lapX.end());
+}
+
 void
 ErgFile::calculateMetrics()
 {
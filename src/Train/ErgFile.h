@@ -114,6 +114,10 @@ class ErgFile
         double gradientAt(long, int&);      // return the gradient value for the passed meter
         int nextLap(long);      // return the msecs value for the next Lap marker
 
+        // watts every 1000/hz msecs from the start to the end of an
+        // erg or mrc workout, in one pass (e.g. for plotting or W'bal)
+        QVector<int> wattsSampled(double hz = 1.0);
+
         // turn the ergfile into a series of sections rather
         // than a list of points
         QList<ErgFileSection> Sections();
@@ -152,6 +156,21 @@ class ErgFile
 
         Context *context;
 
+    private:
+
+        // lookups are a binary search (or a step from the last segment
+        // used) rather than a walk along the points and laps, since the
+        // load is asked for every 100ms while training and every second
+        // of the workout when computing W'bal
+        int segment(long x);        // first segment [i,i+1] ending at or after x
+        int lapAt(long x);          // number of lap markers at or before x
+        double valueAt(int i, long x); // interpolate the load along segment i
+        void indexLaps();           // resort lap markers when Laps has changed
+
+        // Laps is public and edited in place by the workout editor, so we
+        // keep a shallow copy and compare data with it; any change detaches
+        QList<ErgFileLap> indexedLaps;
+        QVector<long> lapX;         // lap marker x, sorted
 };
 
 #endif
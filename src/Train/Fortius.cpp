@@ -449,7 +449,19 @@ void Fortius::run()
                 deviceCadence = curCadence;
                 deviceHeartRate = curHeartRate;
                 devicePower = curPower;
+                double curLoad = load;
+                double curGradient = gradient;
                 pvars.unlock();
+
+                // publish to anyone following every sample
+                RealtimeData published;
+                published.setWatts(curPower);
+                published.setHr(curHeartRate);
+                published.setCadence(curCadence);
+                published.setSpeed(curSpeed);
+                published.setLoad(curLoad);
+                published.setSlope(curGradient);
+                ring.write(published);
             }
         }
 
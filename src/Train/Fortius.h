@@ -115,6 +115,9 @@ public:
     // to sync data read/writes between the run() thread and the main gui thread
     void getTelemetry(double &power, double &heartrate, double &cadence, double &speed, double &distance, int &buttons, int &steering, int &status);
 
+    // every update from the device, see RealtimeRing
+    RealtimeRing *telemetryRing() { return &ring; }
+
 private:
     void run();                                 // called by start to kick off the CT comtrol thread
 
@@ -136,6 +139,7 @@ private:
 
     // Mutex for controlling accessing private data
     QMutex pvars;
+    RealtimeRing ring;
 
     // INBOUND TELEMETRY - all volatile since it is updated by the run() thread
     volatile double devicePower;            // current output power in Watts
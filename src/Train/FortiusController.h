@@ -49,6 +49,7 @@ public:
     bool doesPush(), doesPull(), doesLoad();
     void getRealtimeData(RealtimeData &rtData);
     void pushRealtimeData(RealtimeData &rtData);
+    RealtimeRing *telemetryRing() { return myFortius->telemetryRing(); }
     void setLoad(double);
     void setGradient(double);
     void setMode(int);
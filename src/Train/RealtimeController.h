@@ -19,6 +19,7 @@
 
 // Abstract base class for Realtime device controllers
 #include "RealtimeData.h"
+#include "RealtimeRing.h"
 #include "CalibrationData.h"
 #include "TrainSidebar.h"
 
@@ -57,6 +58,11 @@ public:
     virtual void getRealtimeData(RealtimeData &rtData); // update realtime data with current values
     virtual void pushRealtimeData(RealtimeData &rtData); // update realtime data with current values
 
+    // every sample as it was decoded, for devices that publish telemetry
+    // from their own thread (NULL if they don't). consumers should still
+    // processRealtimeData() what they read.
+    virtual RealtimeRing *telemetryRing() { return NULL; }
+
     // only relevant for Computrainer like devices
     virtual void setLoad(double) { return; }
     virtual void setGradient(double) { return; }
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "RealtimeRing.h"
+
+RealtimeRing::RealtimeRing(int size) : size(size), count(0)
+{
+    samples = new Slot[size];
+    for (int i=0; i<size; i++) samples[i].sequence.fetchAndStoreOrdered(-1);
+    clock.start();
+}
+
+RealtimeRing::~RealtimeRing()
+{
+    delete[] samples;
+}
+
+void
+RealtimeRing::write(const RealtimeData &data)
+{
+    int n = count.fetchAndAddOrdered(0);
+    Slot &slot = samples[n % size];
+
+    slot.sequence.fetchAndStoreOrdered(-1);
+    slot.sample.msecs = clock.elapsed();
+    slot.sample.data = data;
+    slot.sequence.fetchAndStoreOrdered(n);
+
+    // publish it
+    count.fetchAndStoreOrdered(n+1);
+}
+
+bool
+RealtimeRing::read(int n, RealtimeSample &sample)
+{
+    Slot &slot = samples[n % size];
+
+    if (slot.sequence.fetchAndAddOrdered(0) != n) return false;
+    sample = slot.sample;
+    return slot.sequence.fetchAndAddOrdered(0) == n;
+}
+
+void
+RealtimeRingReader::attach(RealtimeRing *ring)
+{
+    this->ring = ring;
+    next_ = ring ? ring->written() : 0;
+    lost_ = 0;
+    lastMsecs = -1;
+    lastSpeed = 0;
+}
+
+bool
+RealtimeRingReader::next(RealtimeSample &sample)
+{
+    if (!ring) return false;
+
+    while (1) {
+        int written = ring->written();
+        if (next_ >= written) return false;
+
+        // fallen behind, skip to the oldest still held
+        if (written - next_ > ring->size) {
+            lost_ += written - ring->size - next_;
+            next_ = written - ring->size;
+        }
+
+        // overwritten whilst we were copying it
+        if (!ring->read(next_, sample)) {
+            lost_++;
+            next_++;
+            continue;
+        }
+
+        next_++;
+        return true;
+    }
+}
+
+bool
+RealtimeRingReader::latest(RealtimeSample &sample)
+{
+    if (!ring) return false;
+
+    // the writer can only overwrite the latest after a ring of writes,
+    // so if that happens we just try again with the new latest
+    while (1) {
+        int written = ring->written();
+        if (written == 0) return false;
+
+        if (ring->read(written-1, sample)) {
+            next_ = written;
+            return true;
+        }
+    }
+}
+
+double
+RealtimeRingReader::travelled(RealtimeSample *latest)
+{
+    static const qint64 HOLD = 2000; // ms a speed is good for
+
+    double km = 0;
+    RealtimeSample sample;
+    while (next(sample)) {
+        if (lastMsecs >= 0) km += lastSpeed * qMin(sample.msecs - lastMsecs, HOLD) / 3600000.0;
+        lastMsecs = sample.msecs;
+        lastSpeed = sample.data.getSpeed();
+        if (latest) *latest = sample;
+    }
+    return km;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef _GC_RealtimeRing_h
+#define _GC_RealtimeRing_h 1
+#include "GoldenCheetah.h"
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include "RealtimeData.h"
+
+// Telemetry from a device thread to whoever wants it, without locks
+//
+// The device thread writes a sample whenever it has decoded new telemetry
+// and never waits for anyone. Each consumer (the GUI, the recorder, the load
+// controller) has its own RealtimeRingReader and takes samples at its own
+// rate; either every sample in order, or just the latest one.
+//
+// There is a single writer. Each slot holds a sequence number, which is -1
+// while the slot is being written and the sample number once it is complete.
+// Readers copy the slot and then check the sequence number hasn't changed.
+// If a reader falls more than a ring behind, the samples it missed are
+// counted as lost and it carries on from the oldest one still held.
+
+struct RealtimeSample {
+    RealtimeSample() : msecs(0) {}
+
+    qint64 msecs;       // when written, ms since the ring was created
+    RealtimeData data;
+};
+
+class RealtimeRing
+{
+    friend class RealtimeRingReader;
+
+    public:
+        RealtimeRing(int size = 256);
+        ~RealtimeRing();
+
+        // device thread only
+        void write(const RealtimeData &data);
+
+        // samples written so far
+        int written() { return count.fetchAndAddOrdered(0); }
+
+    private:
+        struct Slot {
+            QAtomicInt sequence;
+            RealtimeSample sample;
+        };
+
+        // copy sample n if it is still held, false if overwritten
+        bool read(int n, RealtimeSample &sample);
+
+        int size;
+        Slot *samples;
+        QAtomicInt count;
+        QElapsedTimer clock;
+};
+
+class RealtimeRingReader
+{
+    public:
+        RealtimeRingReader(RealtimeRing *ring = NULL) : ring(ring), next_(0), lost_(0), lastMsecs(-1), lastSpeed(0) {}
+
+        // start reading a ring from the next sample written
+        void attach(RealtimeRing *ring);
+
+        // the next sample in order, false if there are no more yet
+        bool next(RealtimeSample &sample);
+
+        // the most recent sample, skipping (not losing) any in between
+        bool latest(RealtimeSample &sample);
+
+        // km travelled according to the samples since the last call, each
+        // sample's speed holds until the next one (for no more than a few
+        // seconds, in case the device goes quiet). the last sample read is
+        // copied to latest, if there were any.
+        double travelled(RealtimeSample *latest = NULL);
+
+        bool attached() const { return ring != NULL; }
+        int lost() const { return lost_; }
+
+    private:
+        RealtimeRing *ring;
+        int next_;
+        int lost_;
+
+        qint64 lastMsecs;   // when the last speed travelled() saw arrived
+        double lastSpeed;
+};
+
+#endif // _GC_RealtimeRing_h
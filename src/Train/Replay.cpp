@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "Replay.h"
+#include "RideFile.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <string.h>
+
+// one record in antlog.raw, see ANTLogger::logRawAntMessage
+static const int CAPTURE_RECORD = 1 + 8 + ANT_MAX_MESSAGE_SIZE;
+
+Replay::Replay(QObject *parent, Context *context, QString filename, double speed) :
+    QThread(parent), context(context), filename(filename), ride(NULL), ant(NULL),
+    pausedAt(-1), pausedTotal(0), paused(false), stopping(false), played(false),
+    load(0), gradient(0)
+{
+    speed_ = qBound(1.0, speed, 100.0);
+}
+
+Replay::~Replay()
+{
+    stop();
+    delete ride;
+    delete ant;
+}
+
+bool
+Replay::open(QStringList &errors)
+{
+    QFile file(filename);
+
+    if (QFileInfo(filename).suffix().toLower() != "raw") {
+
+        // a ride, in any format we can read
+        ride = RideFileFactory::instance().openRideFile(context, file, errors);
+        if (!ride || ride->dataPoints().count() == 0) {
+            errors << tr("No samples to replay in %1").arg(filename);
+            return false;
+        }
+        return true;
+    }
+
+    // an ANT capture
+    if (!file.open(QFile::ReadOnly)) {
+        errors << tr("Cannot open %1").arg(filename);
+        return false;
+    }
+
+    QByteArray record;
+    qint64 first = -1;
+    while ((record = file.read(CAPTURE_RECORD)).size() == CAPTURE_RECORD) {
+
+        const unsigned char *p = (const unsigned char *)record.constData();
+
+        // timestamp in ms, least significant byte first
+        qint64 msecs = 0;
+        for (int i=8; i>0; i--) msecs = (msecs << 8) | p[i];
+        if (first < 0) first = msecs;
+
+        Message m;
+        m.msecs = msecs - first;
+        m.RS = p[0];
+        memcpy(m.data, p + 9, ANT_MAX_MESSAGE_SIZE);
+        messages << m;
+    }
+    file.close();
+
+    if (messages.isEmpty()) {
+        errors << tr("No messages to replay in %1").arg(filename);
+        return false;
+    }
+    ant = new ANT(NULL, NULL);
+    return true;
+}
+
+int
+Replay::start()
+{
+    QMutexLocker locker(&lock);
+    if (isRunning()) return 0;
+
+    clock.start();
+    pausedAt = -1;
+    pausedTotal = 0;
+    paused = stopping = played = false;
+    QThread::start();
+    return 0;
+}
+
+int
+Replay::pause()
+{
+    QMutexLocker locker(&lock);
+    if (paused) return 0;
+
+    pausedAt = clock.elapsed();
+    paused = true;
+    wake.wakeAll();
+    return 0;
+}
+
+int
+Replay::restart()
+{
+    QMutexLocker locker(&lock);
+    if (!paused) return 0;
+
+    pausedTotal += clock.elapsed() - pausedAt;
+    paused = false;
+    wake.wakeAll();
+    return 0;
+}
+
+int
+Replay::stop()
+{
+    lock.lock();
+    stopping = true;
+    wake.wakeAll();
+    lock.unlock();
+
+    wait();
+    return 0;
+}
+
+bool
+Replay::ended()
+{
+    QMutexLocker locker(&lock);
+    return played;
+}
+
+// how far through the recording we should be
+qint64
+Replay::playbackMsecs()
+{
+    qint64 now = paused ? pausedAt : clock.elapsed();
+    return (now - pausedTotal) * speed_;
+}
+
+void
+Replay::run()
+{
+    int count = ride ? ride->dataPoints().count() : messages.count();
+    double first = ride ? ride->dataPoints().first()->secs : 0;
+
+    int index = 0;
+    lock.lock();
+    while (!stopping && index < count) {
+
+        qint64 due = ride ? (ride->dataPoints().at(index)->secs - first) * 1000 : messages.at(index).msecs;
+
+        // not time yet
+        qint64 now = playbackMsecs();
+        if (paused || now < due) {
+            qint64 wait = (due - now) / speed_;
+            wake.wait(&lock, paused ? 100 : qBound(qint64(1), wait, qint64(100)));
+            continue;
+        }
+        lock.unlock();
+
+        play(index++);
+
+        lock.lock();
+    }
+    played = true;
+    lock.unlock();
+}
+
+void
+Replay::play(int index)
+{
+    if (ant) {
+        ant->replay(messages.at(index).RS, messages.at(index).data);
+        return;
+    }
+
+    const RideFilePoint *p = ride->dataPoints().at(index);
+
+    RealtimeData rt;
+    rt.setName((char *)"Replay");
+    rt.setWatts(p->watts);
+    rt.setHr(p->hr);
+    rt.setCadence(p->cad);
+    rt.setSpeed(p->kph);
+    rt.setLRBalance(p->lrbalance);
+    rt.setLTE(p->lte);
+    rt.setRTE(p->rte);
+    rt.setLPS(p->lps);
+    rt.setRPS(p->rps);
+    rt.setHb(p->smo2, p->thb);
+
+    lock.lock();
+    telemetry = rt;
+    lock.unlock();
+
+    ring.write(rt);
+}
+
+void
+Replay::getRealtimeData(RealtimeData &rtData)
+{
+    if (ant) {
+        ant->getRealtimeData(rtData);
+        return;
+    }
+
+    QMutexLocker locker(&lock);
+    rtData = telemetry;
+    rtData.setLoad(load);
+    rtData.setSlope(gradient);
+}
+
+void
+Replay::setLoad(double load)
+{
+    if (ant) ant->setLoad(load);
+
+    QMutexLocker locker(&lock);
+    this->load = load;
+}
+
+void
+Replay::setGradient(double gradient)
+{
+    if (ant) ant->setGradient(gradient);
+
+    QMutexLocker locker(&lock);
+    this->gradient = gradient;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef _GC_Replay_h
+#define _GC_Replay_h 1
+#include "GoldenCheetah.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QVector>
+#include "RealtimeData.h"
+#include "RealtimeRing.h"
+#include "ANT.h"
+
+class Context;
+class RideFile;
+
+// Plays back a recording as if it were a device
+//
+// Either a ride, whose samples are sent as telemetry, or a capture of the
+// ANT messages made by ANTLogger (antlog.raw), whose received messages are
+// passed through the ANT decoder. Samples are played on the schedule they
+// were recorded, from 1x to 100x the speed, so the same recording always
+// produces the same telemetry and the train view can be measured without
+// a trainer. What was recorded is played back whatever load is asked for.
+
+class Replay : public QThread
+{
+    public:
+        Replay(QObject *parent, Context *context, QString filename, double speed = 1.0);
+        ~Replay();
+
+        bool open(QStringList &errors);             // read the recording
+
+        int start();                                // start playing
+        int restart();                              // restart after paused
+        int pause();                                // the recording clock stops whilst paused
+        int stop();                                 // stop playing
+
+        bool ended();                               // played it all
+        double speed() { return speed_; }
+
+        // how the ANT decoder kept up, false when not replaying a capture
+        bool receiveStats(ANTReceiveStats &stats) { if (!ant) return false; stats = ant->receiveStats(); return true; }
+
+        void getRealtimeData(RealtimeData &rtData);
+        RealtimeRing *telemetryRing() { return ant ? ant->telemetryRing() : &ring; }
+        void setLoad(double load);
+        void setGradient(double gradient);
+
+    private:
+        void run();
+        qint64 playbackMsecs();     // called with lock held
+        void play(int index);
+
+        Context *context;
+        QString filename;
+        double speed_;
+
+        // what we are playing, one or the other
+        RideFile *ride;
+        ANT *ant;
+        struct Message {
+            qint64 msecs;           // from the start of the capture
+            unsigned char RS;       // 'R'eceived or 'S'ent
+            unsigned char data[ANT_MAX_MESSAGE_SIZE];
+        };
+        QVector<Message> messages;
+
+        RealtimeRing ring;
+
+        QMutex lock;                // guards the state below
+        QWaitCondition wake;
+        QElapsedTimer clock;
+        qint64 pausedAt, pausedTotal;
+        bool paused, stopping, played;
+        RealtimeData telemetry;
+        double load, gradient;
+};
+
+#endif // _GC_Replay_h
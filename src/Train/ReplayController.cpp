@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "ReplayController.h"
+#include "RealtimeData.h"
+#include "Context.h"
+#include "Athlete.h"
+
+#include <QDir>
+#include <QDebug>
+
+ReplayController::ReplayController(TrainSidebar *parent, DeviceConfiguration *dc, Context *context) :
+    RealtimeController(parent, dc), opened(false)
+{
+    if (parent) context = parent->context;
+
+    // same place ANTlocalController logs to
+    QString filename = dc ? dc->portSpec : "";
+    if (filename.isEmpty()) {
+        if (context) filename = context->athlete->home->root().canonicalPath() + "/antlog.raw";
+        else filename = QDir::tempPath() + "/antlog.raw";
+    }
+
+    double speed = 1.0;
+    if (dc && dc->deviceProfile.toDouble() > 0) speed = dc->deviceProfile.toDouble();
+
+    myReplay = new Replay(this, context, filename, speed);
+}
+
+ReplayController::~ReplayController()
+{
+    delete myReplay;
+}
+
+int
+ReplayController::start()
+{
+    if (!opened) {
+        QStringList errors;
+        if (!myReplay->open(errors)) {
+            qDebug() << "Replay:" << errors.join(", ");
+            return DEVICE_ERROR;
+        }
+        opened = true;
+    }
+    return myReplay->start();
+}
+
+int
+ReplayController::restart()
+{
+    return myReplay->restart();
+}
+
+int
+ReplayController::pause()
+{
+    return myReplay->pause();
+}
+
+int
+ReplayController::stop()
+{
+    return myReplay->stop();
+}
+
+bool
+ReplayController::find()
+{
+    return true;
+}
+
+void
+ReplayController::getRealtimeData(RealtimeData &rtData)
+{
+    myReplay->getRealtimeData(rtData);
+    processRealtimeData(rtData);
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "RealtimeController.h"
+#include "Replay.h"
+
+#ifndef _GC_ReplayController_h
+#define _GC_ReplayController_h 1
+
+// Replays a ride or ANT capture as a device, for testing and benchmarking
+// the train view. The recording is the device port (the athlete's last
+// antlog.raw if none is given) and the speed, 1 to 100 times, is the
+// device profile.
+
+class ReplayController : public RealtimeController
+{
+    Q_OBJECT
+
+public:
+    ReplayController (TrainSidebar *, DeviceConfiguration *, Context *context = NULL);
+    ~ReplayController();
+
+    Replay *myReplay;                           // the device itself
+
+    int start();
+    int restart();                              // restart after paused
+    int pause();                                // pauses data collection, inbound telemetry is discarded
+    int stop();                                 // stops data collection thread
+    bool find();
+    bool discover(QString) { return true; }
+
+    // telemetry push pull
+    bool doesPush() { return false; }
+    bool doesPull() { return true; }
+    bool doesLoad() { return true; }
+    void getRealtimeData(RealtimeData &rtData);
+    void pushRealtimeData(RealtimeData &) {}
+    RealtimeRing *telemetryRing() { return myReplay->telemetryRing(); }
+    void setLoad(double load) { myReplay->setLoad(load); }
+    void setGradient(double gradient) { myReplay->setGradient(gradient); }
+
+private:
+    bool opened;
+};
+
+#endif // _GC_ReplayController_h
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "TrainBenchmark.h"
+#include "TrainSidebar.h"
+#include "TrainRecorder.h"
+#include "ReplayController.h"
+#include "DeviceTypes.h"
+#include "ErgFile.h"
+
+#include <QDir>
+#include <QDateTime>
+#include <QDebug>
+#include <stdio.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+TrainBenchmark::TrainBenchmark(Context *context, QString workout, QString recording, double speed) :
+    context(context), workout(workout), speed(qBound(1.0, speed, 100.0)),
+    ergFile(NULL), controller(NULL), recorder(NULL), cpuStart(0),
+    lastLoad(0), loads(0), lateTotal(0), lateMax(0), loadTotal(0), loadMax(0),
+    updates(0), samples(0), guiTotal(0), guiMax(0), distance(0)
+{
+    dc.type = DEV_REPLAY;
+    dc.portSpec = recording;
+    dc.deviceProfile = QString("%1").arg(this->speed);
+
+    loadTimer = new QTimer(this);
+    guiTimer = new QTimer(this);
+    connect(loadTimer, SIGNAL(timeout()), this, SLOT(loadUpdate()));
+    connect(guiTimer, SIGNAL(timeout()), this, SLOT(guiUpdate()));
+}
+
+TrainBenchmark::~TrainBenchmark()
+{
+    stop();
+    delete recorder;
+    delete controller;
+    delete ergFile;
+}
+
+bool
+TrainBenchmark::start()
+{
+    ergFile = new ErgFile(workout, ERG, context);
+    if (!ergFile->isValid()) {
+        fprintf(stdout, "trainbench: %s is not a workout we can use\n", workout.toUtf8().constData());
+        return false;
+    }
+
+    controller = new ReplayController(NULL, &dc, context);
+    if (controller->start() != DEVICE_OK) {
+        fprintf(stdout, "trainbench: cannot replay %s\n", dc.portSpec.toUtf8().constData());
+        return false;
+    }
+    reader.attach(controller->telemetryRing());
+
+    // the replay is everything, as the train view would set up a single device
+    loop.addDevice(0, controller, DEV_REPLAY);
+    loop.setSources(0, 0, 0, 0);
+    loop.start();
+
+    recorder = new TrainRecorder(context, QDir::tempPath() + "/trainbench.gcj", QDateTime::currentDateTime(),
+                                 qMax(1, int(SAMPLERATE / speed)));
+    loop.record(recorder);
+    if (!recorder->begin()) {
+        fprintf(stdout, "trainbench: cannot record to %s\n", QDir::tempPath().toUtf8().constData());
+        return false;
+    }
+
+    fprintf(stdout, "trainbench: %s against %s at %gx\n", workout.toUtf8().constData(),
+            dc.portSpec.toUtf8().constData(), speed);
+    fflush(stdout);
+
+    cpuStart = cpuMsecs();
+    clock.start();
+    loadTimer->start(qMax(1, int(LOADRATE / speed)));
+    guiTimer->start(qMax(1, int(REFRESHRATE / speed)));
+    return true;
+}
+
+void
+TrainBenchmark::stop()
+{
+    loadTimer->stop();
+    guiTimer->stop();
+    if (controller) controller->stop();
+    if (recorder && recorder->isRunning()) recorder->finish(false);
+}
+
+// the load half of TrainSidebar::loadUpdate
+void
+TrainBenchmark::loadUpdate()
+{
+    // how late was the timer?
+    qint64 now = clock.elapsed();
+    double late = qMax(0.0, (now - lastLoad) - loadTimer->interval() * 1.0);
+    if (loads) {
+        lateTotal += late;
+        if (late > lateMax) lateMax = late;
+    }
+    lastLoad = now;
+
+    QElapsedTimer work;
+    work.start();
+
+    int lap;
+    if (ergFile->format == CRS) distance += loop.travelled(0, 0) * speed; // device time runs fast
+    double value = loop.load(ergFile, ergFile->format != CRS, now * speed, distance, lap);
+
+    double msecs = work.nsecsElapsed() / 1000000.0;
+    loadTotal += msecs;
+    if (msecs > loadMax) loadMax = msecs;
+    loads++;
+
+    // we got to the end, of the workout or the recording
+    if (value == -100 || controller->myReplay->ended()) {
+        double wall = clock.elapsed();
+        double cpu = cpuMsecs() - cpuStart;
+
+        stop();
+        report(wall, cpu);
+        emit done();
+    }
+}
+
+// the telemetry half of TrainSidebar::guiUpdate
+void
+TrainBenchmark::guiUpdate()
+{
+    QElapsedTimer work;
+    work.start();
+
+    RealtimeData rt;
+    loop.telemetry(rt);
+    distance += loop.travelled(guiTimer->interval(), rt.getSpeed()) * speed;
+
+    // what has the device published since last time
+    RealtimeSample sample;
+    while (reader.next(sample)) samples++;
+
+    double msecs = work.nsecsElapsed() / 1000000.0;
+    guiTotal += msecs;
+    if (msecs > guiMax) guiMax = msecs;
+    updates++;
+}
+
+void
+TrainBenchmark::report(double wall, double cpu)
+{
+    double secs = wall / 1000.0;
+    if (secs <= 0) return;
+
+    QStringList lines;
+    lines << QString("played %1s of workout in %2s").arg(wall * speed / 1000.0, 0, 'f', 1).arg(secs, 0, 'f', 1);
+    lines << QString("load loop: %1 updates, timer late mean %2ms max %3ms, update mean %4ms max %5ms")
+             .arg(loads)
+             .arg(loads > 1 ? lateTotal / (loads - 1) : 0, 0, 'f', 2).arg(lateMax, 0, 'f', 2)
+             .arg(loads ? loadTotal / loads : 0, 0, 'f', 3).arg(loadMax, 0, 'f', 3);
+    lines << QString("telemetry: %1 updates/s (wanted %2), update mean %3ms max %4ms, %5 device samples/s, %6 lost")
+             .arg(updates / secs, 0, 'f', 1).arg(1000.0 / guiTimer->interval(), 0, 'f', 1)
+             .arg(updates ? guiTotal / updates : 0, 0, 'f', 3).arg(guiMax, 0, 'f', 3)
+             .arg(samples / secs, 0, 'f', 1).arg(reader.lost());
+    lines << QString("recorder: %1 samples/s (wanted %2), late mean %3ms worst %4ms")
+             .arg(recorder->recorded() / secs, 0, 'f', 1).arg(speed * 1000.0 / SAMPLERATE, 0, 'f', 1)
+             .arg(recorder->meanLateness()).arg(recorder->worstLateness());
+    ANTReceiveStats ant;
+    if (controller->myReplay->receiveStats(ant))
+        lines << QString("ant: %1 messages, %2 dropped, last second %3 messages/s, handled in mean %4us max %5us")
+                 .arg(ant.messages).arg(ant.dropped).arg(ant.rate, 0, 'f', 1)
+                 .arg(ant.latency, 0, 'f', 1).arg(ant.maxLatency, 0, 'f', 1);
+    lines << QString("cpu: %1s, %2% of one core").arg(cpu / 1000.0, 0, 'f', 2).arg(100.0 * cpu / wall, 0, 'f', 1);
+
+    foreach(QString line, lines) fprintf(stdout, "trainbench: %s\n", line.toUtf8().constData());
+    fflush(stdout);
+}
+
+double
+TrainBenchmark::cpuMsecs()
+{
+#ifdef WIN32
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0;
+
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime; k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime; u.HighPart = user.dwHighDateTime;
+    return (k.QuadPart + u.QuadPart) / 10000.0; // 100ns units
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage)) return 0;
+
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+#endif
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef _GC_TrainBenchmark_h
+#define _GC_TrainBenchmark_h 1
+#include "GoldenCheetah.h"
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "DeviceConfiguration.h"
+#include "TrainLoop.h"
+
+class Context;
+class ErgFile;
+class ReplayController;
+class TrainRecorder;
+
+// Measures the train loop without a trainer
+//
+// Runs a workout against a Replay device through the same TrainLoop as
+// TrainSidebar; load set every LOADRATE, telemetry fetched every REFRESHRATE
+// and recorded every SAMPLERATE, all of them sped up along with the replay.
+// When the workout or the recording ends it reports how late the load
+// updates were and how long they took, the telemetry update rate, what
+// the recorder kept up with and how much cpu was used.
+//
+// Started from the command line with
+//      --trainbench=workout,recording[,speed]
+
+class TrainBenchmark : public QObject
+{
+    Q_OBJECT
+
+    public:
+        TrainBenchmark(Context *context, QString workout, QString recording, double speed = 1.0);
+        ~TrainBenchmark();
+
+        bool start();       // false if the workout or recording can't be used
+
+    signals:
+        void done();
+
+    private slots:
+        void loadUpdate();
+        void guiUpdate();
+
+    private:
+        void stop();
+        void report(double wall, double cpu);
+        static double cpuMsecs(); // used by this process so far
+
+        Context *context;
+        QString workout;
+        double speed;
+
+        ErgFile *ergFile;
+        DeviceConfiguration dc;
+        ReplayController *controller;
+        TrainLoop loop;
+        TrainRecorder *recorder;
+        RealtimeRingReader reader;
+        QTimer *loadTimer, *guiTimer;
+        QElapsedTimer clock;
+        double cpuStart;
+
+        // load loop, all ms
+        qint64 lastLoad;
+        int loads;
+        double lateTotal, lateMax, loadTotal, loadMax;
+
+        // telemetry
+        int updates, samples;
+        double guiTotal, guiMax, distance;
+};
+
+#endif // _GC_TrainBenchmark_h
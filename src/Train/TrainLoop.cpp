@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TrainLoop.h"
+#include "TrainRecorder.h"
+#include "RealtimeController.h"
+#include "DeviceTypes.h"
+#include "ErgFile.h"
+
+#include <string.h> // memcpy
+
+TrainLoop::TrainLoop() : bpm(-1), watts(-1), rpm(-1), kph(-1)
+{
+}
+
+TrainLoop::~TrainLoop()
+{
+    clear();
+}
+
+void
+TrainLoop::addDevice(int id, RealtimeController *controller, int type)
+{
+    Device add;
+    add.id = id;
+    add.controller = controller;
+    add.type = type;
+    add.polled = NULL;
+    devices << add;
+}
+
+void
+TrainLoop::setSources(int bpm, int watts, int rpm, int kph)
+{
+    this->bpm = bpm;
+    this->watts = watts;
+    this->rpm = rpm;
+    this->kph = kph;
+}
+
+void
+TrainLoop::clear()
+{
+    recorded();
+    devices.clear();
+    odometer.attach(NULL);
+}
+
+void
+TrainLoop::start()
+{
+    RealtimeRing *ring = NULL;
+    foreach(const Device &device, devices)
+        if (device.id == kph) ring = device.controller->telemetryRing();
+
+    odometer.attach(ring);
+}
+
+void
+TrainLoop::telemetry(RealtimeData &rtData)
+{
+    // fetch the right data from each device...
+    for (int i=0; i<devices.count(); i++) {
+        Device &device = devices[i];
+
+        RealtimeData local = rtData;
+        device.controller->getRealtimeData(local);
+
+        // for the recorder, if the device doesn't publish its own
+        if (device.polled) device.polled->write(local);
+
+        // get spinscan data from a computrainer?
+        if (device.type == DEV_CT) {
+            memcpy((uint8_t*)rtData.spinScan, (uint8_t*)local.spinScan, 24);
+            rtData.setLoad(local.getLoad()); // and get load in case it was adjusted
+            rtData.setSlope(local.getSlope()); // and get slope in case it was adjusted
+            // to within defined limits
+        }
+
+        if (device.type == DEV_FORTIUS) {
+            rtData.setLoad(local.getLoad()); // and get load in case it was adjusted
+            rtData.setSlope(local.getSlope()); // and get slope in case it was adjusted
+            // to within defined limits
+        }
+
+        if (device.type == DEV_ANTLOCAL || device.type == DEV_NULL) {
+            rtData.setHb(local.getSmO2(), local.gettHb()); //only moxy data from ant and robot devices right now
+        }
+
+        // what are we getting from this one?
+        if (device.id == bpm) rtData.setHr(local.getHr());
+        if (device.id == rpm) rtData.setCadence(local.getCadence());
+        if (device.id == kph) {
+            rtData.setSpeed(local.getSpeed());
+            rtData.setDistance(local.getDistance());
+        }
+        if (device.id == watts) {
+            rtData.setWatts(local.getWatts());
+            rtData.setAltWatts(local.getAltWatts());
+            rtData.setLRBalance(local.getLRBalance());
+            rtData.setLTE(local.getLTE());
+            rtData.setRTE(local.getRTE());
+            rtData.setLPS(local.getLPS());
+            rtData.setRPS(local.getRPS());
+        }
+        if (local.getTrainerStatusAvailable())
+        {
+            rtData.setTrainerStatusAvailable(true);
+            rtData.setTrainerReady(local.getTrainerReady());
+            rtData.setTrainerRunning(local.getTrainerRunning());
+            rtData.setTrainerCalibRequired(local.getTrainerCalibRequired());
+            rtData.setTrainerConfigRequired(local.getTrainerConfigRequired());
+            rtData.setTrainerBrakeFault(local.getTrainerBrakeFault());
+        }
+    }
+}
+
+double
+TrainLoop::travelled(double refresh, double speed)
+{
+    if (odometer.attached()) return odometer.travelled();
+    return speed * refresh / 3600000.0; // from km/h
+}
+
+double
+TrainLoop::load(ErgFile *ergFile, bool ergo, long msecs, double km, int &lap)
+{
+    double value = ergo ? ergFile->wattsAt(msecs, lap) : ergFile->gradientAt(km * 1000, lap);
+
+    // we got to the end!
+    if (value == -100) return value;
+
+    foreach(const Device &device, devices) {
+        if (ergo) device.controller->setLoad(value);
+        else device.controller->setGradient(value);
+    }
+    return value;
+}
+
+void
+TrainLoop::record(TrainRecorder *recorder)
+{
+    recorded();
+
+    for (int i=0; i<devices.count(); i++) {
+        Device &device = devices[i];
+
+        int series = 0;
+        if (device.id == bpm) series |= TrainRecorder::Hr;
+        if (device.id == rpm) series |= TrainRecorder::Cadence;
+        if (device.id == kph) series |= TrainRecorder::Speed;
+        if (device.id == watts) series |= TrainRecorder::Power;
+        if (device.type == DEV_ANTLOCAL || device.type == DEV_NULL) series |= TrainRecorder::Oxygen;
+        if (!series) continue;
+
+        RealtimeRing *ring = device.controller->telemetryRing();
+        if (ring) {
+            recorder->addDevice(ring, device.controller, series);
+        } else {
+            device.polled = new RealtimeRing();
+            recorder->addDevice(device.polled, NULL, series);
+        }
+    }
+}
+
+void
+TrainLoop::recorded()
+{
+    for (int i=0; i<devices.count(); i++) {
+        delete devices[i].polled;
+        devices[i].polled = NULL;
+    }
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_TrainLoop_h
+#define _GC_TrainLoop_h 1
+#include "GoldenCheetah.h"
+
+#include <QList>
+#include "RealtimeData.h"
+#include "RealtimeRing.h"
+
+class RealtimeController;
+class TrainRecorder;
+class ErgFile;
+
+// The device side of a training session
+//
+// Shared by the train view and the train benchmark so the benchmark
+// measures the loop the rider actually gets. It holds the devices in the
+// session and where each series comes from:
+//
+//   telemetry()  every refresh, merges what each device reports
+//   travelled()  distance covered, from every speed sample if the speed
+//                device publishes them
+//   load()       every LOADRATE, sets the load or gradient from the workout
+//   record()     has a recorder follow each device's telemetry
+//
+// Everything here runs on the thread that owns the controllers.
+
+class TrainLoop
+{
+    public:
+        TrainLoop();
+        ~TrainLoop();
+
+        // devices are identified by the ids the sources refer to
+        void addDevice(int id, RealtimeController *controller, int type);
+        void setSources(int bpm, int watts, int rpm, int kph);
+        void clear();
+
+        // once the devices are started, and again to forget where we've been
+        void start();
+
+        // merge the latest from each device into rtData, which comes with
+        // the session's lap, load and slope. load and slope are replaced by
+        // the trainer's if it adjusted them.
+        void telemetry(RealtimeData &rtData);
+
+        // km covered since last time, when the speed device doesn't publish
+        // its samples assumes speed for refresh msecs
+        double travelled(double refresh, double speed);
+
+        // the workout's load (ergo) or gradient at msecs or km, sent to the
+        // devices unless we reached the end (-100)
+        double load(ErgFile *ergFile, bool ergo, long msecs, double km, int &lap);
+
+        // the recorder follows every device with telemetry we take, and a
+        // ring we fill for those that don't publish their own. recorded()
+        // once the recorder has gone.
+        void record(TrainRecorder *recorder);
+        void recorded();
+
+    private:
+        struct Device {
+            int id;
+            RealtimeController *controller;
+            int type;
+            RealtimeRing *polled;   // whilst recording, for devices without a ring
+        };
+        QList<Device> devices;
+
+        int bpm, watts, rpm, kph;
+        RealtimeRingReader odometer;
+};
+
+#endif // _GC_TrainLoop_h
@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "TrainRecorder.h"
+#include "RealtimeController.h"
+#include "RideFile.h"
+
+#include <QDataStream>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QDebug>
+
+#ifdef WIN32
+#include <io.h> // _commit
+#else
+#include <unistd.h> // fsync
+#endif
+
+static const quint32 JOURNAL_MAGIC = 0x4743524a; // "GCRJ"
+static const quint32 JOURNAL_VERSION = 1;
+static const int JOURNAL_SYNC = 5;  // samples between syncs to disk
+static const int JOURNAL_LATE = 100; // ms late before we count a sample as late
+static const int JOURNAL_STALE = 5000; // ms without a sample before a device records zeroes
+
+TrainRecorder::TrainRecorder(Context *context, QString filename, QDateTime start, int msecs) :
+    context(context), filename(filename), start(start), msecs(msecs), distance(0), journal(filename),
+    pausedAt(-1), pausedTotal(0), paused(false), stopping(false), lap(0), target(0),
+    samples(0), late(0), lateness(0), worst(0)
+{
+}
+
+TrainRecorder::~TrainRecorder()
+{
+    stop();
+}
+
+void
+TrainRecorder::addDevice(RealtimeRing *ring, RealtimeController *controller, int series)
+{
+    if (!ring || !series || isRunning()) return;
+
+    Device add;
+    add.ring = ring;
+    add.controller = controller;
+    add.series = series;
+    add.heard = 0;
+    devices << add;
+}
+
+void
+TrainRecorder::setProgress(int lap, double target)
+{
+    QMutexLocker locker(&lock);
+    this->lap = lap;
+    this->target = target;
+}
+
+bool
+TrainRecorder::begin()
+{
+    if (!journal.open(QFile::WriteOnly | QFile::Truncate)) return false;
+
+    QDataStream out(&journal);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << JOURNAL_MAGIC << JOURNAL_VERSION << qint64(start.toMSecsSinceEpoch()) << qint32(msecs);
+    sync();
+
+    for (int i=0; i<devices.count(); i++) devices[i].reader.attach(devices[i].ring);
+    clock.start();
+    QThread::start();
+    return true;
+}
+
+qint64
+TrainRecorder::sessionMsecs()
+{
+    return (paused ? pausedAt : clock.elapsed()) - pausedTotal;
+}
+
+void
+TrainRecorder::pause()
+{
+    QMutexLocker locker(&lock);
+    if (paused) return;
+
+    pausedAt = clock.elapsed();
+    paused = true;
+    wake.wakeAll();
+}
+
+void
+TrainRecorder::resume()
+{
+    QMutexLocker locker(&lock);
+    if (!paused) return;
+
+    pausedTotal += clock.elapsed() - pausedAt;
+    paused = false;
+    wake.wakeAll();
+}
+
+// make sure what we've written is on the disk, not just in the os cache
+void
+TrainRecorder::sync()
+{
+    journal.flush();
+#ifdef WIN32
+    _commit(journal.handle());
+#else
+    fsync(journal.handle());
+#endif
+}
+
+// catch up with every device, we don't go anywhere whilst paused
+void
+TrainRecorder::follow(bool moving)
+{
+    qint64 now = clock.elapsed();
+
+    for (int i=0; i<devices.count(); i++) {
+        Device &device = devices[i];
+
+        RealtimeSample sample;
+        sample.msecs = -1;
+        double km = device.reader.travelled(&sample);
+        if (moving && (device.series & Speed)) distance += km;
+
+        if (sample.msecs >= 0) {
+            device.latest = sample.data;
+            if (device.controller) device.controller->processRealtimeData(device.latest);
+            device.heard = now;
+
+        } else if (now - device.heard > JOURNAL_STALE) {
+            device.latest = RealtimeData();
+        }
+    }
+}
+
+void
+TrainRecorder::run()
+{
+    QDataStream out(&journal);
+    out.setVersion(QDataStream::Qt_4_6);
+
+    qint64 due = msecs;
+
+    lock.lock();
+    while (!stopping) {
+
+        qint64 now = sessionMsecs();
+        bool moving = !paused;
+        int lap = this->lap;
+        double target = this->target;
+        lock.unlock();
+
+        follow(moving);
+
+        // not time yet
+        if (!moving || now < due) {
+            lock.lock();
+            if (!stopping) wake.wait(&lock, moving ? qMin(due - now, qint64(100)) : 100);
+            continue;
+        }
+
+        // the latest from each device
+        RealtimeData rt;
+        foreach(const Device &device, devices) {
+            const RealtimeData &from = device.latest;
+
+            if (device.series & Hr) rt.setHr(from.getHr());
+            if (device.series & Cadence) rt.setCadence(from.getCadence());
+            if (device.series & Speed) rt.setSpeed(from.getSpeed());
+            if (device.series & Power) {
+                rt.setWatts(from.getWatts());
+                rt.setLRBalance(from.getLRBalance());
+                rt.setLTE(from.getLTE());
+                rt.setRTE(from.getRTE());
+                rt.setLPS(from.getLPS());
+                rt.setRPS(from.getRPS());
+            }
+            if (device.series & Oxygen) rt.setHb(from.getSmO2(), from.gettHb());
+        }
+
+        out << qint32(due / 1000) << qint32(now - due)
+            << rt.getCadence() << rt.getHr() << distance << rt.getSpeed() << rt.getWatts()
+            << qint32(lap) << rt.getLRBalance() << rt.getLTE() << rt.getRTE()
+            << rt.getLPS() << rt.getRPS() << rt.getSmO2() << rt.gettHb() << target;
+
+        // how late were we?
+        samples++;
+        lateness += now - due;
+        if (now - due > worst) worst = now - due;
+        if (now - due > JOURNAL_LATE) late++;
+
+        if (samples % JOURNAL_SYNC == 0) sync();
+        due += msecs;
+
+        lock.lock();
+    }
+    lock.unlock();
+}
+
+// stop recording, leaving the journal where it is
+void
+TrainRecorder::stop()
+{
+    lock.lock();
+    stopping = true;
+    wake.wakeAll();
+    lock.unlock();
+
+    wait();
+    if (journal.isOpen()) {
+        sync();
+        journal.close();
+    }
+}
+
+QString
+TrainRecorder::finish(bool keep)
+{
+    stop();
+
+    if (!keep) {
+        journal.remove();
+        return "";
+    }
+
+    int lost = 0;
+    foreach(const Device &device, devices) lost += device.reader.lost();
+
+    QString report = QString("%1 samples, mean %2ms late, worst %3ms, %4 over %5ms, %6 device samples lost")
+                     .arg(samples).arg(samples ? lateness / samples : 0).arg(worst)
+                     .arg(late).arg(JOURNAL_LATE).arg(lost);
+    qDebug() << "Recording jitter:" << report;
+
+    return save(context, filename, report);
+}
+
+// convert a journal to a ride saved alongside it as json, the journal is
+// only removed once that's safe
+QString
+TrainRecorder::save(Context *context, QString filename, QString jitter)
+{
+    QFile journal(filename);
+    RideFile *ride = read(journal);
+    if (!ride) return "";
+    if (jitter != "") ride->setTag("Recording Jitter", jitter);
+
+    QFileInfo info(filename);
+    QString name = info.absolutePath() + "/" + info.completeBaseName() + ".json";
+    QFile out(name);
+    bool success = RideFileFactory::instance().writeRideFile(context, ride, out, "json");
+    delete ride;
+
+    if (!success) return "";
+    journal.remove();
+    return name;
+}
+
+QStringList
+TrainRecorder::recover(Context *context, QDir records)
+{
+    QStringList recovered;
+
+    foreach(QString journal, records.entryList(QStringList() << "*.gcj", QDir::Files, QDir::Name)) {
+        QString name = save(context, records.absoluteFilePath(journal), "");
+        if (name != "") recovered << name;
+        else qDebug() << "Could not recover" << journal;
+    }
+    return recovered;
+}
+
+// read back a journal, as the csv reader would have the old .csv
+RideFile *
+TrainRecorder::read(QFile &journal)
+{
+    if (!journal.open(QFile::ReadOnly)) return NULL;
+
+    QDataStream in(&journal);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic, version;
+    qint64 started;
+    qint32 interval;
+    in >> magic >> version >> started >> interval;
+    if (in.status() != QDataStream::Ok || magic != JOURNAL_MAGIC || version != JOURNAL_VERSION || interval <= 0) {
+        journal.close();
+        return NULL;
+    }
+
+    RideFile *ride = new RideFile(QDateTime::fromMSecsSinceEpoch(started), interval / 1000.0);
+    ride->setDeviceType("GoldenCheetah");
+    ride->setFileFormat("GoldenCheetah Train Journal (gcj)");
+
+    XDataSeries *train = NULL;
+    while (!in.atEnd()) {
+
+        qint32 secs, late, lap;
+        double cad, hr, km, kph, watts, lrbalance, lte, rte, lps, rps, smo2, thb, target;
+        in >> secs >> late >> cad >> hr >> km >> kph >> watts >> lap
+           >> lrbalance >> lte >> rte >> lps >> rps >> smo2 >> thb >> target;
+
+        // a partial sample at the end if we crashed
+        if (in.status() != QDataStream::Ok) break;
+
+        ride->appendPoint(secs, cad, hr, km, kph, 0.0, watts, 0.0, 0.0, 0.0, 0.0, 0.0,
+                          RideFile::NA, lrbalance, lte, rte, lps, rps,
+                          0.0, 0.0,
+                          0.0, 0.0, 0.0, 0.0,
+                          0.0, 0.0, 0.0, 0.0,
+                          smo2, thb,
+                          0.0, 0.0, 0.0, 0.0, lap);
+
+        if (target > 0.0) {
+            if (train == NULL) {
+                train = new XDataSeries();
+                train->name = "TRAIN";
+                train->valuename << "TARGET";
+                train->unitname << "Watts";
+            }
+
+            XDataPoint *p = new XDataPoint();
+            p->secs = secs;
+            p->km = km;
+            p->number[0] = target;
+            train->datapoints.append(p);
+        }
+    }
+    journal.close();
+
+    if (train) ride->addXData("TRAIN", train);
+
+    if (ride->dataPoints().count() == 0) {
+        delete ride;
+        return NULL;
+    }
+    return ride;
+}
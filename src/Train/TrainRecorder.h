@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef _GC_TrainRecorder_h
+#define _GC_TrainRecorder_h 1
+#include "GoldenCheetah.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QFile>
+#include <QDir>
+#include <QStringList>
+#include "RealtimeRing.h"
+
+class Context;
+class RideFile;
+class RealtimeController;
+
+// Records a training session on its own thread
+//
+// The recorder follows the telemetry ring of each device in the session
+// and records the latest from each on a schedule kept by its own clock, so
+// a stalled GUI no longer shows up as gaps or repeated timestamps in the
+// ride. Distance comes from every speed sample, not the speed at the time
+// a sample is taken. Samples are appended to a binary journal (.gcj) in the
+// records folder, which is flushed to disk every few seconds so a crash
+// loses very little; any journals left behind are recovered at startup.
+//
+// When the session ends the journal is converted to a RideFile and saved
+// alongside it as json, ready to import. How late each sample was taken
+// against its schedule is reported in the "Recording Jitter" tag.
+
+class TrainRecorder : public QThread
+{
+    public:
+        TrainRecorder(Context *context, QString filename, QDateTime start, int msecs);
+        ~TrainRecorder(); // stops recording, but leaves the journal to be recovered
+
+        // what to record from a device, its ring is followed from begin()
+        enum { Hr = 0x01, Cadence = 0x02, Speed = 0x04, Power = 0x08, Oxygen = 0x10 };
+
+        // samples from the controller are post processed by it, those from
+        // a ring we filled from getRealtimeData() already were (controller NULL)
+        void addDevice(RealtimeRing *ring, RealtimeController *controller, int series);
+
+        // lap and target load aren't telemetry, the train view sets them
+        void setProgress(int lap, double target);
+
+        // open the journal and start recording
+        bool begin();
+
+        // session time stops whilst paused or calibrating
+        void pause();
+        void resume();
+
+        // stop recording and convert the journal to a ride, returns the
+        // ride's filename or an empty string if discarded or failed
+        QString finish(bool keep);
+
+        // how the recording went, once finish() has returned
+        int recorded() const { return samples; }
+        qint64 meanLateness() const { return samples ? lateness / samples : 0; }
+        qint64 worstLateness() const { return worst; }
+
+        // read a journal, NULL if it isn't one or has nothing in it
+        static RideFile *read(QFile &journal);
+
+        // convert journals left behind by a crash, as finish() would have,
+        // returning the rides' filenames
+        static QStringList recover(Context *context, QDir records);
+
+    private:
+        void run();
+        void stop();
+        qint64 sessionMsecs(); // called with lock held
+        void follow(bool moving);
+        void sync();
+        static QString save(Context *context, QString filename, QString jitter);
+
+        Context *context;
+        QString filename;       // journal, the ride is saved as .json
+        QDateTime start;
+        int msecs;              // sample interval
+
+        struct Device {
+            RealtimeRing *ring;
+            RealtimeRingReader reader;
+            RealtimeController *controller;
+            int series;
+            RealtimeData latest;
+            qint64 heard;       // when we last had a sample, by our clock
+        };
+        QList<Device> devices;  // only touched by the recording thread once begun
+        double distance;
+        QFile journal;
+
+        QMutex lock;            // guards the state below
+        QWaitCondition wake;
+        QElapsedTimer clock;
+        qint64 pausedAt, pausedTotal;
+        bool paused, stopping;
+        int lap;
+        double target;
+
+        // jitter, only touched by the recording thread
+        int samples, late;
+        qint64 lateness, worst;
+};
+
+#endif // _GC_TrainRecorder_h
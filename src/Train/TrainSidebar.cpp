@@ -26,6 +26,7 @@
 #include "DeviceTypes.h"
 #include "DeviceConfiguration.h"
 #include "RideImportWizard.h"
+#include "TrainRecorder.h"
 #include <QApplication>
 #include <QtGui>
 #include <QRegExp>
@@ -49,6 +50,7 @@
 #endif
 #include "ANTlocalController.h"
 #include "NullController.h"
+#include "ReplayController.h"
 #ifdef QT_BLUETOOTH_LIB
 #include "BT40Controller.h"
 #endif
@@ -325,7 +327,6 @@ TrainSidebar::TrainSidebar(Context *context) : GcWindow(context), context(contex
 
     // now the GUI is setup lets sort our control variables
     gui_timer = new QTimer(this);
-    disk_timer = new QTimer(this);
     load_timer = new QTimer(this);
 
     session_time = QTime();
@@ -333,7 +334,7 @@ TrainSidebar::TrainSidebar(Context *context) : GcWindow(context), context(contex
     lap_time = QTime();
     lap_elapsed_msec = 0;
 
-    recordFile = NULL;
+    recorder = NULL;
     status = 0;
     setStatusFlags(RT_MODE_ERGO);         // ergo mode by default
     mode = ERG;
@@ -353,7 +354,6 @@ TrainSidebar::TrainSidebar(Context *context) : GcWindow(context), context(contex
     displayLRBalance = displayLTE = displayRTE = displayLPS = displayRPS = 0;
 
     connect(gui_timer, SIGNAL(timeout()), this, SLOT(guiUpdate()));
-    connect(disk_timer, SIGNAL(timeout()), this, SLOT(diskUpdate()));
     connect(load_timer, SIGNAL(timeout()), this, SLOT(loadUpdate()));
 
     configChanged(CONFIG_APPEARANCE | CONFIG_DEVICES | CONFIG_ZONES); // will reset the workout tree
@@ -367,6 +367,25 @@ TrainSidebar::TrainSidebar(Context *context) : GcWindow(context), context(contex
     //toolbarButtons->hide();
 #endif
 
+    // once we're up and running
+    QTimer::singleShot(0, this, SLOT(recoverRecordings()));
+}
+
+TrainSidebar::~TrainSidebar()
+{
+    // anything being recorded is recovered next time
+    delete recorder;
+}
+
+// sessions that were still being recorded when we crashed
+void
+TrainSidebar::recoverRecordings()
+{
+    QList<QString> list = TrainRecorder::recover(context, context->athlete->home->records());
+    if (list.count()) {
+        RideImportWizard *dialog = new RideImportWizard (list, context);
+        dialog->process(); // do it!
+    }
 }
 
 void
@@ -652,6 +671,8 @@ TrainSidebar::configChanged(qint32)
 #endif
         } else if (Devices.at(i).type == DEV_NULL) {
             Devices[i].controller = new NullController(this, &Devices[i]);
+        } else if (Devices.at(i).type == DEV_REPLAY) {
+            Devices[i].controller = new ReplayController(this, &Devices[i]);
         } else if (Devices.at(i).type == DEV_ANTLOCAL) {
             Devices[i].controller = new ANTlocalController(this, &Devices[i]);
             // connect slot for receiving remote control commands
@@ -1051,10 +1072,11 @@ void TrainSidebar::Start()       // when start button is pressed
         // UN PAUSE!
         session_time.start();
         lap_time.start();
+        loop.start();
         clearStatusFlags(RT_PAUSED);
         //foreach(int dev, activeDevices) Devices[dev].controller->restart();
         //gui_timer->start(REFRESHRATE);
-        if (status & RT_RECORDING) disk_timer->start(SAMPLERATE);
+        if (status & RT_RECORDING) recorder->resume();
         load_period.restart();
         if (status & RT_WORKOUT) load_timer->start(LOADRATE);
 
@@ -1080,7 +1102,7 @@ void TrainSidebar::Start()       // when start button is pressed
         setStatusFlags(RT_PAUSED);
         //foreach(int dev, activeDevices) Devices[dev].controller->pause();
         //gui_timer->stop();
-        if (status & RT_RECORDING) disk_timer->stop();
+        if (status & RT_RECORDING) recorder->pause();
         if (status & RT_WORKOUT) load_timer->stop();
         load_msecs += load_period.restart();
 
@@ -1141,6 +1163,7 @@ void TrainSidebar::Start()       // when start button is pressed
         context->notifyStart();
 
         load_period.restart();
+        loop.start();
         session_time.start();
         session_elapsed_msec = 0;
         lap_time.start();
@@ -1173,25 +1196,23 @@ void TrainSidebar::Start()       // when start button is pressed
             QDateTime now = QDateTime::currentDateTime();
 
             // setup file
-            QString filename = now.toString(QString("yyyy_MM_dd_hh_mm_ss")) + QString(".csv");
+            QString filename = now.toString(QString("yyyy_MM_dd_hh_mm_ss")) + QString(".gcj");
 
             if (!context->athlete->home->records().exists())
                 context->athlete->home->createAllSubdirs();
 
             QString fulltarget = context->athlete->home->records().canonicalPath() + "/" + filename;
 
-            if (recordFile) delete recordFile;
-            recordFile = new QFile(fulltarget);
-            if (!recordFile->open(QFile::WriteOnly | QFile::Truncate)) {
-                clearStatusFlags(RT_RECORDING);
-            } else {
-
-                // CSV File header
+            // recording runs on its own thread
+            if (recorder) delete recorder;
+            recorder = new TrainRecorder(context, fulltarget, now, SAMPLERATE);
+            loop.record(recorder); // following each device's telemetry
 
-                QTextStream recordFileStream(recordFile);
-                recordFileStream << "secs, cad, hr, km, kph, nm, watts, alt, lon, lat, headwind, slope, temp, interval, lrbalance, lte, rte, lps, rps, smo2, thb, o2hb, hhb, target\n";
-
-                disk_timer->start(SAMPLERATE);  // start screen
+            if (!recorder->begin()) {
+                clearStatusFlags(RT_RECORDING);
+                delete recorder;
+                recorder = NULL;
+                loop.recorded();
             }
         }
         gui_timer->start(REFRESHRATE);      // start recording
@@ -1214,7 +1235,7 @@ void TrainSidebar::Pause()        // pause capture to recalibrate
         clearStatusFlags(RT_PAUSED);
         foreach(int dev, activeDevices) Devices[dev].controller->restart();
         gui_timer->start(REFRESHRATE);
-        if (status & RT_RECORDING) disk_timer->start(SAMPLERATE);
+        if (status & RT_RECORDING) recorder->resume();
         load_period.restart();
         if (status & RT_WORKOUT) load_timer->start(LOADRATE);
 
@@ -1234,7 +1255,7 @@ void TrainSidebar::Pause()        // pause capture to recalibrate
         foreach(int dev, activeDevices) Devices[dev].controller->pause();
         setStatusFlags(RT_PAUSED);
         gui_timer->stop();
-        if (status & RT_RECORDING) disk_timer->stop();
+        if (status & RT_RECORDING) recorder->pause();
         if (status & RT_WORKOUT) load_timer->stop();
         load_msecs += load_period.restart();
 
@@ -1291,20 +1312,15 @@ void TrainSidebar::Stop(int deviceStatus)        // when stop button is pressed
     QDateTime now = QDateTime::currentDateTime();
 
     if (status & RT_RECORDING) {
-        disk_timer->stop();
-
-        // close and reset File
-        recordFile->close();
-
-        if(deviceStatus == DEVICE_ERROR)
-        {
-            recordFile->remove();
-        }
-        else {
-            // add to the view - using basename ONLY
-            QString name;
-            name = recordFile->fileName();
-
+        // stop recording and convert the journal to a ride, the
+        // journal is discarded if the device failed
+        QString name = recorder->finish(deviceStatus != DEVICE_ERROR);
+        delete recorder;
+        recorder = NULL;
+        loop.recorded();
+
+        if (name != "") {
+            // add to the view
             QList<QString> list;
             list.append(name);
 
@@ -1418,6 +1434,11 @@ void TrainSidebar::Connect()
         Devices[dev].controller->start();
         Devices[dev].controller->resetCalibrationState();
     }
+
+    loop.clear();
+    foreach(int dev, activeDevices) loop.addDevice(dev, Devices[dev].controller, Devices[dev].type);
+    loop.setSources(bpmTelemetry, wattsTelemetry, rpmTelemetry, kphTelemetry);
+    loop.start();
     setStatusFlags(RT_CONNECTED);
     gui_timer->start(REFRESHRATE);
 
@@ -1435,6 +1456,7 @@ void TrainSidebar::Disconnect()
     qDebug() << "disconnecting..";
 
     foreach(int dev, activeDevices) Devices[dev].controller->stop();
+    loop.clear();
     clearStatusFlags(RT_CONNECTED);
 
     gui_timer->stop();
@@ -1470,6 +1492,8 @@ void TrainSidebar::guiUpdate()           // refreshes the telemetry
 #endif
         
         if(calibrating) {
+            loop.travelled(0, 0); // we don't move whilst calibrating
+
             foreach(int dev, activeDevices) { // Do for selected device only
                 RealtimeData local = rtData;
 
@@ -1524,68 +1548,11 @@ void TrainSidebar::guiUpdate()           // refreshes the telemetry
             rtData.setSlope(slope); // always set load..
 
             // fetch the right data from each device...
-            foreach(int dev, activeDevices) {
-
-                RealtimeData local = rtData;
-                Devices[dev].controller->getRealtimeData(local);
-
-                // get spinscan data from a computrainer?
-                if (Devices[dev].type == DEV_CT) {
-                    memcpy((uint8_t*)rtData.spinScan, (uint8_t*)local.spinScan, 24);
-                    rtData.setLoad(local.getLoad()); // and get load in case it was adjusted
-                    rtData.setSlope(local.getSlope()); // and get slope in case it was adjusted
-                    // to within defined limits
-                }
-
-				if (Devices[dev].type == DEV_FORTIUS) {
-	                rtData.setLoad(local.getLoad()); // and get load in case it was adjusted
-                    rtData.setSlope(local.getSlope()); // and get slope in case it was adjusted
-					// to within defined limits
-				}
-
-                if (Devices[dev].type == DEV_ANTLOCAL || Devices[dev].type == DEV_NULL) {
-                    rtData.setHb(local.getSmO2(), local.gettHb()); //only moxy data from ant and robot devices right now
-                }
-
-                // what are we getting from this one?
-                if (dev == bpmTelemetry) rtData.setHr(local.getHr());
-                if (dev == rpmTelemetry) rtData.setCadence(local.getCadence());
-                if (dev == kphTelemetry) {
-                    rtData.setSpeed(local.getSpeed());
-                    rtData.setDistance(local.getDistance());
-                }
-                if (dev == wattsTelemetry) {
-                    rtData.setWatts(local.getWatts());
-                    rtData.setAltWatts(local.getAltWatts());
-                    rtData.setLRBalance(local.getLRBalance());
-                    rtData.setLTE(local.getLTE());
-                    rtData.setRTE(local.getRTE());
-                    rtData.setLPS(local.getLPS());
-                    rtData.setRPS(local.getRPS());
-                }
-                if (local.getTrainerStatusAvailable())
-                {
-                    rtData.setTrainerStatusAvailable(true);
-                    rtData.setTrainerReady(local.getTrainerReady());
-                    rtData.setTrainerRunning(local.getTrainerRunning());
-                    rtData.setTrainerCalibRequired(local.getTrainerCalibRequired());
-                    rtData.setTrainerConfigRequired(local.getTrainerConfigRequired());
-                    rtData.setTrainerBrakeFault(local.getTrainerBrakeFault());
-                }
-            }
+            loop.telemetry(rtData);
 
             // only update time & distance if actively running (not just connected, and not running but paused)
             if ((status&RT_RUNNING) && ((status&RT_PAUSED) == 0)) {
-                // Distance assumes current speed for the last second. from km/h to km/sec
-                displayDistance += displaySpeed / (5 * 3600); // assumes 200ms refreshrate
-
-                if (!(status&RT_MODE_ERGO) && (context->currentVideoSyncFile()))
-                {
-                    displayWorkoutDistance = context->currentVideoSyncFile()->km + context->currentVideoSyncFile()->manualOffset;
-                    // TODO : graphs to be shown at seek position
-                }
-                else
-                    displayWorkoutDistance += displaySpeed / (5 * 3600); // assumes 200ms refreshrate
+                updateDistance(true);
                 rtData.setDistance(displayDistance);
 
                 // time
@@ -1628,6 +1595,7 @@ void TrainSidebar::guiUpdate()           // refreshes the telemetry
                 }
                 rtData.setLapMsecsRemaining(lapTimeRemaining);
             } else {
+                loop.travelled(0, 0); // not moving whilst stopped or paused
                 rtData.setDistance(displayDistance);
                 rtData.setMsecs(session_elapsed_msec);
                 rtData.setLapMsecs(lap_elapsed_msec);
@@ -1693,6 +1661,9 @@ void TrainSidebar::guiUpdate()           // refreshes the telemetry
 
             rtData.setWbal(wbal);
 
+            // the recorder follows the devices, but not where we are in the workout
+            if (recorder && (status&RT_RECORDING)) recorder->setProgress(rtData.getLap(), rtData.getLoad());
+
             // go update the displays...
             context->notifyTelemetryUpdate(rtData); // signal everyone to update telemetry
 
@@ -1760,49 +1731,6 @@ void TrainSidebar::warnnoConfig()
 //----------------------------------------------------------------------
 // DISK UPDATE FUNCTIONS
 //----------------------------------------------------------------------
-void TrainSidebar::diskUpdate()
-{
-    int  secs;
-
-    long torq = 0, altitude = 0;
-    QTextStream recordFileStream(recordFile);
-
-    if (calibrating) return;
-
-    // convert from milliseconds to secondes
-    total_msecs = session_elapsed_msec + session_time.elapsed();
-    secs = total_msecs;
-    secs /= 1000.0;
-
-    // GoldenCheetah CVS Format "secs, cad, hr, km, kph, nm, watts, alt, lon, lat, headwind, slope, temp, interval, lrbalance, lte, rte, lps, rps, smo2, thb, o2hb, hhb\n";
-
-    recordFileStream    << secs
-                        << "," << displayCadence
-                        << "," << displayHeartRate
-                        << "," << displayDistance
-                        << "," << displaySpeed
-                        << "," << torq
-                        << "," << displayPower
-                        << "," << altitude
-                        << "," // lon
-                        << "," // lat
-                        << "," // headwind
-                        << "," // slope
-                        << "," // temp
-                        << "," << (displayLap + displayWorkoutLap)
-                        << "," << displayLRBalance
-                        << "," << displayLTE
-                        << "," << displayRTE
-                        << "," << displayLPS
-                        << "," << displayRPS
-                        << "," << displaySMO2
-                        << "," << displayTHB
-                        << "," << displayO2HB
-                        << "," << displayHHB
-                        << "," << load
-                        << "," << "\n";
-}
-
 //----------------------------------------------------------------------
 // WORKOUT MODE
 //----------------------------------------------------------------------
@@ -1819,7 +1747,7 @@ void TrainSidebar::loadUpdate()
     load_msecs += load_period.restart();
 
     if (status&RT_MODE_ERGO) {
-        load = ergFile->wattsAt(load_msecs, curLap);
+        load = loop.load(ergFile, true, load_msecs, 0, curLap);
 
         if(displayWorkoutLap != curLap)
         {
@@ -1831,11 +1759,12 @@ void TrainSidebar::loadUpdate()
         if (load == -100) {
             Stop(DEVICE_OK);
         } else {
-            foreach(int dev, activeDevices) Devices[dev].controller->setLoad(load);
             context->notifySetNow(load_msecs);
         }
     } else {
-        slope = ergFile->gradientAt(displayWorkoutDistance*1000, curLap);
+        // the speed device may have moved us on since the last refresh
+        updateDistance(false);
+        slope = loop.load(ergFile, false, load_msecs, displayWorkoutDistance, curLap);
 
         if(displayWorkoutLap != curLap)
         {
@@ -1847,12 +1776,28 @@ void TrainSidebar::loadUpdate()
         if (slope == -100) {
             Stop(DEVICE_OK);
         } else {
-            foreach(int dev, activeDevices) Devices[dev].controller->setGradient(slope);
             context->notifySetNow(displayWorkoutDistance * 1000);
         }
     }
 }
 
+// move on by the distance covered since the last update, from every speed
+// sample if the speed device publishes them, otherwise assuming the current
+// speed for the last refresh
+void TrainSidebar::updateDistance(bool refresh)
+{
+    double km = loop.travelled(refresh ? REFRESHRATE : 0, displaySpeed);
+    displayDistance += km;
+
+    if (!(status&RT_MODE_ERGO) && (context->currentVideoSyncFile()))
+    {
+        displayWorkoutDistance = context->currentVideoSyncFile()->km + context->currentVideoSyncFile()->manualOffset;
+        // TODO : graphs to be shown at seek position
+    }
+    else
+        displayWorkoutDistance += km;
+}
+
 void TrainSidebar::Calibrate()
 {
     // Check we're running (and not paused) before attempting
@@ -1875,7 +1820,7 @@ void TrainSidebar::toggleCalibration()
 
         clearStatusFlags(RT_CALIBRATING);
         if (status & RT_WORKOUT) load_timer->start(LOADRATE);
-        if (status & RT_RECORDING) disk_timer->start(SAMPLERATE);
+        if (status & RT_RECORDING) recorder->resume();
         context->notifyUnPause(); // get video started again, amongst other things
 
         // back to ergo/slope mode and restore load/gradient
@@ -1907,7 +1852,7 @@ void TrainSidebar::toggleCalibration()
         lap_elapsed_msec += lap_time.elapsed();
 
         setStatusFlags(RT_CALIBRATING);
-        if (status & RT_RECORDING) disk_timer->stop();
+        if (status & RT_RECORDING) recorder->pause();
         if (status & RT_WORKOUT) load_timer->stop();
         load_msecs += load_period.restart();
 
@@ -22,6 +22,7 @@
 
 #include "Context.h"
 #include "RealtimeData.h"
+#include "TrainLoop.h"
 #include "RealtimePlot.h"
 #include "DeviceConfiguration.h"
 #include "DeviceTypes.h"
@@ -64,7 +65,7 @@
 // msecs constants for timers
 #define REFRESHRATE    200 // screen refresh in milliseconds
 #define STREAMRATE     200 // rate at which we stream updates to remote peer
-#define SAMPLERATE     1000 // disk update in milliseconds
+#define SAMPLERATE     1000 // recording interval in milliseconds
 #define LOADRATE       1000 // rate at which load is adjusted
 
 // device treeview node types
@@ -73,6 +74,7 @@
 #define WORKOUT_TYPE 4444
 
 class RealtimeController;
+class TrainRecorder;
 class ComputrainerController;
 class ANTlocalController;
 class NullController;
@@ -89,6 +91,7 @@ class TrainSidebar : public GcWindow
     public:
 
         TrainSidebar(Context *context);
+        ~TrainSidebar();
         Context *context;
 
         QStringList listWorkoutFiles(const QDir &) const;
@@ -160,8 +163,12 @@ class TrainSidebar : public GcWindow
 
         void viewChanged(int index);
 
+        void recoverRecordings(); // left behind when we crashed
+
         int  getCalibrationIndex(void);
 
+        void updateDistance(bool refresh); // move on with the speed device
+
     public slots:
         void configChanged(qint32);
         void deleteWorkouts(); // deletes selected workouts
@@ -189,7 +196,6 @@ class TrainSidebar : public GcWindow
 
         // Timed actions
         void guiUpdate();           // refreshes the telemetry
-        void diskUpdate();          // writes to CSV file
         void loadUpdate();          // sets Load on CT like devices
 
         // When no config has been setup
@@ -258,7 +264,8 @@ class TrainSidebar : public GcWindow
         int status;
         int displaymode;
 
-        QFile *recordFile;      // where we record!
+        TrainRecorder *recorder; // where we record!
+        TrainLoop loop;          // the active devices
         ErgFile *ergFile;       // workout file
         VideoSyncFile *videosyncFile;       // videosync file
 
@@ -278,8 +285,7 @@ class TrainSidebar : public GcWindow
         QTime session_time, lap_time;
 
         QTimer      *gui_timer,     // refresh the gui
-                    *load_timer,    // change the load on the device
-                    *disk_timer;    // write to .CSV file
+                    *load_timer;    // change the load on the device
 
         bool autoConnect;
         bool pendingConfigChange;